@@ -136,6 +136,43 @@ typedef struct _CFDATA
 } CFDATA, *PCFDATA;
 
 
+/* Read-ahead */
+
+/* Number of decompressed data blocks that can be waiting to be copied */
+#define CAB_READ_AHEAD_BLOCKS 8
+
+typedef struct _CAB_BLOCK_BUFFER
+{
+    ULONG UncompOffset;     // Uncompressed offset of the block in the folder
+    ULONG Size;             // Number of uncompressed bytes in the block
+    ULONG Status;           // Codec status (CS_*)
+    UCHAR Data[CAB_BLOCKSIZE];
+} CAB_BLOCK_BUFFER, *PCAB_BLOCK_BUFFER;
+
+typedef struct _CAB_READ_AHEAD
+{
+    RTL_CRITICAL_SECTION Lock;
+    HANDLE BlockReadyEvent;     // Set when a block has been decompressed
+    HANDLE BlockFreeEvent;      // Set when a block has been copied, or to stop the thread
+    HANDLE Thread;              // NULL if the blocks are decompressed on demand
+    BOOLEAN Stop;
+
+    /* Data blocks of the folder that are not decompressed yet */
+    PCFFOLDER Folder;
+    PCFDATA NextCFData;
+    ULONG NextOffset;
+    ULONG BlocksLeft;
+    BOOLEAN Filling;            // A block is being decompressed
+    ULONG DataReserved;
+    struct _CAB_CODEC* Codec;   // Private copy of the codec, with its own stream
+
+    /* Ring of decompressed blocks, oldest first */
+    ULONG First;
+    ULONG Count;
+    CAB_BLOCK_BUFFER Blocks[CAB_READ_AHEAD_BLOCKS];
+} CAB_READ_AHEAD;
+
+
 /* FUNCTIONS ****************************************************************/
 
 #if !defined(_INC_MALLOC) && !defined(_INC_STDLIB)
@@ -480,6 +517,344 @@ SetAttributesOnFile(PCFFILE File,
     return NT_SUCCESS(NtStatus);
 }
 
+/*
+ * FUNCTION: Decompresses the next data block of the folder into the ring
+ * ARGUMENTS:
+ *     ReadAhead = Pointer to read-ahead state
+ * RETURNS:
+ *     FALSE if the ring is full or all blocks of the folder are decompressed
+ * NOTES:
+ *     Only one thread at a time may fill the ring. The blocks are
+ *     independent of each other, so the codec starts over for each one
+ */
+static BOOLEAN
+ReadAheadFillBlock(
+    IN PCAB_READ_AHEAD ReadAhead)
+{
+    PCAB_BLOCK_BUFFER Block;
+    PCFDATA CFData;
+    LONG InputLength, OutputLength;
+    ULONG Status;
+
+    RtlEnterCriticalSection(&ReadAhead->Lock);
+    if (ReadAhead->Stop ||
+        ReadAhead->BlocksLeft == 0 ||
+        ReadAhead->Count == CAB_READ_AHEAD_BLOCKS)
+    {
+        RtlLeaveCriticalSection(&ReadAhead->Lock);
+        return FALSE;
+    }
+
+    /* The consumer does not look at this slot until it is counted */
+    Block = &ReadAhead->Blocks[(ReadAhead->First + ReadAhead->Count) % CAB_READ_AHEAD_BLOCKS];
+    CFData = ReadAhead->NextCFData;
+    Block->UncompOffset = ReadAhead->NextOffset;
+
+    ReadAhead->NextOffset += CFData->UncompSize;
+    ReadAhead->NextCFData = (PCFDATA)((PUCHAR)(CFData + 1) + ReadAhead->DataReserved + CFData->CompSize);
+    ReadAhead->BlocksLeft--;
+    ReadAhead->Filling = TRUE;
+    RtlLeaveCriticalSection(&ReadAhead->Lock);
+
+    /* Decompress the whole block at once */
+    InputLength = CFData->CompSize;
+    OutputLength = CAB_BLOCKSIZE;
+    Status = ReadAhead->Codec->Uncompress(ReadAhead->Codec,
+                                          Block->Data,
+                                          (PUCHAR)(CFData + 1) + ReadAhead->DataReserved,
+                                          &InputLength,
+                                          &OutputLength);
+    if (Status == CS_SUCCESS && OutputLength != CFData->UncompSize)
+    {
+        DPRINT1("Block at offset 0x%X has %d bytes instead of %u\n",
+                Block->UncompOffset, OutputLength, CFData->UncompSize);
+        Status = CS_BADSTREAM;
+    }
+    Block->Size = (Status == CS_SUCCESS) ? (ULONG)OutputLength : 0;
+    Block->Status = Status;
+
+    RtlEnterCriticalSection(&ReadAhead->Lock);
+    ReadAhead->Count++;
+    ReadAhead->Filling = FALSE;
+    RtlLeaveCriticalSection(&ReadAhead->Lock);
+
+    /* The thread may not know its own handle yet, so always signal;
+     * the waiter checks the ring again when it wakes up */
+    NtSetEvent(ReadAhead->BlockReadyEvent, NULL);
+
+    return TRUE;
+}
+
+/* Decompresses the blocks of the folder ahead of the copy */
+static ULONG NTAPI
+ReadAheadThread(IN PVOID Parameter)
+{
+    PCAB_READ_AHEAD ReadAhead = (PCAB_READ_AHEAD)Parameter;
+    BOOLEAN Full;
+
+    for (;;)
+    {
+        RtlEnterCriticalSection(&ReadAhead->Lock);
+        if (ReadAhead->Stop || ReadAhead->BlocksLeft == 0)
+        {
+            RtlLeaveCriticalSection(&ReadAhead->Lock);
+            break;
+        }
+        Full = (ReadAhead->Count == CAB_READ_AHEAD_BLOCKS);
+        RtlLeaveCriticalSection(&ReadAhead->Lock);
+
+        if (Full)
+            NtWaitForSingleObject(ReadAhead->BlockFreeEvent, FALSE, NULL);
+        else
+            ReadAheadFillBlock(ReadAhead);
+    }
+
+    NtTerminateThread(NtCurrentThread(), STATUS_SUCCESS);
+    return 0;
+}
+
+/*
+ * FUNCTION: Stops the read-ahead thread and empties the ring
+ * ARGUMENTS:
+ *     ReadAhead = Pointer to read-ahead state
+ */
+static VOID
+ReadAheadReset(
+    IN PCAB_READ_AHEAD ReadAhead)
+{
+    if (ReadAhead->Thread)
+    {
+        RtlEnterCriticalSection(&ReadAhead->Lock);
+        ReadAhead->Stop = TRUE;
+        RtlLeaveCriticalSection(&ReadAhead->Lock);
+
+        NtSetEvent(ReadAhead->BlockFreeEvent, NULL);
+        NtWaitForSingleObject(ReadAhead->Thread, FALSE, NULL);
+        NtClose(ReadAhead->Thread);
+        ReadAhead->Thread = NULL;
+    }
+
+    ReadAhead->Stop = FALSE;
+    ReadAhead->Folder = NULL;
+    ReadAhead->BlocksLeft = 0;
+    ReadAhead->Filling = FALSE;
+    ReadAhead->First = 0;
+    ReadAhead->Count = 0;
+}
+
+/*
+ * FUNCTION: Frees the read-ahead state of a cabinet
+ */
+static VOID
+ReadAheadDestroy(
+    IN OUT PCABINET_CONTEXT CabinetContext)
+{
+    PCAB_READ_AHEAD ReadAhead = CabinetContext->ReadAhead;
+
+    if (!ReadAhead)
+        return;
+
+    ReadAheadReset(ReadAhead);
+
+    if (ReadAhead->Codec)
+        RtlFreeHeap(ProcessHeap, 0, ReadAhead->Codec);
+    if (ReadAhead->BlockReadyEvent)
+        NtClose(ReadAhead->BlockReadyEvent);
+    if (ReadAhead->BlockFreeEvent)
+        NtClose(ReadAhead->BlockFreeEvent);
+    RtlDeleteCriticalSection(&ReadAhead->Lock);
+
+    RtlFreeHeap(ProcessHeap, 0, ReadAhead);
+    CabinetContext->ReadAhead = NULL;
+}
+
+/*
+ * FUNCTION: Makes sure the ring holds, or will hold, the block of a folder
+ *           containing an uncompressed offset
+ * ARGUMENTS:
+ *     Folder = Pointer to the folder
+ *     Offset = Uncompressed offset in the folder
+ * RETURNS:
+ *     Status of operation
+ * NOTES:
+ *     Files are usually extracted in the order they are stored, so the
+ *     blocks decompressed for the previous file are kept and the thread
+ *     is only restarted when the folder changes or the offset is far off
+ */
+static ULONG
+ReadAheadSeek(
+    IN PCABINET_CONTEXT CabinetContext,
+    IN PCFFOLDER Folder,
+    IN ULONG Offset)
+{
+    PCAB_READ_AHEAD ReadAhead = CabinetContext->ReadAhead;
+    PCFDATA CFData;
+    ULONG CurrentOffset;
+    ULONG Index;
+    ULONG FirstOffset;
+    NTSTATUS Status;
+
+    if (!ReadAhead)
+    {
+        ReadAhead = RtlAllocateHeap(ProcessHeap, HEAP_ZERO_MEMORY, sizeof(*ReadAhead));
+        if (!ReadAhead)
+            return CAB_STATUS_NOMEMORY;
+
+        RtlInitializeCriticalSection(&ReadAhead->Lock);
+        CabinetContext->ReadAhead = ReadAhead;
+
+        ReadAhead->Codec = RtlAllocateHeap(ProcessHeap, HEAP_ZERO_MEMORY, sizeof(CAB_CODEC));
+        if (!ReadAhead->Codec)
+        {
+            ReadAheadDestroy(CabinetContext);
+            return CAB_STATUS_NOMEMORY;
+        }
+
+        Status = NtCreateEvent(&ReadAhead->BlockReadyEvent,
+                               EVENT_ALL_ACCESS,
+                               NULL,
+                               SynchronizationEvent,
+                               FALSE);
+        if (NT_SUCCESS(Status))
+        {
+            Status = NtCreateEvent(&ReadAhead->BlockFreeEvent,
+                                   EVENT_ALL_ACCESS,
+                                   NULL,
+                                   SynchronizationEvent,
+                                   FALSE);
+        }
+        if (!NT_SUCCESS(Status))
+        {
+            DPRINT1("NtCreateEvent() failed (%x)\n", Status);
+            ReadAheadDestroy(CabinetContext);
+            return CAB_STATUS_NOMEMORY;
+        }
+    }
+
+    if (ReadAhead->Folder == Folder)
+    {
+        RtlEnterCriticalSection(&ReadAhead->Lock);
+        FirstOffset = (ReadAhead->Count > 0) ? ReadAhead->Blocks[ReadAhead->First].UncompOffset
+                                             : ReadAhead->NextOffset;
+        CurrentOffset = ReadAhead->NextOffset;
+        RtlLeaveCriticalSection(&ReadAhead->Lock);
+
+        /* Close enough ahead that decompressing the blocks in between
+           costs less than starting over */
+        if (Offset >= FirstOffset &&
+            Offset < CurrentOffset + CAB_READ_AHEAD_BLOCKS * CAB_BLOCKSIZE)
+        {
+            return CAB_STATUS_SUCCESS;
+        }
+    }
+
+    ReadAheadReset(ReadAhead);
+
+    /* Walk the data blocks until we reach
+       the one containing the offset */
+    CFData = (PCFDATA)(CabinetContext->FileBuffer + Folder->DataOffset);
+    CurrentOffset = 0;
+    for (Index = 0; Index < Folder->DataBlockCount; Index++)
+    {
+        if (CurrentOffset + CFData->UncompSize > Offset)
+            break;
+
+        CurrentOffset += CFData->UncompSize;
+        CFData = (PCFDATA)((PUCHAR)(CFData + 1) + CabinetContext->DataReserved + CFData->CompSize);
+    }
+
+    ReadAhead->Folder = Folder;
+    ReadAhead->NextCFData = CFData;
+    ReadAhead->NextOffset = CurrentOffset;
+    ReadAhead->BlocksLeft = Folder->DataBlockCount - Index;
+    ReadAhead->DataReserved = CabinetContext->DataReserved;
+    RtlCopyMemory(ReadAhead->Codec, CabinetContext->Codec, sizeof(CAB_CODEC));
+
+    /* Without the thread the blocks are decompressed when they are needed */
+    Status = RtlCreateUserThread(NtCurrentProcess(),
+                                 NULL,
+                                 FALSE,
+                                 0,
+                                 0,
+                                 0,
+                                 ReadAheadThread,
+                                 ReadAhead,
+                                 &ReadAhead->Thread,
+                                 NULL);
+    if (!NT_SUCCESS(Status))
+    {
+        DPRINT1("Failed to create the read-ahead thread (Status 0x%08lx)\n", Status);
+        ReadAhead->Thread = NULL;
+    }
+
+    return CAB_STATUS_SUCCESS;
+}
+
+/*
+ * FUNCTION: Returns the oldest decompressed block, waiting for it if needed
+ * ARGUMENTS:
+ *     Block = Address of buffer to place the pointer to the block
+ * RETURNS:
+ *     Status of operation
+ */
+static ULONG
+ReadAheadGetBlock(
+    IN PCAB_READ_AHEAD ReadAhead,
+    OUT PCAB_BLOCK_BUFFER *Block)
+{
+    BOOLEAN Pending;
+
+    for (;;)
+    {
+        RtlEnterCriticalSection(&ReadAhead->Lock);
+        if (ReadAhead->Count > 0)
+        {
+            *Block = &ReadAhead->Blocks[ReadAhead->First];
+            RtlLeaveCriticalSection(&ReadAhead->Lock);
+            break;
+        }
+        Pending = (ReadAhead->BlocksLeft > 0 || ReadAhead->Filling);
+        RtlLeaveCriticalSection(&ReadAhead->Lock);
+
+        if (!Pending)
+        {
+            DPRINT1("File data goes beyond the end of the folder\n");
+            return CAB_STATUS_INVALID_CAB;
+        }
+
+        if (ReadAhead->Thread)
+            NtWaitForSingleObject(ReadAhead->BlockReadyEvent, FALSE, NULL);
+        else
+            ReadAheadFillBlock(ReadAhead);
+    }
+
+    if ((*Block)->Status != CS_SUCCESS)
+    {
+        DPRINT("Cannot uncompress block\n");
+        if ((*Block)->Status == CS_NOMEMORY)
+            return CAB_STATUS_NOMEMORY;
+        return CAB_STATUS_INVALID_CAB;
+    }
+
+    return CAB_STATUS_SUCCESS;
+}
+
+/*
+ * FUNCTION: Frees the oldest block of the ring
+ */
+static VOID
+ReadAheadReleaseBlock(
+    IN PCAB_READ_AHEAD ReadAhead)
+{
+    RtlEnterCriticalSection(&ReadAhead->Lock);
+    ReadAhead->First = (ReadAhead->First + 1) % CAB_READ_AHEAD_BLOCKS;
+    ReadAhead->Count--;
+    RtlLeaveCriticalSection(&ReadAhead->Lock);
+
+    if (ReadAhead->Thread)
+        NtSetEvent(ReadAhead->BlockFreeEvent, NULL);
+}
+
 /*
  * FUNCTION: Closes the current cabinet
  * RETURNS:
@@ -489,6 +864,9 @@ static ULONG
 CloseCabinet(
     IN PCABINET_CONTEXT CabinetContext)
 {
+    /* The read-ahead thread reads the mapped cabinet */
+    ReadAheadDestroy(CabinetContext);
+
     if (CabinetContext->FileBuffer)
     {
         NtUnmapViewOfSection(NtCurrentProcess(), CabinetContext->FileBuffer);
@@ -966,15 +1344,15 @@ CabinetExtractFile(
     IN PCABINET_CONTEXT CabinetContext,
     IN PCAB_SEARCH Search)
 {
-    ULONG Size;                 // remaining file bytes to decompress
+    ULONG Size;                 // remaining file bytes to copy
     ULONG CurrentOffset;        // current uncompressed offset within the folder
-    PUCHAR CurrentBuffer;       // current pointer to compressed data in the block
-    LONG RemainingBlock;        // remaining comp data in the block
+    ULONG Length;
+    ULONG BlockEnd;
+    PCAB_BLOCK_BUFFER Block;    // current decompressed data block
     HANDLE DestFile;
     HANDLE DestFileSection;
     PVOID DestFileBuffer;       // mapped view of dest file
     PVOID CurrentDestBuffer;    // pointer to the current position in the dest view
-    PCFDATA CFData;             // current data block
     ULONG Status;
     FILETIME FileTime;
     WCHAR DestName[MAX_PATH];
@@ -986,9 +1364,7 @@ CabinetExtractFile(
     FILE_BASIC_INFORMATION FileBasic;
     PCFFOLDER CurrentFolder;
     LARGE_INTEGER MaxDestFileSize;
-    LONG InputLength, OutputLength;
     SIZE_T StringLength;
-    char Chunk[512];
 
     if (wcscmp(Search->Cabinet, CabinetContext->CabinetName) != 0)
     {
@@ -1179,100 +1555,41 @@ CabinetExtractFile(
     if (CabinetContext->ExtractHandler != NULL)
         CabinetContext->ExtractHandler(CabinetContext, Search->File, DestName);
 
-    if (Search->CFData)
-        CFData = Search->CFData;
-    else
-        CFData = (PCFDATA)(CabinetContext->CabinetFolders[Search->File->FolderIndex].DataOffset + CabinetContext->FileBuffer);
+    /* Copy the file out of the decompressed blocks of its folder */
+    Status = ReadAheadSeek(CabinetContext, CurrentFolder, Search->File->FileOffset);
+    if (Status != CAB_STATUS_SUCCESS)
+        goto UnmapDestFile;
 
-    CurrentOffset = Search->Offset;
-    while (CurrentOffset + CFData->UncompSize <= Search->File->FileOffset)
-    {
-        /* walk the data blocks until we reach
-           the one containing the start of the file */
-        CurrentOffset += CFData->UncompSize;
-        CFData = (PCFDATA)((char *)(CFData + 1) + CabinetContext->DataReserved + CFData->CompSize);
-    }
-
-    Search->CFData = CFData;
-    Search->Offset = CurrentOffset;
-
-    /* now decompress and discard any data in
-       the block before the start of the file */
-
-    /* start of comp data */
-    CurrentBuffer = ((unsigned char *)(CFData + 1)) + CabinetContext->DataReserved;
-    RemainingBlock = CFData->CompSize;
-    InputLength = RemainingBlock;
-
-    while (CurrentOffset < Search->File->FileOffset)
-    {
-        /* compute remaining uncomp bytes to start
-           of file, bounded by size of chunk */
-        OutputLength = Search->File->FileOffset - CurrentOffset;
-        if (OutputLength > (LONG)sizeof(Chunk))
-            OutputLength = sizeof(Chunk);
-
-        /* negate to signal NOT end of block */
-        OutputLength = -OutputLength;
-
-        CabinetContext->Codec->Uncompress(CabinetContext->Codec,
-                                          Chunk,
-                                          CurrentBuffer,
-                                          &InputLength,
-                                          &OutputLength);
-
-        /* add the uncomp bytes extracted to current folder offset */
-        CurrentOffset += OutputLength;
-        /* add comp bytes consumed to CurrentBuffer */
-        CurrentBuffer += InputLength;
-        /* subtract bytes consumed from bytes remaining in block */
-        RemainingBlock -= InputLength;
-        /* neg for resume decompression of the same block */
-        InputLength = -RemainingBlock;
-    }
-
-    /* now CurrentBuffer points to the first comp byte
-       of the file, so we can begin decompressing */
-
-    /* Size = remaining uncomp bytes of the file to decompress */
+    CurrentOffset = Search->File->FileOffset;
     Size = Search->File->FileSize;
     while (Size > 0)
     {
-        OutputLength = Size;
-        DPRINT("Decompressing block at %x with RemainingBlock = %d, Size = %d\n",
-               CurrentBuffer, RemainingBlock, Size);
-
-        Status = CabinetContext->Codec->Uncompress(CabinetContext->Codec,
-                                                   CurrentDestBuffer,
-                                                   CurrentBuffer,
-                                                   &InputLength,
-                                                   &OutputLength);
-        if (Status != CS_SUCCESS)
-        {
-            DPRINT("Cannot uncompress block\n");
-            if (Status == CS_NOMEMORY)
-                Status = CAB_STATUS_NOMEMORY;
-            Status = CAB_STATUS_INVALID_CAB;
+        Status = ReadAheadGetBlock(CabinetContext->ReadAhead, &Block);
+        if (Status != CAB_STATUS_SUCCESS)
             goto UnmapDestFile;
-        }
 
-        /* advance dest buffer by bytes produced */
-        CurrentDestBuffer = (PVOID)((ULONG_PTR)CurrentDestBuffer + OutputLength);
-        /* advance src buffer by bytes consumed */
-        CurrentBuffer += InputLength;
-        /* reduce remaining file bytes by bytes produced */
-        Size -= OutputLength;
-        /* reduce remaining block size by bytes consumed */
-        RemainingBlock -= InputLength;
-        if (Size > 0 && RemainingBlock == 0)
+        BlockEnd = Block->UncompOffset + Block->Size;
+        if (CurrentOffset >= BlockEnd)
         {
-            /* used up this block, move on to the next */
-            DPRINT("Out of block data\n");
-            CFData = (PCFDATA)CurrentBuffer;
-            RemainingBlock = CFData->CompSize;
-            CurrentBuffer = (unsigned char *)(CFData + 1) + CabinetContext->DataReserved;
-            InputLength = RemainingBlock;
+            /* The block is before the start of the file */
+            ReadAheadReleaseBlock(CabinetContext->ReadAhead);
+            continue;
         }
+
+        Length = min(BlockEnd - CurrentOffset, Size);
+        DPRINT("Copying %u bytes at offset 0x%X of block at 0x%X\n",
+               Length, CurrentOffset, Block->UncompOffset);
+        RtlCopyMemory(CurrentDestBuffer,
+                      &Block->Data[CurrentOffset - Block->UncompOffset],
+                      Length);
+
+        CurrentDestBuffer = (PVOID)((ULONG_PTR)CurrentDestBuffer + Length);
+        CurrentOffset += Length;
+        Size -= Length;
+
+        /* The next file usually starts in the last block of this one */
+        if (CurrentOffset == BlockEnd)
+            ReadAheadReleaseBlock(CabinetContext->ReadAhead);
     }
 
     Status = CAB_STATUS_SUCCESS;
@@ -13,6 +13,7 @@ typedef struct _CFHEADER *PCFHEADER;
 typedef struct _CFFOLDER *PCFFOLDER;
 typedef struct _CFFILE *PCFFILE;
 typedef struct _CFDATA *PCFDATA;
+typedef struct _CAB_READ_AHEAD *PCAB_READ_AHEAD;
 
 struct _CABINET_CONTEXT;
 
@@ -111,6 +112,7 @@ typedef struct _CABINET_CONTEXT
     PCABINET_DISK_CHANGE DiskChangeHandler;
     PCABINET_CREATE_FILE CreateFileHandler;
     PVOID CabinetReservedArea;
+    PCAB_READ_AHEAD ReadAhead;      // Decompressed blocks of the folder being extracted
 } CABINET_CONTEXT, *PCABINET_CONTEXT;
 
 
@@ -18,10 +18,15 @@ else()
 endif()
 
 if(DEFINED EFI_PLATFORM_ID)
+    # The files of the image, laid out at once by the fatten bulk mode
+    file(GENERATE
+         OUTPUT ${CMAKE_CURRENT_BINARY_DIR}/efisys.$<CONFIG>.lst
+         CONTENT "\"$<TARGET_FILE:uefildr>\" EFI/BOOT/boot${EFI_PLATFORM_ID}.efi\n")
+
     add_custom_target(efisys
         COMMAND native-fatten ${CMAKE_CURRENT_BINARY_DIR}/efisys.bin -format 2880 EFIBOOT
             -boot ${CMAKE_CURRENT_BINARY_DIR}/freeldr/bootsect/fat.bin
-            -mkdir EFI -mkdir EFI/BOOT -add $<TARGET_FILE:uefildr> EFI/BOOT/boot${EFI_PLATFORM_ID}.efi
+            -bulk ${CMAKE_CURRENT_BINARY_DIR}/efisys.$<CONFIG>.lst
         DEPENDS native-fatten fat uefildr
         VERBATIM)
 endif()
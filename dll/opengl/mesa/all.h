@@ -111,6 +111,7 @@
 #include "pointers.h"
 #include "points.h"
 #include "polygon.h"
+#include "rastpar.h"
 #include "rastpos.h"
 #include "readpix.h"
 #include "rect.h"
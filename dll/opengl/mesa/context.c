@@ -251,6 +251,7 @@
 #include "points.h"
 #include "pointers.h"
 #include "quads.h"
+#include "rastpar.h"
 #include "stencil.h"
 #include "triangle.h"
 #include "teximage.h"
@@ -1195,6 +1196,7 @@ void gl_destroy_context( GLcontext *ctx )
 
       free( ctx->PB );
       free( ctx->VB );
+      gl_free_bins( ctx );
 
       ctx->Shared->RefCount--;
       assert(ctx->Shared->RefCount>=0);
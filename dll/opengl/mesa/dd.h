@@ -483,6 +483,17 @@ struct dd_function_table {
     * Return GL_FALSE if failure, let core Mesa render the vertex buffer.
     */
 
+   void (*RunBands)( GLcontext *ctx, GLuint count,
+                     void (*func)( GLcontext *ctx, GLuint band ) );
+   /*
+    * If not NULL, core Mesa collects the triangles of a vertex buffer and
+    * rasterizes them in horizontal bands of the color buffer (rastpar.c).
+    * This function must call func(ctx, band) once for each band with
+    * 0 <= band < count and return when all the calls are finished.
+    * The calls may run on several threads at once.  The span functions
+    * are then called concurrently, but never for the same rows.
+    */
+
    /***
     *** Texture mapping functions:
     ***/
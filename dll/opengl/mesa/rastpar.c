@@ -0,0 +1,218 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  2.6
+ * Copyright (C) 1995-1997  Brian Paul
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+/*
+ * Parallel triangle rasterization
+ *
+ * Instead of drawing each triangle of a vertex buffer right away, the
+ * triangles are collected in a bin.  When the vertex buffer is done the
+ * color buffer is split into horizontal bands of BAND_ROWS scan lines and
+ * the device driver's RunBands() function hands the bands out to its
+ * worker threads.  Each band draws, in order, the part of every binned
+ * triangle which falls into its rows, so the result is the same as when
+ * the triangles are drawn one after the other.
+ *
+ * Only the triangle functions which write nothing but the rows they are
+ * given (see BandTriangleFunc in triangle.c) can be binned.
+ */
+
+
+#ifdef PC_HEADER
+#include "all.h"
+#else
+#include <stdlib.h>
+#include "macros.h"
+#include "rastpar.h"
+#include "types.h"
+#include "vb.h"
+#endif
+
+
+
+#define BAND_ROWS 16
+
+/* At most VB_MAX-2 triangles are made from a full vertex buffer */
+#define BIN_SIZE VB_MAX
+
+
+struct gl_band_bin {
+   GLuint Count;
+   GLint Ymin, Ymax;		/* rows touched by all binned triangles */
+   GLint FirstRow;		/* first row of band 0 while drawing */
+   struct {
+      GLuint v0, v1, v2, pv;
+      GLint ymin, ymax;		/* rows touched by this triangle */
+   } Tri[BIN_SIZE];
+};
+
+
+
+/*
+ * Return GL_TRUE if the current triangle function can be binned.
+ */
+GLboolean gl_can_bin_triangles( GLcontext *ctx )
+{
+   if (!ctx->Driver.RunBands || !ctx->BandTriangleFunc) {
+      return GL_FALSE;
+   }
+
+   /* These change the colors or the depth offset from one triangle to
+    * the next, or draw to two buffers.
+    */
+   if (   (ctx->Light.Enabled && ctx->Light.Model.TwoSide)
+       || ctx->Polygon.OffsetAny
+       || ctx->Polygon.Unfilled
+       || (ctx->RasterMask & FRONT_AND_BACK_BIT)) {
+      return GL_FALSE;
+   }
+
+   return GL_TRUE;
+}
+
+
+
+/*
+ * Draw the binned triangles which touch one band.
+ */
+static void render_band( GLcontext *ctx, GLuint band )
+{
+   struct gl_band_bin *bin = ctx->BandBin;
+   GLint ymin = bin->FirstRow + band * BAND_ROWS;
+   GLint ymax = ymin + BAND_ROWS;
+   GLuint i;
+
+   if (ymax > ctx->Buffer->Height) {
+      ymax = ctx->Buffer->Height;
+   }
+
+   for (i=0;i<bin->Count;i++) {
+      if (bin->Tri[i].ymin < ymax && bin->Tri[i].ymax > ymin) {
+         (*ctx->BandTriangleFunc)( ctx, bin->Tri[i].v0, bin->Tri[i].v1,
+                                   bin->Tri[i].v2, bin->Tri[i].pv,
+                                   ymin, ymax );
+      }
+   }
+}
+
+
+
+/*
+ * Draw all binned triangles and empty the bin.  This must be called
+ * before the vertices of the vertex buffer are changed.
+ */
+void gl_flush_bins( GLcontext *ctx )
+{
+   struct gl_band_bin *bin = ctx->BandBin;
+   GLint ymin, ymax;
+   GLuint count;
+
+   if (!bin || bin->Count==0) {
+      return;
+   }
+
+   ymin = MAX2( bin->Ymin, 0 );
+   ymax = MIN2( bin->Ymax, ctx->Buffer->Height );
+
+   if (ymin < ymax) {
+      bin->FirstRow = ymin - ymin % BAND_ROWS;
+      count = (ymax - bin->FirstRow + BAND_ROWS - 1) / BAND_ROWS;
+
+      if (count > 1 && ctx->Driver.RunBands) {
+         (*ctx->Driver.RunBands)( ctx, count, render_band );
+      }
+      else {
+         /* not worth waking up other threads */
+         GLuint i;
+         for (i=0;i<count;i++) {
+            render_band( ctx, i );
+         }
+      }
+   }
+
+   bin->Count = 0;
+}
+
+
+
+/*
+ * Collect a triangle.  Used as ctx->Driver.TriangleFunc.
+ */
+void gl_bin_triangle( GLcontext *ctx,
+                      GLuint v0, GLuint v1, GLuint v2, GLuint pv )
+{
+   struct gl_band_bin *bin = ctx->BandBin;
+   GLfloat (*win)[3] = ctx->VB->Win;
+   GLfloat ymin, ymax;
+   GLuint n;
+
+   if (!bin) {
+      bin = ctx->BandBin = (struct gl_band_bin *) malloc( sizeof(struct gl_band_bin) );
+      if (!bin) {
+         (*ctx->BandTriangleFunc)( ctx, v0, v1, v2, pv,
+                                   0, ctx->Buffer->Height );
+         return;
+      }
+      bin->Count = 0;
+   }
+
+   if (v0 >= VB_MAX || v1 >= VB_MAX || v2 >= VB_MAX) {
+      /* The clipper reuses these vertices for the next polygon */
+      gl_flush_bins( ctx );
+      (*ctx->BandTriangleFunc)( ctx, v0, v1, v2, pv,
+                                0, ctx->Buffer->Height );
+      return;
+   }
+
+   if (bin->Count==BIN_SIZE) {
+      gl_flush_bins( ctx );
+   }
+
+   ymin = MIN2( win[v0][1], MIN2( win[v1][1], win[v2][1] ) );
+   ymax = MAX2( win[v0][1], MAX2( win[v1][1], win[v2][1] ) );
+
+   n = bin->Count++;
+   bin->Tri[n].v0 = v0;
+   bin->Tri[n].v1 = v1;
+   bin->Tri[n].v2 = v2;
+   bin->Tri[n].pv = pv;
+   /* one row of slack on both sides for the sample point rounding */
+   bin->Tri[n].ymin = (GLint) ymin - 1;
+   bin->Tri[n].ymax = (GLint) ymax + 2;
+
+   if (n==0) {
+      bin->Ymin = bin->Tri[n].ymin;
+      bin->Ymax = bin->Tri[n].ymax;
+   }
+   else {
+      bin->Ymin = MIN2( bin->Ymin, bin->Tri[n].ymin );
+      bin->Ymax = MAX2( bin->Ymax, bin->Tri[n].ymax );
+   }
+}
+
+
+
+void gl_free_bins( GLcontext *ctx )
+{
+   if (ctx->BandBin) {
+      free( ctx->BandBin );
+      ctx->BandBin = NULL;
+   }
+}
@@ -0,0 +1,39 @@
+/*
+ * Mesa 3-D graphics library
+ * Version:  2.6
+ * Copyright (C) 1995-1997  Brian Paul
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#ifndef RASTPAR_H
+#define RASTPAR_H
+
+
+#include "types.h"
+
+
+extern GLboolean gl_can_bin_triangles( GLcontext *ctx );
+
+extern void gl_bin_triangle( GLcontext *ctx,
+                             GLuint v0, GLuint v1, GLuint v2, GLuint pv );
+
+extern void gl_flush_bins( GLcontext *ctx );
+
+extern void gl_free_bins( GLcontext *ctx );
+
+
+#endif
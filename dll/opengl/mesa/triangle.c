@@ -131,6 +131,7 @@
 #include "depth.h"
 #include "feedback.h"
 #include "macros.h"
+#include "rastpar.h"
 #include "span.h"
 #include "texstate.h"
 #include "triangle.h"
@@ -321,9 +322,12 @@ static void flat_rgba_triangle( GLcontext *ctx,
 /*
  * Render a smooth-shaded RGBA triangle.
  */
-static void smooth_rgba_triangle( GLcontext *ctx,
-                                  GLuint v0, GLuint v1, GLuint v2, GLuint pv )
+static void smooth_rgba_triangle_band( GLcontext *ctx, GLuint v0, GLuint v1,
+                                       GLuint v2, GLuint pv,
+                                       GLint ymin, GLint ymax )
 {
+#define ROW_MIN ymin
+#define ROW_MAX ymax
 #define INTERP_Z 1
 #define INTERP_RGB 1
 #define INTERP_ALPHA 1
@@ -356,15 +360,24 @@ static void smooth_rgba_triangle( GLcontext *ctx,
 #include "tritemp.h"
 }
 
+static void smooth_rgba_triangle( GLcontext *ctx, GLuint v0, GLuint v1,
+                                  GLuint v2, GLuint pv )
+{
+   smooth_rgba_triangle_band( ctx, v0, v1, v2, pv, 0, ctx->Buffer->Height );
+}
+
 
 
 /*
  * Render an RGB, GL_DECAL, textured triangle.
  * Interpolate S,T only w/out mipmapping or perspective correction.
  */
-static void simple_textured_triangle( GLcontext *ctx, GLuint v0, GLuint v1,
-                                      GLuint v2, GLuint pv )
+static void simple_textured_triangle_band( GLcontext *ctx, GLuint v0, GLuint v1,
+                                           GLuint v2, GLuint pv,
+                                           GLint ymin, GLint ymax )
 {
+#define ROW_MIN ymin
+#define ROW_MAX ymax
 #define INTERP_ST 1
 #define S_SCALE twidth
 #define T_SCALE theight
@@ -402,6 +415,12 @@ static void simple_textured_triangle( GLcontext *ctx, GLuint v0, GLuint v1,
 #include "tritemp.h"
 }
 
+static void simple_textured_triangle( GLcontext *ctx, GLuint v0, GLuint v1,
+                                      GLuint v2, GLuint pv )
+{
+   simple_textured_triangle_band( ctx, v0, v1, v2, pv, 0, ctx->Buffer->Height );
+}
+
 
 
 /*
@@ -409,9 +428,12 @@ static void simple_textured_triangle( GLcontext *ctx, GLuint v0, GLuint v1,
  * Interpolate S,T, GL_LESS depth test, w/out mipmapping or
  * perspective correction.
  */
-static void simple_z_textured_triangle( GLcontext *ctx, GLuint v0, GLuint v1,
-                                      GLuint v2, GLuint pv )
+static void simple_z_textured_triangle_band( GLcontext *ctx, GLuint v0, GLuint v1,
+                                             GLuint v2, GLuint pv,
+                                             GLint ymin, GLint ymax )
 {
+#define ROW_MIN ymin
+#define ROW_MAX ymax
 #define INTERP_Z 1
 #define INTERP_ST 1
 #define S_SCALE twidth
@@ -460,6 +482,12 @@ static void simple_z_textured_triangle( GLcontext *ctx, GLuint v0, GLuint v1,
 #include "tritemp.h"
 }
 
+static void simple_z_textured_triangle( GLcontext *ctx, GLuint v0, GLuint v1,
+                                        GLuint v2, GLuint pv )
+{
+   simple_z_textured_triangle_band( ctx, v0, v1, v2, pv, 0, ctx->Buffer->Height );
+}
+
 
 
 /*
@@ -468,9 +496,12 @@ static void simple_z_textured_triangle( GLcontext *ctx, GLuint v0, GLuint v1,
  * Note: we use texture coordinates S,T,U,V instead of S,T,R,Q because
  * R is already used for red.
  */
-static void general_textured_triangle( GLcontext *ctx, GLuint v0, GLuint v1,
-                                       GLuint v2, GLuint pv )
+static void general_textured_triangle_band( GLcontext *ctx, GLuint v0, GLuint v1,
+                                            GLuint v2, GLuint pv,
+                                            GLint ymin, GLint ymax )
 {
+#define ROW_MIN ymin
+#define ROW_MAX ymax
 #define INTERP_Z 1
 #define INTERP_RGB 1
 #define INTERP_ALPHA 1
@@ -545,6 +576,12 @@ static void general_textured_triangle( GLcontext *ctx, GLuint v0, GLuint v1,
 #include "tritemp.h"
 }
 
+static void general_textured_triangle( GLcontext *ctx, GLuint v0, GLuint v1,
+                                       GLuint v2, GLuint pv )
+{
+   general_textured_triangle_band( ctx, v0, v1, v2, pv, 0, ctx->Buffer->Height );
+}
+
 
 
 /*
@@ -589,9 +626,12 @@ static GLfloat compute_lambda( GLfloat s, GLfloat t,
  * minification or magnification filter.  If minification and using
  * mipmaps, lambda is also used to select the texture level of detail.
  */
-static void lambda_textured_triangle( GLcontext *ctx, GLuint v0, GLuint v1,
-                                      GLuint v2, GLuint pv )
+static void lambda_textured_triangle_band( GLcontext *ctx, GLuint v0, GLuint v1,
+                                           GLuint v2, GLuint pv,
+                                           GLint ymin, GLint ymax )
 {
+#define ROW_MIN ymin
+#define ROW_MAX ymax
 #define INTERP_Z 1
 #define INTERP_RGB 1
 #define INTERP_ALPHA 1
@@ -689,6 +729,12 @@ static void lambda_textured_triangle( GLcontext *ctx, GLuint v0, GLuint v1,
 #include "tritemp.h"
 }
 
+static void lambda_textured_triangle( GLcontext *ctx, GLuint v0, GLuint v1,
+                                      GLuint v2, GLuint pv )
+{
+   lambda_textured_triangle_band( ctx, v0, v1, v2, pv, 0, ctx->Buffer->Height );
+}
+
 
 
 /*
@@ -709,6 +755,8 @@ void gl_set_triangle_function( GLcontext *ctx )
 {
    GLboolean rgbmode = ctx->Visual->RGBAflag;
 
+   ctx->BandTriangleFunc = NULL;
+
    if (ctx->RenderMode==GL_RENDER) {
       if (ctx->NoRaster) {
          ctx->Driver.TriangleFunc = null_triangle;
@@ -739,9 +787,11 @@ void gl_set_triangle_function( GLcontext *ctx )
              && ctx->Visual->EightBitColor) {
             if (ctx->RasterMask==DEPTH_BIT) {
                ctx->Driver.TriangleFunc = simple_z_textured_triangle;
+               ctx->BandTriangleFunc = simple_z_textured_triangle_band;
             }
             else {
                ctx->Driver.TriangleFunc = simple_textured_triangle;
+               ctx->BandTriangleFunc = simple_textured_triangle_band;
             }
          }
          else {
@@ -759,17 +809,23 @@ void gl_set_triangle_function( GLcontext *ctx )
                   needLambda = GL_FALSE;
                }
             }
-            if (needLambda)
+            if (needLambda) {
                ctx->Driver.TriangleFunc = lambda_textured_triangle;
-            else
+               ctx->BandTriangleFunc = lambda_textured_triangle_band;
+            }
+            else {
                ctx->Driver.TriangleFunc = general_textured_triangle;
+               ctx->BandTriangleFunc = general_textured_triangle_band;
+            }
          }
       }
       else {
 	 if (ctx->Light.ShadeModel==GL_SMOOTH) {
 	    /* smooth shaded, no texturing, stippled or some raster ops */
-            if (rgbmode)
+            if (rgbmode) {
                ctx->Driver.TriangleFunc = smooth_rgba_triangle;
+               ctx->BandTriangleFunc = smooth_rgba_triangle_band;
+            }
             else
                ctx->Driver.TriangleFunc = smooth_ci_triangle;
 	 }
@@ -781,6 +837,10 @@ void gl_set_triangle_function( GLcontext *ctx )
                ctx->Driver.TriangleFunc = flat_ci_triangle;
 	 }
       }
+      if (gl_can_bin_triangles( ctx )) {
+         /* collect the triangles and rasterize them in parallel bands */
+         ctx->Driver.TriangleFunc = gl_bin_triangle;
+      }
    }
    else if (ctx->RenderMode==GL_FEEDBACK) {
       ctx->Driver.TriangleFunc = feedback_triangle;
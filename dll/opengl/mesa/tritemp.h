@@ -106,6 +106,10 @@
  *
  * Optionally, one may provide one-time setup code per triangle:
  *    SETUP_CODE    - code which is to be executed once per triangle
+ *
+ * To rasterize only a horizontal band of the triangle, define:
+ *    ROW_MIN, ROW_MAX - only scan lines with ROW_MIN <= Y < ROW_MAX are
+ *                       written (see rastpar.c)
  * 
  * The following macro MUST be defined:
  *    INNER_LOOP(LEFT,RIGHT,Y) - code to write a span of pixels.
@@ -770,6 +774,12 @@
                if (ffi<0) ffi = 0;
 #endif
 
+#ifdef ROW_MAX
+               if (iy >= ROW_MAX) {
+                  return;  /* above the band */
+               }
+               if (iy >= ROW_MIN)
+#endif
                INNER_LOOP( left, right, iy );
 
                /*
@@ -858,6 +868,9 @@
 #undef SETUP_CODE
 #undef INNER_LOOP
 
+#undef ROW_MIN
+#undef ROW_MAX
+
 #undef PIXEL_TYPE
 #undef BYTES_PER_ROW
 #undef PIXEL_ADDRESS
@@ -241,6 +241,10 @@ typedef void (*line_func)( GLcontext *ctx, GLuint v1, GLuint v2, GLuint pv );
 typedef void (*triangle_func)( GLcontext *ctx,
                                GLuint v1, GLuint v2, GLuint v3, GLuint pv );
 
+typedef void (*band_triangle_func)( GLcontext *ctx,
+                                    GLuint v1, GLuint v2, GLuint v3, GLuint pv,
+                                    GLint ymin, GLint ymax );
+
 typedef void (*quad_func)( GLcontext *ctx, GLuint v1, GLuint v2,
                            GLuint v3, GLuint v4, GLuint pv );
 
@@ -1382,6 +1386,10 @@ struct gl_context {
         /* The pixel buffer being used by this context */
         struct pixel_buffer* PB;
 
+        /* Parallel triangle rasterization, see rastpar.c */
+        band_triangle_func BandTriangleFunc; /* draws rows ymin..ymax-1 */
+        struct gl_band_bin* BandBin;	/* triangles waiting to be drawn */
+
 #ifdef PROFILE
         /* Performance measurements */
         GLuint BeginEndCount;	/* number of glBegin/glEnd pairs */
@@ -111,6 +111,7 @@
 #include "macros.h"
 #include "matrix.h"
 #include "pb.h"
+#include "rastpar.h"
 #include "types.h"
 #include "vb.h"
 #include "vbrender.h"
@@ -1137,6 +1138,9 @@ void gl_render_vb( GLcontext *ctx, GLboolean allDone )
          gl_problem( ctx, "invalid mode in gl_render_vb" );
    }
 
+   /* draw the binned triangles before the vertices go away */
+   gl_flush_bins( ctx );
+
    gl_reset_vb( ctx, allDone );
 }
 
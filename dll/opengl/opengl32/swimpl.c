@@ -7,6 +7,8 @@
 
 #include "opengl32.h"
 
+#include <stdlib.h>
+
 /* MESA includes */
 #include <context.h>
 #include <matrix.h>
@@ -16,6 +18,9 @@ WINE_DEFAULT_DEBUG_CHANNEL(opengl32);
 #define WIDTH_BYTES_ALIGN32(cx, bpp) ((((cx) * (bpp) + 31) & ~31) >> 3)
 #define WIDTH_BYTES_ALIGN16(cx, bpp) ((((cx) * (bpp) + 15) & ~15) >> 3)
 
+/* Maximum number of helper threads rasterizing triangles with the application's thread */
+#define SW_MAX_THREADS 7
+
 /* Flags for our pixel formats */
 #define SB_FLAGS            (PFD_DRAW_TO_BITMAP | PFD_SUPPORT_GDI | PFD_SUPPORT_OPENGL | PFD_GENERIC_FORMAT)
 #define SB_FLAGS_WINDOW     (PFD_DRAW_TO_BITMAP | PFD_SUPPORT_GDI | PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_GENERIC_FORMAT)
@@ -268,6 +273,17 @@ struct sw_context
         } u32;
     };
     GLenum Mode;
+
+    /* Worker threads of the band rasterizer, see run_bands */
+    ULONG ThreadCount;
+    HANDLE Threads[SW_MAX_THREADS];
+    HANDLE WorkSemaphore;
+    HANDLE DoneEvent;
+    void (*BandFunc)(GLcontext* ctx, GLuint band);
+    GLuint BandCount;
+    LONG NextBand;
+    LONG PendingWork;
+    BOOL Quit;
 };
 
 /* WGL <-> mesa glue */
@@ -419,6 +435,132 @@ BOOL sw_SetPixelFormat(HDC hdc, struct wgl_dc_data* dc_data, INT format)
     return TRUE;
 }
 
+/* Draws the bands which haven't been taken by another thread yet */
+static void do_bands(struct sw_context* sw_ctx)
+{
+    LONG Band;
+
+    while ((Band = InterlockedIncrement(&sw_ctx->NextBand) - 1) < (LONG)sw_ctx->BandCount)
+        sw_ctx->BandFunc(sw_ctx->gl_ctx, Band);
+}
+
+static DWORD WINAPI band_thread_proc(LPVOID lpParameter)
+{
+    struct sw_context* sw_ctx = lpParameter;
+
+    for (;;)
+    {
+        WaitForSingleObject(sw_ctx->WorkSemaphore, INFINITE);
+        if (sw_ctx->Quit)
+            break;
+
+        do_bands(sw_ctx);
+
+        if (InterlockedDecrement(&sw_ctx->PendingWork) == 0)
+            SetEvent(sw_ctx->DoneEvent);
+    }
+
+    return 0;
+}
+
+static void run_bands(GLcontext* ctx, GLuint count, void (*func)(GLcontext* ctx, GLuint band))
+{
+    struct sw_context* sw_ctx = ctx->DriverCtx;
+    LONG Helpers;
+
+    /* Front buffer spans go through GDI, keep them on this thread */
+    if (sw_ctx->Mode == GL_FRONT)
+    {
+        GLuint i;
+        for (i = 0; i < count; i++)
+            func(ctx, i);
+        return;
+    }
+
+    Helpers = min(sw_ctx->ThreadCount, count - 1);
+
+    sw_ctx->BandFunc = func;
+    sw_ctx->BandCount = count;
+    sw_ctx->NextBand = 0;
+    sw_ctx->PendingWork = Helpers;
+    ReleaseSemaphore(sw_ctx->WorkSemaphore, Helpers, NULL);
+
+    /* Take part in the work, then wait for the helpers to be done */
+    do_bands(sw_ctx);
+    WaitForSingleObject(sw_ctx->DoneEvent, INFINITE);
+}
+
+static void create_band_threads(struct sw_context* sw_ctx)
+{
+    SYSTEM_INFO SystemInfo;
+    ULONG Count, Length, i;
+    CHAR Buffer[16];
+
+    /* 24bpp pixels are written as 32 bit values, which would overlap the next row */
+    if (sw_ctx->fb->pixel_format->cColorBits == 24)
+        return;
+
+    /* MESA_RASTER_THREADS=0 turns this off */
+    Length = GetEnvironmentVariableA("MESA_RASTER_THREADS", Buffer, sizeof(Buffer));
+    if (Length && Length < sizeof(Buffer))
+    {
+        Count = strtoul(Buffer, NULL, 10);
+    }
+    else
+    {
+        GetSystemInfo(&SystemInfo);
+        Count = SystemInfo.dwNumberOfProcessors - 1;
+    }
+    Count = min(Count, SW_MAX_THREADS);
+    if (Count == 0)
+        return;
+
+    sw_ctx->WorkSemaphore = CreateSemaphoreW(NULL, 0, SW_MAX_THREADS, NULL);
+    sw_ctx->DoneEvent = CreateEventW(NULL, FALSE, FALSE, NULL);
+    if (!sw_ctx->WorkSemaphore || !sw_ctx->DoneEvent)
+        goto fail;
+
+    for (i = 0; i < Count; i++)
+    {
+        sw_ctx->Threads[i] = CreateThread(NULL, 0, band_thread_proc, sw_ctx, 0, NULL);
+        if (!sw_ctx->Threads[i])
+            break;
+        sw_ctx->ThreadCount++;
+    }
+
+    if (sw_ctx->ThreadCount)
+    {
+        TRACE("Rasterizing with %lu helper threads.\n", sw_ctx->ThreadCount);
+        return;
+    }
+
+fail:
+    ERR("Failed to set up the rasterizer threads.\n");
+    if (sw_ctx->WorkSemaphore)
+        CloseHandle(sw_ctx->WorkSemaphore);
+    if (sw_ctx->DoneEvent)
+        CloseHandle(sw_ctx->DoneEvent);
+    sw_ctx->WorkSemaphore = sw_ctx->DoneEvent = NULL;
+}
+
+static void destroy_band_threads(struct sw_context* sw_ctx)
+{
+    ULONG i;
+
+    if (!sw_ctx->ThreadCount)
+        return;
+
+    sw_ctx->Quit = TRUE;
+    ReleaseSemaphore(sw_ctx->WorkSemaphore, sw_ctx->ThreadCount, NULL);
+    WaitForMultipleObjects(sw_ctx->ThreadCount, sw_ctx->Threads, TRUE, INFINITE);
+
+    for (i = 0; i < sw_ctx->ThreadCount; i++)
+        CloseHandle(sw_ctx->Threads[i]);
+    CloseHandle(sw_ctx->WorkSemaphore);
+    CloseHandle(sw_ctx->DoneEvent);
+    sw_ctx->ThreadCount = 0;
+}
+
 DHGLRC sw_CreateContext(struct wgl_dc_data* dc_data)
 {
     struct sw_context* sw_ctx;
@@ -442,6 +584,8 @@ DHGLRC sw_CreateContext(struct wgl_dc_data* dc_data)
     /* Choose relevant default */
     sw_ctx->Mode = fb->gl_visual->DBflag ? GL_BACK : GL_FRONT;
 
+    create_band_threads(sw_ctx);
+
     return (DHGLRC)sw_ctx;
 }
 
@@ -453,6 +597,7 @@ BOOL sw_DeleteContext(DHGLRC dhglrc)
     const GLDISPATCHTABLE* table_save = IntGetCurrentDispatchTable();
 
     /* Destroy everything */
+    destroy_band_threads(sw_ctx);
     gl_destroy_context(sw_ctx->gl_ctx);
 
     HeapFree(GetProcessHeap(), 0, sw_ctx);
@@ -1355,6 +1500,7 @@ HANDLE_BPP(32);
 
     ctx->Driver.SetBuffer = set_buffer;
     ctx->Driver.GetBufferSize = buffer_size;
+    ctx->Driver.RunBands = sw_ctx->ThreadCount ? run_bands : NULL;
 
     /* Pixel/span writing functions: */
     ctx->Driver.WriteIndexSpan       = write_index_span;
@@ -19,14 +19,301 @@
 DEBUG_CHANNEL(kernel32file);
 #endif
 
+/* Size and number of the copy buffers. Half of them are being read
+ * while the other half is being written */
+#define COPY_CHUNK_SIZE     0x80000
+#define COPY_CHUNK_COUNT    8
+
+/* Largest range we ask the file system to clone at once */
+#define COPY_CLONE_SIZE     0x40000000
+
+#ifndef COPY_FILE_NO_BUFFERING
+#define COPY_FILE_NO_BUFFERING  0x00001000
+#endif
+
+#ifndef FSCTL_DUPLICATE_EXTENTS_TO_FILE
+#define FSCTL_DUPLICATE_EXTENTS_TO_FILE CTL_CODE(FILE_DEVICE_FILE_SYSTEM, 209, METHOD_BUFFERED, FILE_WRITE_DATA)
+
+typedef struct _DUPLICATE_EXTENTS_DATA
+{
+    HANDLE FileHandle;
+    LARGE_INTEGER SourceFileOffset;
+    LARGE_INTEGER TargetFileOffset;
+    LARGE_INTEGER ByteCount;
+} DUPLICATE_EXTENTS_DATA, *PDUPLICATE_EXTENTS_DATA;
+#endif
+
+typedef struct _COPY_CHUNK
+{
+    HANDLE ReadEvent;
+    HANDLE WriteEvent;
+    IO_STATUS_BLOCK ReadIoStatusBlock;
+    IO_STATUS_BLOCK WriteIoStatusBlock;
+    PUCHAR Buffer;
+    ULONG Length;
+    BOOL ReadPending;
+    BOOL WritePending;
+    BOOL Writing;
+} COPY_CHUNK, *PCOPY_CHUNK;
+
 /* FUNCTIONS ****************************************************************/
 
+static NTSTATUS
+SetEndOfFile64(
+    HANDLE FileHandle,
+    LONGLONG EndOfFile
+)
+{
+    IO_STATUS_BLOCK IoStatusBlock;
+    FILE_END_OF_FILE_INFORMATION EndOfFileInfo;
+
+    EndOfFileInfo.EndOfFile.QuadPart = EndOfFile;
+    return NtSetInformationFile(FileHandle,
+                                &IoStatusBlock,
+                                &EndOfFileInfo,
+                                sizeof(FILE_END_OF_FILE_INFORMATION),
+                                FileEndOfFileInformation);
+}
+
+static BOOL
+GetVolumeSerialNumber(
+    HANDLE FileHandle,
+    PULONG SerialNumber
+)
+{
+    NTSTATUS errCode;
+    IO_STATUS_BLOCK IoStatusBlock;
+    UCHAR Buffer[sizeof(FILE_FS_VOLUME_INFORMATION) + MAX_PATH * sizeof(WCHAR)];
+    PFILE_FS_VOLUME_INFORMATION FsVolume = (PFILE_FS_VOLUME_INFORMATION)Buffer;
+
+    errCode = NtQueryVolumeInformationFile(FileHandle,
+                                           &IoStatusBlock,
+                                           FsVolume,
+                                           sizeof(Buffer),
+                                           FileFsVolumeInformation);
+    if (!NT_SUCCESS(errCode))
+    {
+        return FALSE;
+    }
+
+    *SerialNumber = FsVolume->VolumeSerialNumber;
+    return TRUE;
+}
+
+static BOOL
+SupportsBlockCloning(
+    HANDLE FileHandle
+)
+{
+    NTSTATUS errCode;
+    IO_STATUS_BLOCK IoStatusBlock;
+    UCHAR Buffer[sizeof(FILE_FS_ATTRIBUTE_INFORMATION) + MAX_PATH * sizeof(WCHAR)];
+    PFILE_FS_ATTRIBUTE_INFORMATION FsAttribute = (PFILE_FS_ATTRIBUTE_INFORMATION)Buffer;
+
+    errCode = NtQueryVolumeInformationFile(FileHandle,
+                                           &IoStatusBlock,
+                                           FsAttribute,
+                                           sizeof(Buffer),
+                                           FileFsAttributeInformation);
+    if (!NT_SUCCESS(errCode))
+    {
+        return FALSE;
+    }
+
+    return (FsAttribute->FileSystemAttributes & FILE_SUPPORTS_BLOCK_REFCOUNTING) != 0;
+}
+
+/*
+ * Prepares the destination for block cloning: both files have to live
+ * on the same volume, that volume has to support block refcounting, and
+ * the target has to be as large as the source before the file system
+ * lets us share extents.
+ * Returns the cluster size of the volume, or 0 if cloning can't be used.
+ */
+static ULONG
+CopyPrepareClone(
+    HANDLE FileHandleSource,
+    HANDLE FileHandleDest,
+    LARGE_INTEGER SourceFileSize
+)
+{
+    NTSTATUS errCode;
+    IO_STATUS_BLOCK IoStatusBlock;
+    FILE_FS_SIZE_INFORMATION FsSize;
+    ULONG SourceSerial, DestSerial;
+
+    if (SourceFileSize.QuadPart == 0)
+    {
+        return 0;
+    }
+
+    if (!GetVolumeSerialNumber(FileHandleSource, &SourceSerial) ||
+        !GetVolumeSerialNumber(FileHandleDest, &DestSerial) ||
+        SourceSerial != DestSerial ||
+        !SupportsBlockCloning(FileHandleDest))
+    {
+        return 0;
+    }
+
+    errCode = NtQueryVolumeInformationFile(FileHandleDest,
+                                           &IoStatusBlock,
+                                           &FsSize,
+                                           sizeof(FILE_FS_SIZE_INFORMATION),
+                                           FileFsSizeInformation);
+    if (!NT_SUCCESS(errCode))
+    {
+        return 0;
+    }
+
+    errCode = SetEndOfFile64(FileHandleDest, SourceFileSize.QuadPart);
+    if (!NT_SUCCESS(errCode))
+    {
+        return 0;
+    }
+
+    return FsSize.SectorsPerAllocationUnit * FsSize.BytesPerSector;
+}
+
+/*
+ * Asks the file system to share the extents of the given source range
+ * with the destination (FSCTL_DUPLICATE_EXTENTS_TO_FILE), so no data
+ * has to be read or written. Both offsets are cluster aligned, the
+ * length is rounded up to a cluster as allowed at the end of the file.
+ */
+static NTSTATUS
+CopyCloneChunk(
+    HANDLE FileHandleSource,
+    HANDLE FileHandleDest,
+    LARGE_INTEGER Offset,
+    LONGLONG Length,
+    ULONG ClusterSize
+)
+{
+    IO_STATUS_BLOCK IoStatusBlock;
+    DUPLICATE_EXTENTS_DATA DuplicateExtents;
+
+    DuplicateExtents.FileHandle = FileHandleSource;
+    DuplicateExtents.SourceFileOffset = Offset;
+    DuplicateExtents.TargetFileOffset = Offset;
+    DuplicateExtents.ByteCount.QuadPart = ROUNDUP(Length, (LONGLONG)ClusterSize);
+
+    return NtFsControlFile(FileHandleDest,
+                           NULL,
+                           NULL,
+                           NULL,
+                           &IoStatusBlock,
+                           FSCTL_DUPLICATE_EXTENTS_TO_FILE,
+                           &DuplicateExtents,
+                           sizeof(DuplicateExtents),
+                           NULL,
+                           0);
+}
+
+/*
+ * Starts an asynchronous read of one chunk. The handles are opened for
+ * overlapped I/O, so completion is signalled through the chunk event.
+ */
+static VOID
+CopyStartRead(
+    HANDLE FileHandleSource,
+    PCOPY_CHUNK Chunk,
+    LARGE_INTEGER Offset
+)
+{
+    NTSTATUS errCode;
+
+    errCode = NtReadFile(FileHandleSource,
+                         Chunk->ReadEvent,
+                         NULL,
+                         NULL,
+                         &Chunk->ReadIoStatusBlock,
+                         Chunk->Buffer,
+                         COPY_CHUNK_SIZE,
+                         &Offset,
+                         NULL);
+    Chunk->ReadPending = (errCode == STATUS_PENDING);
+    if (!NT_SUCCESS(errCode))
+    {
+        Chunk->ReadIoStatusBlock.Status = errCode;
+        Chunk->ReadIoStatusBlock.Information = 0;
+    }
+}
+
+static NTSTATUS
+CopyWaitRead(
+    PCOPY_CHUNK Chunk
+)
+{
+    if (Chunk->ReadPending)
+    {
+        NtWaitForSingleObject(Chunk->ReadEvent, FALSE, NULL);
+        Chunk->ReadPending = FALSE;
+    }
+
+    /* With async read, 0 length or STATUS_END_OF_FILE both mean EOF */
+    if (NT_SUCCESS(Chunk->ReadIoStatusBlock.Status) && Chunk->ReadIoStatusBlock.Information == 0)
+    {
+        return STATUS_END_OF_FILE;
+    }
+
+    return Chunk->ReadIoStatusBlock.Status;
+}
+
+static NTSTATUS
+CopyStartWrite(
+    HANDLE FileHandleDest,
+    PCOPY_CHUNK Chunk,
+    ULONG WriteLength,
+    LARGE_INTEGER Offset
+)
+{
+    NTSTATUS errCode;
+
+    errCode = NtWriteFile(FileHandleDest,
+                          Chunk->WriteEvent,
+                          NULL,
+                          NULL,
+                          &Chunk->WriteIoStatusBlock,
+                          Chunk->Buffer,
+                          WriteLength,
+                          &Offset,
+                          NULL);
+    Chunk->WritePending = (errCode == STATUS_PENDING);
+    Chunk->Writing = NT_SUCCESS(errCode);
+
+    return Chunk->Writing ? STATUS_SUCCESS : errCode;
+}
+
+static NTSTATUS
+CopyWaitWrite(
+    PCOPY_CHUNK Chunk
+)
+{
+    if (Chunk->WritePending)
+    {
+        NtWaitForSingleObject(Chunk->WriteEvent, FALSE, NULL);
+        Chunk->WritePending = FALSE;
+    }
+    Chunk->Writing = FALSE;
+
+    return Chunk->WriteIoStatusBlock.Status;
+}
 
+/*
+ * Copies the data through COPY_CHUNK_COUNT buffers used as a ring: the
+ * chunk being handled is written while the reads of the next half of the
+ * ring are still in flight, and a buffer is only read into again once the
+ * write issued from it half a ring earlier has completed.
+ * Reads are always issued at chunk aligned offsets, as the source is
+ * opened unbuffered. A read returning less than a chunk is the end of
+ * the file, no further read is issued after it.
+ */
 static NTSTATUS
 CopyLoop (
     HANDLE			FileHandleSource,
     HANDLE			FileHandleDest,
     LARGE_INTEGER		SourceFileSize,
+    ULONG			WriteAlignment,
     LPPROGRESS_ROUTINE	lpProgressRoutine,
     LPVOID			lpData,
     BOOL			*pbCancel,
@@ -34,27 +321,56 @@ CopyLoop (
 )
 {
     NTSTATUS errCode;
-    IO_STATUS_BLOCK IoStatusBlock;
+    NTSTATUS WriteStatus;
+    COPY_CHUNK Chunk[COPY_CHUNK_COUNT];
+    PCOPY_CHUNK Current, Oldest;
     UCHAR *lpBuffer = NULL;
-    SIZE_T RegionSize = 0x10000;
+    SIZE_T RegionSize = COPY_CHUNK_COUNT * COPY_CHUNK_SIZE;
     LARGE_INTEGER BytesCopied;
+    LARGE_INTEGER ReadOffset;
+    LARGE_INTEGER WriteOffset;
+    ULONG ClusterSize;
+    ULONG WriteLength;
+    ULONG ChunkIndex;
+    ULONG i;
     DWORD CallbackReason;
     DWORD ProgressResult;
     BOOL EndOfFileFound;
+    BOOL ReadStarted;
+    BOOL Truncate;
 
     *KeepDest = FALSE;
+    BytesCopied.QuadPart = 0;
+    ReadOffset.QuadPart = 0;
+    WriteOffset.QuadPart = 0;
+    EndOfFileFound = FALSE;
+    ReadStarted = FALSE;
+    Truncate = FALSE;
+    ChunkIndex = 0;
+    CallbackReason = CALLBACK_STREAM_SWITCH;
+    RtlZeroMemory(Chunk, sizeof(Chunk));
+
+    /* First try to have the file system clone the data for us */
+    ClusterSize = CopyPrepareClone(FileHandleSource, FileHandleDest, SourceFileSize);
+
     errCode = NtAllocateVirtualMemory(NtCurrentProcess(),
                                       (PVOID *)&lpBuffer,
                                       0,
                                       &RegionSize,
                                       MEM_RESERVE | MEM_COMMIT,
                                       PAGE_READWRITE);
+    for (i = 0; i < COPY_CHUNK_COUNT && NT_SUCCESS(errCode); i++)
+    {
+        Chunk[i].Buffer = lpBuffer + i * COPY_CHUNK_SIZE;
+        errCode = NtCreateEvent(&Chunk[i].ReadEvent, EVENT_ALL_ACCESS, NULL, SynchronizationEvent, FALSE);
+        if (NT_SUCCESS(errCode))
+        {
+            errCode = NtCreateEvent(&Chunk[i].WriteEvent, EVENT_ALL_ACCESS, NULL, SynchronizationEvent, FALSE);
+        }
+    }
 
     if (NT_SUCCESS(errCode))
     {
-        BytesCopied.QuadPart = 0;
-        EndOfFileFound = FALSE;
-        CallbackReason = CALLBACK_STREAM_SWITCH;
         while (! EndOfFileFound &&
                 NT_SUCCESS(errCode) &&
                 (NULL == pbCancel || ! *pbCancel))
@@ -90,57 +406,113 @@ CopyLoop (
                 }
                 CallbackReason = CALLBACK_CHUNK_FINISHED;
             }
-            if (NT_SUCCESS(errCode))
+            if (!NT_SUCCESS(errCode))
+            {
+                break;
+            }
+
+            if (ClusterSize != 0)
+            {
+                LONGLONG Length;
+
+                Length = min(SourceFileSize.QuadPart - BytesCopied.QuadPart, COPY_CLONE_SIZE);
+                errCode = CopyCloneChunk(FileHandleSource,
+                                         FileHandleDest,
+                                         BytesCopied,
+                                         Length,
+                                         ClusterSize);
+                if (NT_SUCCESS(errCode))
+                {
+                    BytesCopied.QuadPart += Length;
+                    EndOfFileFound = (BytesCopied.QuadPart >= SourceFileSize.QuadPart);
+                    continue;
+                }
+
+                /* Not supported here, go on copying from where we are */
+                TRACE("Cloning failed with 0x%08x, copying the data\n", errCode);
+                ClusterSize = 0;
+                errCode = SetEndOfFile64(FileHandleDest, BytesCopied.QuadPart);
+                if (!NT_SUCCESS(errCode))
+                {
+                    break;
+                }
+            }
+
+            if (!ReadStarted)
             {
-                errCode = NtReadFile(FileHandleSource,
-                                     NULL,
-                                     NULL,
-                                     NULL,
-                                     (PIO_STATUS_BLOCK)&IoStatusBlock,
-                                     lpBuffer,
-                                     RegionSize,
-                                     NULL,
-                                     NULL);
-                /* With sync read, 0 length + status success mean EOF:
-                 * https://msdn.microsoft.com/en-us/library/windows/desktop/aa365467(v=vs.85).aspx
-                 */
-                if (NT_SUCCESS(errCode) && IoStatusBlock.Information == 0)
+                /* Fill the first half of the ring, the offset is a multiple of the clone size */
+                ReadOffset = BytesCopied;
+                WriteOffset = BytesCopied;
+                for (i = 0; i < COPY_CHUNK_COUNT / 2; i++)
                 {
-                    errCode = STATUS_END_OF_FILE;
+                    CopyStartRead(FileHandleSource, &Chunk[i], ReadOffset);
+                    ReadOffset.QuadPart += COPY_CHUNK_SIZE;
                 }
-                if (NT_SUCCESS(errCode) && (NULL == pbCancel || ! *pbCancel))
+                ReadStarted = TRUE;
+            }
+
+            Current = &Chunk[ChunkIndex % COPY_CHUNK_COUNT];
+            errCode = CopyWaitRead(Current);
+            if (!NT_SUCCESS(errCode))
+            {
+                if (STATUS_END_OF_FILE == errCode)
                 {
-                    errCode = NtWriteFile(FileHandleDest,
-                                          NULL,
-                                          NULL,
-                                          NULL,
-                                          (PIO_STATUS_BLOCK)&IoStatusBlock,
-                                          lpBuffer,
-                                          IoStatusBlock.Information,
-                                          NULL,
-                                          NULL);
-                    if (NT_SUCCESS(errCode))
-                    {
-                        BytesCopied.QuadPart += IoStatusBlock.Information;
-                    }
-                    else
-                    {
-                        WARN("Error 0x%08x reading writing to dest\n", errCode);
-                    }
+                    EndOfFileFound = TRUE;
+                    errCode = STATUS_SUCCESS;
                 }
-                else if (!NT_SUCCESS(errCode))
+                else
                 {
-                    if (STATUS_END_OF_FILE == errCode)
-                    {
-                        EndOfFileFound = TRUE;
-                        errCode = STATUS_SUCCESS;
-                    }
-                    else
-                    {
-                        WARN("Error 0x%08x reading from source\n", errCode);
-                    }
+                    WARN("Error 0x%08x reading from source\n", errCode);
+                }
+                break;
+            }
+
+            /* A short read ends the file, reading on would need an unaligned offset */
+            Current->Length = (ULONG)Current->ReadIoStatusBlock.Information;
+            EndOfFileFound = (Current->Length < COPY_CHUNK_SIZE);
+
+            if (NULL != pbCancel && *pbCancel)
+            {
+                break;
+            }
+
+            /* Unbuffered writes have to cover whole sectors, the file gets truncated afterwards */
+            WriteLength = Current->Length;
+            if (WriteAlignment != 0 && (WriteLength % WriteAlignment) != 0)
+            {
+                WriteLength = ROUND_UP(WriteLength, WriteAlignment);
+                Truncate = TRUE;
+            }
+
+            errCode = CopyStartWrite(FileHandleDest, Current, WriteLength, WriteOffset);
+            if (!NT_SUCCESS(errCode))
+            {
+                WARN("Error 0x%08x reading writing to dest\n", errCode);
+                break;
+            }
+            WriteOffset.QuadPart += Current->Length;
+
+            /* Recycle the buffer written half a ring ago for the next read */
+            if (ChunkIndex >= COPY_CHUNK_COUNT / 2)
+            {
+                Oldest = &Chunk[(ChunkIndex + COPY_CHUNK_COUNT / 2) % COPY_CHUNK_COUNT];
+                errCode = CopyWaitWrite(Oldest);
+                if (!NT_SUCCESS(errCode))
+                {
+                    WARN("Error 0x%08x reading writing to dest\n", errCode);
+                    break;
                 }
+                BytesCopied.QuadPart += Oldest->Length;
+            }
+            if (!EndOfFileFound)
+            {
+                CopyStartRead(FileHandleSource,
+                              &Chunk[(ChunkIndex + COPY_CHUNK_COUNT / 2) % COPY_CHUNK_COUNT],
+                              ReadOffset);
+                ReadOffset.QuadPart += COPY_CHUNK_SIZE;
             }
+
+            ChunkIndex++;
         }
 
         if (! EndOfFileFound && (NULL != pbCancel && *pbCancel))
@@ -148,16 +520,52 @@ CopyLoop (
             TRACE("User requested cancel\n");
             errCode = STATUS_REQUEST_ABORTED;
         }
+    }
+    else
+    {
+        TRACE("Error 0x%08x allocating buffer of %lu bytes\n", errCode, RegionSize);
+    }
+
+    /* Don't release the buffers under a pending read or write */
+    for (i = 0; i < COPY_CHUNK_COUNT; i++)
+    {
+        if (Chunk[i].Writing)
+        {
+            WriteStatus = CopyWaitWrite(&Chunk[i]);
+            if (NT_SUCCESS(errCode) && !NT_SUCCESS(WriteStatus))
+            {
+                WARN("Error 0x%08x reading writing to dest\n", WriteStatus);
+                errCode = WriteStatus;
+            }
+            BytesCopied.QuadPart += Chunk[i].Length;
+        }
+        if (Chunk[i].ReadPending)
+        {
+            NtWaitForSingleObject(Chunk[i].ReadEvent, FALSE, NULL);
+        }
+        if (Chunk[i].ReadEvent != NULL)
+        {
+            NtClose(Chunk[i].ReadEvent);
+        }
+        if (Chunk[i].WriteEvent != NULL)
+        {
+            NtClose(Chunk[i].WriteEvent);
+        }
+    }
+
+    if (NT_SUCCESS(errCode) && Truncate)
+    {
+        errCode = SetEndOfFile64(FileHandleDest, BytesCopied.QuadPart);
+    }
 
+    if (lpBuffer != NULL)
+    {
+        RegionSize = 0;
         NtFreeVirtualMemory(NtCurrentProcess(),
                             (PVOID *)&lpBuffer,
                             &RegionSize,
                             MEM_RELEASE);
     }
-    else
-    {
-        TRACE("Error 0x%08x allocating buffer of %lu bytes\n", errCode, RegionSize);
-    }
 
     return errCode;
 }
@@ -217,13 +625,14 @@ BasepCopyFileExW(IN LPCWSTR lpExistingFileName,
     BOOL RC = FALSE;
     BOOL KeepDestOnError = FALSE;
     DWORD SystemError;
+    ULONG WriteAlignment;
 
     FileHandleSource = CreateFileW(lpExistingFileName,
                                    GENERIC_READ,
                                    FILE_SHARE_READ | FILE_SHARE_WRITE,
                                    NULL,
                                    OPEN_EXISTING,
-                                   FILE_ATTRIBUTE_NORMAL|FILE_FLAG_NO_BUFFERING,
+                                   FILE_ATTRIBUTE_NORMAL|FILE_FLAG_NO_BUFFERING|FILE_FLAG_OVERLAPPED,
                                    NULL);
     if (INVALID_HANDLE_VALUE != FileHandleSource)
     {
@@ -254,14 +663,29 @@ BasepCopyFileExW(IN LPCWSTR lpExistingFileName,
                                              GENERIC_WRITE,
                                              FILE_SHARE_WRITE,
                                              NULL,
-                                             dwCopyFlags ? CREATE_NEW : CREATE_ALWAYS,
-                                             FileBasic.FileAttributes,
+                                             (dwCopyFlags & COPY_FILE_FAIL_IF_EXISTS) ? CREATE_NEW : CREATE_ALWAYS,
+                                             FileBasic.FileAttributes | FILE_FLAG_OVERLAPPED |
+                                             ((dwCopyFlags & COPY_FILE_NO_BUFFERING) ? FILE_FLAG_NO_BUFFERING : 0),
                                              NULL);
                 if (INVALID_HANDLE_VALUE != FileHandleDest)
                 {
+                    WriteAlignment = 0;
+                    if (dwCopyFlags & COPY_FILE_NO_BUFFERING)
+                    {
+                        FILE_FS_SIZE_INFORMATION FsSize;
+
+                        errCode = NtQueryVolumeInformationFile(FileHandleDest,
+                                                               &IoStatusBlock,
+                                                               &FsSize,
+                                                               sizeof(FILE_FS_SIZE_INFORMATION),
+                                                               FileFsSizeInformation);
+                        WriteAlignment = NT_SUCCESS(errCode) ? FsSize.BytesPerSector : PAGE_SIZE;
+                    }
+
                     errCode = CopyLoop(FileHandleSource,
                                        FileHandleDest,
                                        FileStandard.EndOfFile,
+                                       WriteAlignment,
                                        lpProgressRoutine,
                                        lpData,
                                        pbCancel,
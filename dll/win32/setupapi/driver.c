@@ -711,6 +711,585 @@ RegGetValueW( HKEY hKey, LPCWSTR pszSubKey, LPCWSTR pszValue,
 }
 #endif /* End of code copied from advapi32/reg/reg.c */
 
+/***********************************************************************
+ *		Device ID index of the system INF directory
+ *
+ * The index remembers which device IDs the models of each INF file of
+ * %SystemRoot%\inf contain, so that building a compatible driver list only
+ * opens the INF files which can match. An entry is only trusted as long as
+ * the size and last write time of its INF file don't change. INF files
+ * without a valid entry are opened as before, and indexed on the way.
+ */
+
+#define INF_INDEX_MAGIC     0x58444e49 /* "INDX" */
+#define INF_INDEX_VERSION   1
+#define INF_INDEX_BUCKETS   512
+
+static const WCHAR InfIndexFileName[] = {'i','n','f','i','n','d','e','x','.','d','a','t',0};
+static const WCHAR InfIndexTempFileName[] = {'i','n','f','i','n','d','e','x','.','t','m','p',0};
+static const WCHAR InfFileSpecification[] = {'*','.','i','n','f',0};
+
+/* The index file is an INF_INDEX_HEADER followed by the entries. Each entry
+ * is an INF_INDEX_ENTRY_HEADER followed by the INF file name and the device
+ * IDs of its models as a MULTI_SZ, padded to a DWORD boundary. */
+typedef struct _INF_INDEX_HEADER
+{
+    DWORD Magic;
+    DWORD Version;
+    DWORD EntryCount;
+} INF_INDEX_HEADER;
+
+typedef struct _INF_INDEX_ENTRY_HEADER
+{
+    DWORD cbSize;
+    DWORD nFileSizeLow;
+    DWORD nFileSizeHigh;
+    FILETIME ftLastWriteTime;
+} INF_INDEX_ENTRY_HEADER;
+
+struct InfIndexId
+{
+    LIST_ENTRY ListEntry;           /* in InfIndex.IdBuckets */
+    LPCWSTR Id;
+    struct InfIndexEntry *Entry;
+};
+
+struct InfIndexEntry
+{
+    LIST_ENTRY ListEntry;           /* in InfIndex.NameBuckets */
+    BOOL Seen;                      /* the INF file is still there */
+    BOOL Matched;                   /* its models contain one of the searched IDs */
+    LPWSTR Ids;                     /* NULL until the INF file has been read */
+    struct InfIndexId *IdNodes;
+    DWORD nFileSizeLow;
+    DWORD nFileSizeHigh;
+    FILETIME ftLastWriteTime;
+    WCHAR FileName[ANYSIZE_ARRAY];
+};
+
+struct InfIndex
+{
+    BOOL Dirty;
+    LIST_ENTRY NameBuckets[INF_INDEX_BUCKETS];
+    LIST_ENTRY IdBuckets[INF_INDEX_BUCKETS];
+};
+
+static ULONG
+HashInfIndexString(
+    IN LPCWSTR String)
+{
+    ULONG Hash = 0;
+
+    while (*String)
+        Hash = Hash * 31 + toupperW(*String++);
+    return Hash % INF_INDEX_BUCKETS;
+}
+
+static struct InfIndexEntry *
+FindInfIndexEntry(
+    IN struct InfIndex *Index,
+    IN LPCWSTR FileName)
+{
+    PLIST_ENTRY Bucket, ListEntry;
+    struct InfIndexEntry *Entry;
+
+    Bucket = &Index->NameBuckets[HashInfIndexString(FileName)];
+    for (ListEntry = Bucket->Flink; ListEntry != Bucket; ListEntry = ListEntry->Flink)
+    {
+        Entry = CONTAINING_RECORD(ListEntry, struct InfIndexEntry, ListEntry);
+        if (strcmpiW(Entry->FileName, FileName) == 0)
+            return Entry;
+    }
+    return NULL;
+}
+
+static struct InfIndexEntry *
+AddInfIndexEntry(
+    IN struct InfIndex *Index,
+    IN LPCWSTR FileName)
+{
+    struct InfIndexEntry *Entry;
+
+    Entry = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY,
+        FIELD_OFFSET(struct InfIndexEntry, FileName) + (strlenW(FileName) + 1) * sizeof(WCHAR));
+    if (!Entry)
+        return NULL;
+    strcpyW(Entry->FileName, FileName);
+    InsertTailList(&Index->NameBuckets[HashInfIndexString(FileName)], &Entry->ListEntry);
+    return Entry;
+}
+
+/* Makes the device IDs of an entry searchable */
+static BOOL
+SetInfIndexEntryIds(
+    IN struct InfIndex *Index,
+    IN struct InfIndexEntry *Entry,
+    IN LPWSTR Ids)
+{
+    LPCWSTR Id;
+    ULONG Count = 0;
+
+    for (Id = Ids; *Id; Id += strlenW(Id) + 1)
+        Count++;
+
+    Entry->IdNodes = HeapAlloc(GetProcessHeap(), 0, max(Count, 1) * sizeof(struct InfIndexId));
+    if (!Entry->IdNodes)
+        return FALSE;
+
+    for (Id = Ids, Count = 0; *Id; Id += strlenW(Id) + 1, Count++)
+    {
+        Entry->IdNodes[Count].Id = Id;
+        Entry->IdNodes[Count].Entry = Entry;
+        InsertTailList(&Index->IdBuckets[HashInfIndexString(Id)], &Entry->IdNodes[Count].ListEntry);
+    }
+    Entry->Ids = Ids;
+    return TRUE;
+}
+
+static VOID
+ClearInfIndexEntryIds(
+    IN struct InfIndexEntry *Entry)
+{
+    LPCWSTR Id;
+    ULONG i;
+
+    if (!Entry->Ids)
+        return;
+    if (Entry->IdNodes)
+    {
+        for (Id = Entry->Ids, i = 0; *Id; Id += strlenW(Id) + 1, i++)
+            RemoveEntryList(&Entry->IdNodes[i].ListEntry);
+        HeapFree(GetProcessHeap(), 0, Entry->IdNodes);
+    }
+    HeapFree(GetProcessHeap(), 0, Entry->Ids);
+    Entry->IdNodes = NULL;
+    Entry->Ids = NULL;
+}
+
+static VOID
+FreeInfIndex(
+    IN struct InfIndex *Index)
+{
+    struct InfIndexEntry *Entry;
+    ULONG i;
+
+    for (i = 0; i < INF_INDEX_BUCKETS; i++)
+    {
+        while (!IsListEmpty(&Index->NameBuckets[i]))
+        {
+            Entry = CONTAINING_RECORD(RemoveHeadList(&Index->NameBuckets[i]), struct InfIndexEntry, ListEntry);
+            ClearInfIndexEntryIds(Entry);
+            HeapFree(GetProcessHeap(), 0, Entry);
+        }
+    }
+    HeapFree(GetProcessHeap(), 0, Index);
+}
+
+/* Returns the length in characters of a MULTI_SZ, both terminating NULL
+ * characters included, or 0 if it doesn't end before Max characters */
+static SIZE_T
+GetMultiSzLength(
+    IN LPCWSTR MultiSz,
+    IN SIZE_T Max)
+{
+    SIZE_T Length = 0;
+
+    while (Length < Max)
+    {
+        if (MultiSz[Length] == UNICODE_NULL)
+            return Length + 1;
+        while (Length < Max && MultiSz[Length] != UNICODE_NULL)
+            Length++;
+        Length++;
+    }
+    return 0;
+}
+
+/* Reads the index file. A missing or damaged file gives an empty index. */
+static struct InfIndex *
+LoadInfIndex(
+    IN LPWSTR InfDirectoryPath)
+{
+    struct InfIndex *Index;
+    struct InfIndexEntry *Entry;
+    INF_INDEX_HEADER *Header;
+    INF_INDEX_ENTRY_HEADER *EntryHeader;
+    LPWSTR FileName, Ids, IdsCopy;
+    SIZE_T NameLength, IdsLength, MaxLength;
+    HANDLE hFile;
+    PBYTE Buffer = NULL, Pos, End;
+    DWORD Size, Read, i;
+    LPWSTR pFileName = &InfDirectoryPath[strlenW(InfDirectoryPath)];
+
+    Index = HeapAlloc(GetProcessHeap(), 0, sizeof(struct InfIndex));
+    if (!Index)
+        return NULL;
+    Index->Dirty = FALSE;
+    for (i = 0; i < INF_INDEX_BUCKETS; i++)
+    {
+        InitializeListHead(&Index->NameBuckets[i]);
+        InitializeListHead(&Index->IdBuckets[i]);
+    }
+
+    strcpyW(pFileName, InfIndexFileName);
+    hFile = CreateFileW(InfDirectoryPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+    *pFileName = UNICODE_NULL;
+    if (hFile == INVALID_HANDLE_VALUE)
+        return Index;
+
+    Size = GetFileSize(hFile, NULL);
+    if (Size != INVALID_FILE_SIZE && Size >= sizeof(INF_INDEX_HEADER))
+        Buffer = HeapAlloc(GetProcessHeap(), 0, Size);
+    if (!Buffer || !ReadFile(hFile, Buffer, Size, &Read, NULL) || Read != Size)
+        goto done;
+
+    Header = (INF_INDEX_HEADER *)Buffer;
+    if (Header->Magic != INF_INDEX_MAGIC || Header->Version != INF_INDEX_VERSION)
+        goto done;
+
+    Pos = Buffer + sizeof(INF_INDEX_HEADER);
+    End = Buffer + Size;
+    for (i = 0; i < Header->EntryCount; i++)
+    {
+        EntryHeader = (INF_INDEX_ENTRY_HEADER *)Pos;
+        if ((SIZE_T)(End - Pos) < sizeof(INF_INDEX_ENTRY_HEADER) ||
+            EntryHeader->cbSize < sizeof(INF_INDEX_ENTRY_HEADER) ||
+            EntryHeader->cbSize > (SIZE_T)(End - Pos))
+        {
+            WARN("Damaged INF index\n");
+            break;
+        }
+
+        /* The file name and the IDs must end inside the entry */
+        FileName = (LPWSTR)(EntryHeader + 1);
+        MaxLength = (EntryHeader->cbSize - sizeof(INF_INDEX_ENTRY_HEADER)) / sizeof(WCHAR);
+        for (NameLength = 0; NameLength < MaxLength && FileName[NameLength]; NameLength++)
+            ;
+        if (NameLength == 0 || NameLength >= MaxLength)
+        {
+            WARN("Damaged INF index\n");
+            break;
+        }
+        Ids = FileName + NameLength + 1;
+        IdsLength = GetMultiSzLength(Ids, MaxLength - NameLength - 1);
+        if (IdsLength == 0)
+        {
+            WARN("Damaged INF index\n");
+            break;
+        }
+        Pos += EntryHeader->cbSize;
+
+        if (FindInfIndexEntry(Index, FileName))
+            continue;
+        IdsCopy = HeapAlloc(GetProcessHeap(), 0, IdsLength * sizeof(WCHAR));
+        Entry = IdsCopy ? AddInfIndexEntry(Index, FileName) : NULL;
+        if (!Entry)
+        {
+            HeapFree(GetProcessHeap(), 0, IdsCopy);
+            break;
+        }
+        memcpy(IdsCopy, Ids, IdsLength * sizeof(WCHAR));
+        Entry->nFileSizeLow = EntryHeader->nFileSizeLow;
+        Entry->nFileSizeHigh = EntryHeader->nFileSizeHigh;
+        Entry->ftLastWriteTime = EntryHeader->ftLastWriteTime;
+        if (!SetInfIndexEntryIds(Index, Entry, IdsCopy))
+        {
+            HeapFree(GetProcessHeap(), 0, IdsCopy);
+            break;
+        }
+    }
+
+done:
+    HeapFree(GetProcessHeap(), 0, Buffer);
+    CloseHandle(hFile);
+    return Index;
+}
+
+/* Writes the entries of the INF files that still exist, if anything changed */
+static VOID
+SaveInfIndex(
+    IN struct InfIndex *Index,
+    IN LPWSTR InfDirectoryPath)
+{
+    struct InfIndexEntry *Entry;
+    PLIST_ENTRY ListEntry;
+    INF_INDEX_HEADER Header;
+    INF_INDEX_ENTRY_HEADER EntryHeader;
+    WCHAR IndexFileName[MAX_PATH];
+    SIZE_T NameLength, IdsLength;
+    HANDLE hFile;
+    DWORD Written, Padding = 0;
+    BOOL ret = TRUE;
+    ULONG i;
+
+    Header.Magic = INF_INDEX_MAGIC;
+    Header.Version = INF_INDEX_VERSION;
+    Header.EntryCount = 0;
+    for (i = 0; i < INF_INDEX_BUCKETS; i++)
+    {
+        for (ListEntry = Index->NameBuckets[i].Flink; ListEntry != &Index->NameBuckets[i]; ListEntry = ListEntry->Flink)
+        {
+            Entry = CONTAINING_RECORD(ListEntry, struct InfIndexEntry, ListEntry);
+            if (!Entry->Seen)
+                Index->Dirty = TRUE;
+            else if (Entry->Ids)
+                Header.EntryCount++;
+        }
+    }
+    if (!Index->Dirty)
+        return;
+
+    if (strlenW(InfDirectoryPath) + strlenW(InfIndexTempFileName) >= MAX_PATH)
+        return;
+    strcpyW(IndexFileName, InfDirectoryPath);
+    strcatW(IndexFileName, InfIndexTempFileName);
+
+    hFile = CreateFileW(IndexFileName, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        TRACE("Unable to create %s (error %lu)\n", debugstr_w(IndexFileName), GetLastError());
+        return;
+    }
+
+    ret = WriteFile(hFile, &Header, sizeof(Header), &Written, NULL);
+    for (i = 0; ret && i < INF_INDEX_BUCKETS; i++)
+    {
+        for (ListEntry = Index->NameBuckets[i].Flink; ret && ListEntry != &Index->NameBuckets[i]; ListEntry = ListEntry->Flink)
+        {
+            Entry = CONTAINING_RECORD(ListEntry, struct InfIndexEntry, ListEntry);
+            if (!Entry->Seen || !Entry->Ids)
+                continue;
+
+            NameLength = strlenW(Entry->FileName) + 1;
+            IdsLength = GetMultiSzLength(Entry->Ids, ~(SIZE_T)0);
+            EntryHeader.cbSize = sizeof(EntryHeader) + (((NameLength + IdsLength) * sizeof(WCHAR) + 3) & ~3);
+            EntryHeader.nFileSizeLow = Entry->nFileSizeLow;
+            EntryHeader.nFileSizeHigh = Entry->nFileSizeHigh;
+            EntryHeader.ftLastWriteTime = Entry->ftLastWriteTime;
+            ret = WriteFile(hFile, &EntryHeader, sizeof(EntryHeader), &Written, NULL) &&
+                  WriteFile(hFile, Entry->FileName, NameLength * sizeof(WCHAR), &Written, NULL) &&
+                  WriteFile(hFile, Entry->Ids, IdsLength * sizeof(WCHAR), &Written, NULL) &&
+                  WriteFile(hFile, &Padding, EntryHeader.cbSize - sizeof(EntryHeader) - (NameLength + IdsLength) * sizeof(WCHAR), &Written, NULL);
+        }
+    }
+    CloseHandle(hFile);
+
+    if (ret)
+    {
+        WCHAR TargetFileName[MAX_PATH];
+
+        strcpyW(TargetFileName, InfDirectoryPath);
+        strcatW(TargetFileName, InfIndexFileName);
+        ret = MoveFileExW(IndexFileName, TargetFileName, MOVEFILE_REPLACE_EXISTING);
+    }
+    if (!ret)
+        DeleteFileW(IndexFileName);
+}
+
+/* Returns the device IDs of all models of an INF file as a MULTI_SZ, or
+ * NULL if they couldn't all be read */
+static LPWSTR
+GetInfModelIds(
+    IN HINF hInf)
+{
+    INFCONTEXT ContextManufacturer, ContextDevice;
+    WCHAR ManufacturerSection[LINE_LEN + 1];
+    WCHAR DeviceId[LINE_LEN + 1];
+    LPWSTR Ids, NewIds;
+    SIZE_T Length = 0, Allocated = 256;
+    DWORD RequiredSize, FieldCount, i;
+    BOOL Result;
+
+    Ids = HeapAlloc(GetProcessHeap(), 0, Allocated * sizeof(WCHAR));
+    if (!Ids)
+        return NULL;
+
+    Result = SetupFindFirstLineW(hInf, INF_MANUFACTURER, NULL, &ContextManufacturer);
+    while (Result)
+    {
+        /* Same lookup of the models section as in SetupDiBuildDriverInfoList */
+        Result = SetupGetStringFieldW(&ContextManufacturer, 1, ManufacturerSection, LINE_LEN, &RequiredSize);
+        if (Result)
+        {
+            ManufacturerSection[RequiredSize] = 0;
+            Result = SetupDiGetActualSectionToInstallW(hInf, ManufacturerSection, ManufacturerSection, LINE_LEN, NULL, NULL);
+            if (Result)
+                Result = SetupFindFirstLineW(hInf, ManufacturerSection, NULL, &ContextDevice);
+        }
+        while (Result)
+        {
+            FieldCount = SetupGetFieldCount(&ContextDevice);
+            for (i = 2; i <= FieldCount; i++)
+            {
+                if (!SetupGetStringFieldW(&ContextDevice, i, DeviceId, LINE_LEN + 1, &RequiredSize))
+                {
+                    /* Don't index what may be incomplete */
+                    HeapFree(GetProcessHeap(), 0, Ids);
+                    return NULL;
+                }
+                if (!*DeviceId)
+                    continue;
+                if (Length + RequiredSize + 1 > Allocated)
+                {
+                    Allocated = (Length + RequiredSize + 1) * 2;
+                    NewIds = HeapReAlloc(GetProcessHeap(), 0, Ids, Allocated * sizeof(WCHAR));
+                    if (!NewIds)
+                    {
+                        HeapFree(GetProcessHeap(), 0, Ids);
+                        return NULL;
+                    }
+                    Ids = NewIds;
+                }
+                strcpyW(&Ids[Length], DeviceId);
+                Length += RequiredSize;
+            }
+            Result = SetupFindNextLine(&ContextDevice, &ContextDevice);
+        }
+        Result = SetupFindNextLine(&ContextManufacturer, &ContextManufacturer);
+    }
+
+    Ids[Length] = UNICODE_NULL;
+    return Ids;
+}
+
+/* Records the device IDs of an INF file that had no valid entry. hInf is
+ * NULL if the file can't provide any driver. */
+static VOID
+UpdateInfIndex(
+    IN struct InfIndex *Index,
+    IN LPCWSTR FileName,
+    IN HINF hInf OPTIONAL)
+{
+    struct InfIndexEntry *Entry;
+    LPWSTR Ids;
+
+    Entry = FindInfIndexEntry(Index, FileName);
+    if (!Entry || Entry->Ids)
+        return;
+
+    if (hInf)
+        Ids = GetInfModelIds(hInf);
+    else
+        Ids = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(WCHAR));
+    if (!Ids)
+        return;
+
+    /* Only used by the next search, no need to make it searchable */
+    Entry->Ids = Ids;
+    Index->Dirty = TRUE;
+}
+
+/* Lists the INF files of the system INF directory which must be opened to
+ * find the drivers for these IDs: those whose models contain one of them,
+ * and those the index doesn't know (yet). */
+static BOOL
+GetIndexedInfFileList(
+    IN struct InfIndex *Index,
+    IN LPWSTR InfDirectoryPath,
+    IN LPCWSTR HardwareIDs OPTIONAL,
+    IN LPCWSTR CompatibleIDs OPTIONAL,
+    OUT LPWSTR *pBuffer)
+{
+    struct InfIndexEntry *Entry;
+    struct InfIndexId *IdNode;
+    PLIST_ENTRY Bucket, ListEntry;
+    WIN32_FIND_DATAW wfdFileInfo;
+    LPCWSTR IdLists[2] = { HardwareIDs, CompatibleIDs };
+    LPCWSTR currentId;
+    LPWSTR Buffer, NewBuffer;
+    SIZE_T Length = 0, Allocated = 4096, NameLength;
+    HANDLE hSearch;
+    LPWSTR pFileName = &InfDirectoryPath[strlenW(InfDirectoryPath)];
+    ULONG i;
+
+    /* Look up the IDs in the index */
+    for (i = 0; i < sizeof(IdLists) / sizeof(IdLists[0]); i++)
+    {
+        if (!IdLists[i])
+            continue;
+        for (currentId = IdLists[i]; *currentId; currentId += strlenW(currentId) + 1)
+        {
+            Bucket = &Index->IdBuckets[HashInfIndexString(currentId)];
+            for (ListEntry = Bucket->Flink; ListEntry != Bucket; ListEntry = ListEntry->Flink)
+            {
+                IdNode = CONTAINING_RECORD(ListEntry, struct InfIndexId, ListEntry);
+                if (strcmpiW(IdNode->Id, currentId) == 0)
+                    IdNode->Entry->Matched = TRUE;
+            }
+        }
+    }
+
+    Buffer = HeapAlloc(GetProcessHeap(), 0, Allocated * sizeof(WCHAR));
+    if (!Buffer)
+    {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return FALSE;
+    }
+
+    strcpyW(pFileName, InfFileSpecification);
+    hSearch = FindFirstFileW(InfDirectoryPath, &wfdFileInfo);
+    *pFileName = UNICODE_NULL;
+    if (hSearch == INVALID_HANDLE_VALUE)
+    {
+        HeapFree(GetProcessHeap(), 0, Buffer);
+        return FALSE;
+    }
+
+    do
+    {
+        if (wfdFileInfo.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+
+        Entry = FindInfIndexEntry(Index, wfdFileInfo.cFileName);
+        if (Entry && Entry->Ids &&
+            Entry->nFileSizeLow == wfdFileInfo.nFileSizeLow &&
+            Entry->nFileSizeHigh == wfdFileInfo.nFileSizeHigh &&
+            CompareFileTime(&Entry->ftLastWriteTime, &wfdFileInfo.ftLastWriteTime) == 0)
+        {
+            Entry->Seen = TRUE;
+            if (!Entry->Matched)
+                continue;
+        }
+        else
+        {
+            /* New or modified INF file, it has to be read again */
+            if (!Entry)
+                Entry = AddInfIndexEntry(Index, wfdFileInfo.cFileName);
+            if (Entry)
+            {
+                ClearInfIndexEntryIds(Entry);
+                Entry->Seen = TRUE;
+                Entry->nFileSizeLow = wfdFileInfo.nFileSizeLow;
+                Entry->nFileSizeHigh = wfdFileInfo.nFileSizeHigh;
+                Entry->ftLastWriteTime = wfdFileInfo.ftLastWriteTime;
+            }
+        }
+
+        NameLength = strlenW(wfdFileInfo.cFileName) + 1;
+        if (Length + NameLength + 1 > Allocated)
+        {
+            Allocated = (Length + NameLength + 1) * 2;
+            NewBuffer = HeapReAlloc(GetProcessHeap(), 0, Buffer, Allocated * sizeof(WCHAR));
+            if (!NewBuffer)
+            {
+                FindClose(hSearch);
+                HeapFree(GetProcessHeap(), 0, Buffer);
+                SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+                return FALSE;
+            }
+            Buffer = NewBuffer;
+        }
+        strcpyW(&Buffer[Length], wfdFileInfo.cFileName);
+        Length += NameLength;
+    }
+    while (FindNextFileW(hSearch, &wfdFileInfo));
+
+    FindClose(hSearch);
+    Buffer[Length] = UNICODE_NULL;
+    *pBuffer = Buffer;
+    return TRUE;
+}
+
 /***********************************************************************
  *		SetupDiBuildDriverInfoList (SETUPAPI.@)
  */
@@ -731,6 +1310,8 @@ SetupDiBuildDriverInfoList(
     LPWSTR CompatibleIDs = NULL;
     LPWSTR FullInfFileName = NULL;
     LPWSTR ExcludeFromSelect = NULL;
+    struct InfIndex *InfIndex = NULL;
+    WCHAR InfIndexDirectory[MAX_PATH];
     FILETIME DriverDate;
     DWORDLONG DriverVersion = 0;
     DWORD RequiredSize;
@@ -884,11 +1465,27 @@ SetupDiBuildDriverInfoList(
         }
         else
         {
+            if (DriverType == SPDIT_COMPATDRIVER && !*InstallParams.DriverPath)
+            {
+                /* Only open the .inf files of %SYSTEMROOT%\inf which may contain these IDs */
+                RequiredSize = GetSystemWindowsDirectoryW(InfIndexDirectory, MAX_PATH);
+                if (RequiredSize != 0 &&
+                    RequiredSize + 1 + strlenW(InfDirectory) + strlenW(InfIndexTempFileName) < MAX_PATH)
+                {
+                    if (*InfIndexDirectory && InfIndexDirectory[strlenW(InfIndexDirectory) - 1] != '\\')
+                        strcatW(InfIndexDirectory, BackSlash);
+                    strcatW(InfIndexDirectory, InfDirectory);
+                    InfIndex = LoadInfIndex(InfIndexDirectory);
+                }
+            }
+
             /* Enumerate .inf files */
             Result = FALSE;
             RequiredSize = 32768; /* Initial buffer size */
             SetLastError(ERROR_INSUFFICIENT_BUFFER);
-            while (!Result && GetLastError() == ERROR_INSUFFICIENT_BUFFER)
+            if (InfIndex)
+                Result = GetIndexedInfFileList(InfIndex, InfIndexDirectory, HardwareIDs, CompatibleIDs, (LPWSTR *)&Buffer);
+            else while (!Result && GetLastError() == ERROR_INSUFFICIENT_BUFFER)
             {
                 HeapFree(GetProcessHeap(), 0, Buffer);
                 Buffer = HeapAlloc(GetProcessHeap(), 0, RequiredSize * sizeof(WCHAR));
@@ -972,7 +1569,12 @@ SetupDiBuildDriverInfoList(
 
                 currentInfFileDetails = CreateInfFileDetails(FullInfFileName);
                 if (!currentInfFileDetails)
+                {
+                    /* Not a driver .inf file, don't open it again */
+                    if (InfIndex && GetLastError() == ERROR_WRONG_INF_STYLE)
+                        UpdateInfIndex(InfIndex, filename, NULL);
                     continue;
+                }
 
                 if (!GetVersionInformationFromInfFile(
                     currentInfFileDetails->hInf,
@@ -981,11 +1583,16 @@ SetupDiBuildDriverInfoList(
                     &DriverDate,
                     &DriverVersion))
                 {
+                    if (InfIndex && GetLastError() != ERROR_NOT_ENOUGH_MEMORY)
+                        UpdateInfIndex(InfIndex, filename, NULL);
                     DereferenceInfFile(currentInfFileDetails);
                     currentInfFileDetails = NULL;
                     continue;
                 }
 
+                if (InfIndex)
+                    UpdateInfIndex(InfIndex, filename, currentInfFileDetails->hInf);
+
                 if (DriverType == SPDIT_CLASSDRIVER)
                 {
                     /* Check if the ClassGuid in this .inf file is corresponding with our needs */
@@ -1195,6 +1802,13 @@ done:
     HeapFree(GetProcessHeap(), 0, ExcludeFromSelect);
     if (currentInfFileDetails)
         DereferenceInfFile(currentInfFileDetails);
+    if (InfIndex)
+    {
+        /* Without the file list, it isn't known which INF files still exist */
+        if (Buffer)
+            SaveInfIndex(InfIndex, InfIndexDirectory);
+        FreeInfIndex(InfIndex);
+    }
     HeapFree(GetProcessHeap(), 0, Buffer);
 
     TRACE("Returning %d\n", ret);
@@ -1230,7 +1230,21 @@ BOOL WINAPI SetupUninstallOEMInfW( PCWSTR inf_file, DWORD flags, PVOID reserved
     strcatW( target, inf_file );
 
     if (flags & SUOI_FORCEDELETE)
-        return DeleteFileW(target);
+    {
+        static const WCHAR pnfW[] = {'.','p','n','f',0};
+        WCHAR *ext;
+
+        if (!DeleteFileW(target)) return FALSE;
+
+        /* The precompiled form isn't useful anymore */
+        ext = strrchrW( target, '.' );
+        if (ext && ext > strrchrW( target, '\\' ) && (ext - target) + 5 <= MAX_PATH)
+        {
+            strcpyW( ext, pnfW );
+            DeleteFileW( target );
+        }
+        return TRUE;
+    }
 
     FIXME("not deleting %s\n", debugstr_w(target));
 
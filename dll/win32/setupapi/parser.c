@@ -144,6 +144,35 @@ static const WCHAR WindowsNT[]  = {'$','W','i','n','d','o','w','s',' ','N','T','
 static const WCHAR Windows95[]  = {'$','W','i','n','d','o','w','s',' ','9','5','$',0};
 static const WCHAR LayoutFile[] = {'L','a','y','o','u','t','F','i','l','e',0};
 
+/* precompiled INF files */
+
+#define PNF_MAGIC    0x464e5052  /* "RPNF" */
+#define PNF_VERSION  1
+
+struct pnf_header
+{
+    DWORD    magic;
+    DWORD    version;
+    DWORD    size;              /* size of the whole .pnf file */
+    FILETIME inf_time;          /* last write time of the .inf file */
+    DWORD    inf_size;          /* size of the .inf file */
+    DWORD    nb_strings;        /* number of WCHARs in the strings buffer */
+    DWORD    nb_fields;
+    DWORD    nb_sections;
+    DWORD    nb_lines;          /* number of lines in all sections */
+    int      strings_section;
+    /* followed by WCHAR strings[nb_strings], padded to a DWORD boundary, */
+    /* DWORD field_text[nb_fields] (offsets in strings),                  */
+    /* struct pnf_section sections[nb_sections],                          */
+    /* and struct line lines[nb_lines], in section order                  */
+};
+
+struct pnf_section
+{
+    DWORD name;                 /* offset of the section name in strings */
+    DWORD nb_lines;
+};
+
 /* extend an array, allocating more memory if necessary */
 static void *grow_array( void *array, unsigned int *count, size_t elem )
 {
@@ -981,23 +1010,278 @@ static void append_inf_file( struct inf_file *parent, struct inf_file *child )
 }
 
 
+/* check that the [Version] section has a known signature */
+static DWORD check_signature( struct inf_file *file, UINT *error_line, DWORD style )
+{
+    int version_index = find_section( file, Version );
+    if (version_index != -1)
+    {
+        struct line *line = find_line( file, version_index, Signature );
+        if (line && line->nb_fields > 0)
+        {
+            struct field *field = file->fields + line->first_field;
+            if (!strcmpiW( field->text, Chicago )) return 0;
+            if (!strcmpiW( field->text, WindowsNT )) return 0;
+            if (!strcmpiW( field->text, Windows95 )) return 0;
+        }
+    }
+    if (error_line) *error_line = 0;
+    if (style & INF_STYLE_WIN4) return ERROR_WRONG_INF_STYLE;
+    return 0;
+}
+
+
+/***********************************************************************
+ *            get_pnf_path
+ *
+ * Return the name of the precompiled file for an INF file, or NULL if it
+ * shouldn't have one. Only the INF files of the system INF directory are
+ * precompiled, those are the ones searched again and again for drivers.
+ */
+static WCHAR *get_pnf_path( const WCHAR *path )
+{
+    static const WCHAR Inf[]    = {'\\','i','n','f','\\',0};
+    static const WCHAR InfExt[] = {'.','i','n','f',0};
+    static const WCHAR PnfExt[] = {'.','p','n','f',0};
+    WCHAR dir[MAX_PATH];
+    unsigned int len, name_len;
+    WCHAR *ret;
+
+    len = GetWindowsDirectoryW( dir, MAX_PATH - 5 );
+    if (!len || len >= MAX_PATH - 5) return NULL;
+    strcatW( dir, Inf );
+    len = strlenW( dir );
+
+    if (strncmpiW( path, dir, len ) || strchrW( path + len, '\\' )) return NULL;
+    name_len = strlenW( path + len );
+    if (name_len <= 4 || strcmpiW( path + len + name_len - 4, InfExt )) return NULL;
+
+    if (!(ret = HeapAlloc( GetProcessHeap(), 0, (len + name_len + 1) * sizeof(WCHAR) ))) return NULL;
+    strcpyW( ret, path );
+    strcpyW( ret + len + name_len - 4, PnfExt );
+    return ret;
+}
+
+
+/***********************************************************************
+ *            load_pnf
+ *
+ * Load the precompiled form of an INF file, if it is still up to date.
+ */
+static struct inf_file *load_pnf( const WCHAR *pnf_path, HANDLE inf_handle, DWORD inf_size )
+{
+    const struct pnf_header *header;
+    const struct pnf_section *pnf_sections;
+    const struct line *lines;
+    const DWORD *field_text;
+    const WCHAR *strings;
+    struct inf_file *file = NULL;
+    struct section *section;
+    FILETIME inf_time;
+    HANDLE handle, mapping = NULL;
+    ULONGLONG needed;
+    DWORD size, i, j, nb_lines;
+    void *buffer;
+
+    if (!GetFileTime( inf_handle, NULL, NULL, &inf_time )) return NULL;
+
+    handle = CreateFileW( pnf_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, 0 );
+    if (handle == INVALID_HANDLE_VALUE) return NULL;
+    size = GetFileSize( handle, NULL );
+    if (size != INVALID_FILE_SIZE && size >= sizeof(*header))
+        mapping = CreateFileMappingW( handle, NULL, PAGE_READONLY, 0, size, NULL );
+    CloseHandle( handle );
+    if (!mapping) return NULL;
+    buffer = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, size );
+    NtClose( mapping );
+    if (!buffer) return NULL;
+
+    header = buffer;
+    if (header->magic != PNF_MAGIC || header->version != PNF_VERSION || header->size != size ||
+        header->inf_size != inf_size || CompareFileTime( &header->inf_time, &inf_time ))
+    {
+        TRACE( "%s is out of date\n", debugstr_w(pnf_path) );
+        goto done;
+    }
+
+    needed = sizeof(*header) + (((ULONGLONG)header->nb_strings * sizeof(WCHAR) + 3) & ~3) +
+             (ULONGLONG)header->nb_fields * sizeof(DWORD) +
+             (ULONGLONG)header->nb_sections * sizeof(struct pnf_section) +
+             (ULONGLONG)header->nb_lines * sizeof(struct line);
+    if (needed != size || !header->nb_strings) goto corrupted;
+
+    strings = (const WCHAR *)(header + 1);
+    field_text = (const DWORD *)((const BYTE *)strings + ((header->nb_strings * sizeof(WCHAR) + 3) & ~3));
+    pnf_sections = (const struct pnf_section *)(field_text + header->nb_fields);
+    lines = (const struct line *)(pnf_sections + header->nb_sections);
+
+    /* everything must point inside the file */
+    if (strings[header->nb_strings - 1]) goto corrupted;
+    if (header->strings_section < -1 || header->strings_section >= (int)header->nb_sections) goto corrupted;
+    for (i = 0; i < header->nb_fields; i++)
+        if (field_text[i] >= header->nb_strings) goto corrupted;
+    for (i = 0, nb_lines = 0; i < header->nb_sections; i++)
+    {
+        if (pnf_sections[i].name >= header->nb_strings) goto corrupted;
+        if (pnf_sections[i].nb_lines > header->nb_lines - nb_lines) goto corrupted;
+        nb_lines += pnf_sections[i].nb_lines;
+    }
+    if (nb_lines != header->nb_lines) goto corrupted;
+    for (i = 0; i < header->nb_lines; i++)
+    {
+        if (lines[i].first_field < 0 || lines[i].nb_fields < 0 ||
+            (DWORD)lines[i].first_field > header->nb_fields ||
+            (DWORD)lines[i].nb_fields > header->nb_fields - lines[i].first_field ||
+            lines[i].key_field < -1 || lines[i].key_field >= (int)header->nb_fields) goto corrupted;
+    }
+
+    if (!(file = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*file) ))) goto done;
+    file->strings  = HeapAlloc( GetProcessHeap(), 0, header->nb_strings * sizeof(WCHAR) );
+    file->fields   = HeapAlloc( GetProcessHeap(), 0, max( header->nb_fields, 1 ) * sizeof(file->fields[0]) );
+    file->sections = HeapAlloc( GetProcessHeap(), 0, max( header->nb_sections, 1 ) * sizeof(file->sections[0]) );
+    if (!file->strings || !file->fields || !file->sections) goto failed;
+
+    memcpy( file->strings, strings, header->nb_strings * sizeof(WCHAR) );
+    file->string_pos = file->strings + header->nb_strings;
+    for (i = 0; i < header->nb_fields; i++) file->fields[i].text = file->strings + field_text[i];
+    file->nb_fields = file->alloc_fields = header->nb_fields;
+    file->alloc_sections = header->nb_sections;
+    file->strings_section = header->strings_section;
+
+    for (i = 0; i < header->nb_sections; i++)
+    {
+        j = max( pnf_sections[i].nb_lines, sizeof(section->lines)/sizeof(section->lines[0]) );
+        if (!(section = HeapAlloc( GetProcessHeap(), 0, FIELD_OFFSET( struct section, lines[j] ) )))
+            goto failed;
+        section->name        = file->strings + pnf_sections[i].name;
+        section->nb_lines    = pnf_sections[i].nb_lines;
+        section->alloc_lines = j;
+        memcpy( section->lines, lines, section->nb_lines * sizeof(*lines) );
+        lines += section->nb_lines;
+        file->sections[file->nb_sections++] = section;
+    }
+    goto done;
+
+corrupted:
+    WARN( "%s is corrupted\n", debugstr_w(pnf_path) );
+    goto done;
+
+failed:
+    free_inf_file( file );
+    file = NULL;
+
+done:
+    UnmapViewOfFile( buffer );
+    return file;
+}
+
+
+/***********************************************************************
+ *            save_pnf
+ *
+ * Store a freshly parsed INF file in precompiled form. Errors are ignored,
+ * the file will simply be parsed again next time.
+ */
+static void save_pnf( const WCHAR *pnf_path, HANDLE inf_handle, DWORD inf_size,
+                      const struct inf_file *file )
+{
+    struct pnf_header *header;
+    struct pnf_section *pnf_sections;
+    struct line *lines;
+    DWORD *field_text;
+    DWORD size, strings_size, written, i;
+    unsigned int nb_lines = 0;
+    HANDLE handle;
+    BOOL ret;
+
+    for (i = 0; i < file->nb_sections; i++) nb_lines += file->sections[i]->nb_lines;
+
+    strings_size = ((file->string_pos - file->strings) * sizeof(WCHAR) + 3) & ~3;
+    size = sizeof(*header) + strings_size + file->nb_fields * sizeof(DWORD) +
+           file->nb_sections * sizeof(struct pnf_section) + nb_lines * sizeof(struct line);
+    if (!(header = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, size ))) return;
+
+    header->magic           = PNF_MAGIC;
+    header->version         = PNF_VERSION;
+    header->size            = size;
+    header->inf_size        = inf_size;
+    header->nb_strings      = file->string_pos - file->strings;
+    header->nb_fields       = file->nb_fields;
+    header->nb_sections     = file->nb_sections;
+    header->nb_lines        = nb_lines;
+    header->strings_section = file->strings_section;
+    if (!GetFileTime( inf_handle, NULL, NULL, &header->inf_time )) goto done;
+
+    memcpy( header + 1, file->strings, header->nb_strings * sizeof(WCHAR) );
+    field_text = (DWORD *)((BYTE *)(header + 1) + strings_size);
+    for (i = 0; i < file->nb_fields; i++) field_text[i] = file->fields[i].text - file->strings;
+    pnf_sections = (struct pnf_section *)(field_text + file->nb_fields);
+    lines = (struct line *)(pnf_sections + file->nb_sections);
+    for (i = 0; i < file->nb_sections; i++)
+    {
+        pnf_sections[i].name     = file->sections[i]->name - file->strings;
+        pnf_sections[i].nb_lines = file->sections[i]->nb_lines;
+        memcpy( lines, file->sections[i]->lines, file->sections[i]->nb_lines * sizeof(*lines) );
+        lines += file->sections[i]->nb_lines;
+    }
+
+    /* not shared, so nobody can load a half written file */
+    handle = CreateFileW( pnf_path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0 );
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        TRACE( "can't create %s, error %lu\n", debugstr_w(pnf_path), GetLastError() );
+        goto done;
+    }
+    ret = WriteFile( handle, header, size, &written, NULL ) && written == size;
+    CloseHandle( handle );
+    if (!ret) DeleteFileW( pnf_path );
+
+done:
+    HeapFree( GetProcessHeap(), 0, header );
+}
+
+
 /***********************************************************************
  *            parse_file
  *
  * parse an INF file.
  */
-static struct inf_file *parse_file( HANDLE handle, UINT *error_line, DWORD style )
+static struct inf_file *parse_file( HANDLE handle, const WCHAR *path, UINT *error_line, DWORD style )
 {
     void *buffer;
     DWORD err = 0;
     struct inf_file *file;
+    WCHAR *pnf_path;
+    HANDLE mapping;
 
     DWORD size = GetFileSize( handle, NULL );
-    HANDLE mapping = CreateFileMappingW( handle, NULL, PAGE_READONLY, 0, size, NULL );
-    if (!mapping) return NULL;
+
+    if ((pnf_path = get_pnf_path( path )) && (file = load_pnf( pnf_path, handle, size )))
+    {
+        TRACE( "using %s\n", debugstr_w(pnf_path) );
+        HeapFree( GetProcessHeap(), 0, pnf_path );
+        if ((err = check_signature( file, error_line, style )))
+        {
+            free_inf_file( file );
+            SetLastError( err );
+            file = NULL;
+        }
+        return file;
+    }
+
+    mapping = CreateFileMappingW( handle, NULL, PAGE_READONLY, 0, size, NULL );
+    if (!mapping)
+    {
+        HeapFree( GetProcessHeap(), 0, pnf_path );
+        return NULL;
+    }
     buffer = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, size );
     NtClose( mapping );
-    if (!buffer) return NULL;
+    if (!buffer)
+    {
+        HeapFree( GetProcessHeap(), 0, pnf_path );
+        return NULL;
+    }
 
     if (!(file = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*file) )))
     {
@@ -1036,6 +1320,7 @@ static struct inf_file *parse_file( HANDLE handle, UINT *error_line, DWORD style
             err = parse_buffer( file, new_buff, new_buff + len, error_line );
             HeapFree( GetProcessHeap(), 0, new_buff );
         }
+        else err = ERROR_NOT_ENOUGH_MEMORY;
     }
     else
     {
@@ -1046,26 +1331,14 @@ static struct inf_file *parse_file( HANDLE handle, UINT *error_line, DWORD style
         err = parse_buffer( file, new_buff, (WCHAR *)((char *)buffer + size), error_line );
     }
 
+    if (!err && pnf_path) save_pnf( pnf_path, handle, size, file );
+
     if (!err)  /* now check signature */
-    {
-        int version_index = find_section( file, Version );
-        if (version_index != -1)
-        {
-            struct line *line = find_line( file, version_index, Signature );
-            if (line && line->nb_fields > 0)
-            {
-                struct field *field = file->fields + line->first_field;
-                if (!strcmpiW( field->text, Chicago )) goto done;
-                if (!strcmpiW( field->text, WindowsNT )) goto done;
-                if (!strcmpiW( field->text, Windows95 )) goto done;
-            }
-        }
-        if (error_line) *error_line = 0;
-        if (style & INF_STYLE_WIN4) err = ERROR_WRONG_INF_STYLE;
-    }
+        err = check_signature( file, error_line, style );
 
  done:
     UnmapViewOfFile( buffer );
+    HeapFree( GetProcessHeap(), 0, pnf_path );
     if (err)
     {
         if (file) free_inf_file( file );
@@ -1278,7 +1551,7 @@ HINF WINAPI SetupOpenInfFileW( PCWSTR name, PCWSTR class, DWORD style, UINT *err
 
     if (handle != INVALID_HANDLE_VALUE)
     {
-        file = parse_file( handle, error, style);
+        file = parse_file( handle, path, error, style );
         CloseHandle( handle );
     }
     if (!file)
@@ -133,6 +133,125 @@ static void to_sRGB(BYTE *bgr)
 }
 #endif
 
+/* The helpers below handle a whole 32bpp pixel at a time in a DWORD, which
+ * lets the compiler do two channels in one multiplication instead of working
+ * byte by byte. Alpha is always the top byte, the order of the other channels
+ * doesn't matter to them. */
+
+static inline DWORD premultiply_pixel(DWORD pixel)
+{
+    DWORD alpha = pixel >> 24, rb, g;
+
+    if (alpha == 255) return pixel;
+
+    /* x * alpha / 255 for both the first and the third channel, the
+     * (t + 1 + (t >> 8)) >> 8 form is exact for t <= 255 * 255 */
+    rb = (pixel & 0x00ff00ff) * alpha;
+    rb = ((rb + 0x00010001 + ((rb >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+    g = ((pixel >> 8) & 0xff) * alpha;
+    g = (g + 1 + (g >> 8)) >> 8;
+
+    return (pixel & 0xff000000) | rb | (g << 8);
+}
+
+static void premultiply_rows(BYTE *bits, UINT width, UINT height, UINT stride)
+{
+    UINT x, y;
+    DWORD *pixel;
+
+    for (y=0; y<height; y++)
+    {
+        pixel = (DWORD *)(bits + stride * y);
+        for (x=0; x<width; x++)
+            pixel[x] = premultiply_pixel(pixel[x]);
+    }
+}
+
+static void unpremultiply_rows(BYTE *bits, UINT width, UINT height, UINT stride)
+{
+    UINT x, y, alpha, factor;
+    DWORD *pixel;
+
+    for (y=0; y<height; y++)
+    {
+        pixel = (DWORD *)(bits + stride * y);
+        for (x=0; x<width; x++)
+        {
+            alpha = pixel[x] >> 24;
+            if (alpha == 0 || alpha == 255) continue;
+
+            /* (c * factor) >> 16 equals c * 255 / alpha for all 8 bit values */
+            factor = (255 * 65536 + alpha - 1) / alpha;
+            pixel[x] = (pixel[x] & 0xff000000) |
+                (((pixel[x] & 0xff) * factor >> 16) & 0xff) |
+                (((((pixel[x] >> 8) & 0xff) * factor >> 16) & 0xff) << 8) |
+                (((((pixel[x] >> 16) & 0xff) * factor >> 16) & 0xff) << 16);
+        }
+    }
+}
+
+static void set_alpha_rows(BYTE *bits, UINT width, UINT height, UINT stride)
+{
+    UINT x, y;
+    DWORD *pixel;
+
+    for (y=0; y<height; y++)
+    {
+        pixel = (DWORD *)(bits + stride * y);
+        for (x=0; x<width; x++)
+            pixel[x] |= 0xff000000;
+    }
+}
+
+/* The expanding converters below work in place: the source row has been read
+ * into the start of the destination row, and is converted from its end so
+ * that no source pixel is overwritten before it is read. */
+
+static void expand_gray8_row(BYTE *row, UINT width)
+{
+    const BYTE *src = row + width;
+    DWORD *dst = (DWORD *)row + width;
+
+    while (src != row)
+    {
+        src--;
+        *--dst = 0xff000000 | (*src * 0x010101);
+    }
+}
+
+static void expand_indexed8_row(BYTE *row, UINT width, const WICColor *colors)
+{
+    const BYTE *src = row + width;
+    DWORD *dst = (DWORD *)row + width;
+
+    while (src != row)
+        *--dst = colors[*--src];
+}
+
+static void expand_bgr24_row(BYTE *row, UINT width)
+{
+    const BYTE *src = row + 3 * width;
+    DWORD *dst = (DWORD *)row + width;
+
+    while (src != row)
+    {
+        src -= 3;
+        *--dst = 0xff000000 | (src[2] << 16) | (src[1] << 8) | src[0];
+    }
+}
+
+static void expand_rgb24_row(BYTE *row, UINT width)
+{
+    const BYTE *src = row + 3 * width;
+    DWORD *dst = (DWORD *)row + width;
+
+    while (src != row)
+    {
+        src -= 3;
+        *--dst = 0xff000000 | (src[0] << 16) | (src[1] << 8) | src[2];
+    }
+}
+
 static inline FormatConverter *impl_from_IWICFormatConverter(IWICFormatConverter *iface)
 {
     return CONTAINING_RECORD(iface, FormatConverter, IWICFormatConverter_iface);
@@ -338,41 +457,17 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            INT x, y;
-            BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
-            const BYTE *srcbyte;
-            BYTE *dstrow;
-            DWORD *dstpixel;
-
-            srcstride = prc->Width;
-            srcdatasize = srcstride * prc->Height;
-
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
+            INT y;
 
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+            /* the source rows fit in the destination, expand them in place */
+            res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
 
             if (SUCCEEDED(res))
             {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcbyte = srcrow;
-                    dstpixel=(DWORD*)dstrow;
-                    for (x=0; x<prc->Width; x++)
-                    {
-                        *dstpixel++ = 0xff000000|(*srcbyte<<16)|(*srcbyte<<8)|*srcbyte;
-                        srcbyte++;
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
-                }
+                for (y=0; y<prc->Height; y++)
+                    expand_gray8_row(pbBuffer + cbStride * y, prc->Width);
             }
 
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
             return res;
         }
         return S_OK;
@@ -380,13 +475,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            INT x, y;
-            BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
-            const BYTE *srcbyte;
-            BYTE *dstrow;
-            DWORD *dstpixel;
+            INT y;
             WICColor colors[256];
             IWICPalette *palette;
             UINT actualcolors;
@@ -402,30 +491,14 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
 
             if (FAILED(res)) return res;
 
-            srcstride = prc->Width;
-            srcdatasize = srcstride * prc->Height;
-
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
-
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+            res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
 
             if (SUCCEEDED(res))
             {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcbyte = srcrow;
-                    dstpixel=(DWORD*)dstrow;
-                    for (x=0; x<prc->Width; x++)
-                        *dstpixel++ = colors[*srcbyte++];
-                    srcrow += srcstride;
-                    dstrow += cbStride;
-                }
+                for (y=0; y<prc->Height; y++)
+                    expand_indexed8_row(pbBuffer + cbStride * y, prc->Width, colors);
             }
 
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
             return res;
         }
         return S_OK;
@@ -617,93 +690,26 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         }
         return S_OK;
     case format_24bppBGR:
-        if (prc)
-        {
-            HRESULT res;
-            INT x, y;
-            BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
-            const BYTE *srcpixel;
-            BYTE *dstrow;
-            BYTE *dstpixel;
-
-            srcstride = 3 * prc->Width;
-            srcdatasize = srcstride * prc->Height;
-
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
-
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
-
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        *dstpixel++=*srcpixel++; /* blue */
-                        *dstpixel++=*srcpixel++; /* green */
-                        *dstpixel++=*srcpixel++; /* red */
-                        *dstpixel++=255; /* alpha */
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
-                }
-            }
-
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
-            return res;
-        }
-        return S_OK;
     case format_24bppRGB:
         if (prc)
         {
             HRESULT res;
-            INT x, y;
-            BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
-            const BYTE *srcpixel;
-            BYTE *dstrow;
-            BYTE *dstpixel;
-            BYTE tmppixel[3];
-
-            srcstride = 3 * prc->Width;
-            srcdatasize = srcstride * prc->Height;
+            INT y;
 
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
-
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+            /* the source rows fit in the destination, expand them in place */
+            res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
 
             if (SUCCEEDED(res))
             {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        tmppixel[0]=*srcpixel++; /* red */
-                        tmppixel[1]=*srcpixel++; /* green */
-                        tmppixel[2]=*srcpixel++; /* blue */
-
-                        *dstpixel++=tmppixel[2]; /* blue */
-                        *dstpixel++=tmppixel[1]; /* green */
-                        *dstpixel++=tmppixel[0]; /* red */
-                        *dstpixel++=255; /* alpha */
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
+                for (y=0; y<prc->Height; y++)
+                {
+                    if (source_format == format_24bppBGR)
+                        expand_bgr24_row(pbBuffer + cbStride * y, prc->Width);
+                    else
+                        expand_rgb24_row(pbBuffer + cbStride * y, prc->Width);
                 }
             }
 
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
             return res;
         }
         return S_OK;
@@ -711,15 +717,12 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            INT x, y;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(res)) return res;
 
             /* set all alpha values to 255 */
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                    pbBuffer[cbStride*y+4*x+3] = 0xff;
+            set_alpha_rows(pbBuffer, prc->Width, prc->Height, cbStride);
         }
         return S_OK;
     case format_32bppRGBA:
@@ -739,22 +742,11 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            INT x, y;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(res)) return res;
 
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 0 && alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * 255 / alpha;
-                    }
-                }
+            unpremultiply_rows(pbBuffer, prc->Width, prc->Height, cbStride);
         }
         return S_OK;
     case format_48bppRGB:
@@ -883,15 +875,11 @@ static HRESULT copypixels_to_32bppRGBA(struct FormatConverter *This, const WICRe
     case format_32bppRGB:
         if (prc)
         {
-            INT x, y;
-
             hr = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(hr)) return hr;
 
             /* set all alpha values to 255 */
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                    pbBuffer[cbStride*y+4*x+3] = 0xff;
+            set_alpha_rows(pbBuffer, prc->Width, prc->Height, cbStride);
         }
         return S_OK;
 
@@ -903,22 +891,10 @@ static HRESULT copypixels_to_32bppRGBA(struct FormatConverter *This, const WICRe
     case format_32bppPRGBA:
         if (prc)
         {
-            INT x, y;
-
             hr = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(hr)) return hr;
 
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 0 && alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * 255 / alpha;
-                    }
-                }
+            unpremultiply_rows(pbBuffer, prc->Width, prc->Height, cbStride);
         }
         return S_OK;
 
@@ -976,21 +952,7 @@ static HRESULT copypixels_to_32bppPBGRA(struct FormatConverter *This, const WICR
     default:
         hr = copypixels_to_32bppBGRA(This, prc, cbStride, cbBufferSize, pbBuffer, source_format);
         if (SUCCEEDED(hr) && prc)
-        {
-            INT x, y;
-
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * alpha / 255;
-                    }
-                }
-        }
+            premultiply_rows(pbBuffer, prc->Width, prc->Height, cbStride);
         return hr;
     }
 }
@@ -1009,21 +971,7 @@ static HRESULT copypixels_to_32bppPRGBA(struct FormatConverter *This, const WICR
     default:
         hr = copypixels_to_32bppRGBA(This, prc, cbStride, cbBufferSize, pbBuffer, source_format);
         if (SUCCEEDED(hr) && prc)
-        {
-            INT x, y;
-
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * alpha / 255;
-                    }
-                }
-        }
+            premultiply_rows(pbBuffer, prc->Width, prc->Height, cbStride);
         return hr;
     }
 }
@@ -1056,9 +1004,10 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
             BYTE *srcdata;
             UINT srcstride, srcdatasize;
             const BYTE *srcrow;
-            const BYTE *srcpixel;
+            const DWORD *srcpixel;
             BYTE *dstrow;
             BYTE *dstpixel;
+            DWORD pixel;
 
             srcstride = 4 * prc->Width;
             srcdatasize = srcstride * prc->Height;
@@ -1077,13 +1026,13 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
                 {
                     for (y = 0; y < prc->Height; y++)
                     {
-                        srcpixel = srcrow;
+                        srcpixel = (const DWORD *)srcrow;
                         dstpixel = dstrow;
                         for (x = 0; x < prc->Width; x++) {
-                            *dstpixel++ = srcpixel[2]; /* blue */
-                            *dstpixel++ = srcpixel[1]; /* green */
-                            *dstpixel++ = srcpixel[0]; /* red */
-                            srcpixel += 4;
+                            pixel = *srcpixel++;
+                            *dstpixel++ = pixel >> 16; /* blue */
+                            *dstpixel++ = pixel >> 8; /* green */
+                            *dstpixel++ = pixel; /* red */
                         }
                         srcrow += srcstride;
                         dstrow += cbStride;
@@ -1093,13 +1042,13 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
                 {
                     for (y = 0; y < prc->Height; y++)
                     {
-                        srcpixel = srcrow;
+                        srcpixel = (const DWORD *)srcrow;
                         dstpixel = dstrow;
                         for (x = 0; x < prc->Width; x++) {
-                            *dstpixel++ = *srcpixel++; /* blue */
-                            *dstpixel++ = *srcpixel++; /* green */
-                            *dstpixel++ = *srcpixel++; /* red */
-                            srcpixel++; /* alpha */
+                            pixel = *srcpixel++;
+                            *dstpixel++ = pixel; /* blue */
+                            *dstpixel++ = pixel >> 8; /* green */
+                            *dstpixel++ = pixel >> 16; /* red */
                         }
                         srcrow += srcstride;
                         dstrow += cbStride;
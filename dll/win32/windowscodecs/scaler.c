@@ -20,6 +20,7 @@
 #include "config.h"
 
 #include <stdarg.h>
+#include <math.h>
 
 #define COBJMACROS
 
@@ -33,6 +34,18 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(wincodecs);
 
+/* The weights of the filtered modes are fixed point numbers with FILTER_BITS
+ * fractional bits. The horizontally filtered rows keep FILTER_ROW_BITS of
+ * them until the vertical pass, which is enough for 8 bit channels. */
+#define FILTER_BITS 14
+#define FILTER_ROW_BITS 7
+
+struct scaler_filter {
+    UINT taps;      /* number of source pixels read for each destination pixel */
+    UINT *start;    /* first source pixel of each destination pixel */
+    INT *weights;   /* taps weights for each destination pixel */
+};
+
 typedef struct BitmapScaler {
     IWICBitmapScaler IWICBitmapScaler_iface;
     LONG ref;
@@ -44,6 +57,12 @@ typedef struct BitmapScaler {
     UINT bpp;
     void (*fn_get_required_source_rect)(struct BitmapScaler*,UINT,UINT,WICRect*);
     void (*fn_copy_scanline)(struct BitmapScaler*,UINT,UINT,UINT,BYTE**,UINT,UINT,BYTE*);
+    struct scaler_filter filter_x, filter_y;
+    INT *ring;          /* the last filter_y.taps horizontally filtered source rows */
+    INT **ring_rows;
+    BYTE *src_row;
+    INT cache_x, cache_width;   /* destination columns held by the ring */
+    UINT cache_first, cache_end; /* source rows held by the ring */
     CRITICAL_SECTION lock; /* must be held when initialized */
 } BitmapScaler;
 
@@ -57,6 +76,15 @@ static inline BitmapScaler *impl_from_IMILBitmapScaler(IMILBitmapScaler *iface)
     return CONTAINING_RECORD(iface, BitmapScaler, IMILBitmapScaler_iface);
 }
 
+static void free_filter(struct scaler_filter *filter)
+{
+    HeapFree(GetProcessHeap(), 0, filter->start);
+    HeapFree(GetProcessHeap(), 0, filter->weights);
+    filter->start = NULL;
+    filter->weights = NULL;
+    filter->taps = 0;
+}
+
 static HRESULT WINAPI BitmapScaler_QueryInterface(IWICBitmapScaler *iface, REFIID iid,
     void **ppv)
 {
@@ -108,6 +136,11 @@ static ULONG WINAPI BitmapScaler_Release(IWICBitmapScaler *iface)
         This->lock.DebugInfo->Spare[0] = 0;
         DeleteCriticalSection(&This->lock);
         if (This->source) IWICBitmapSource_Release(This->source);
+        free_filter(&This->filter_x);
+        free_filter(&This->filter_y);
+        HeapFree(GetProcessHeap(), 0, This->ring);
+        HeapFree(GetProcessHeap(), 0, This->ring_rows);
+        HeapFree(GetProcessHeap(), 0, This->src_row);
         HeapFree(GetProcessHeap(), 0, This);
     }
 
@@ -205,6 +238,242 @@ static void NearestNeighbor_CopyScanline(BitmapScaler *This,
     }
 }
 
+/* Catmull-Rom spline */
+static double cubic_weight(double x)
+{
+    x = fabs(x);
+    if (x < 1.0) return (1.5 * x - 2.5) * x * x + 1.0;
+    if (x < 2.0) return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+    return 0.0;
+}
+
+/* Computes which source pixels make up each destination pixel along one axis,
+ * and how much each of them contributes. Source pixels past the edges are
+ * replaced by the edge pixels. */
+static HRESULT create_filter(WICBitmapInterpolationMode mode, UINT src_size, UINT dst_size,
+    struct scaler_filter *filter)
+{
+    double scale = (double)src_size / dst_size;
+    double center, left = 0.0, right = 0.0, sum, *w;
+    UINT i, k, taps, max_k;
+    INT first, j, total;
+
+    switch (mode)
+    {
+    case WICBitmapInterpolationModeLinear:
+        taps = 2;
+        break;
+    case WICBitmapInterpolationModeCubic:
+        taps = 4;
+        break;
+    default: /* Fant, average over the area covered by the destination pixel */
+        taps = (UINT)ceil(max(scale, 1.0)) + 1;
+        break;
+    }
+
+    filter->taps = min(taps, src_size);
+    filter->start = HeapAlloc(GetProcessHeap(), 0, dst_size * sizeof(UINT));
+    filter->weights = HeapAlloc(GetProcessHeap(), 0, dst_size * filter->taps * sizeof(INT));
+    w = HeapAlloc(GetProcessHeap(), 0, filter->taps * sizeof(double));
+    if (!filter->start || !filter->weights || !w)
+    {
+        HeapFree(GetProcessHeap(), 0, w);
+        free_filter(filter);
+        return E_OUTOFMEMORY;
+    }
+
+    for (i = 0; i < dst_size; i++)
+    {
+        center = (i + 0.5) * scale;
+
+        if (mode == WICBitmapInterpolationModeFant)
+        {
+            left = center - max(scale, 1.0) / 2.0;
+            right = center + max(scale, 1.0) / 2.0;
+            first = (INT)floor(left);
+        }
+        else
+        {
+            first = (INT)floor(center - 0.5);
+            if (mode == WICBitmapInterpolationModeCubic) first--;
+        }
+
+        /* keep all taps inside the source */
+        filter->start[i] = min(max(first, 0), (INT)(src_size - filter->taps));
+
+        for (k = 0; k < filter->taps; k++)
+            w[k] = 0.0;
+
+        for (k = 0; k < taps; k++)
+        {
+            double weight;
+
+            j = first + k;
+            if (mode == WICBitmapInterpolationModeFant)
+                weight = max(min(right, j + 1.0) - max(left, (double)j), 0.0);
+            else if (mode == WICBitmapInterpolationModeCubic)
+                weight = cubic_weight(center - 0.5 - j);
+            else
+                weight = max(1.0 - fabs(center - 0.5 - j), 0.0);
+
+            j = min(max(j, 0), (INT)src_size - 1);
+            w[j - filter->start[i]] += weight;
+        }
+
+        sum = 0.0;
+        max_k = 0;
+        for (k = 0; k < filter->taps; k++)
+        {
+            sum += w[k];
+            if (w[k] > w[max_k]) max_k = k;
+        }
+
+        /* the fixed point weights must add up to exactly one */
+        total = 0;
+        for (k = 0; k < filter->taps; k++)
+        {
+            filter->weights[i * filter->taps + k] = (INT)floor(w[k] / sum * (1 << FILTER_BITS) + 0.5);
+            total += filter->weights[i * filter->taps + k];
+        }
+        filter->weights[i * filter->taps + max_k] += (1 << FILTER_BITS) - total;
+    }
+
+    HeapFree(GetProcessHeap(), 0, w);
+
+    return S_OK;
+}
+
+static void Filter_HorizontalPass(BitmapScaler *This, UINT dst_x, UINT dst_width,
+    const BYTE *src, UINT src_x, INT *row)
+{
+    UINT bytesperpixel = This->bpp/8;
+    UINT taps = This->filter_x.taps;
+    UINT i, j, k;
+
+    for (i=0; i<dst_width; i++)
+    {
+        const INT *weights = This->filter_x.weights + (dst_x + i) * taps;
+        const BYTE *pixel = src + (This->filter_x.start[dst_x + i] - src_x) * bytesperpixel;
+
+        for (j=0; j<bytesperpixel; j++)
+        {
+            INT sum = 0;
+
+            for (k=0; k<taps; k++)
+                sum += weights[k] * pixel[k * bytesperpixel + j];
+
+            *row++ = (sum + (1 << (FILTER_BITS - FILTER_ROW_BITS - 1))) >> (FILTER_BITS - FILTER_ROW_BITS);
+        }
+    }
+}
+
+static void Filter_VerticalPass(BitmapScaler *This, UINT dst_y, UINT count, BYTE *pbBuffer)
+{
+    const INT *weights = This->filter_y.weights + dst_y * This->filter_y.taps;
+    UINT taps = This->filter_y.taps;
+    UINT i, k;
+    INT sum;
+
+    for (i=0; i<count; i++)
+    {
+        sum = 1 << (FILTER_BITS + FILTER_ROW_BITS - 1);
+
+        for (k=0; k<taps; k++)
+            sum += weights[k] * This->ring_rows[k][i];
+
+        sum >>= FILTER_BITS + FILTER_ROW_BITS;
+        pbBuffer[i] = sum < 0 ? 0 : sum > 255 ? 255 : sum;
+    }
+}
+
+/* Produces the destination rows from the top down while reading each source
+ * row only once. The last source rows are kept horizontally filtered in a ring
+ * buffer, so the next call can continue where this one stopped, which is what
+ * happens when the scanlines are requested one at a time. */
+static HRESULT Filter_CopyPixels(BitmapScaler *This, const WICRect *dst_rect,
+    UINT cbStride, BYTE *pbBuffer)
+{
+    UINT bytesperpixel = This->bpp/8;
+    UINT ring_size = This->filter_y.taps;
+    UINT ring_stride = This->width * bytesperpixel;
+    UINT first, y, k;
+    WICRect src_rect;
+    HRESULT hr;
+
+    if (dst_rect->Width == 0 || dst_rect->Height == 0)
+        return S_OK;
+
+    if (!This->ring)
+    {
+        This->ring = HeapAlloc(GetProcessHeap(), 0, ring_size * ring_stride * sizeof(INT));
+        This->ring_rows = HeapAlloc(GetProcessHeap(), 0, ring_size * sizeof(INT*));
+        This->src_row = HeapAlloc(GetProcessHeap(), 0, This->src_width * bytesperpixel);
+
+        if (!This->ring || !This->ring_rows || !This->src_row)
+        {
+            HeapFree(GetProcessHeap(), 0, This->ring);
+            HeapFree(GetProcessHeap(), 0, This->ring_rows);
+            HeapFree(GetProcessHeap(), 0, This->src_row);
+            This->ring = NULL;
+            This->ring_rows = NULL;
+            This->src_row = NULL;
+            return E_OUTOFMEMORY;
+        }
+
+        This->cache_first = This->cache_end = 0;
+        This->cache_x = dst_rect->X;
+        This->cache_width = dst_rect->Width;
+    }
+
+    /* the ring only holds the columns of the previous request */
+    if (dst_rect->X != This->cache_x || dst_rect->Width != This->cache_width)
+    {
+        This->cache_first = This->cache_end = 0;
+        This->cache_x = dst_rect->X;
+        This->cache_width = dst_rect->Width;
+    }
+
+    src_rect.X = This->filter_x.start[dst_rect->X];
+    src_rect.Width = This->filter_x.start[dst_rect->X + dst_rect->Width - 1] +
+        This->filter_x.taps - src_rect.X;
+    src_rect.Height = 1;
+
+    for (y=0; y<dst_rect->Height; y++)
+    {
+        first = This->filter_y.start[dst_rect->Y + y];
+
+        if (first < This->cache_first || first > This->cache_end)
+            This->cache_first = This->cache_end = first;
+
+        while (This->cache_end < first + ring_size)
+        {
+            src_rect.Y = This->cache_end;
+            hr = IWICBitmapSource_CopyPixels(This->source, &src_rect, src_rect.Width * bytesperpixel,
+                src_rect.Width * bytesperpixel, This->src_row);
+            if (FAILED(hr))
+            {
+                This->cache_first = This->cache_end = 0;
+                return hr;
+            }
+
+            Filter_HorizontalPass(This, dst_rect->X, dst_rect->Width, This->src_row, src_rect.X,
+                This->ring + (This->cache_end % ring_size) * ring_stride);
+
+            This->cache_end++;
+            if (This->cache_end - This->cache_first > ring_size)
+                This->cache_first = This->cache_end - ring_size;
+        }
+
+        for (k=0; k<ring_size; k++)
+            This->ring_rows[k] = This->ring + ((first + k) % ring_size) * ring_stride;
+
+        Filter_VerticalPass(This, dst_rect->Y + y, dst_rect->Width * bytesperpixel,
+            pbBuffer + cbStride * y);
+    }
+
+    return S_OK;
+}
+
 static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
@@ -259,13 +528,18 @@ static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
         goto end;
     }
 
+    if (This->filter_y.taps)
+    {
+        hr = Filter_CopyPixels(This, &dest_rect, cbStride, pbBuffer);
+        goto end;
+    }
+
     /* MSDN recommends calling CopyPixels once for each scanline from top to
      * bottom, and claims codecs optimize for this. Ideally, when called in this
      * way, we should avoid requesting a scanline from the source more than
      * once, by saving the data that will be useful for the next scanline after
-     * the call returns. The GetRequiredSourceRect/CopyScanline functions are
-     * designed to make it possible to do this in a generic way, but for now we
-     * just grab all the data we need in each call. */
+     * the call returns. The filtered modes do this, but for nearest neighbor
+     * we just grab all the data we need in each call. */
 
     This->fn_get_required_source_rect(This, dest_rect.X, dest_rect.Y, &src_rect_ul);
     This->fn_get_required_source_rect(This, dest_rect.X+dest_rect.Width-1,
@@ -314,6 +588,28 @@ end:
     return hr;
 }
 
+/* Formats made of 8 bit channels that can be filtered independently */
+static BOOL is_filterable_format(const WICPixelFormatGUID *format)
+{
+    static const WICPixelFormatGUID *formats[] = {
+        &GUID_WICPixelFormat8bppGray,
+        &GUID_WICPixelFormat24bppBGR,
+        &GUID_WICPixelFormat24bppRGB,
+        &GUID_WICPixelFormat32bppBGR,
+        &GUID_WICPixelFormat32bppBGRA,
+        &GUID_WICPixelFormat32bppPBGRA,
+        &GUID_WICPixelFormat32bppRGB,
+        &GUID_WICPixelFormat32bppRGBA,
+        &GUID_WICPixelFormat32bppPRGBA,
+    };
+    UINT i;
+
+    for (i=0; i<ARRAY_SIZE(formats); i++)
+        if (IsEqualGUID(format, formats[i])) return TRUE;
+
+    return FALSE;
+}
+
 static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
     IWICBitmapSource *pISource, UINT uiWidth, UINT uiHeight,
     WICBitmapInterpolationMode mode)
@@ -349,27 +645,51 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
         hr = get_pixelformat_bpp(&src_pixelformat, &This->bpp);
     }
 
+    if (SUCCEEDED(hr))
+    {
+        /* Every mode keeps the output format of the nearest neighbor mode */
+        if ((This->bpp % 8) == 0)
+        {
+            IWICBitmapSource_AddRef(pISource);
+            This->source = pISource;
+        }
+        else
+        {
+            hr = WICConvertBitmapSource(&GUID_WICPixelFormat32bppBGRA,
+                pISource, &This->source);
+            src_pixelformat = GUID_WICPixelFormat32bppBGRA;
+            This->bpp = 32;
+        }
+        This->fn_get_required_source_rect = NearestNeighbor_GetRequiredSourceRect;
+        This->fn_copy_scanline = NearestNeighbor_CopyScanline;
+    }
+
     if (SUCCEEDED(hr))
     {
         switch (mode)
         {
+        case WICBitmapInterpolationModeLinear:
+        case WICBitmapInterpolationModeCubic:
+        case WICBitmapInterpolationModeFant:
+            /* palette indices and packed channels are scaled like nearest neighbor */
+            if (!is_filterable_format(&src_pixelformat))
+                break;
+
+            hr = create_filter(mode, This->src_width, This->width, &This->filter_x);
+            if (SUCCEEDED(hr))
+                hr = create_filter(mode, This->src_height, This->height, &This->filter_y);
+
+            if (FAILED(hr))
+            {
+                free_filter(&This->filter_x);
+                IWICBitmapSource_Release(This->source);
+                This->source = NULL;
+            }
+            break;
         default:
             FIXME("unsupported mode %i\n", mode);
             /* fall-through */
         case WICBitmapInterpolationModeNearestNeighbor:
-            if ((This->bpp % 8) == 0)
-            {
-                IWICBitmapSource_AddRef(pISource);
-                This->source = pISource;
-            }
-            else
-            {
-                hr = WICConvertBitmapSource(&GUID_WICPixelFormat32bppBGRA,
-                    pISource, &This->source);
-                This->bpp = 32;
-            }
-            This->fn_get_required_source_rect = NearestNeighbor_GetRequiredSourceRect;
-            This->fn_copy_scanline = NearestNeighbor_CopyScanline;
             break;
         }
     }
@@ -529,6 +849,12 @@ HRESULT BitmapScaler_Create(IWICBitmapScaler **scaler)
     This->src_height = 0;
     This->mode = 0;
     This->bpp = 0;
+    This->filter_x.taps = This->filter_y.taps = 0;
+    This->filter_x.start = This->filter_y.start = NULL;
+    This->filter_x.weights = This->filter_y.weights = NULL;
+    This->ring = NULL;
+    This->ring_rows = NULL;
+    This->src_row = NULL;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": BitmapScaler.lock");
 
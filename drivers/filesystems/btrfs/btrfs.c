@@ -6023,6 +6023,32 @@ static void check_cpu() {
 }
 #endif
 
+#ifdef _AMD64_
+static void check_cpu_csum() {
+    bool have_ssse3, have_sse41, have_sha = false;
+    int cpu_info[4];
+    int max_leaf;
+
+    __cpuid(cpu_info, 0);
+    max_leaf = cpu_info[0];
+
+    __cpuid(cpu_info, 1);
+    have_ssse3 = cpu_info[2] & (1 << 9);
+    have_sse41 = cpu_info[2] & (1 << 19);
+
+    if (max_leaf >= 7) {
+        __cpuidex(cpu_info, 7, 0);
+        have_sha = cpu_info[1] & (1 << 29);
+    }
+
+    if (have_sha && have_ssse3 && have_sse41) {
+        TRACE("SHA extensions are supported\n");
+        calc_sha256 = calc_sha256_hw;
+    } else
+        TRACE("SHA extensions not supported\n");
+}
+#endif
+
 #ifdef _DEBUG
 static void init_logging() {
     ExAcquireResourceExclusiveLite(&log_lock, true);
@@ -6336,6 +6362,10 @@ NTSTATUS __stdcall DriverEntry(_In_ PDRIVER_OBJECT DriverObject, _In_ PUNICODE_S
     check_cpu();
 #endif
 
+#ifdef _AMD64_
+    check_cpu_csum();
+#endif
+
     if (ver.dwMajorVersion > 6 || (ver.dwMajorVersion == 6 && ver.dwMinorVersion >= 2)) { // Windows 8 or above
         UNICODE_STRING name;
         tPsIsDiskCountersEnabled fPsIsDiskCountersEnabled;
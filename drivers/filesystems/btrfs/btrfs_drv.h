@@ -65,6 +65,7 @@
 #include <stdbool.h>
 #include "btrfs.h"
 #include "btrfsioctl.h"
+#include "sha256.h"
 
 #ifdef __REACTOS__
 C_ASSERT(sizeof(bool) == 1);
@@ -1244,7 +1245,6 @@ void _free_fcb(_Inout_ fcb* fcb, _In_ const char* func);
 void init_fast_io_dispatch(FAST_IO_DISPATCH** fiod);
 
 // in sha256.c
-void calc_sha256(uint8_t* hash, const void* input, size_t len);
 #define SHA256_HASH_SIZE 32
 
 // in blake2b-ref.c
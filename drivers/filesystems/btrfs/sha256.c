@@ -1,10 +1,9 @@
 #include <stdint.h>
 #include <string.h>
+#include "sha256.h"
 
 // Public domain code from https://github.com/amosnier/sha-2
 
-// FIXME - x86 SHA extensions
-
 #define CHUNK_SIZE 64
 #define TOTAL_LEN_LEN 8
 
@@ -21,7 +20,11 @@
  * Initialize array of round constants:
  * (first 32 bits of the fractional parts of the cube roots of the first 64 primes 2..311):
  */
-static const uint32_t k[] = {
+#ifdef _AMD64_
+const uint32_t sha256_k[] = {
+#else
+static const uint32_t sha256_k[] = {
+#endif
 	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
 	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
 	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
@@ -32,6 +35,16 @@ static const uint32_t k[] = {
 	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
 };
 
+#ifdef _AMD64_
+/* pshufb mask converting the big-endian message words */
+const uint8_t sha256_flip_mask[] = {
+	0x03, 0x02, 0x01, 0x00, 0x07, 0x06, 0x05, 0x04, 0x0b, 0x0a, 0x09, 0x08, 0x0f, 0x0e, 0x0d, 0x0c
+};
+
+// in sha256-ni.S
+void __stdcall sha256_transform_ni(uint32_t* state, const uint8_t* data, size_t blocks);
+#endif
+
 struct buffer_state {
 	const uint8_t * p;
 	size_t len;
@@ -123,7 +136,7 @@ static int calc_chunk(uint8_t chunk[CHUNK_SIZE], struct buffer_state * state)
  *   for bit string lengths that are not multiples of eight, and it really operates on arrays of bytes.
  *   In particular, the len parameter is a number of bytes.
  */
-void calc_sha256(uint8_t* hash, const void* input, size_t len)
+void calc_sha256_sw(uint8_t* hash, const void* input, size_t len)
 {
 	/*
 	 * Note 1: All integers (expect indexes) are 32-bit unsigned integers and addition is calculated modulo 2^32.
@@ -190,7 +203,7 @@ void calc_sha256(uint8_t* hash, const void* input, size_t len)
 				{
 					const uint32_t s1 = right_rot(ah[4], 6) ^ right_rot(ah[4], 11) ^ right_rot(ah[4], 25);
 					const uint32_t ch = (ah[4] & ah[5]) ^ (~ah[4] & ah[6]);
-					const uint32_t temp1 = ah[7] + s1 + ch + k[i << 4 | j] + w[j];
+					const uint32_t temp1 = ah[7] + s1 + ch + sha256_k[i << 4 | j] + w[j];
 					const uint32_t s0 = right_rot(ah[0], 2) ^ right_rot(ah[0], 13) ^ right_rot(ah[0], 22);
 					const uint32_t maj = (ah[0] & ah[1]) ^ (ah[0] & ah[2]) ^ (ah[1] & ah[2]);
 					const uint32_t temp2 = s0 + maj;
@@ -221,3 +234,36 @@ void calc_sha256(uint8_t* hash, const void* input, size_t len)
 		hash[j++] = (uint8_t) h[i];
 	}
 }
+
+#ifdef _AMD64_
+/* As calc_sha256_sw, but using the x86 SHA extensions */
+void calc_sha256_hw(uint8_t* hash, const void* input, size_t len)
+{
+	uint32_t h[] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+	size_t blocks = len / CHUNK_SIZE;
+	unsigned i, j;
+	uint8_t chunk[64];
+	struct buffer_state state;
+
+	/* Whole blocks are hashed in place, only the tail goes through the padding buffer. */
+	sha256_transform_ni(h, input, blocks);
+
+	init_buf_state(&state, input, len);
+	state.p += blocks * CHUNK_SIZE;
+	state.len -= blocks * CHUNK_SIZE;
+
+	while (calc_chunk(chunk, &state)) {
+		sha256_transform_ni(h, chunk, 1);
+	}
+
+	for (i = 0, j = 0; i < 8; i++)
+	{
+		hash[j++] = (uint8_t) (h[i] >> 24);
+		hash[j++] = (uint8_t) (h[i] >> 16);
+		hash[j++] = (uint8_t) (h[i] >> 8);
+		hash[j++] = (uint8_t) h[i];
+	}
+}
+#endif
+
+sha256_func calc_sha256 = calc_sha256_sw;
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef _AMD64_
+void calc_sha256_hw(uint8_t* hash, const void* input, size_t len);
+#endif
+
+void calc_sha256_sw(uint8_t* hash, const void* input, size_t len);
+
+typedef void (*sha256_func)(uint8_t* hash, const void* input, size_t len);
+
+extern sha256_func calc_sha256;
+
+#ifdef __cplusplus
+}
+#endif
@@ -290,6 +290,46 @@ NpCancelDataQueueIrp(IN PDEVICE_OBJECT DeviceObject,
     NpCompleteDeferredIrps(&DeferredList);
 }
 
+PVOID
+NTAPI
+NpLockDirectBuffer(IN PIRP Irp,
+                   IN ULONG Length,
+                   IN LOCK_OPERATION Operation)
+{
+    PMDL Mdl;
+    PVOID SystemBuffer;
+    PAGED_CODE();
+
+    /* The IRP must not have an MDL yet, the one allocated below becomes Irp->MdlAddress */
+    ASSERT(Irp->MdlAddress == NULL);
+
+    Mdl = IoAllocateMdl(Irp->UserBuffer, Length, FALSE, FALSE, Irp);
+    if (!Mdl) return NULL;
+
+    _SEH2_TRY
+    {
+        MmProbeAndLockPages(Mdl, Irp->RequestorMode, Operation);
+    }
+    _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
+    {
+        Irp->MdlAddress = NULL;
+        IoFreeMdl(Mdl);
+        _SEH2_YIELD(return NULL);
+    }
+    _SEH2_END;
+
+    /* The MDL stays attached to the IRP, completing it unlocks the pages */
+    SystemBuffer = MmGetSystemAddressForMdlSafe(Mdl, NormalPagePriority);
+    if (!SystemBuffer)
+    {
+        MmUnlockPages(Mdl);
+        Irp->MdlAddress = NULL;
+        IoFreeMdl(Mdl);
+    }
+
+    return SystemBuffer;
+}
+
 NTSTATUS
 NTAPI
 NpAddDataQueueEntry(IN ULONG NamedPipeEnd,
@@ -307,6 +347,8 @@ NpAddDataQueueEntry(IN ULONG NamedPipeEnd,
     SIZE_T EntrySize;
     ULONG QuotaInEntry;
     PSECURITY_CLIENT_CONTEXT ClientContext;
+    PIO_STACK_LOCATION IoStack;
+    PVOID DirectBuffer;
     BOOLEAN HasSpace;
 
     ClientContext = NULL;
@@ -327,6 +369,27 @@ NpAddDataQueueEntry(IN ULONG NamedPipeEnd,
         }
     }
 
+    DirectBuffer = NULL;
+    if ((Type == Buffered) && (Irp) && (DataSize >= NP_DIRECT_TRANSFER_THRESHOLD))
+    {
+        IoStack = IoGetCurrentIrpStackLocation(Irp);
+        if ((Who == ReadEntries) && (IoStack->MajorFunction == IRP_MJ_READ))
+        {
+            /* Let the writer copy straight into the reader's buffer */
+            DirectBuffer = NpLockDirectBuffer(Irp, DataSize, IoWriteAccess);
+        }
+        else if ((Who == WriteEntries) &&
+                 (IoStack->MajorFunction == IRP_MJ_WRITE) &&
+                 (DataQueue->Quota - DataQueue->QuotaUsed < DataSize - ByteOffset))
+        {
+            /* This write pends anyway, so don't copy it into the queue:
+             * keep the writer's pages locked and have the readers copy
+             * from them, the IRP completes once everything was read */
+            DirectBuffer = NpLockDirectBuffer(Irp, DataSize, IoReadAccess);
+            if (DirectBuffer) Type = Unbuffered;
+        }
+    }
+
     switch (Type)
     {
         case Unbuffered:
@@ -348,6 +411,7 @@ NpAddDataQueueEntry(IN ULONG NamedPipeEnd,
             DataEntry->Irp = Irp;
             DataEntry->DataSize = DataSize;
             DataEntry->ClientSecurityContext = ClientContext;
+            DataEntry->DirectBuffer = DirectBuffer;
             ASSERT((DataQueue->QueueState == Empty) || (DataQueue->QueueState == Who));
             Status = STATUS_PENDING;
             break;
@@ -390,6 +454,7 @@ NpAddDataQueueEntry(IN ULONG NamedPipeEnd,
             DataEntry->DataEntryType = Buffered;
             DataEntry->ClientSecurityContext = ClientContext;
             DataEntry->DataSize = DataSize;
+            DataEntry->DirectBuffer = DirectBuffer;
 
             if (Who == ReadEntries)
             {
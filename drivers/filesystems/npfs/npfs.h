@@ -32,6 +32,12 @@
 #define MIN_INDEXED_LENGTH 5
 #define MAX_INDEXED_LENGTH 9
 
+//
+// Transfers of at least this size are done directly between the locked
+// buffers of the reader and the writer instead of through pool copies
+//
+#define NP_DIRECT_TRANSFER_THRESHOLD 0x10000
+
 /* TYPEDEFS & DEFINES *********************************************************/
 
 //
@@ -153,6 +159,7 @@ typedef struct _NP_DATA_QUEUE_ENTRY
     ULONG QuotaInEntry;
     PSECURITY_CLIENT_CONTEXT ClientSecurityContext;
     ULONG DataSize;
+    PVOID DirectBuffer;
 } NP_DATA_QUEUE_ENTRY, *PNP_DATA_QUEUE_ENTRY;
 
 /* A Wait Queue. Only the VCB has one of these. */
@@ -421,6 +428,12 @@ NTAPI
 NpCompleteStalledWrites(IN PNP_DATA_QUEUE DataQueue,
                         IN PLIST_ENTRY List);
 
+PVOID
+NTAPI
+NpLockDirectBuffer(IN PIRP Irp,
+                   IN ULONG Length,
+                   IN LOCK_OPERATION Operation);
+
 NTSTATUS
 NTAPI
 NpInitializeDataQueue(IN PNP_DATA_QUEUE DataQueue,
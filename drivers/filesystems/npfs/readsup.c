@@ -59,7 +59,11 @@ NpReadDataQueue(IN PNP_DATA_QUEUE DataQueue,
             DataEntry->DataEntryType == Buffered ||
             DataEntry->DataEntryType == Unbuffered)
         {
-            if (DataEntry->DataEntryType == Unbuffered)
+            if (DataEntry->DirectBuffer)
+            {
+                DataBuffer = DataEntry->DirectBuffer;
+            }
+            else if (DataEntry->DataEntryType == Unbuffered)
             {
                 DataBuffer = DataEntry->Irp->AssociatedIrp.SystemBuffer;
             }
@@ -98,8 +102,12 @@ NpReadDataQueue(IN PNP_DATA_QUEUE DataQueue,
 
             if (!Peek)
             {
-                DataEntry->QuotaInEntry -= DataLength;
-                DataQueue->QuotaUsed -= DataLength;
+                /* Unbuffered entries don't hold any quota */
+                if (DataEntry->DataEntryType == Buffered)
+                {
+                    DataEntry->QuotaInEntry -= DataLength;
+                    DataQueue->QuotaUsed -= DataLength;
+                }
                 DataQueue->ByteOffset += DataLength;
                 CompleteWrites = TRUE;
             }
@@ -80,7 +80,13 @@ NpWriteDataQueue(IN PNP_DATA_QUEUE WriteQueue,
         BufferSize = *BytesNotWritten;
         if (BufferSize >= DataSize) BufferSize = DataSize;
 
-        if (DataEntry->DataEntryType != Unbuffered && BufferSize)
+        if (DataEntry->DirectBuffer)
+        {
+            /* The reader's buffer is locked, fill it in place */
+            Buffer = DataEntry->DirectBuffer;
+            AllocatedBuffer = FALSE;
+        }
+        else if (DataEntry->DataEntryType != Unbuffered && BufferSize)
         {
             Buffer = ExAllocatePoolWithTag(NonPagedPool, BufferSize, NPFS_DATA_ENTRY_TAG);
             if (!Buffer) return STATUS_INSUFFICIENT_RESOURCES;
@@ -97,6 +97,8 @@ FindFile(
     UNICODE_STRING PathNameU;
     UNICODE_STRING FileToFindUpcase;
     BOOLEAN WildCard;
+    BOOLEAN UseNameCache;
+    PVOID CacheContext;
     BOOLEAN IsFatX = vfatVolumeIsFatX(DeviceExt);
 
     DPRINT("FindFile(Parent %p, FileToFind '%wZ', DirIndex: %u)\n",
@@ -169,6 +171,19 @@ FindFile(
         return Status;
     }
 
+    /* A full search for a plain name can be answered from the lookup cache */
+    UseNameCache = (!WildCard && First && DirContext->DirIndex == 0);
+    if (UseNameCache &&
+        FsRtlFindInNameCache(&DeviceExt->NameCache, (ULONG_PTR)Parent, &FileToFindUpcase, &CacheContext))
+    {
+        /* Only the misses are cached, hits are served by the FCB table */
+        ASSERT(CacheContext == NULL);
+        DPRINT("FindFile: '%wZ' known not to exist\n", FileToFindU);
+        RtlFreeUnicodeString(&FileToFindUpcase);
+        ExFreePoolWithTag(PathNameBuffer, TAG_NAME);
+        return STATUS_NO_MORE_ENTRIES;
+    }
+
     while (TRUE)
     {
         Status = VfatGetNextDirEntry(DeviceExt, &Context, &Page, Parent, DirContext, First);
@@ -244,6 +259,11 @@ FindFile(
         CcUnpinData(Context);
     }
 
+    if (UseNameCache && Status == STATUS_NO_MORE_ENTRIES)
+    {
+        FsRtlAddToNameCache(&DeviceExt->NameCache, (ULONG_PTR)Parent, &FileToFindUpcase, NULL);
+    }
+
     RtlFreeUnicodeString(&FileToFindUpcase);
     ExFreePoolWithTag(PathNameBuffer, TAG_NAME);
     return Status;
@@ -18,6 +18,24 @@
 extern UNICODE_STRING DebugFile;
 #endif
 
+/*
+ * A new name was written to the directory: the lookup cache
+ * may still remember it as missing
+ */
+static
+VOID
+vfatNameCacheEntryAdded(
+    IN PDEVICE_EXTENSION DeviceExt,
+    IN PVFATFCB ParentFcb,
+    IN PVFAT_DIRENTRY_CONTEXT DirContext)
+{
+    FsRtlDeleteNameFromNameCache(&DeviceExt->NameCache, (ULONG_PTR)ParentFcb, &DirContext->LongNameU);
+    if (DirContext->ShortNameU.Length != 0)
+    {
+        FsRtlDeleteNameFromNameCache(&DeviceExt->NameCache, (ULONG_PTR)ParentFcb, &DirContext->ShortNameU);
+    }
+}
+
 NTSTATUS
 vfatFCBInitializeCacheFromVolume(
     PVCB vcb,
@@ -234,6 +252,7 @@ vfatRenameEntry(
 
         CcSetDirtyPinnedData(Context, NULL);
         CcUnpinData(Context);
+        vfatNameCacheEntryAdded(DeviceExt, pFcb->parentFcb, &DirContext);
 
         Status = vfatUpdateFCB(DeviceExt, pFcb, &DirContext, pFcb->parentFcb);
         if (NT_SUCCESS(Status))
@@ -760,6 +779,7 @@ FATAddEntry(
     }
     CcSetDirtyPinnedData(Context, NULL);
     CcUnpinData(Context);
+    vfatNameCacheEntryAdded(DeviceExt, ParentFcb, &DirContext);
 
     if (MoveContext != NULL)
     {
@@ -932,6 +952,7 @@ FATXAddEntry(
     RtlCopyMemory(pFatXDirEntry, &DirContext.DirEntry.FatX, sizeof(FATX_DIR_ENTRY));
     CcSetDirtyPinnedData(Context, NULL);
     CcUnpinData(Context);
+    vfatNameCacheEntryAdded(DeviceExt, ParentFcb, &DirContext);
 
     if (MoveContext != NULL)
     {
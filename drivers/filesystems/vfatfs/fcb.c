@@ -385,6 +385,11 @@ _vfatReleaseFCB(
             ASSERT(pFCB->OpenHandleCount == 0);
             tmpFcb = pFCB->parentFcb;
             vfatDelFCBFromTable(pVCB, pFCB);
+            if (vfatFCBIsDirectory(pFCB))
+            {
+                /* The FCB address may be reused for another directory */
+                FsRtlDeleteKeyFromNameCache(&pVCB->NameCache, (ULONG_PTR)pFCB);
+            }
             vfatDestroyFCB(pFCB);
         }
         else
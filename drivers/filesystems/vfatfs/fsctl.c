@@ -780,6 +780,9 @@ VfatMount(
     InitializeListHead(&DeviceExt->NotifyList);
     FsRtlNotifyInitializeSync(&DeviceExt->NotifySync);
 
+    /* And the directory lookup cache */
+    FsRtlInitializeNameCache(&DeviceExt->NameCache, 0);
+
     /* The VCB is OK for usage */
     SetFlag(DeviceExt->Flags, VCB_GOOD);
 
@@ -54,6 +54,9 @@ vfatKdbgHandler(
         {
             DeviceExt = CONTAINING_RECORD(ListEntry, DEVICE_EXTENSION, VolumeListEntry);
             DPRINT1("Volume: %p with VCB: %p\n", DeviceExt->VolumeDevice, DeviceExt);
+            DPRINT1("    Name cache: %lu entries, %lu hits, %lu misses\n",
+                    DeviceExt->NameCache.NumEntries, DeviceExt->NameCache.Hits,
+                    DeviceExt->NameCache.Misses);
             ++Count;
         }
 
@@ -657,6 +657,7 @@ VfatCheckForDismount(
 
         /* Uninitialize the notify synchronization object */
         FsRtlNotifyUninitializeSync(&DeviceExt->NotifySync);
+        FsRtlDeleteNameCache(&DeviceExt->NameCache);
 
         /* Release resources */
         ExFreePoolWithTag(DeviceExt->Statistics, TAG_STATS);
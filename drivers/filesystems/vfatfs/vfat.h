@@ -6,6 +6,7 @@
 #include <dos.h>
 #include <pseh/pseh2.h>
 #include <section_attribs.h>
+#include <reactos/fsnamecache.h>
 #ifdef KDBG
 #include <ndk/kdfuncs.h>
 #include <reactos/kdros.h>
@@ -351,6 +352,9 @@ typedef struct DEVICE_EXTENSION
     LIST_ENTRY NotifyList;
     PNOTIFY_SYNC NotifySync;
 
+    /* Results of directory lookups, mostly of files that don't exist */
+    FSRTL_NAME_CACHE NameCache;
+
     /* Incremented on IRP_MJ_CREATE, decremented on IRP_MJ_CLOSE */
     ULONG OpenHandleCount;
 
@@ -0,0 +1,121 @@
+/*
+ * PROJECT:     ReactOS API tests
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Tests for CopyFileW and CopyFileExW
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "precomp.h"
+
+#ifndef COPY_FILE_NO_BUFFERING
+#define COPY_FILE_NO_BUFFERING  0x00001000
+#endif
+
+static const WCHAR SourceName[] = L"CopyFileSrc.tmp";
+static const WCHAR DestName[] = L"CopyFileDst.tmp";
+
+static
+BOOL
+CreateTestFile(
+    LPCWSTR FileName,
+    DWORD Size)
+{
+    HANDLE hFile;
+    PUCHAR Buffer;
+    DWORD i, Written;
+    BOOL Ret;
+
+    Buffer = HeapAlloc(GetProcessHeap(), 0, Size + 1);
+    if (!Buffer)
+        return FALSE;
+
+    for (i = 0; i < Size; i++)
+        Buffer[i] = (UCHAR)(i * 7 + i / 4096);
+
+    hFile = CreateFileW(FileName, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        HeapFree(GetProcessHeap(), 0, Buffer);
+        return FALSE;
+    }
+
+    Ret = WriteFile(hFile, Buffer, Size, &Written, NULL) && Written == Size;
+    CloseHandle(hFile);
+    HeapFree(GetProcessHeap(), 0, Buffer);
+    return Ret;
+}
+
+static
+VOID
+CheckCopy(
+    LPCWSTR FileName,
+    DWORD Size,
+    DWORD Flags)
+{
+    HANDLE hFile;
+    PUCHAR Buffer;
+    DWORD i, Read;
+    LARGE_INTEGER FileSize;
+
+    hFile = CreateFileW(FileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    ok(hFile != INVALID_HANDLE_VALUE, "Size %lu, flags 0x%lx: failed opening the copy: %lu\n", Size, Flags, GetLastError());
+    if (hFile == INVALID_HANDLE_VALUE)
+        return;
+
+    ok(GetFileSizeEx(hFile, &FileSize), "GetFileSizeEx failed: %lu\n", GetLastError());
+    ok(FileSize.QuadPart == Size, "Size %lu, flags 0x%lx: copy is %I64d bytes\n", Size, Flags, FileSize.QuadPart);
+
+    Buffer = HeapAlloc(GetProcessHeap(), 0, Size + 1);
+    if (!Buffer)
+    {
+        skip("Out of memory\n");
+        CloseHandle(hFile);
+        return;
+    }
+
+    ok(ReadFile(hFile, Buffer, Size + 1, &Read, NULL), "ReadFile failed: %lu\n", GetLastError());
+    ok(Read == Size, "Size %lu, flags 0x%lx: read %lu bytes\n", Size, Flags, Read);
+    for (i = 0; i < Read; i++)
+    {
+        if (Buffer[i] != (UCHAR)(i * 7 + i / 4096))
+            break;
+    }
+    ok(i == Read, "Size %lu, flags 0x%lx: data differs at offset %lu\n", Size, Flags, i);
+
+    HeapFree(GetProcessHeap(), 0, Buffer);
+    CloseHandle(hFile);
+}
+
+START_TEST(CopyFile)
+{
+    /* Sizes that aren't a multiple of the sector size, on both sides of the copy chunk size */
+    static const DWORD Sizes[] = { 0, 1, 511, 513, 4097, 0x80000 - 1, 0x80000, 0x80000 + 1, 0x400000 + 123, 0xC00000 + 4097 };
+    static const DWORD Flags[] = { 0, COPY_FILE_NO_BUFFERING };
+    ULONG i, j;
+    BOOL Ret;
+
+    for (i = 0; i < _countof(Sizes); i++)
+    {
+        if (!CreateTestFile(SourceName, Sizes[i]))
+        {
+            skip("Failed creating a %lu bytes file: %lu\n", Sizes[i], GetLastError());
+            continue;
+        }
+
+        for (j = 0; j < _countof(Flags); j++)
+        {
+            DeleteFileW(DestName);
+            SetLastError(0xdeadbeef);
+            if (Flags[j] == 0)
+                Ret = CopyFileW(SourceName, DestName, FALSE);
+            else
+                Ret = CopyFileExW(SourceName, DestName, NULL, NULL, NULL, Flags[j]);
+            ok(Ret, "Size %lu, flags 0x%lx: copy failed: %lu\n", Sizes[i], Flags[j], GetLastError());
+            if (Ret)
+                CheckCopy(DestName, Sizes[i], Flags[j]);
+        }
+    }
+
+    DeleteFileW(DestName);
+    DeleteFileW(SourceName);
+}
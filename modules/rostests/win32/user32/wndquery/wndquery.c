@@ -0,0 +1,241 @@
+/*
+ * PROJECT:     ReactOS Tests
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Measures the throughput of read-only window queries
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/*
+ * Usage: wndquery [threads] [milliseconds]
+ *
+ * Every thread runs each query in a loop for the given time, so running
+ * with several threads shows how much the queries contend with each other.
+ */
+
+#include <windef.h>
+#include <winbase.h>
+#include <winuser.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_THREADS 64
+
+static HWND hwndTop, hwndChild, hwndPopup, hwndForeign;
+static DWORD dwDuration = 1000;
+static HANDLE hStartEvent;
+
+typedef VOID (*QUERY_PROC)(VOID);
+
+static VOID QueryWindowRect(VOID)
+{
+    RECT rc;
+    GetWindowRect(hwndChild, &rc);
+}
+
+static VOID QueryClientRect(VOID)
+{
+    RECT rc;
+    GetClientRect(hwndChild, &rc);
+}
+
+static VOID QueryStyle(VOID)
+{
+    GetWindowLongPtrW(hwndChild, GWL_STYLE);
+}
+
+static VOID QueryParent(VOID)
+{
+    GetParent(hwndChild);
+}
+
+static VOID QueryRoot(VOID)
+{
+    GetAncestor(hwndChild, GA_ROOT);
+}
+
+static VOID QueryRootOwner(VOID)
+{
+    GetAncestor(hwndPopup, GA_ROOTOWNER);
+}
+
+static VOID QueryVisible(VOID)
+{
+    IsWindowVisible(hwndChild);
+}
+
+static VOID QueryClassWord(VOID)
+{
+    GetClassWord(hwndChild, GCW_ATOM);
+}
+
+static VOID QueryOwnThreadId(VOID)
+{
+    DWORD dwProcessId;
+    GetWindowThreadProcessId(hwndTop, &dwProcessId);
+}
+
+static VOID QueryForeignThreadId(VOID)
+{
+    DWORD dwProcessId;
+    GetWindowThreadProcessId(hwndForeign, &dwProcessId);
+}
+
+static const struct
+{
+    PCSTR pszName;
+    QUERY_PROC Proc;
+} Queries[] =
+{
+    { "GetWindowRect",                      QueryWindowRect },
+    { "GetClientRect",                      QueryClientRect },
+    { "GetWindowLongPtr(GWL_STYLE)",        QueryStyle },
+    { "GetParent",                          QueryParent },
+    { "GetAncestor(GA_ROOT)",               QueryRoot },
+    { "GetAncestor(GA_ROOTOWNER)",          QueryRootOwner },
+    { "IsWindowVisible",                    QueryVisible },
+    { "GetClassWord(GCW_ATOM)",             QueryClassWord },
+    { "GetWindowThreadProcessId (own)",     QueryOwnThreadId },
+    { "GetWindowThreadProcessId (foreign)", QueryForeignThreadId },
+};
+
+typedef struct _BENCH_THREAD
+{
+    QUERY_PROC Proc;
+    ULONGLONG cCalls;
+} BENCH_THREAD, *PBENCH_THREAD;
+
+static DWORD WINAPI
+BenchThread(LPVOID lpParameter)
+{
+    PBENCH_THREAD pThread = lpParameter;
+    ULONGLONG cCalls = 0;
+    DWORD dwStart;
+    ULONG i;
+
+    WaitForSingleObject(hStartEvent, INFINITE);
+
+    dwStart = GetTickCount();
+    while (GetTickCount() - dwStart < dwDuration)
+    {
+        /* Don't let the tick count dominate the loop */
+        for (i = 0; i < 256; i++)
+            pThread->Proc();
+        cCalls += 256;
+    }
+
+    pThread->cCalls = cCalls;
+    return 0;
+}
+
+static DWORD WINAPI
+ForeignWindowThread(LPVOID lpParameter)
+{
+    HANDLE hReadyEvent = lpParameter;
+    MSG msg;
+
+    hwndForeign = CreateWindowExW(0, L"STATIC", L"wndquery foreign", WS_POPUP,
+                                  0, 0, 10, 10, NULL, NULL, NULL, NULL);
+    SetEvent(hReadyEvent);
+
+    while (GetMessageW(&msg, NULL, 0, 0) > 0)
+        DispatchMessageW(&msg);
+
+    DestroyWindow(hwndForeign);
+    return 0;
+}
+
+static ULONGLONG
+RunQuery(QUERY_PROC Proc, ULONG cThreads)
+{
+    BENCH_THREAD Threads[MAX_THREADS];
+    HANDLE hThreads[MAX_THREADS];
+    ULONGLONG cCalls = 0;
+    ULONG i;
+
+    ResetEvent(hStartEvent);
+
+    for (i = 0; i < cThreads; i++)
+    {
+        Threads[i].Proc = Proc;
+        Threads[i].cCalls = 0;
+        hThreads[i] = CreateThread(NULL, 0, BenchThread, &Threads[i], 0, NULL);
+        if (!hThreads[i])
+        {
+            printf("CreateThread failed, error %lu\n", GetLastError());
+            exit(1);
+        }
+    }
+
+    SetEvent(hStartEvent);
+    WaitForMultipleObjects(cThreads, hThreads, TRUE, INFINITE);
+
+    for (i = 0; i < cThreads; i++)
+    {
+        CloseHandle(hThreads[i]);
+        cCalls += Threads[i].cCalls;
+    }
+
+    return cCalls;
+}
+
+int wmain(int argc, WCHAR *argv[])
+{
+    ULONG cThreads = 1;
+    HANDLE hReadyEvent, hForeignThread;
+    DWORD dwForeignThreadId;
+    ULONGLONG cCalls;
+    ULONG i;
+
+    if (argc > 1)
+        cThreads = wcstoul(argv[1], NULL, 0);
+    if (argc > 2)
+        dwDuration = wcstoul(argv[2], NULL, 0);
+
+    if (cThreads == 0 || cThreads > MAX_THREADS || dwDuration == 0)
+    {
+        printf("Usage: wndquery [threads (1-%d)] [milliseconds]\n", MAX_THREADS);
+        return 1;
+    }
+
+    hwndTop = CreateWindowExW(0, L"STATIC", L"wndquery", WS_OVERLAPPEDWINDOW | WS_VISIBLE,
+                              0, 0, 200, 200, NULL, NULL, NULL, NULL);
+    hwndChild = CreateWindowExW(0, L"STATIC", NULL, WS_CHILD | WS_VISIBLE,
+                                10, 10, 50, 50, hwndTop, NULL, NULL, NULL);
+    hwndPopup = CreateWindowExW(0, L"STATIC", NULL, WS_POPUP,
+                                0, 0, 50, 50, hwndTop, NULL, NULL, NULL);
+    if (!hwndTop || !hwndChild || !hwndPopup)
+    {
+        printf("CreateWindowEx failed, error %lu\n", GetLastError());
+        return 1;
+    }
+
+    hStartEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    hReadyEvent = CreateEventW(NULL, FALSE, FALSE, NULL);
+    hForeignThread = CreateThread(NULL, 0, ForeignWindowThread, hReadyEvent, 0,
+                                  &dwForeignThreadId);
+    if (!hStartEvent || !hReadyEvent || !hForeignThread)
+    {
+        printf("Setup failed, error %lu\n", GetLastError());
+        return 1;
+    }
+    WaitForSingleObject(hReadyEvent, INFINITE);
+
+    printf("%lu thread(s), %lu ms per query\n\n", cThreads, dwDuration);
+    printf("%-38s %14s\n", "Query", "calls/sec");
+
+    for (i = 0; i < ARRAYSIZE(Queries); i++)
+    {
+        cCalls = RunQuery(Queries[i].Proc, cThreads);
+        printf("%-38s %14I64u\n", Queries[i].pszName, cCalls * 1000 / dwDuration);
+    }
+
+    PostThreadMessageW(dwForeignThreadId, WM_QUIT, 0, 0);
+    WaitForSingleObject(hForeignThread, INFINITE);
+    CloseHandle(hForeignThread);
+    CloseHandle(hReadyEvent);
+    CloseHandle(hStartEvent);
+
+    DestroyWindow(hwndTop);
+    return 0;
+}
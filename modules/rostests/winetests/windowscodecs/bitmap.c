@@ -1314,6 +1314,189 @@ static void test_bitmap_scaler(void)
     IWICBitmap_Release(bitmap);
 }
 
+static const WICBitmapInterpolationMode scaler_modes[] =
+{
+    WICBitmapInterpolationModeNearestNeighbor,
+    WICBitmapInterpolationModeLinear,
+    WICBitmapInterpolationModeCubic,
+    WICBitmapInterpolationModeFant,
+};
+
+static IWICBitmapScaler *create_scaler(const WICPixelFormatGUID *format, UINT width, UINT height,
+    UINT stride, BYTE *bits, UINT dst_width, UINT dst_height, WICBitmapInterpolationMode mode)
+{
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    HRESULT hr;
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, width, height, format, stride,
+        stride * height, bits, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#x.\n", hr);
+
+    hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+    ok(hr == S_OK, "Failed to create bitmap scaler, hr %#x.\n", hr);
+
+    hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, dst_width, dst_height, mode);
+    ok(hr == S_OK, "Mode %d: failed to initialize bitmap scaler, hr %#x.\n", mode, hr);
+
+    IWICBitmap_Release(bitmap);
+    return scaler;
+}
+
+static void test_bitmap_scaler_modes(void)
+{
+    static const WICPixelFormatGUID *formats[] =
+    {
+        &GUID_WICPixelFormat8bppGray,
+        &GUID_WICPixelFormat8bppIndexed,
+        &GUID_WICPixelFormat24bppBGR,
+        &GUID_WICPixelFormat32bppBGRA,
+    };
+    static const struct
+    {
+        UINT width, height;
+    }
+    sizes[] = { { 7, 9 }, { 3, 2 }, { 5, 1 } };
+    static BYTE gray_step[4] = { 0, 255 };
+    static BYTE gray_quad[] = { 0, 100, 200, 50 };
+    static BYTE indexed[] = { 0, 1, 0, 0, 2, 3, 0, 0 };
+    static const BYTE indexed_expect[] =
+    {
+        0, 0, 1, 1,
+        0, 0, 1, 1,
+        2, 2, 3, 3,
+        2, 2, 3, 3,
+    };
+    WICPixelFormatGUID pixel_format;
+    IWICBitmapScaler *scaler;
+    BYTE src[5 * 5 * 4], full[9 * 9 * 3], rows[9 * 9 * 3], buf[9 * 9 * 4];
+    WICRect rc;
+    UINT i, j, k, x, y, stride;
+    HRESULT hr;
+
+    for (i = 0; i < ARRAY_SIZE(scaler_modes); i++)
+    {
+        /* the filtered modes keep the pixel format of the source */
+        for (j = 0; j < ARRAY_SIZE(formats); j++)
+        {
+            memset(src, 0, sizeof(src));
+            scaler = create_scaler(formats[j], 4, 4, 16, src, 8, 2, scaler_modes[i]);
+
+            memset(&pixel_format, 0, sizeof(pixel_format));
+            hr = IWICBitmapScaler_GetPixelFormat(scaler, &pixel_format);
+            ok(hr == S_OK, "Failed to get pixel format, hr %#x.\n", hr);
+            ok(IsEqualGUID(&pixel_format, formats[j]), "Mode %d: unexpected pixel format %s for %s.\n",
+                scaler_modes[i], wine_dbgstr_guid(&pixel_format), wine_dbgstr_guid(formats[j]));
+
+            IWICBitmapScaler_Release(scaler);
+        }
+
+        /* a uniform image stays uniform */
+        for (k = 0; k < ARRAY_SIZE(sizes); k++)
+        {
+            for (j = 0; j < 5 * 5; j++)
+            {
+                src[j * 3 + 0] = 0x10;
+                src[j * 3 + 1] = 0x80;
+                src[j * 3 + 2] = 0xf0;
+            }
+            scaler = create_scaler(&GUID_WICPixelFormat24bppBGR, 5, 5, 15, src,
+                sizes[k].width, sizes[k].height, scaler_modes[i]);
+
+            stride = sizes[k].width * 3;
+            memset(buf, 0xcc, sizeof(buf));
+            hr = IWICBitmapScaler_CopyPixels(scaler, NULL, stride, stride * sizes[k].height, buf);
+            ok(hr == S_OK, "Failed to copy pixels, hr %#x.\n", hr);
+            for (j = 0; j < sizes[k].width * sizes[k].height; j++)
+            {
+                if (buf[j * 3] != 0x10 || buf[j * 3 + 1] != 0x80 || buf[j * 3 + 2] != 0xf0)
+                    break;
+            }
+            ok(j == sizes[k].width * sizes[k].height, "Mode %d, %ux%u: unexpected pixel %u: %02x%02x%02x.\n",
+                scaler_modes[i], sizes[k].width, sizes[k].height, j, buf[j * 3 + 2], buf[j * 3 + 1], buf[j * 3]);
+
+            IWICBitmapScaler_Release(scaler);
+        }
+
+        /* copying the rows one by one gives the same pixels as copying them all at once */
+        for (k = 0; k < ARRAY_SIZE(sizes); k++)
+        {
+            for (j = 0; j < 5 * 5 * 3; j++)
+                src[j] = (BYTE)(j * 37 + (j / 15) * 11);
+            scaler = create_scaler(&GUID_WICPixelFormat24bppBGR, 5, 5, 15, src,
+                sizes[k].width, sizes[k].height, scaler_modes[i]);
+
+            stride = sizes[k].width * 3;
+            hr = IWICBitmapScaler_CopyPixels(scaler, NULL, stride, stride * sizes[k].height, full);
+            ok(hr == S_OK, "Failed to copy pixels, hr %#x.\n", hr);
+
+            memset(rows, 0xcc, sizeof(rows));
+            for (y = 0; y < sizes[k].height; y++)
+            {
+                rc.X = 0;
+                rc.Y = y;
+                rc.Width = sizes[k].width;
+                rc.Height = 1;
+                hr = IWICBitmapScaler_CopyPixels(scaler, &rc, stride, stride, rows + y * stride);
+                ok(hr == S_OK, "Failed to copy pixels, hr %#x.\n", hr);
+            }
+            ok(!memcmp(full, rows, stride * sizes[k].height), "Mode %d, %ux%u: rows differ.\n",
+                scaler_modes[i], sizes[k].width, sizes[k].height);
+
+            /* and so does a part of the columns, going back up */
+            for (y = sizes[k].height; y-- > 0;)
+            {
+                rc.X = 1;
+                rc.Y = y;
+                rc.Width = sizes[k].width - 1;
+                rc.Height = 1;
+                hr = IWICBitmapScaler_CopyPixels(scaler, &rc, stride, stride, buf);
+                ok(hr == S_OK, "Failed to copy pixels, hr %#x.\n", hr);
+                ok(!memcmp(buf, full + y * stride + 3, (sizes[k].width - 1) * 3),
+                    "Mode %d, %ux%u: row %u differs.\n", scaler_modes[i], sizes[k].width, sizes[k].height, y);
+            }
+
+            IWICBitmapScaler_Release(scaler);
+        }
+
+        /* an edge keeps its end values when enlarged */
+        scaler = create_scaler(&GUID_WICPixelFormat8bppGray, 2, 1, 4, gray_step, 8, 1, scaler_modes[i]);
+        hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 8, 8, buf);
+        ok(hr == S_OK, "Failed to copy pixels, hr %#x.\n", hr);
+        ok(buf[0] == 0 && buf[7] == 255, "Mode %d: unexpected ends %u, %u.\n", scaler_modes[i], buf[0], buf[7]);
+        if (scaler_modes[i] != WICBitmapInterpolationModeCubic)
+        {
+            for (x = 1; x < 8; x++)
+                ok(buf[x] >= buf[x - 1], "Mode %d: pixel %u decreases: %u < %u.\n",
+                   scaler_modes[i], x, buf[x], buf[x - 1]);
+        }
+        IWICBitmapScaler_Release(scaler);
+
+        /* palette indices are never interpolated */
+        scaler = create_scaler(&GUID_WICPixelFormat8bppIndexed, 2, 2, 4, indexed, 4, 4, scaler_modes[i]);
+        memset(buf, 0xcc, sizeof(buf));
+        hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 4, 16, buf);
+        ok(hr == S_OK, "Failed to copy pixels, hr %#x.\n", hr);
+        ok(!memcmp(buf, indexed_expect, sizeof(indexed_expect)), "Mode %d: unexpected indices.\n", scaler_modes[i]);
+        IWICBitmapScaler_Release(scaler);
+    }
+
+    /* halving averages the pixel pairs */
+    for (i = 0; i < ARRAY_SIZE(scaler_modes); i++)
+    {
+        if (scaler_modes[i] != WICBitmapInterpolationModeLinear &&
+            scaler_modes[i] != WICBitmapInterpolationModeFant)
+            continue;
+
+        scaler = create_scaler(&GUID_WICPixelFormat8bppGray, 4, 1, 4, gray_quad, 2, 1, scaler_modes[i]);
+        memset(buf, 0xcc, sizeof(buf));
+        hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 2, 2, buf);
+        ok(hr == S_OK, "Failed to copy pixels, hr %#x.\n", hr);
+        ok(buf[0] == 50 && buf[1] == 125, "Mode %d: unexpected pixels %u, %u.\n", scaler_modes[i], buf[0], buf[1]);
+        IWICBitmapScaler_Release(scaler);
+    }
+}
+
 static LONG obj_refcount(void *obj)
 {
     IUnknown_AddRef((IUnknown *)obj);
@@ -1484,6 +1667,7 @@ START_TEST(bitmap)
     test_CreateBitmapFromHBITMAP();
     test_clipper();
     test_bitmap_scaler();
+    test_bitmap_scaler_modes();
 
     IWICImagingFactory_Release(factory);
 
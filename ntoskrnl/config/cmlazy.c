@@ -34,7 +34,6 @@ CmpDoFlushNextHive(_In_  BOOLEAN ForceFlush,
                    _Out_ PBOOLEAN Error,
                    _Out_ PULONG DirtyCount)
 {
-    NTSTATUS Status;
     PLIST_ENTRY NextEntry;
     PCMHIVE CmHive;
     BOOLEAN Result;
@@ -63,31 +62,36 @@ CmpDoFlushNextHive(_In_  BOOLEAN ForceFlush,
             /* Great sucess! */
             Result = TRUE;
 
-            /* One less to flush */
-            HiveCount--;
-
             /* Ignore clean or volatile hives */
             if ((!CmHive->Hive.DirtyCount && !ForceFlush) ||
                 (CmHive->Hive.HiveFlags & HIVE_VOLATILE))
             {
-                /* Don't do anything but do update the count */
+                /*
+                 * Don't do anything but do update the count. Clean
+                 * hives don't count against the hives we flush in
+                 * this pass, so that a single pass can write out
+                 * all the dirty hives it is allowed to.
+                 */
                 CmHive->FlushCount = CmpLazyFlushCount;
                 DPRINT("Hive %wZ is clean.\n", &CmHive->FileFullPath);
             }
             else
             {
+                /* One less to flush */
+                HiveCount--;
+
                 /* Do the sync */
                 DPRINT("Flushing: %wZ\n", &CmHive->FileFullPath);
                 DPRINT("Handle: %p\n", CmHive->FileHandles[HFILE_TYPE_PRIMARY]);
-                Status = HvSyncHive(&CmHive->Hive);
-                if(!NT_SUCCESS(Status))
+                if (!HvSyncHive(&CmHive->Hive))
                 {
-                    /* Let them know we failed */
-                    DPRINT1("Failed to flush %wZ on handle %p (status 0x%08lx)\n",
-                        &CmHive->FileFullPath,  CmHive->FileHandles[HFILE_TYPE_PRIMARY], Status);
+                    /*
+                     * Let them know we failed, but don't retry this hive
+                     * before the next round, so the others get flushed.
+                     */
+                    DPRINT1("Failed to flush %wZ on handle %p\n",
+                        &CmHive->FileFullPath, CmHive->FileHandles[HFILE_TYPE_PRIMARY]);
                     *Error = TRUE;
-                    Result = FALSE;
-                    break;
                 }
                 CmHive->FlushCount = CmpLazyFlushCount;
             }
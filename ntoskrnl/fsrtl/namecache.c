@@ -0,0 +1,407 @@
+/*
+ * PROJECT:         ReactOS Kernel
+ * LICENSE:         GPL - See COPYING in the top level directory
+ * FILE:            ntoskrnl/fsrtl/namecache.c
+ * PURPOSE:         Provides a directory lookup cache for file system drivers,
+ *                  so that repeated opens (mostly of files that don't exist)
+ *                  don't have to rescan the directory each time.
+ * PROGRAMMERS:     ReactOS Portable Systems Group
+ */
+
+/* INCLUDES ******************************************************************/
+
+#include <ntoskrnl.h>
+#include <reactos/fsnamecache.h>
+#define NDEBUG
+#include <debug.h>
+
+typedef struct _NAME_CACHE_ENTRY
+{
+    LIST_ENTRY NameLink;
+    LIST_ENTRY KeyLink;
+    LIST_ENTRY LruLink;
+    ULONGLONG DirectoryKey;
+    ULONG Hash;
+    PVOID Context;
+    UNICODE_STRING Name;
+    /* Upcased name follows */
+} NAME_CACHE_ENTRY, *PNAME_CACHE_ENTRY;
+
+#define NAME_CACHE_DEFAULT_ENTRIES  1024
+
+/* PRIVATE FUNCTIONS *********************************************************/
+
+static
+ULONG
+FsRtlpKeyBucket(
+    IN ULONGLONG DirectoryKey)
+{
+    /* Directory keys are usually pool addresses, skip the alignment bits */
+    return ((ULONG)(DirectoryKey >> 4) ^ (ULONG)(DirectoryKey >> 32)) % FSRTL_NAME_CACHE_BUCKETS;
+}
+
+static
+ULONG
+FsRtlpHashName(
+    IN ULONGLONG DirectoryKey,
+    IN PCUNICODE_STRING Name)
+{
+    ULONG Hash, i;
+
+    Hash = (ULONG)DirectoryKey ^ (ULONG)(DirectoryKey >> 32);
+    for (i = 0; i < Name->Length / sizeof(WCHAR); i++)
+    {
+        Hash = Hash * 31 + RtlUpcaseUnicodeChar(Name->Buffer[i]);
+    }
+
+    return Hash;
+}
+
+static
+PNAME_CACHE_ENTRY
+FsRtlpLookupNameCache(
+    IN PFSRTL_NAME_CACHE Cache,
+    IN ULONGLONG DirectoryKey,
+    IN PCUNICODE_STRING Name,
+    IN ULONG Hash)
+{
+    PLIST_ENTRY Bucket, Entry;
+    PNAME_CACHE_ENTRY CurEntry;
+
+    Bucket = &Cache->NameBuckets[Hash % FSRTL_NAME_CACHE_BUCKETS];
+    for (Entry = Bucket->Flink; Entry != Bucket; Entry = Entry->Flink)
+    {
+        CurEntry = CONTAINING_RECORD(Entry, NAME_CACHE_ENTRY, NameLink);
+
+        if (CurEntry->Hash == Hash &&
+            CurEntry->DirectoryKey == DirectoryKey &&
+            RtlEqualUnicodeString(&CurEntry->Name, Name, TRUE))
+        {
+            return CurEntry;
+        }
+    }
+
+    return NULL;
+}
+
+static
+VOID
+FsRtlpRemoveNameCacheEntry(
+    IN PFSRTL_NAME_CACHE Cache,
+    IN PNAME_CACHE_ENTRY CurEntry)
+{
+    RemoveEntryList(&CurEntry->NameLink);
+    RemoveEntryList(&CurEntry->KeyLink);
+    RemoveEntryList(&CurEntry->LruLink);
+    Cache->NumEntries--;
+
+    ExFreePoolWithTag(CurEntry, TAG_NAME_CACHE);
+}
+
+/* PUBLIC FUNCTIONS **********************************************************/
+
+/*++
+ * @name FsRtlInitializeNameCache
+ * @implemented
+ *
+ * Initializes a name lookup cache.
+ *
+ * @param Cache
+ *        Caller allocated, non paged cache structure.
+ *
+ * @param MaxEntries
+ *        Number of lookups to remember, 0 for the default. Least
+ *        recently used entries are discarded once it is reached.
+ *
+ * @return None
+ *
+ * @remarks None
+ *
+ *--*/
+VOID
+NTAPI
+FsRtlInitializeNameCache(IN PFSRTL_NAME_CACHE Cache,
+                         IN ULONG MaxEntries)
+{
+    ULONG i;
+    PAGED_CODE();
+
+    ExInitializeFastMutex(&Cache->Mutex);
+    InitializeListHead(&Cache->LruList);
+
+    for (i = 0; i < FSRTL_NAME_CACHE_BUCKETS; i++)
+    {
+        InitializeListHead(&Cache->NameBuckets[i]);
+        InitializeListHead(&Cache->KeyBuckets[i]);
+    }
+
+    Cache->NumEntries = 0;
+    Cache->MaxEntries = MaxEntries ? MaxEntries : NAME_CACHE_DEFAULT_ENTRIES;
+    Cache->Hits = 0;
+    Cache->Misses = 0;
+}
+
+/*++
+ * @name FsRtlDeleteNameCache
+ * @implemented
+ *
+ * Frees all the entries of a name lookup cache.
+ *
+ * @param Cache
+ *        Cache to empty.
+ *
+ * @return None
+ *
+ * @remarks None
+ *
+ *--*/
+VOID
+NTAPI
+FsRtlDeleteNameCache(IN PFSRTL_NAME_CACHE Cache)
+{
+    PNAME_CACHE_ENTRY CurEntry;
+    PAGED_CODE();
+
+    ExAcquireFastMutex(&Cache->Mutex);
+
+    DPRINT("Name cache %p: %lu hits, %lu misses\n", Cache, Cache->Hits, Cache->Misses);
+
+    while (!IsListEmpty(&Cache->LruList))
+    {
+        CurEntry = CONTAINING_RECORD(Cache->LruList.Flink, NAME_CACHE_ENTRY, LruLink);
+        FsRtlpRemoveNameCacheEntry(Cache, CurEntry);
+    }
+
+    ASSERT(Cache->NumEntries == 0);
+
+    ExReleaseFastMutex(&Cache->Mutex);
+}
+
+/*++
+ * @name FsRtlAddToNameCache
+ * @implemented
+ *
+ * Remembers the result of looking up a name in a directory.
+ *
+ * @param Cache
+ *        Name lookup cache.
+ *
+ * @param DirectoryKey
+ *        Identifies the directory the lookup was done in.
+ *
+ * @param Name
+ *        Name that was looked up, compared case insensitively.
+ *
+ * @param Context
+ *        Value to return for hits, NULL if the name doesn't exist.
+ *
+ * @return None
+ *
+ * @remarks An existing entry for the same name is replaced.
+ *
+ *--*/
+VOID
+NTAPI
+FsRtlAddToNameCache(IN PFSRTL_NAME_CACHE Cache,
+                    IN ULONGLONG DirectoryKey,
+                    IN PCUNICODE_STRING Name,
+                    IN PVOID Context OPTIONAL)
+{
+    PNAME_CACHE_ENTRY NewEntry, CurEntry;
+    ULONG Hash, i;
+    PAGED_CODE();
+
+    Hash = FsRtlpHashName(DirectoryKey, Name);
+
+    /* Prepare the entry outside of the lock */
+    NewEntry = ExAllocatePoolWithTag(PagedPool,
+                                     sizeof(NAME_CACHE_ENTRY) + Name->Length,
+                                     TAG_NAME_CACHE);
+    if (!NewEntry)
+    {
+        /* It's only a cache */
+        return;
+    }
+
+    NewEntry->DirectoryKey = DirectoryKey;
+    NewEntry->Hash = Hash;
+    NewEntry->Context = Context;
+    NewEntry->Name.Length = NewEntry->Name.MaximumLength = Name->Length;
+    NewEntry->Name.Buffer = (PWCHAR)(NewEntry + 1);
+    for (i = 0; i < Name->Length / sizeof(WCHAR); i++)
+    {
+        NewEntry->Name.Buffer[i] = RtlUpcaseUnicodeChar(Name->Buffer[i]);
+    }
+
+    ExAcquireFastMutex(&Cache->Mutex);
+
+    CurEntry = FsRtlpLookupNameCache(Cache, DirectoryKey, Name, Hash);
+    if (CurEntry)
+    {
+        FsRtlpRemoveNameCacheEntry(Cache, CurEntry);
+    }
+
+    InsertHeadList(&Cache->NameBuckets[Hash % FSRTL_NAME_CACHE_BUCKETS], &NewEntry->NameLink);
+    InsertHeadList(&Cache->KeyBuckets[FsRtlpKeyBucket(DirectoryKey)], &NewEntry->KeyLink);
+    InsertHeadList(&Cache->LruList, &NewEntry->LruLink);
+    Cache->NumEntries++;
+
+    /* Drop the least recently used entries */
+    while (Cache->NumEntries > Cache->MaxEntries)
+    {
+        CurEntry = CONTAINING_RECORD(Cache->LruList.Blink, NAME_CACHE_ENTRY, LruLink);
+        FsRtlpRemoveNameCacheEntry(Cache, CurEntry);
+    }
+
+    ExReleaseFastMutex(&Cache->Mutex);
+}
+
+/*++
+ * @name FsRtlFindInNameCache
+ * @implemented
+ *
+ * Looks for a previous lookup of a name in a directory.
+ *
+ * @param Cache
+ *        Name lookup cache.
+ *
+ * @param DirectoryKey
+ *        Identifies the directory to look in.
+ *
+ * @param Name
+ *        Name to look for, compared case insensitively.
+ *
+ * @param Context
+ *        Receives the context given when the entry was added, NULL
+ *        for a name known not to exist.
+ *
+ * @return TRUE if the cache knows the answer, FALSE if the directory
+ *         has to be searched.
+ *
+ * @remarks None
+ *
+ *--*/
+BOOLEAN
+NTAPI
+FsRtlFindInNameCache(IN PFSRTL_NAME_CACHE Cache,
+                     IN ULONGLONG DirectoryKey,
+                     IN PCUNICODE_STRING Name,
+                     OUT PVOID *Context)
+{
+    PNAME_CACHE_ENTRY CurEntry;
+    ULONG Hash;
+    PAGED_CODE();
+
+    Hash = FsRtlpHashName(DirectoryKey, Name);
+
+    ExAcquireFastMutex(&Cache->Mutex);
+
+    CurEntry = FsRtlpLookupNameCache(Cache, DirectoryKey, Name, Hash);
+    if (CurEntry)
+    {
+        /* Make it the most recently used one */
+        RemoveEntryList(&CurEntry->LruLink);
+        InsertHeadList(&Cache->LruList, &CurEntry->LruLink);
+
+        *Context = CurEntry->Context;
+        Cache->Hits++;
+    }
+    else
+    {
+        Cache->Misses++;
+    }
+
+    ExReleaseFastMutex(&Cache->Mutex);
+
+    return (CurEntry != NULL);
+}
+
+/*++
+ * @name FsRtlDeleteNameFromNameCache
+ * @implemented
+ *
+ * Forgets about a name in a directory, typically because it was just
+ * created or renamed to.
+ *
+ * @param Cache
+ *        Name lookup cache.
+ *
+ * @param DirectoryKey
+ *        Identifies the directory.
+ *
+ * @param Name
+ *        Name to forget, compared case insensitively.
+ *
+ * @return None
+ *
+ * @remarks None
+ *
+ *--*/
+VOID
+NTAPI
+FsRtlDeleteNameFromNameCache(IN PFSRTL_NAME_CACHE Cache,
+                             IN ULONGLONG DirectoryKey,
+                             IN PCUNICODE_STRING Name)
+{
+    PNAME_CACHE_ENTRY CurEntry;
+    ULONG Hash;
+    PAGED_CODE();
+
+    Hash = FsRtlpHashName(DirectoryKey, Name);
+
+    ExAcquireFastMutex(&Cache->Mutex);
+
+    CurEntry = FsRtlpLookupNameCache(Cache, DirectoryKey, Name, Hash);
+    if (CurEntry)
+    {
+        FsRtlpRemoveNameCacheEntry(Cache, CurEntry);
+    }
+
+    ExReleaseFastMutex(&Cache->Mutex);
+}
+
+/*++
+ * @name FsRtlDeleteKeyFromNameCache
+ * @implemented
+ *
+ * Forgets about all the names of a directory, to be called before
+ * its key can be reused.
+ *
+ * @param Cache
+ *        Name lookup cache.
+ *
+ * @param DirectoryKey
+ *        Identifies the directory.
+ *
+ * @return None
+ *
+ * @remarks None
+ *
+ *--*/
+VOID
+NTAPI
+FsRtlDeleteKeyFromNameCache(IN PFSRTL_NAME_CACHE Cache,
+                            IN ULONGLONG DirectoryKey)
+{
+    PLIST_ENTRY Bucket, Entry, NextEntry;
+    PNAME_CACHE_ENTRY CurEntry;
+    PAGED_CODE();
+
+    ExAcquireFastMutex(&Cache->Mutex);
+
+    Bucket = &Cache->KeyBuckets[FsRtlpKeyBucket(DirectoryKey)];
+    for (Entry = Bucket->Flink; Entry != Bucket; Entry = NextEntry)
+    {
+        NextEntry = Entry->Flink;
+        CurEntry = CONTAINING_RECORD(Entry, NAME_CACHE_ENTRY, KeyLink);
+
+        if (CurEntry->DirectoryKey == DirectoryKey)
+        {
+            FsRtlpRemoveNameCacheEntry(Cache, CurEntry);
+        }
+    }
+
+    ExReleaseFastMutex(&Cache->Mutex);
+}
+
+/* EOF */
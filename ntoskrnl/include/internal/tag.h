@@ -49,6 +49,7 @@
 #define TAG_RANGE   'ARSF'
 #define TAG_FLOCK   'KCLF'
 #define TAG_OPLOCK  'orSF'
+#define TAG_NAME_CACHE 'cNSF'
 
 /* FSTUB Tag */
 #define TAG_FSTUB   'BtsF'
@@ -181,6 +181,11 @@ KdbSymPrintAddress(
     IN PVOID Address,
     IN PCONTEXT Context);
 
+BOOLEAN
+KdbSymGetAddress(
+    IN PCSTR Name,
+    OUT PVOID *Address);
+
 VOID
 KdbSymProcessSymbols(
     _Inout_ PLDR_DATA_TABLE_ENTRY LdrEntry,
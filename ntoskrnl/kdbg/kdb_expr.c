@@ -444,7 +444,9 @@ RpnpParseExpression(
     INT_PTR i, i2;
     ULONG64 ull;
     UCHAR MemorySize;
-    CHAR Buffer[16];
+    CHAR Buffer[128];
+    SIZE_T OperandLength;
+    PVOID SymbolAddress;
     BOOLEAN First;
 
     ASSERT(Stack);
@@ -544,13 +546,19 @@ RpnpParseExpression(
 
 get_operand:
         i = strcspn(p, "+-*/%()[]<>!=");
+
+        /* A '!' not starting "!=" separates a module name from a symbol name */
+        if (i > 0 && p[i] == '!' && p[i + 1] != '=')
+            i += 1 + strcspn(p + i + 1, "+-*/%()[]<>!=");
+
         if (i > 0)
         {
             i2 = i;
 
-            /* Copy register name/memory size */
+            /* Copy register name/memory size/symbol name */
             while (isspace(p[--i2]));
 
+            OperandLength = i2 + 1;
             i2 = min(i2 + 1, (INT)sizeof (Buffer) - 1);
             strncpy(Buffer, p, i2);
             Buffer[i2] = '\0';
@@ -609,6 +617,25 @@ get_operand:
                     CharacterOffset += pend - p;
                     p = pend;
                 }
+                else if (OperandLength < sizeof(Buffer) &&
+                         KdbSymGetAddress(Buffer, &SymbolAddress))
+                {
+                    /* Symbol name */
+                    RpnOp.Type = RpnOpImmediate;
+                    RpnOp.CharacterOffset = CharacterOffset;
+                    RpnOp.Data.Immediate = (ULONG_PTR)SymbolAddress;
+                    CharacterOffset += OperandLength;
+                    p += OperandLength;
+                }
+                else if (isalpha(*p) || *p == '_')
+                {
+                    CONST_STRCPY(ErrMsg, "Unknown symbol");
+
+                    if (ErrOffset)
+                        *ErrOffset = CharacterOffset;
+
+                    return FALSE;
+                }
                 else
                 {
                     CONST_STRCPY(ErrMsg, "Operand expected");
@@ -192,6 +192,73 @@ KdbSymPrintAddress(
     return TRUE;
 }
 
+/*! \brief Find the address of a function...
+ *
+ * \param Name     Name of the function, optionally prefixed with the name of
+ *                 its module and a '!' (e.g. "ntoskrnl!KeBugCheckEx" or
+ *                 "ntoskrnl.exe!KeBugCheckEx").
+ * \param Address  Pointer to a PVOID which is filled with the address.
+ *
+ * Without a module name, the modules are searched in load order.
+ *
+ * \retval TRUE   The function was found, \a Address was filled.
+ * \retval FALSE  No module with symbols knows the function.
+ */
+BOOLEAN
+KdbSymGetAddress(
+    IN PCSTR Name,
+    OUT PVOID *Address)
+{
+    PLDR_DATA_TABLE_ENTRY LdrEntry;
+    ULONG_PTR RelativeAddress;
+    PCSTR FunctionName;
+    SIZE_T ModuleNameLength = 0;
+    CHAR ModuleNameAnsi[64];
+    PCHAR Extension;
+    INT Index;
+
+    FunctionName = strchr(Name, '!');
+    if (FunctionName)
+    {
+        ModuleNameLength = FunctionName - Name;
+        FunctionName++;
+    }
+    else
+    {
+        FunctionName = Name;
+    }
+
+    for (Index = 0; KdbpSymFindModule(NULL, Index, &LdrEntry); Index++)
+    {
+        if (!LdrEntry->PatchInformation)
+            continue;
+
+        if (ModuleNameLength)
+        {
+            KdbpSymUnicodeToAnsi(&LdrEntry->BaseDllName,
+                                 ModuleNameAnsi,
+                                 sizeof(ModuleNameAnsi));
+
+            /* The extension of the module may be left out */
+            if (_strnicmp(ModuleNameAnsi, Name, ModuleNameLength) != 0)
+                continue;
+            Extension = ModuleNameAnsi + ModuleNameLength;
+            if (*Extension != ANSI_NULL && (*Extension != '.' || strchr(Extension + 1, '.')))
+                continue;
+        }
+
+        if (RosSymGetFunctionAddress(LdrEntry->PatchInformation,
+                                     FunctionName,
+                                     &RelativeAddress))
+        {
+            *Address = (PVOID)((ULONG_PTR)LdrEntry->DllBase + RelativeAddress);
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
 static KSTART_ROUTINE LoadSymbolsRoutine;
 /*! \brief          The symbol loader thread routine.
  *                  This opens the image file for reading and loads the symbols
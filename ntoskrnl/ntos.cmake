@@ -111,6 +111,7 @@ list(APPEND SOURCE
     ${REACTOS_SOURCE_DIR}/ntoskrnl/fsrtl/largemcb.c
     ${REACTOS_SOURCE_DIR}/ntoskrnl/fsrtl/mcb.c
     ${REACTOS_SOURCE_DIR}/ntoskrnl/fsrtl/name.c
+    ${REACTOS_SOURCE_DIR}/ntoskrnl/fsrtl/namecache.c
     ${REACTOS_SOURCE_DIR}/ntoskrnl/fsrtl/notify.c
     ${REACTOS_SOURCE_DIR}/ntoskrnl/fsrtl/oplock.c
     ${REACTOS_SOURCE_DIR}/ntoskrnl/fsrtl/pnp.c
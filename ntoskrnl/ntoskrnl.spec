@@ -187,6 +187,7 @@
 @ stdcall FsRtlAddBaseMcbEntry(ptr long long long long long long)
 @ stdcall FsRtlAddLargeMcbEntry(ptr long long long long long long)
 @ stdcall FsRtlAddMcbEntry(ptr long long long)
+@ stdcall FsRtlAddToNameCache(ptr long long ptr ptr)
 @ stdcall FsRtlAddToTunnelCache(ptr long long ptr ptr long long ptr)
 @ stdcall FsRtlAllocateFileLock(ptr ptr)
 @ stdcall FsRtlAllocatePool(long long)
@@ -203,7 +204,10 @@
 @ stdcall FsRtlCopyWrite(ptr ptr long long long ptr ptr ptr)
 @ stdcall FsRtlCreateSectionForDataScan(ptr ptr ptr ptr long ptr ptr long long long)
 @ stdcall FsRtlCurrentBatchOplock(ptr)
+@ stdcall FsRtlDeleteKeyFromNameCache(ptr long long)
 @ stdcall FsRtlDeleteKeyFromTunnelCache(ptr long long)
+@ stdcall FsRtlDeleteNameCache(ptr)
+@ stdcall FsRtlDeleteNameFromNameCache(ptr long long ptr)
 @ stdcall FsRtlDeleteTunnelCache(ptr)
 @ stdcall FsRtlDeregisterUncProvider(ptr)
 @ stdcall FsRtlDissectDbcs(long ptr ptr ptr)
@@ -215,6 +219,7 @@
 @ stdcall FsRtlFastUnlockAll(ptr ptr ptr ptr)
 @ stdcall FsRtlFastUnlockAllByKey(ptr ptr ptr long ptr)
 @ stdcall FsRtlFastUnlockSingle(ptr ptr ptr ptr ptr long ptr long)
+@ stdcall FsRtlFindInNameCache(ptr long long ptr ptr)
 @ stdcall FsRtlFindInTunnelCache(ptr long long ptr ptr ptr ptr ptr)
 @ stdcall FsRtlFreeFileLock(ptr)
 @ stdcall FsRtlGetFileSize(ptr ptr)
@@ -230,6 +235,7 @@
 @ stdcall FsRtlInitializeFileLock(ptr ptr ptr)
 @ stdcall FsRtlInitializeLargeMcb(ptr long)
 @ stdcall FsRtlInitializeMcb(ptr long)
+@ stdcall FsRtlInitializeNameCache(ptr long)
 @ stdcall FsRtlInitializeOplock(ptr)
 @ stdcall FsRtlInitializeTunnelCache(ptr)
 @ stdcall FsRtlInsertPerFileObjectContext(ptr ptr)
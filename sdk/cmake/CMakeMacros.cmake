@@ -869,6 +869,12 @@ else()
     set(ROSSYM_LIB "")
 endif()
 
+if(TOOLS_CACHE_DIR)
+    set(SPEC2DEF_CACHE_ARG "--cache=${TOOLS_CACHE_DIR}")
+else()
+    set(SPEC2DEF_CACHE_ARG "")
+endif()
+
 function(add_rc_deps _target_rc)
     set_source_files_properties(${_target_rc} PROPERTIES OBJECT_DEPENDS "${ARGN}")
 endfunction()
@@ -24,6 +24,10 @@ function(add_typelib)
     endforeach()
 endfunction()
 
+# FIXME: widl takes a single input file, so every IDL file is compiled by its own
+# widl process, which parses all the IDL files it imports again. Compiling a batch
+# of them in one run, sharing the imports, needs widl to reset its parser and
+# output state between input files.
 function(add_idl_headers TARGET)
     get_includes(INCLUDES)
     get_defines(DEFINES)
@@ -0,0 +1,90 @@
+/*
+ * PROJECT:     ReactOS Kernel
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     File system name lookup cache (ReactOS extension to FsRtl)
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FSRTL_NAME_CACHE_BUCKETS 64
+
+/*
+ * Remembers the outcome of directory lookups, keyed by the parent
+ * directory (usually the address of its FCB) and the name that was
+ * looked up. Entries with a NULL context are negative: the name is
+ * known not to exist in that directory. The file system owns the
+ * storage and is responsible for dropping entries when a name gets
+ * added to a directory and when a directory key goes away.
+ */
+typedef struct _FSRTL_NAME_CACHE
+{
+    FAST_MUTEX Mutex;
+    LIST_ENTRY LruList;
+    LIST_ENTRY NameBuckets[FSRTL_NAME_CACHE_BUCKETS];
+    LIST_ENTRY KeyBuckets[FSRTL_NAME_CACHE_BUCKETS];
+    ULONG NumEntries;
+    ULONG MaxEntries;
+    /* Lookup statistics, for debugging (vfatfs shows them in ?fat.vols) */
+    ULONG Hits;
+    ULONG Misses;
+} FSRTL_NAME_CACHE, *PFSRTL_NAME_CACHE;
+
+_IRQL_requires_max_(APC_LEVEL)
+NTKERNELAPI
+VOID
+NTAPI
+FsRtlInitializeNameCache(
+    _Out_ PFSRTL_NAME_CACHE Cache,
+    _In_ ULONG MaxEntries);
+
+_IRQL_requires_max_(APC_LEVEL)
+NTKERNELAPI
+VOID
+NTAPI
+FsRtlDeleteNameCache(
+    _In_ PFSRTL_NAME_CACHE Cache);
+
+_IRQL_requires_max_(APC_LEVEL)
+NTKERNELAPI
+VOID
+NTAPI
+FsRtlAddToNameCache(
+    _In_ PFSRTL_NAME_CACHE Cache,
+    _In_ ULONGLONG DirectoryKey,
+    _In_ PCUNICODE_STRING Name,
+    _In_opt_ PVOID Context);
+
+_IRQL_requires_max_(APC_LEVEL)
+NTKERNELAPI
+BOOLEAN
+NTAPI
+FsRtlFindInNameCache(
+    _In_ PFSRTL_NAME_CACHE Cache,
+    _In_ ULONGLONG DirectoryKey,
+    _In_ PCUNICODE_STRING Name,
+    _Out_ PVOID *Context);
+
+_IRQL_requires_max_(APC_LEVEL)
+NTKERNELAPI
+VOID
+NTAPI
+FsRtlDeleteNameFromNameCache(
+    _In_ PFSRTL_NAME_CACHE Cache,
+    _In_ ULONGLONG DirectoryKey,
+    _In_ PCUNICODE_STRING Name);
+
+_IRQL_requires_max_(APC_LEVEL)
+NTKERNELAPI
+VOID
+NTAPI
+FsRtlDeleteKeyFromNameCache(
+    _In_ PFSRTL_NAME_CACHE Cache,
+    _In_ ULONGLONG DirectoryKey);
+
+#ifdef __cplusplus
+}
+#endif
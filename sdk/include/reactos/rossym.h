@@ -17,10 +17,10 @@ extern "C" {
 #endif
 
 typedef struct _ROSSYM_HEADER {
-  unsigned long SymbolsOffset;
-  unsigned long SymbolsLength;
-  unsigned long StringsOffset;
-  unsigned long StringsLength;
+  ULONG SymbolsOffset;
+  ULONG SymbolsLength;
+  ULONG StringsOffset;
+  ULONG StringsLength;
 } ROSSYM_HEADER, *PROSSYM_HEADER;
 
 typedef struct _ROSSYM_ENTRY {
@@ -30,6 +30,53 @@ typedef struct _ROSSYM_ENTRY {
   ULONG SourceLine;
 } ROSSYM_ENTRY, *PROSSYM_ENTRY;
 
+/*
+ * Version 2 of the section. It starts with a zero where version 1 has
+ * SymbolsOffset, so version 1 readers reject it instead of misreading it.
+ *
+ * The data following the header, optionally zlib compressed, holds:
+ * - the block index: one ROSSYM_V2_BLOCK for every ROSSYM_V2_BLOCK_ENTRIES
+ *   entries, sorted by address;
+ * - the blocks: each entry is coded as the unsigned LEB128 distance to the
+ *   address of the previous entry (the block start for the first one),
+ *   followed by the zigzag LEB128 differences of FunctionOffset, FileOffset
+ *   and SourceLine with the previous entry of the block (zero for the first);
+ * - the functions: one ROSSYM_V2_FUNCTION per function, sorted by name;
+ * - the same string table as version 1.
+ * All the offsets of the header are relative to the uncompressed data.
+ */
+#define ROSSYM_V2_SIGNATURE       0x32535352 /* "RSS2" */
+#define ROSSYM_V2_COMPRESSED      0x00000001
+#define ROSSYM_V2_BLOCK_ENTRIES   64
+
+typedef struct _ROSSYM_V2_HEADER {
+  ULONG Zero;
+  ULONG Signature;
+  ULONG Flags;
+  ULONG SymbolsCount;
+  ULONG DataOffset;                  /* from the start of the section */
+  ULONG DataLength;                  /* as stored in the section */
+  ULONG RawDataLength;               /* once uncompressed */
+  ULONG BlocksOffset;
+  ULONG BlocksCount;
+  ULONG BlockDataOffset;
+  ULONG BlockDataLength;
+  ULONG FunctionsOffset;
+  ULONG FunctionsCount;
+  ULONG StringsOffset;
+  ULONG StringsLength;
+} ROSSYM_V2_HEADER, *PROSSYM_V2_HEADER;
+
+typedef struct _ROSSYM_V2_BLOCK {
+  ULONG Address;                     /* of the first entry of the block */
+  ULONG DataOffset;                  /* from BlockDataOffset */
+} ROSSYM_V2_BLOCK, *PROSSYM_V2_BLOCK;
+
+typedef struct _ROSSYM_V2_FUNCTION {
+  ULONG NameOffset;                  /* in the string table */
+  ULONG Address;                     /* lowest address of the function */
+} ROSSYM_V2_FUNCTION, *PROSSYM_V2_FUNCTION;
+
 enum _ROSSYM_REGNAME {
     ROSSYM_X86_EAX = 0,
     ROSSYM_X86_ECX,
@@ -120,10 +167,16 @@ struct Dwarf;
 typedef struct Dwarf *PROSSYM_INFO;
 #else
 typedef struct _ROSSYM_INFO {
-  PROSSYM_ENTRY Symbols;
+  PROSSYM_ENTRY Symbols;             /* NULL for version 2 */
   ULONG SymbolsCount;
   PCHAR Strings;
   ULONG StringsLength;
+  PROSSYM_V2_BLOCK Blocks;           /* Version 2 only */
+  ULONG BlocksCount;
+  PUCHAR BlockData;
+  ULONG BlockDataLength;
+  PROSSYM_V2_FUNCTION Functions;
+  ULONG FunctionsCount;
 } ROSSYM_INFO, *PROSSYM_INFO;
 #endif
 
@@ -151,6 +204,9 @@ BOOLEAN RosSymGetAddressInformation(PROSSYM_INFO RosSymInfo,
                                     char *FileName,
                                     char *FunctionName);
 #endif
+BOOLEAN RosSymGetFunctionAddress(PROSSYM_INFO RosSymInfo,
+                                 PCSTR FunctionName,
+                                 ULONG_PTR *RelativeAddress);
 VOID RosSymFreeInfo(PROSSYM_LINEINFO RosSymLineInfo);
 VOID RosSymDelete(PROSSYM_INFO RosSymInfo);
 BOOLEAN
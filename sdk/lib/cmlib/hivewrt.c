@@ -21,6 +21,13 @@ IoSetThreadHardErrorMode(
     _In_ BOOLEAN HardErrorEnabled);
 #endif
 
+/*
+ * Maximum number of hive blocks we coalesce into a single
+ * write request. Adjacent dirty blocks that are also contiguous
+ * in memory (i.e. they belong to the same bin) are written at once.
+ */
+#define HV_MAX_WRITE_RUN_BLOCKS    64
+
 /* GLOBALS ******************************************************************/
 
 /* PRIVATE FUNCTIONS ********************************************************/
@@ -56,6 +63,77 @@ HvpValidateBaseHeader(
     ASSERT(BaseBlock->Major == HSYS_MAJOR);
 }
 
+/**
+ * @brief
+ * Finds the next run of dirty blocks of a hive
+ * that can be written into a file with a single
+ * write request.
+ *
+ * @param[in] RegistryHive
+ * A pointer to a hive descriptor where the dirty
+ * vector is to be looked up.
+ *
+ * @param[in] StartIndex
+ * The block index where the search begins.
+ *
+ * @param[out] RunLength
+ * A pointer to a variable that receives the number
+ * of adjacent dirty blocks the run spans.
+ *
+ * @return
+ * Returns the index of the first block of the run,
+ * or ~HV_CLEAN_BLOCK if there are no dirty blocks
+ * left past the start index.
+ *
+ * @remarks
+ * A run only spans blocks that are contiguous in memory,
+ * hence blocks that belong to different bins are never
+ * merged together. The run is also capped to
+ * HV_MAX_WRITE_RUN_BLOCKS blocks.
+ */
+static
+ULONG
+HvpFindDirtyRun(
+    _In_ PHHIVE RegistryHive,
+    _In_ ULONG StartIndex,
+    _Out_ PULONG RunLength)
+{
+    ULONG BlockIndex;
+    ULONG LastIndex;
+    ULONG_PTR NextAddress;
+    PHMAP_ENTRY BlockList;
+
+    *RunLength = 0;
+
+    if (StartIndex >= RegistryHive->Storage[Stable].Length)
+        return ~HV_CLEAN_BLOCK;
+
+    /*
+     * Check if the block is clean or we're past the last block.
+     * RtlFindSetBits wraps around at the end of the bitmap so
+     * catch that too.
+     */
+    BlockIndex = RtlFindSetBits(&RegistryHive->DirtyVector, 1, StartIndex);
+    if (BlockIndex == ~HV_CLEAN_BLOCK || BlockIndex < StartIndex)
+        return ~HV_CLEAN_BLOCK;
+
+    /* Extend the run as long as the next blocks are dirty and adjacent */
+    BlockList = RegistryHive->Storage[Stable].BlockList;
+    LastIndex = BlockIndex + 1;
+    NextAddress = BlockList[BlockIndex].BlockAddress + HBLOCK_SIZE;
+    while (LastIndex < RegistryHive->Storage[Stable].Length &&
+           (LastIndex - BlockIndex) < HV_MAX_WRITE_RUN_BLOCKS &&
+           RtlCheckBit(&RegistryHive->DirtyVector, LastIndex) &&
+           BlockList[LastIndex].BlockAddress == NextAddress)
+    {
+        NextAddress += HBLOCK_SIZE;
+        LastIndex++;
+    }
+
+    *RunLength = LastIndex - BlockIndex;
+    return BlockIndex;
+}
+
 /**
  * @unimplemented
  * @brief
@@ -90,6 +168,7 @@ HvpWriteLog(
     ULONG BlockIndex;
     ULONG LastIndex;
     PVOID Block;
+    ULONG RunLength;
     UINT32 BitmapSize, BufferSize;
     PUCHAR HeaderBuffer, Ptr;
 
@@ -204,34 +283,37 @@ HvpWriteLog(
         return FALSE;
     }
 
-    /* Now write the actual dirty data to log */
+    /*
+     * Now write the actual dirty data to log. The dirty blocks are
+     * stored back to back in the log, so write each run of adjacent
+     * dirty blocks with a single request.
+     */
     FileOffset = BufferSize;
     BlockIndex = 0;
-    while (BlockIndex < RegistryHive->Storage[Stable].Length)
+    for (;;)
     {
-        /* Check if the block is clean or we're past the last block */
-        LastIndex = BlockIndex;
-        BlockIndex = RtlFindSetBits(&RegistryHive->DirtyVector, 1, BlockIndex);
-        if (BlockIndex == ~HV_CLEAN_BLOCK || BlockIndex < LastIndex)
+        BlockIndex = HvpFindDirtyRun(RegistryHive, BlockIndex, &RunLength);
+        if (BlockIndex == ~HV_CLEAN_BLOCK)
         {
             break;
         }
 
-        /* Get the block */
+        /* Get the first block of the run */
         Block = (PVOID)RegistryHive->Storage[Stable].BlockList[BlockIndex].BlockAddress;
 
         /* Write it to log */
         Success = RegistryHive->FileWrite(RegistryHive, HFILE_TYPE_LOG,
-                                          &FileOffset, Block, HBLOCK_SIZE);
+                                          &FileOffset, Block, RunLength * HBLOCK_SIZE);
         if (!Success)
         {
-            DPRINT1("Failed to write dirty block to log (block 0x%p, block index 0x%x)\n", Block, BlockIndex);
+            DPRINT1("Failed to write dirty blocks to log (block 0x%p, block index 0x%x, count %u)\n",
+                    Block, BlockIndex, RunLength);
             return FALSE;
         }
 
-        /* Grow up the file offset as we go to the next block */
-        BlockIndex++;
-        FileOffset += HBLOCK_SIZE;
+        /* Grow up the file offset as we go to the next run */
+        BlockIndex += RunLength;
+        FileOffset += RunLength * HBLOCK_SIZE;
     }
 
     /*
@@ -316,7 +398,8 @@ HvpWriteHive(
     BOOLEAN Success;
     ULONG FileOffset;
     ULONG BlockIndex;
-    ULONG LastIndex;
+    ULONG RunLength;
+    PHMAP_ENTRY BlockList;
     PVOID Block;
 
     ASSERT(!RegistryHive->ReadOnly);
@@ -361,7 +444,11 @@ HvpWriteHive(
         return FALSE;
     }
 
-    /* Write the whole primary hive, block by block */
+    /*
+     * Write the primary hive. Adjacent blocks are merged
+     * into a single write as long as they are contiguous
+     * in memory.
+     */
     BlockIndex = 0;
     while (BlockIndex < RegistryHive->Storage[Stable].Length)
     {
@@ -374,31 +461,41 @@ HvpWriteHive(
          */
         if (OnlyDirty)
         {
-            /* Check if the block is clean or we're past the last block */
-            LastIndex = BlockIndex;
-            BlockIndex = RtlFindSetBits(&RegistryHive->DirtyVector, 1, BlockIndex);
-            if (BlockIndex == ~HV_CLEAN_BLOCK || BlockIndex < LastIndex)
+            BlockIndex = HvpFindDirtyRun(RegistryHive, BlockIndex, &RunLength);
+            if (BlockIndex == ~HV_CLEAN_BLOCK)
             {
                 break;
             }
         }
+        else
+        {
+            BlockList = RegistryHive->Storage[Stable].BlockList;
+            RunLength = 1;
+            while ((BlockIndex + RunLength) < RegistryHive->Storage[Stable].Length &&
+                   RunLength < HV_MAX_WRITE_RUN_BLOCKS &&
+                   BlockList[BlockIndex + RunLength].BlockAddress ==
+                   BlockList[BlockIndex].BlockAddress + RunLength * HBLOCK_SIZE)
+            {
+                RunLength++;
+            }
+        }
 
-        /* Get the block and offset position */
+        /* Get the first block of the run and offset position */
         Block = (PVOID)RegistryHive->Storage[Stable].BlockList[BlockIndex].BlockAddress;
         FileOffset = (BlockIndex + 1) * HBLOCK_SIZE;
 
-        /* Now write this block to primary hive file */
+        /* Now write this run to primary hive file */
         Success = RegistryHive->FileWrite(RegistryHive, FileType,
-                                          &FileOffset, Block, HBLOCK_SIZE);
+                                          &FileOffset, Block, RunLength * HBLOCK_SIZE);
         if (!Success)
         {
-            DPRINT1("Failed to write hive block to primary hive file (block 0x%p, block index 0x%x)\n",
-                    Block, BlockIndex);
+            DPRINT1("Failed to write hive blocks to primary hive file (block 0x%p, block index 0x%x, count %u)\n",
+                    Block, BlockIndex, RunLength);
             return FALSE;
         }
 
-        /* Go to the next block */
-        BlockIndex++;
+        /* Go to the next run */
+        BlockIndex += RunLength;
     }
 
     /*
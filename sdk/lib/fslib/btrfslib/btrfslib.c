@@ -65,7 +65,7 @@
 #endif
 
 #define SHA256_HASH_SIZE 32
-void calc_sha256(uint8_t* hash, const void* input, size_t len);
+#include "sha256.h"
 
 #define BLAKE2_HASH_SIZE 32
 void blake2b(void *out, size_t outlen, const void* in, size_t inlen);
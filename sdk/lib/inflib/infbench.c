@@ -0,0 +1,150 @@
+/*
+ * PROJECT:     .inf file parser
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Host benchmark of parsing and looking up .inf files
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/*
+ * Usage: infbench [-n iterations] file.inf [file.inf ...]
+ *
+ * Every file is parsed, then every section is walked line by line the way
+ * mkhive does, and every key is looked up the way usetup does. Run it on
+ * the files of boot/bootdata to see how the library scales with their size.
+ */
+
+#include "inflib.h"
+#include "infhost.h"
+
+#include <time.h>
+
+typedef struct _BENCH_RESULT
+{
+    clock_t ParseTime;
+    clock_t WalkTime;
+    clock_t LookupTime;
+    ULONG Sections;
+    ULONG Lines;
+    ULONG Keys;
+} BENCH_RESULT, *PBENCH_RESULT;
+
+static int
+BenchFile(const char *FileName, PBENCH_RESULT Result)
+{
+    HINF hInf;
+    PINFCACHE Cache;
+    PINFCACHESECTION Section;
+    PINFCONTEXT Context;
+    WCHAR *Key, *Data;
+    ULONG ErrorLine;
+    clock_t Start;
+
+    Start = clock();
+    if (InfHostOpenFile(&hInf, FileName, 0, &ErrorLine) != 0)
+    {
+        printf("Unable to open '%s' (error line %u)\n", FileName, (UINT)ErrorLine);
+        return -1;
+    }
+    Result->ParseTime += clock() - Start;
+
+    /* Every section, line by line */
+    Cache = (PINFCACHE)hInf;
+    Start = clock();
+    for (Section = Cache->FirstSection; Section != NULL; Section = Section->Next)
+    {
+        Result->Sections++;
+        if (InfHostFindFirstLine(hInf, Section->Name, NULL, &Context) != 0)
+            continue;
+        do
+        {
+            InfHostGetData(Context, &Key, &Data);
+            Result->Lines++;
+        } while (InfHostFindNextLine(Context, Context) == 0);
+        InfHostFreeContext(Context);
+    }
+    Result->WalkTime += clock() - Start;
+
+    /* Every key of every section */
+    Start = clock();
+    for (Section = Cache->FirstSection; Section != NULL; Section = Section->Next)
+    {
+        PINFCACHELINE Line;
+
+        for (Line = Section->FirstLine; Line != NULL; Line = Line->Next)
+        {
+            if (Line->Key == NULL)
+                continue;
+            Result->Keys++;
+            if (InfHostFindFirstLine(hInf, Section->Name, Line->Key, &Context) == 0)
+                InfHostFreeContext(Context);
+        }
+    }
+    Result->LookupTime += clock() - Start;
+
+    Start = clock();
+    InfHostCloseFile(hInf);
+    Result->ParseTime += clock() - Start;
+    return 0;
+}
+
+static double
+Milliseconds(clock_t Time, ULONG Iterations)
+{
+    return (double)Time * 1000.0 / CLOCKS_PER_SEC / Iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    BENCH_RESULT Result, Total;
+    ULONG Iterations = 10;
+    ULONG i;
+    int Arg = 1;
+
+    if (argc > 2 && strcmp(argv[1], "-n") == 0)
+    {
+        Iterations = strtoul(argv[2], NULL, 0);
+        Arg = 3;
+    }
+    if (Arg >= argc || Iterations == 0)
+    {
+        printf("Usage: infbench [-n iterations] file.inf [file.inf ...]\n");
+        return 1;
+    }
+
+    memset(&Total, 0, sizeof(Total));
+    printf("%-24s %8s %8s %8s %10s %10s %10s\n",
+           "File", "Sections", "Lines", "Keys", "Parse ms", "Walk ms", "Lookup ms");
+
+    for (; Arg < argc; Arg++)
+    {
+        const char *Name = strrchr(argv[Arg], '/');
+
+        memset(&Result, 0, sizeof(Result));
+        for (i = 0; i < Iterations; i++)
+        {
+            if (BenchFile(argv[Arg], &Result) != 0)
+                return 1;
+        }
+
+        printf("%-24s %8u %8u %8u %10.2f %10.2f %10.2f\n",
+               Name ? Name + 1 : argv[Arg],
+               (UINT)(Result.Sections / Iterations),
+               (UINT)(Result.Lines / Iterations),
+               (UINT)(Result.Keys / Iterations),
+               Milliseconds(Result.ParseTime, Iterations),
+               Milliseconds(Result.WalkTime, Iterations),
+               Milliseconds(Result.LookupTime, Iterations));
+
+        Total.ParseTime += Result.ParseTime;
+        Total.WalkTime += Result.WalkTime;
+        Total.LookupTime += Result.LookupTime;
+    }
+
+    printf("%-24s %8s %8s %8s %10.2f %10.2f %10.2f\n", "Total", "", "", "",
+           Milliseconds(Total.ParseTime, Iterations),
+           Milliseconds(Total.WalkTime, Iterations),
+           Milliseconds(Total.LookupTime, Iterations));
+    return 0;
+}
+
+/* EOF */
@@ -82,40 +82,93 @@ static const parser_state_func parser_funcs[NB_PARSER_STATES] =
 
 /* PRIVATE FUNCTIONS ********************************************************/
 
-static PINFCACHELINE
-InfpFreeLine (PINFCACHELINE Line)
+static ULONG
+InfpHashName(PCWSTR Name)
 {
-  PINFCACHELINE Next;
-  PINFCACHEFIELD Field;
+  ULONG Hash = 0;
 
-  if (Line == NULL)
+  /* Case insensitive, the same way as strcmpiW() */
+  while (*Name != 0)
     {
-      return NULL;
+      Hash = Hash * 31 + tolowerW(*Name);
+      Name++;
     }
 
-  Next = Line->Next;
-  if (Line->Key != NULL)
+  return Hash;
+}
+
+
+static PVOID
+InfpAllocate(PINFCACHE Cache,
+             ULONG Size)
+{
+  PINFCACHEBLOCK Block = Cache->Blocks;
+  ULONG BlockSize;
+  PVOID Data;
+
+  Size = (Size + sizeof(ULONGLONG) - 1) & ~(ULONG)(sizeof(ULONGLONG) - 1);
+
+  if (Block == NULL || Block->Size - Block->Used < Size)
     {
-      FREE (Line->Key);
-      Line->Key = NULL;
+      BlockSize = (Size > INF_BLOCK_SIZE) ? Size : INF_BLOCK_SIZE;
+      Block = (PINFCACHEBLOCK)MALLOC(FIELD_OFFSET(INFCACHEBLOCK, Data) + BlockSize);
+      if (Block == NULL)
+        {
+          DPRINT("MALLOC() failed\n");
+          return NULL;
+        }
+      Block->Size = BlockSize;
+      Block->Used = 0;
+
+      /* Keep using the current block for smaller allocations if it has more room */
+      if (Cache->Blocks != NULL &&
+          Cache->Blocks->Size - Cache->Blocks->Used > BlockSize - Size)
+        {
+          Block->Next = Cache->Blocks->Next;
+          Cache->Blocks->Next = Block;
+        }
+      else
+        {
+          Block->Next = Cache->Blocks;
+          Cache->Blocks = Block;
+        }
     }
 
-  /* Remove data fields */
-  while (Line->FirstField != NULL)
+  Data = (PUCHAR)Block->Data + Block->Used;
+  Block->Used += Size;
+  ZEROMEMORY(Data, Size);
+
+  return Data;
+}
+
+
+/* Grows an array of pointers, the new entries are zeroed */
+static PVOID
+InfpGrowArray(PVOID Array,
+              UINT Count,
+              UINT NewCount)
+{
+  PVOID *NewArray;
+
+  NewArray = (PVOID *)MALLOC(NewCount * sizeof(PVOID));
+  if (NewArray == NULL)
     {
-      Field = Line->FirstField->Next;
-      FREE (Line->FirstField);
-      Line->FirstField = Field;
+      DPRINT("MALLOC() failed\n");
+      return NULL;
     }
-  Line->LastField = NULL;
+  ZEROMEMORY(NewArray, NewCount * sizeof(PVOID));
 
-  FREE (Line);
+  if (Array != NULL)
+    {
+      MEMCPY(NewArray, Array, Count * sizeof(PVOID));
+      FREE(Array);
+    }
 
-  return Next;
+  return NewArray;
 }
 
 
-PINFCACHESECTION
+static PINFCACHESECTION
 InfpFreeSection (PINFCACHESECTION Section)
 {
   PINFCACHESECTION Next;
@@ -125,13 +178,16 @@ InfpFreeSection (PINFCACHESECTION Section)
       return NULL;
     }
 
-  /* Release all keys */
+  /* The lines themselves belong to the blocks of the cache */
   Next = Section->Next;
-  while (Section->FirstLine != NULL)
+  if (Section->Lines != NULL)
+    {
+      FREE(Section->Lines);
+    }
+  if (Section->KeyBuckets != NULL)
     {
-      Section->FirstLine = InfpFreeLine (Section->FirstLine);
+      FREE(Section->KeyBuckets);
     }
-  Section->LastLine = NULL;
 
   FREE (Section);
 
@@ -139,6 +195,38 @@ InfpFreeSection (PINFCACHESECTION Section)
 }
 
 
+VOID
+InfpFreeCache(PINFCACHE Cache)
+{
+  PINFCACHEBLOCK Block;
+
+  if (Cache == NULL)
+    {
+      return;
+    }
+
+  while (Cache->FirstSection != NULL)
+    {
+      Cache->FirstSection = InfpFreeSection(Cache->FirstSection);
+    }
+  Cache->LastSection = NULL;
+
+  if (Cache->Sections != NULL)
+    {
+      FREE(Cache->Sections);
+    }
+
+  while (Cache->Blocks != NULL)
+    {
+      Block = Cache->Blocks->Next;
+      FREE(Cache->Blocks);
+      Cache->Blocks = Block;
+    }
+
+  FREE(Cache);
+}
+
+
 PINFCACHESECTION
 InfpFindSection(PINFCACHE Cache,
                 PCWSTR Name)
@@ -150,8 +238,8 @@ InfpFindSection(PINFCACHE Cache,
       return NULL;
     }
 
-  /* iterate through list of sections */
-  Section = Cache->FirstSection;
+  /* iterate through the sections of the name's bucket */
+  Section = Cache->SectionBuckets[InfpHashName(Name) % INF_SECTION_BUCKETS];
   while (Section != NULL)
     {
       if (strcmpiW(Section->Name, Name) == 0)
@@ -160,7 +248,7 @@ InfpFindSection(PINFCACHE Cache,
         }
 
       /* get the next section*/
-      Section = Section->Next;
+      Section = Section->NextName;
     }
 
   return NULL;
@@ -172,6 +260,7 @@ InfpAddSection(PINFCACHE Cache,
                PCWSTR Name)
 {
   PINFCACHESECTION Section = NULL;
+  PINFCACHESECTION *Bucket;
   ULONG Size;
 
   if (Cache == NULL || Name == NULL)
@@ -180,6 +269,21 @@ InfpAddSection(PINFCACHE Cache,
       return NULL;
     }
 
+  /* Make room in the table of sections */
+  if (Cache->NextSectionId >= Cache->SectionsSize)
+    {
+      PINFCACHESECTION *Sections;
+      UINT NewSize = (Cache->SectionsSize != 0) ? Cache->SectionsSize * 2 : 16;
+
+      Sections = InfpGrowArray(Cache->Sections, Cache->SectionsSize, NewSize);
+      if (Sections == NULL)
+        {
+          return NULL;
+        }
+      Cache->Sections = Sections;
+      Cache->SectionsSize = NewSize;
+    }
+
   /* Allocate and initialize the new section */
   Size = (ULONG)FIELD_OFFSET(INFCACHESECTION,
                              Name[strlenW(Name) + 1]);
@@ -192,6 +296,7 @@ InfpAddSection(PINFCACHE Cache,
   ZEROMEMORY (Section,
               Size);
   Section->Id = ++Cache->NextSectionId;
+  Cache->Sections[Section->Id - 1] = Section;
 
   /* Copy section name */
   strcpyW(Section->Name, Name);
@@ -209,12 +314,18 @@ InfpAddSection(PINFCACHE Cache,
       Cache->LastSection = Section;
     }
 
+  /* Make it searchable by name */
+  Bucket = &Cache->SectionBuckets[InfpHashName(Name) % INF_SECTION_BUCKETS];
+  Section->NextName = *Bucket;
+  *Bucket = Section;
+
   return Section;
 }
 
 
 PINFCACHELINE
-InfpAddLine(PINFCACHESECTION Section)
+InfpAddLine(PINFCACHE Cache,
+            PINFCACHESECTION Section)
 {
   PINFCACHELINE Line;
 
@@ -224,15 +335,28 @@ InfpAddLine(PINFCACHESECTION Section)
       return NULL;
     }
 
-  Line = (PINFCACHELINE)MALLOC(sizeof(INFCACHELINE));
+  /* Make room in the table of lines */
+  if (Section->NextLineId >= Section->LinesSize)
+    {
+      PINFCACHELINE *Lines;
+      UINT NewSize = (Section->LinesSize != 0) ? Section->LinesSize * 2 : 8;
+
+      Lines = InfpGrowArray(Section->Lines, Section->LinesSize, NewSize);
+      if (Lines == NULL)
+        {
+          return NULL;
+        }
+      Section->Lines = Lines;
+      Section->LinesSize = NewSize;
+    }
+
+  Line = (PINFCACHELINE)InfpAllocate(Cache, sizeof(INFCACHELINE));
   if (Line == NULL)
     {
-      DPRINT("MALLOC() failed\n");
       return NULL;
     }
-  ZEROMEMORY(Line,
-             sizeof(INFCACHELINE));
   Line->Id = ++Section->NextLineId;
+  Section->Lines[Line->Id - 1] = Line;
 
   /* Append line */
   if (Section->FirstLine == NULL)
@@ -254,19 +378,12 @@ InfpAddLine(PINFCACHESECTION Section)
 PINFCACHESECTION
 InfpFindSectionById(PINFCACHE Cache, UINT Id)
 {
-    PINFCACHESECTION Section;
-
-    for (Section = Cache->FirstSection;
-         Section != NULL;
-         Section = Section->Next)
+    if (Id == 0 || Id > Cache->NextSectionId)
     {
-        if (Section->Id == Id)
-        {
-            return Section;
-        }
+        return NULL;
     }
 
-    return NULL;
+    return Cache->Sections[Id - 1];
 }
 
 PINFCACHESECTION
@@ -291,19 +408,12 @@ InfpGetSectionForContext(PINFCONTEXT Context)
 PINFCACHELINE
 InfpFindLineById(PINFCACHESECTION Section, UINT Id)
 {
-    PINFCACHELINE Line;
-
-    for (Line = Section->FirstLine;
-         Line != NULL;
-         Line = Line->Next)
+    if (Id == 0 || Id > Section->NextLineId)
     {
-        if (Line->Id == Id)
-        {
-            return Line;
-        }
+        return NULL;
     }
 
-    return NULL;
+    return Section->Lines[Id - 1];
 }
 
 PINFCACHELINE
@@ -320,10 +430,55 @@ InfpGetLineForContext(PINFCONTEXT Context)
     return InfpFindLineById(Section, Context->Line);
 }
 
+/* Grows the key hash table of a section, so that it stays at most full */
+static BOOLEAN
+InfpGrowKeyBuckets(PINFCACHESECTION Section)
+{
+  PINFCACHELINE *Buckets;
+  PINFCACHELINE Line, Next;
+  UINT NewCount = (Section->KeyBucketCount != 0) ? Section->KeyBucketCount * 2 : 16;
+  UINT i;
+
+  Buckets = InfpGrowArray(NULL, 0, NewCount);
+  if (Buckets == NULL)
+    {
+      return FALSE;
+    }
+
+  for (i = 0; i < Section->KeyBucketCount; i++)
+    {
+      for (Line = Section->KeyBuckets[i]; Line != NULL; Line = Next)
+        {
+          PINFCACHELINE *Bucket = &Buckets[InfpHashName(Line->Key) & (NewCount - 1)];
+
+          /* Keep the lines of each bucket in file order */
+          Next = Line->NextKey;
+          while (*Bucket != NULL)
+            Bucket = &(*Bucket)->NextKey;
+          Line->NextKey = NULL;
+          *Bucket = Line;
+        }
+    }
+
+  if (Section->KeyBuckets != NULL)
+    {
+      FREE(Section->KeyBuckets);
+    }
+  Section->KeyBuckets = Buckets;
+  Section->KeyBucketCount = NewCount;
+
+  return TRUE;
+}
+
 PVOID
-InfpAddKeyToLine(PINFCACHELINE Line,
+InfpAddKeyToLine(PINFCACHE Cache,
+                 PINFCACHESECTION Section,
+                 PINFCACHELINE Line,
                  PCWSTR Key)
 {
+  PINFCACHELINE *Bucket;
+  PWCHAR LineKey;
+
   if (Line == NULL)
     {
       DPRINT1("Invalid Line\n");
@@ -336,21 +491,39 @@ InfpAddKeyToLine(PINFCACHELINE Line,
       return NULL;
     }
 
-  Line->Key = (PWCHAR)MALLOC((strlenW(Key) + 1) * sizeof(WCHAR));
-  if (Line->Key == NULL)
+  LineKey = (PWCHAR)InfpAllocate(Cache, (ULONG)(strlenW(Key) + 1) * sizeof(WCHAR));
+  if (LineKey == NULL)
     {
-      DPRINT1("MALLOC() failed\n");
+      DPRINT1("InfpAllocate() failed\n");
       return NULL;
     }
+  strcpyW(LineKey, Key);
 
-  strcpyW(Line->Key, Key);
+  /* Only the first line with a given key has to be found by it */
+  if (InfpFindKeyLine(Section, Key) == NULL)
+    {
+      if (Section->KeyCount >= Section->KeyBucketCount &&
+          !InfpGrowKeyBuckets(Section))
+        {
+          return NULL;
+        }
+
+      Bucket = &Section->KeyBuckets[InfpHashName(Key) & (Section->KeyBucketCount - 1)];
+      while (*Bucket != NULL)
+        Bucket = &(*Bucket)->NextKey;
+      *Bucket = Line;
+      Section->KeyCount++;
+    }
+
+  Line->Key = LineKey;
 
   return (PVOID)Line->Key;
 }
 
 
 PVOID
-InfpAddFieldToLine(PINFCACHELINE Line,
+InfpAddFieldToLine(PINFCACHE Cache,
+                   PINFCACHELINE Line,
                    PCWSTR Data)
 {
   PINFCACHEFIELD Field;
@@ -358,14 +531,12 @@ InfpAddFieldToLine(PINFCACHELINE Line,
 
   Size = (ULONG)FIELD_OFFSET(INFCACHEFIELD,
                              Data[strlenW(Data) + 1]);
-  Field = (PINFCACHEFIELD)MALLOC(Size);
+  Field = (PINFCACHEFIELD)InfpAllocate(Cache, Size);
   if (Field == NULL)
     {
-      DPRINT1("MALLOC() failed\n");
+      DPRINT1("InfpAllocate() failed\n");
       return NULL;
     }
-  ZEROMEMORY (Field,
-              Size);
   strcpyW(Field->Data, Data);
 
   /* Append key */
@@ -392,15 +563,20 @@ InfpFindKeyLine(PINFCACHESECTION Section,
 {
   PINFCACHELINE Line;
 
-  Line = Section->FirstLine;
+  if (Section->KeyBuckets == NULL)
+    {
+      return NULL;
+    }
+
+  Line = Section->KeyBuckets[InfpHashName(Key) & (Section->KeyBucketCount - 1)];
   while (Line != NULL)
     {
-      if (Line->Key != NULL && strcmpiW(Line->Key, Key) == 0)
+      if (strcmpiW(Line->Key, Key) == 0)
         {
           return Line;
         }
 
-      Line = Line->Next;
+      Line = Line->NextKey;
     }
 
   return NULL;
@@ -526,7 +702,7 @@ static struct field *add_field_from_token( struct parser *parser, int is_key )
           return NULL;
         }
 
-      parser->line = InfpAddLine(parser->cur_section);
+      parser->line = InfpAddLine(parser->file, parser->cur_section);
       if (parser->line == NULL)
         goto error;
     }
@@ -537,11 +713,12 @@ static struct field *add_field_from_token( struct parser *parser, int is_key )
 
   if (is_key)
     {
-      field = InfpAddKeyToLine(parser->line, parser->token);
+      field = InfpAddKeyToLine(parser->file, parser->cur_section,
+                               parser->line, parser->token);
     }
   else
     {
-      field = InfpAddFieldToLine(parser->line, parser->token);
+      field = InfpAddFieldToLine(parser->file, parser->line, parser->token);
     }
 
   if (field != NULL)
@@ -18,6 +18,9 @@
 #define INF_STATUS_WRONG_INF_STYLE         ((INFSTATUS)0xC0700003)
 #define INF_STATUS_NOT_ENOUGH_MEMORY       ((INFSTATUS)0xC0700004)
 
+#define INF_SECTION_BUCKETS  64     /* hash buckets of the section names */
+#define INF_BLOCK_SIZE       16384  /* allocation unit of the lines and fields */
+
 typedef struct _INFCACHEFIELD
 {
   struct _INFCACHEFIELD *Next;
@@ -30,6 +33,7 @@ typedef struct _INFCACHELINE
 {
   struct _INFCACHELINE *Next;
   struct _INFCACHELINE *Prev;
+  struct _INFCACHELINE *NextKey;     /* next line in the same key bucket */
   UINT Id;
 
   LONG FieldCount;
@@ -45,6 +49,7 @@ typedef struct _INFCACHESECTION
 {
   struct _INFCACHESECTION *Next;
   struct _INFCACHESECTION *Prev;
+  struct _INFCACHESECTION *NextName; /* next section in the same name bucket */
 
   PINFCACHELINE FirstLine;
   PINFCACHELINE LastLine;
@@ -53,9 +58,26 @@ typedef struct _INFCACHESECTION
   LONG LineCount;
   UINT NextLineId;
 
+  PINFCACHELINE *Lines;              /* lines by Id - 1 */
+  UINT LinesSize;
+
+  PINFCACHELINE *KeyBuckets;         /* first line of each key, by key hash */
+  UINT KeyBucketCount;               /* always a power of 2 */
+  UINT KeyCount;
+
   WCHAR Name[1];
 } INFCACHESECTION, *PINFCACHESECTION;
 
+/* Lines, keys and fields live as long as the whole cache, so they are
+ * carved out of large blocks instead of being allocated one by one */
+typedef struct _INFCACHEBLOCK
+{
+  struct _INFCACHEBLOCK *Next;
+  ULONG Size;
+  ULONG Used;
+  ULONGLONG Data[1];
+} INFCACHEBLOCK, *PINFCACHEBLOCK;
+
 typedef struct _INFCACHE
 {
   LANGID LanguageId;
@@ -64,6 +86,12 @@ typedef struct _INFCACHE
   UINT NextSectionId;
 
   PINFCACHESECTION StringsSection;
+
+  PINFCACHESECTION *Sections;        /* sections by Id - 1 */
+  UINT SectionsSize;
+  PINFCACHESECTION SectionBuckets[INF_SECTION_BUCKETS];
+
+  PINFCACHEBLOCK Blocks;
 } INFCACHE, *PINFCACHE;
 
 typedef struct _INFCONTEXT
@@ -82,13 +110,17 @@ extern INFSTATUS InfpParseBuffer(PINFCACHE file,
                                  const WCHAR *buffer,
                                  const WCHAR *end,
                                  PULONG error_line);
-extern PINFCACHESECTION InfpFreeSection(PINFCACHESECTION Section);
+extern VOID InfpFreeCache(PINFCACHE Cache);
 extern PINFCACHESECTION InfpAddSection(PINFCACHE Cache,
                                        PCWSTR Name);
-extern PINFCACHELINE InfpAddLine(PINFCACHESECTION Section);
-extern PVOID InfpAddKeyToLine(PINFCACHELINE Line,
+extern PINFCACHELINE InfpAddLine(PINFCACHE Cache,
+                                 PINFCACHESECTION Section);
+extern PVOID InfpAddKeyToLine(PINFCACHE Cache,
+                              PINFCACHESECTION Section,
+                              PINFCACHELINE Line,
                               PCWSTR Key);
-extern PVOID InfpAddFieldToLine(PINFCACHELINE Line,
+extern PVOID InfpAddFieldToLine(PINFCACHE Cache,
+                                PINFCACHELINE Line,
                                 PCWSTR Data);
 extern PINFCACHELINE InfpFindKeyLine(PINFCACHESECTION Section,
                                      PCWSTR Key);
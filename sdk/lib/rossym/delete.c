@@ -7,7 +7,11 @@
  * PROGRAMMERS:     Ge van Geldorp (gvg@reactos.com)
  */
 
+#ifdef ROSSYM_HOST
+#include <typedefs.h>
+#else
 #include <ntdef.h>
+#endif
 #include <reactos/rossym.h>
 #include "rossympriv.h"
 
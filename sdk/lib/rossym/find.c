@@ -35,7 +35,11 @@
  * SUCH DAMAGE.
  */
 
+#ifdef ROSSYM_HOST
+#include <typedefs.h>
+#else
 #include <ntdef.h>
+#endif
 #include <reactos/rossym.h>
 #include "rossympriv.h"
 
@@ -89,6 +93,109 @@ FindEntry(IN PROSSYM_INFO RosSymInfo, IN ULONG_PTR RelativeAddress)
   return Low;
 }
 
+static BOOLEAN
+ReadLeb128(IN OUT PUCHAR *Data, IN PUCHAR End, OUT PULONG Value)
+{
+  ULONG Shift = 0;
+  UCHAR Byte;
+
+  *Value = 0;
+  do
+    {
+      if (*Data >= End || 32 <= Shift)
+        {
+          return FALSE;
+        }
+      Byte = *(*Data)++;
+      *Value |= (ULONG)(Byte & 0x7f) << Shift;
+      Shift += 7;
+    }
+  while (0 != (Byte & 0x80));
+
+  return TRUE;
+}
+
+static BOOLEAN
+ReadDelta(IN OUT PUCHAR *Data, IN PUCHAR End, IN OUT PULONG Value)
+{
+  ULONG ZigZag;
+
+  if (! ReadLeb128(Data, End, &ZigZag))
+    {
+      return FALSE;
+    }
+  *Value += (ZigZag >> 1) ^ (0 - (ZigZag & 1));
+
+  return TRUE;
+}
+
+static BOOLEAN
+FindEntryV2(IN PROSSYM_INFO RosSymInfo, IN ULONG_PTR RelativeAddress,
+            OUT PROSSYM_ENTRY RosSymEntry)
+{
+  PROSSYM_V2_BLOCK Block;
+  ULONG Low, High, Mid, Index, Count, Delta;
+  PUCHAR Data, End;
+  ROSSYM_ENTRY Entry;
+
+  /* Find the last block starting at or before the address */
+  if (RelativeAddress < RosSymInfo->Blocks[0].Address)
+    {
+      return FALSE;
+    }
+  Low = 0;
+  High = RosSymInfo->BlocksCount;
+  while (High - Low > 1)
+    {
+      Mid = Low + (High - Low) / 2;
+      if (RosSymInfo->Blocks[Mid].Address <= RelativeAddress)
+        {
+          Low = Mid;
+        }
+      else
+        {
+          High = Mid;
+        }
+    }
+  Block = &RosSymInfo->Blocks[Low];
+
+  /* Decode it up to the last entry at or before the address */
+  Data = RosSymInfo->BlockData + Block->DataOffset;
+  End = (Low + 1 < RosSymInfo->BlocksCount) ? RosSymInfo->BlockData + Block[1].DataOffset
+                                            : RosSymInfo->BlockData + RosSymInfo->BlockDataLength;
+  Count = RosSymInfo->SymbolsCount - Low * ROSSYM_V2_BLOCK_ENTRIES;
+  if (Count > ROSSYM_V2_BLOCK_ENTRIES)
+    {
+      Count = ROSSYM_V2_BLOCK_ENTRIES;
+    }
+
+  memset(&Entry, 0, sizeof(Entry));
+  Entry.Address = Block->Address;
+  for (Index = 0; Index < Count; Index++)
+    {
+      if (! ReadLeb128(&Data, End, &Delta))
+        {
+          DPRINT1("Corrupted rossym block %u\n", Low);
+          return FALSE;
+        }
+      if (RelativeAddress < Entry.Address + Delta)
+        {
+          break;
+        }
+      Entry.Address += Delta;
+      if (! ReadDelta(&Data, End, &Entry.FunctionOffset)
+          || ! ReadDelta(&Data, End, &Entry.FileOffset)
+          || ! ReadDelta(&Data, End, &Entry.SourceLine))
+        {
+          DPRINT1("Corrupted rossym block %u\n", Low);
+          return FALSE;
+        }
+      *RosSymEntry = Entry;
+    }
+
+  /* The block address is the address of its first entry */
+  return (0 != Index);
+}
 
 BOOLEAN
 RosSymGetAddressInformation(PROSSYM_INFO RosSymInfo,
@@ -98,10 +205,12 @@ RosSymGetAddressInformation(PROSSYM_INFO RosSymInfo,
                             char *FunctionName)
 {
   PROSSYM_ENTRY RosSymEntry;
+  ROSSYM_ENTRY V2Entry;
 
   DPRINT("RelativeAddress = 0x%08x\n", RelativeAddress);
 
-  if (RosSymInfo->Symbols == NULL || RosSymInfo->SymbolsCount == 0 ||
+  if ((RosSymInfo->Symbols == NULL && RosSymInfo->Blocks == NULL) ||
+      RosSymInfo->SymbolsCount == 0 ||
       RosSymInfo->Strings == NULL || RosSymInfo->StringsLength == 0)
     {
       DPRINT1("Uninitialized RosSymInfo\n");
@@ -111,7 +220,21 @@ RosSymGetAddressInformation(PROSSYM_INFO RosSymInfo,
   ASSERT(LineNumber || FileName || FunctionName);
 
   /* find symbol entry for function */
-  RosSymEntry = FindEntry(RosSymInfo, RelativeAddress);
+  if (RosSymInfo->Blocks != NULL)
+    {
+      RosSymEntry = FindEntryV2(RosSymInfo, RelativeAddress, &V2Entry) ? &V2Entry : NULL;
+      if (RosSymEntry != NULL &&
+          (RosSymEntry->FileOffset >= RosSymInfo->StringsLength ||
+           RosSymEntry->FunctionOffset >= RosSymInfo->StringsLength))
+        {
+          DPRINT1("Corrupted rossym entry\n");
+          return FALSE;
+        }
+    }
+  else
+    {
+      RosSymEntry = FindEntry(RosSymInfo, RelativeAddress);
+    }
 
   if (NULL == RosSymEntry)
     {
@@ -145,4 +268,70 @@ RosSymGetAddressInformation(PROSSYM_INFO RosSymInfo,
   return TRUE;
 }
 
+BOOLEAN
+RosSymGetFunctionAddress(PROSSYM_INFO RosSymInfo,
+                         PCSTR FunctionName,
+                         ULONG_PTR *RelativeAddress)
+{
+  ULONG Low, High, Mid, i;
+  int Compare;
+  BOOLEAN Found = FALSE;
+
+  if (RosSymInfo->Strings == NULL || RosSymInfo->StringsLength == 0)
+    {
+      DPRINT1("Uninitialized RosSymInfo\n");
+      return FALSE;
+    }
+
+  if (RosSymInfo->Functions != NULL)
+    {
+      /* Binary search for the first function with this name */
+      Low = 0;
+      High = RosSymInfo->FunctionsCount;
+      while (Low < High)
+        {
+          Mid = Low + (High - Low) / 2;
+          Compare = strcmp(RosSymInfo->Strings + RosSymInfo->Functions[Mid].NameOffset,
+                           FunctionName);
+          if (Compare < 0)
+            {
+              Low = Mid + 1;
+            }
+          else
+            {
+              High = Mid;
+            }
+        }
+      if (Low < RosSymInfo->FunctionsCount &&
+          0 == strcmp(RosSymInfo->Strings + RosSymInfo->Functions[Low].NameOffset,
+                      FunctionName))
+        {
+          *RelativeAddress = RosSymInfo->Functions[Low].Address;
+          return TRUE;
+        }
+      return FALSE;
+    }
+
+  if (RosSymInfo->Symbols == NULL)
+    {
+      return FALSE;
+    }
+
+  /* Version 1 has no name index, the entries are sorted by address */
+  for (i = 0; i < RosSymInfo->SymbolsCount; i++)
+    {
+      if (RosSymInfo->Symbols[i].FunctionOffset != 0 &&
+          RosSymInfo->Symbols[i].FunctionOffset < RosSymInfo->StringsLength &&
+          0 == strcmp(RosSymInfo->Strings + RosSymInfo->Symbols[i].FunctionOffset,
+                      FunctionName))
+        {
+          *RelativeAddress = RosSymInfo->Symbols[i].Address;
+          Found = TRUE;
+          break;
+        }
+    }
+
+  return Found;
+}
+
 /* EOF */
@@ -15,6 +15,49 @@
 #define NDEBUG
 #include <debug.h>
 
+static BOOLEAN
+RosSymCreateFromFileV2(PVOID FileContext, ULONG SectionOffset,
+                       PROSSYM_HEADER RosSymHeader, PROSSYM_INFO *RosSymInfo)
+{
+  ROSSYM_V2_HEADER V2Header;
+  PVOID Data;
+  BOOLEAN Result;
+
+  /* The start of the header was already read as a version 1 header */
+  memcpy(&V2Header, RosSymHeader, sizeof(ROSSYM_HEADER));
+  if (! RosSymReadFile(FileContext, (char *) &V2Header + sizeof(ROSSYM_HEADER),
+                       sizeof(ROSSYM_V2_HEADER) - sizeof(ROSSYM_HEADER)))
+    {
+      DPRINT1("Failed to read rossym header\n");
+      return FALSE;
+    }
+  if (V2Header.DataOffset < sizeof(ROSSYM_V2_HEADER)
+      || 0 == V2Header.DataLength)
+    {
+      DPRINT1("Invalid ROSSYM_V2_HEADER\n");
+      return FALSE;
+    }
+
+  Data = RosSymAllocMem(V2Header.DataLength);
+  if (NULL == Data)
+    {
+      DPRINT1("Failed to allocate memory for rossym data\n");
+      return FALSE;
+    }
+  if (! RosSymSeekFile(FileContext, SectionOffset + V2Header.DataOffset)
+      || ! RosSymReadFile(FileContext, Data, V2Header.DataLength))
+    {
+      RosSymFreeMem(Data);
+      DPRINT1("Failed to read rossym data\n");
+      return FALSE;
+    }
+
+  Result = RosSymCreateFromV2(&V2Header, Data, RosSymInfo);
+  RosSymFreeMem(Data);
+
+  return Result;
+}
+
 BOOLEAN
 RosSymCreateFromFile(PVOID FileContext, PROSSYM_INFO *RosSymInfo)
 {
@@ -24,6 +67,7 @@ RosSymCreateFromFile(PVOID FileContext, PROSSYM_INFO *RosSymInfo)
   unsigned SectionIndex;
   char SectionName[IMAGE_SIZEOF_SHORT_NAME];
   ROSSYM_HEADER RosSymHeader;
+  ULONG SectionOffset;
 
   /* Load DOS header */
   if (! RosSymReadFile(FileContext, &DosHeader, sizeof(IMAGE_DOS_HEADER)))
@@ -97,7 +141,8 @@ RosSymCreateFromFile(PVOID FileContext, PROSSYM_INFO *RosSymInfo)
     }
 
   /* Load rossym header */
-  if (! RosSymSeekFile(FileContext, SectionHeader->PointerToRawData))
+  SectionOffset = SectionHeader->PointerToRawData;
+  if (! RosSymSeekFile(FileContext, SectionOffset))
     {
       RosSymFreeMem(SectionHeaders);
       DPRINT1("Failed seeking to section data\n");
@@ -109,6 +154,10 @@ RosSymCreateFromFile(PVOID FileContext, PROSSYM_INFO *RosSymInfo)
       DPRINT1("Failed to read rossym header\n");
       return FALSE;
     }
+  if (0 == RosSymHeader.SymbolsOffset)
+    {
+      return RosSymCreateFromFileV2(FileContext, SectionOffset, &RosSymHeader, RosSymInfo);
+    }
   if (RosSymHeader.SymbolsOffset < sizeof(ROSSYM_HEADER)
       || RosSymHeader.StringsOffset < RosSymHeader.SymbolsOffset + RosSymHeader.SymbolsLength
       || 0 != (RosSymHeader.SymbolsLength % sizeof(ROSSYM_ENTRY)))
@@ -130,6 +179,9 @@ RosSymCreateFromFile(PVOID FileContext, PROSSYM_INFO *RosSymInfo)
   (*RosSymInfo)->Strings = (PCHAR) *RosSymInfo + sizeof(ROSSYM_INFO) - sizeof(ROSSYM_HEADER)
                            + RosSymHeader.StringsOffset;
   (*RosSymInfo)->StringsLength = RosSymHeader.StringsLength;
+  (*RosSymInfo)->Blocks = NULL;
+  (*RosSymInfo)->Functions = NULL;
+  (*RosSymInfo)->FunctionsCount = 0;
   if (! RosSymReadFile(FileContext, *RosSymInfo + 1,
                        RosSymHeader.StringsOffset + RosSymHeader.StringsLength
                        - sizeof(ROSSYM_HEADER)))
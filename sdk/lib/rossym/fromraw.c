@@ -7,7 +7,11 @@
  * PROGRAMMERS:     Ge van Geldorp (gvg@reactos.com)
  */
 
+#ifdef ROSSYM_HOST
+#include <typedefs.h>
+#else
 #include <ntdef.h>
+#endif
 #include <reactos/rossym.h>
 #include "rossympriv.h"
 
@@ -20,6 +24,22 @@ RosSymCreateFromRaw(PVOID RawData, ULONG_PTR DataSize, PROSSYM_INFO *RosSymInfo)
   PROSSYM_HEADER RosSymHeader;
 
   RosSymHeader = (PROSSYM_HEADER) RawData;
+  if (0 == RosSymHeader->SymbolsOffset)
+    {
+      PROSSYM_V2_HEADER V2Header = (PROSSYM_V2_HEADER) RawData;
+
+      if (DataSize < sizeof(ROSSYM_V2_HEADER)
+          || V2Header->DataOffset < sizeof(ROSSYM_V2_HEADER)
+          || DataSize < V2Header->DataOffset
+          || DataSize - V2Header->DataOffset < V2Header->DataLength)
+        {
+          DPRINT1("Invalid ROSSYM_V2_HEADER\n");
+          return FALSE;
+        }
+
+      return RosSymCreateFromV2(V2Header, (char *) RawData + V2Header->DataOffset, RosSymInfo);
+    }
+
   if (RosSymHeader->SymbolsOffset < sizeof(ROSSYM_HEADER)
       || RosSymHeader->StringsOffset < RosSymHeader->SymbolsOffset + RosSymHeader->SymbolsLength
       || DataSize < RosSymHeader->StringsOffset + RosSymHeader->StringsLength
@@ -41,6 +61,9 @@ RosSymCreateFromRaw(PVOID RawData, ULONG_PTR DataSize, PROSSYM_INFO *RosSymInfo)
   (*RosSymInfo)->SymbolsCount = RosSymHeader->SymbolsLength / sizeof(ROSSYM_ENTRY);
   (*RosSymInfo)->Strings = (PCHAR) *RosSymInfo + sizeof(ROSSYM_INFO) + RosSymHeader->SymbolsLength;
   (*RosSymInfo)->StringsLength = RosSymHeader->StringsLength;
+  (*RosSymInfo)->Blocks = NULL;
+  (*RosSymInfo)->Functions = NULL;
+  (*RosSymInfo)->FunctionsCount = 0;
   memcpy((*RosSymInfo)->Symbols, (char *) RosSymHeader + RosSymHeader->SymbolsOffset,
          RosSymHeader->SymbolsLength);
   memcpy((*RosSymInfo)->Strings, (char *) RosSymHeader + RosSymHeader->StringsOffset,
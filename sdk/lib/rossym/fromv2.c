@@ -0,0 +1,172 @@
+/*
+ * COPYRIGHT:       See COPYING in the top level directory
+ * PROJECT:         ReactOS kernel
+ * FILE:            lib/rossym/fromv2.c
+ * PURPOSE:         Creating rossym info from version 2 symbol data
+ *
+ * PROGRAMMERS:     ReactOS Team
+ */
+
+#ifdef ROSSYM_HOST
+#include <typedefs.h>
+#else
+#include <ntdef.h>
+#endif
+#include <reactos/rossym.h>
+#include "rossympriv.h"
+
+#define Z_SOLO
+#include <zlib.h>
+
+#define NDEBUG
+#include <debug.h>
+
+static voidpf
+RosSymZAlloc(voidpf Opaque, uInt Items, uInt Size)
+{
+  return RosSymAllocMem((ULONG_PTR) Items * Size);
+}
+
+static void
+RosSymZFree(voidpf Opaque, voidpf Address)
+{
+  RosSymFreeMem(Address);
+}
+
+static BOOLEAN
+RosSymInflate(PVOID Destination, ULONG DestinationLength,
+              PVOID Source, ULONG SourceLength)
+{
+  z_stream Stream;
+  int Status;
+
+  memset(&Stream, 0, sizeof(Stream));
+  Stream.zalloc = RosSymZAlloc;
+  Stream.zfree = RosSymZFree;
+  if (Z_OK != inflateInit(&Stream))
+    {
+      DPRINT1("Failed to initialize zlib\n");
+      return FALSE;
+    }
+
+  Stream.next_in = Source;
+  Stream.avail_in = SourceLength;
+  Stream.next_out = Destination;
+  Stream.avail_out = DestinationLength;
+  Status = inflate(&Stream, Z_FINISH);
+  inflateEnd(&Stream);
+
+  if (Z_STREAM_END != Status || 0 != Stream.avail_out)
+    {
+      DPRINT1("Failed to inflate rossym data (%d)\n", Status);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static BOOLEAN
+RosSymIsValidRange(PROSSYM_V2_HEADER Header, ULONG Offset, ULONG Length)
+{
+  return Offset <= Header->RawDataLength && Length <= Header->RawDataLength - Offset;
+}
+
+/*
+ * Data points to the DataLength bytes following the header in the section.
+ * The index, the blocks and the strings are copied (or inflated) right after
+ * the returned ROSSYM_INFO.
+ */
+BOOLEAN
+RosSymCreateFromV2(PROSSYM_V2_HEADER Header, PVOID Data, PROSSYM_INFO *RosSymInfo)
+{
+  PROSSYM_INFO Info;
+  PUCHAR RawData;
+  ULONG i;
+
+  if (ROSSYM_V2_SIGNATURE != Header->Signature
+      || 0 == Header->BlocksCount
+      || Header->BlocksCount != (Header->SymbolsCount + ROSSYM_V2_BLOCK_ENTRIES - 1) / ROSSYM_V2_BLOCK_ENTRIES
+      || Header->BlocksCount > (Header->RawDataLength / sizeof(ROSSYM_V2_BLOCK))
+      || Header->FunctionsCount > (Header->RawDataLength / sizeof(ROSSYM_V2_FUNCTION))
+      || ! RosSymIsValidRange(Header, Header->BlocksOffset,
+                              Header->BlocksCount * sizeof(ROSSYM_V2_BLOCK))
+      || ! RosSymIsValidRange(Header, Header->BlockDataOffset, Header->BlockDataLength)
+      || ! RosSymIsValidRange(Header, Header->FunctionsOffset,
+                              Header->FunctionsCount * sizeof(ROSSYM_V2_FUNCTION))
+      || ! RosSymIsValidRange(Header, Header->StringsOffset, Header->StringsLength)
+      || 0 != (Header->BlocksOffset % sizeof(ULONG))
+      || 0 != (Header->FunctionsOffset % sizeof(ULONG))
+      || (0 == (Header->Flags & ROSSYM_V2_COMPRESSED)
+          && Header->DataLength != Header->RawDataLength))
+    {
+      DPRINT1("Invalid ROSSYM_V2_HEADER\n");
+      return FALSE;
+    }
+
+  Info = RosSymAllocMem(sizeof(ROSSYM_INFO) + Header->RawDataLength);
+  if (NULL == Info)
+    {
+      DPRINT1("Failed to allocate memory for rossym\n");
+      return FALSE;
+    }
+  RawData = (PUCHAR)(Info + 1);
+
+  if (0 != (Header->Flags & ROSSYM_V2_COMPRESSED))
+    {
+      if (! RosSymInflate(RawData, Header->RawDataLength, Data, Header->DataLength))
+        {
+          RosSymFreeMem(Info);
+          return FALSE;
+        }
+    }
+  else
+    {
+      memcpy(RawData, Data, Header->RawDataLength);
+    }
+
+  Info->Symbols = NULL;
+  Info->SymbolsCount = Header->SymbolsCount;
+  Info->Strings = (PCHAR) RawData + Header->StringsOffset;
+  Info->StringsLength = Header->StringsLength;
+  Info->Blocks = (PROSSYM_V2_BLOCK)(RawData + Header->BlocksOffset);
+  Info->BlocksCount = Header->BlocksCount;
+  Info->BlockData = RawData + Header->BlockDataOffset;
+  Info->BlockDataLength = Header->BlockDataLength;
+  Info->Functions = (PROSSYM_V2_FUNCTION)(RawData + Header->FunctionsOffset);
+  Info->FunctionsCount = Header->FunctionsCount;
+
+  /* The lookups trust the index, so check it once here */
+  for (i = 0; i < Info->BlocksCount; i++)
+    {
+      if (Info->BlockDataLength < Info->Blocks[i].DataOffset
+          || (0 < i && (Info->Blocks[i].Address < Info->Blocks[i - 1].Address
+                        || Info->Blocks[i].DataOffset < Info->Blocks[i - 1].DataOffset)))
+        {
+          DPRINT1("Invalid rossym block index\n");
+          RosSymFreeMem(Info);
+          return FALSE;
+        }
+    }
+  for (i = 0; i < Info->FunctionsCount; i++)
+    {
+      if (Info->StringsLength <= Info->Functions[i].NameOffset)
+        {
+          DPRINT1("Invalid rossym function index\n");
+          RosSymFreeMem(Info);
+          return FALSE;
+        }
+    }
+
+  /* The string table is not necessarily last, so it must end with a null */
+  if (0 == Info->StringsLength || '\0' != Info->Strings[Info->StringsLength - 1])
+    {
+      DPRINT1("Invalid rossym string table\n");
+      RosSymFreeMem(Info);
+      return FALSE;
+    }
+
+  *RosSymInfo = Info;
+  return TRUE;
+}
+
+/* EOF */
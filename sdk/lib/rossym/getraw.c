@@ -14,16 +14,65 @@
 ULONG
 RosSymGetRawDataLength(PROSSYM_INFO RosSymInfo)
 {
+  if (NULL != RosSymInfo->Blocks)
+    {
+      return sizeof(ROSSYM_V2_HEADER)
+             + RosSymInfo->BlocksCount * sizeof(ROSSYM_V2_BLOCK)
+             + RosSymInfo->FunctionsCount * sizeof(ROSSYM_V2_FUNCTION)
+             + RosSymInfo->BlockDataLength
+             + RosSymInfo->StringsLength;
+    }
+
   return sizeof(ROSSYM_HEADER)
          + RosSymInfo->SymbolsCount * sizeof(ROSSYM_ENTRY)
          + RosSymInfo->StringsLength;
 }
 
+static VOID
+RosSymGetRawDataV2(PROSSYM_INFO RosSymInfo, PVOID RawData)
+{
+  PROSSYM_V2_HEADER Header;
+  char *Data;
+
+  /* Written back uncompressed */
+  Header = (PROSSYM_V2_HEADER) RawData;
+  memset(Header, 0, sizeof(ROSSYM_V2_HEADER));
+  Header->Signature = ROSSYM_V2_SIGNATURE;
+  Header->SymbolsCount = RosSymInfo->SymbolsCount;
+  Header->DataOffset = sizeof(ROSSYM_V2_HEADER);
+  Header->DataLength = RosSymGetRawDataLength(RosSymInfo) - sizeof(ROSSYM_V2_HEADER);
+  Header->RawDataLength = Header->DataLength;
+  Header->BlocksOffset = 0;
+  Header->BlocksCount = RosSymInfo->BlocksCount;
+  Header->FunctionsOffset = Header->BlocksOffset + Header->BlocksCount * sizeof(ROSSYM_V2_BLOCK);
+  Header->FunctionsCount = RosSymInfo->FunctionsCount;
+  Header->BlockDataOffset = Header->FunctionsOffset + Header->FunctionsCount * sizeof(ROSSYM_V2_FUNCTION);
+  Header->BlockDataLength = RosSymInfo->BlockDataLength;
+  Header->StringsOffset = Header->BlockDataOffset + Header->BlockDataLength;
+  Header->StringsLength = RosSymInfo->StringsLength;
+
+  Data = (char *) RawData + Header->DataOffset;
+  memcpy(Data + Header->BlocksOffset, RosSymInfo->Blocks,
+         Header->BlocksCount * sizeof(ROSSYM_V2_BLOCK));
+  memcpy(Data + Header->FunctionsOffset, RosSymInfo->Functions,
+         Header->FunctionsCount * sizeof(ROSSYM_V2_FUNCTION));
+  memcpy(Data + Header->BlockDataOffset, RosSymInfo->BlockData,
+         Header->BlockDataLength);
+  memcpy(Data + Header->StringsOffset, RosSymInfo->Strings,
+         Header->StringsLength);
+}
+
 VOID
 RosSymGetRawData(PROSSYM_INFO RosSymInfo, PVOID RawData)
 {
   PROSSYM_HEADER RosSymHeader;
 
+  if (NULL != RosSymInfo->Blocks)
+    {
+      RosSymGetRawDataV2(RosSymInfo, RawData);
+      return;
+    }
+
   RosSymHeader = (PROSSYM_HEADER) RawData;
   RosSymHeader->SymbolsOffset = sizeof(ROSSYM_HEADER);
   RosSymHeader->SymbolsLength = RosSymInfo->SymbolsCount * sizeof(ROSSYM_ENTRY);
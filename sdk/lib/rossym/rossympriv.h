@@ -9,16 +9,33 @@
 
 #pragma once
 
+#ifdef ROSSYM_HOST
+/* Built for the host tools (rossymhost), only to load and query sections */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RosSymAllocMem(Size) malloc(Size)
+#define RosSymFreeMem(Area) free(Area)
+
+/* rsymtest loads broken sections on purpose, don't report them */
+#undef DPRINT1
+#define DPRINT1 DPRINT
+#else
 extern ROSSYM_CALLBACKS RosSymCallbacks;
 
 #define RosSymAllocMem(Size) (*RosSymCallbacks.AllocMemProc)(Size)
 #define RosSymFreeMem(Area) (*RosSymCallbacks.FreeMemProc)(Area)
+#endif
+
 #define RosSymReadFile(FileContext, Buffer, Size) (*RosSymCallbacks.ReadFileProc)((FileContext), (Buffer), (Size))
 #define RosSymSeekFile(FileContext, Position) (*RosSymCallbacks.SeekFileProc)((FileContext), (Position))
 
 extern BOOLEAN RosSymZwReadFile(PVOID FileContext, PVOID Buffer, ULONG Size);
 extern BOOLEAN RosSymZwSeekFile(PVOID FileContext, ULONG_PTR Position);
 
+extern BOOLEAN RosSymCreateFromV2(PROSSYM_V2_HEADER Header, PVOID Data, PROSSYM_INFO *RosSymInfo);
+
 #define ROSSYM_IS_VALID_DOS_HEADER(DosHeader) (IMAGE_DOS_SIGNATURE == (DosHeader)->e_magic \
                                                && 0L != (DosHeader)->e_lfanew)
 #define ROSSYM_IS_VALID_NT_HEADERS(NtHeaders) (IMAGE_NT_SIGNATURE == (NtHeaders)->Signature \
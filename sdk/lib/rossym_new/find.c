@@ -122,6 +122,25 @@ RosSymGetAddressInformation
     return TRUE;
 }
 
+BOOLEAN
+RosSymGetFunctionAddress
+(PROSSYM_INFO RosSymInfo,
+ PCSTR FunctionName,
+ ULONG_PTR *RelativeAddress)
+{
+    DwarfSym sym = { };
+
+    /* .debug_pubnames is the name index of a dwarf image */
+    if (dwarflookupname(RosSymInfo, (char *)FunctionName, &sym) == -1 ||
+        !sym.attrs.have.lowpc) {
+        werrstr("Could not find function %s", FunctionName);
+        return FALSE;
+    }
+
+    *RelativeAddress = sym.attrs.lowpc - RosSymInfo->pe->imagebase;
+    return TRUE;
+}
+
 VOID
 RosSymFreeAggregate(PROSSYM_AGGREGATE Aggregate)
 {
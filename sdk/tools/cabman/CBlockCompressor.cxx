@@ -0,0 +1,292 @@
+/*
+ * PROJECT:     ReactOS cabinet manager
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     CBlockCompressor class implementation
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CBlockCompressor.h"
+#include "raw.h"
+#include "mszip.h"
+
+#if !defined(CAB_READ_ONLY)
+
+/**
+* @name CBlockCompressor class
+* @implemented
+*
+* Default constructor
+*/
+CBlockCompressor::CBlockCompressor()
+{
+    Oldest = 0;
+    Count = 0;
+    NextToCompress = 0;
+    Stopping = false;
+}
+
+/**
+* @name CBlockCompressor class
+* @implemented
+*
+* Default destructor
+*/
+CBlockCompressor::~CBlockCompressor()
+{
+    Stop();
+}
+
+/**
+* @name CBlockCompressor class
+* @implemented
+*
+* Starts the worker threads
+*
+* @param CodecId
+* Codec to compress the blocks with (CAB_CODEC_*)
+*
+* @param Level
+* Compression level passed to the codec
+*
+* @param Threads
+* Number of worker threads
+*
+* @return
+* Status of operation
+*/
+ULONG CBlockCompressor::Start(LONG CodecId, int Level, ULONG Threads)
+{
+    ULONG i;
+
+    ASSERT(Workers.empty());
+
+    for (i = 0; i < Threads * CAB_BLOCKS_PER_THREAD; i++)
+    {
+        PCAB_BLOCK_JOB Job = new CAB_BLOCK_JOB;
+        if (!Job)
+        {
+            Stop();
+            return CAB_STATUS_NOMEMORY;
+        }
+        Jobs.push_back(Job);
+    }
+
+    Oldest = 0;
+    Count = 0;
+    NextToCompress = 0;
+    Stopping = false;
+
+    for (i = 0; i < Threads; i++)
+    {
+        CCABCodec* Codec;
+
+        switch (CodecId)
+        {
+            case CAB_CODEC_RAW:
+                Codec = new CRawCodec();
+                break;
+
+            case CAB_CODEC_MSZIP:
+                Codec = new CMSZipCodec();
+                ((CMSZipCodec*)Codec)->SetLevel(Level);
+                break;
+
+            default:
+                Stop();
+                return CAB_STATUS_UNSUPPCOMP;
+        }
+
+        Codecs.push_back(Codec);
+        try
+        {
+            Workers.push_back(std::thread(&CBlockCompressor::WorkerThread, this, Codec));
+        }
+        catch (const std::system_error&)
+        {
+            DPRINT(MIN_TRACE, ("Cannot create worker thread.\n"));
+            Stop();
+            return CAB_STATUS_FAILURE;
+        }
+    }
+
+    return CAB_STATUS_SUCCESS;
+}
+
+/**
+* @name CBlockCompressor class
+* @implemented
+*
+* Stops the worker threads and throws away all queued blocks
+*/
+void CBlockCompressor::Stop()
+{
+    {
+        std::lock_guard<std::mutex> Guard(Lock);
+        Stopping = true;
+    }
+    WorkAvailable.notify_all();
+
+    for (std::thread& Worker : Workers)
+        Worker.join();
+    Workers.clear();
+
+    for (CCABCodec* Codec : Codecs)
+        delete Codec;
+    Codecs.clear();
+
+    for (PCAB_BLOCK_JOB Job : Jobs)
+        delete Job;
+    Jobs.clear();
+
+    Count = 0;
+    NextToCompress = 0;
+}
+
+/**
+* @name CBlockCompressor class
+* @implemented
+*
+* Returns true if no more blocks can be queued before the oldest one is released
+*/
+bool CBlockCompressor::IsFull()
+{
+    return (Count == Jobs.size());
+}
+
+/**
+* @name CBlockCompressor class
+* @implemented
+*
+* Returns true if no blocks are queued
+*/
+bool CBlockCompressor::IsEmpty()
+{
+    return (Count == 0);
+}
+
+/**
+* @name CBlockCompressor class
+* @implemented
+*
+* Queues a block for compression. The queue must not be full
+*
+* @param Buffer
+* Pointer to the uncompressed data, which is copied
+*
+* @param Size
+* Size of the uncompressed data (at most CAB_BLOCKSIZE)
+*
+* @param FolderNode
+* Folder the block belongs to
+*
+* @param DataNode
+* Node describing the block
+*
+* @return
+* Status of operation
+*/
+ULONG CBlockCompressor::QueueBlock(void* Buffer, ULONG Size, PCFFOLDER_NODE FolderNode, PCFDATA_NODE DataNode)
+{
+    PCAB_BLOCK_JOB Job;
+
+    ASSERT(!IsFull());
+    ASSERT(Size <= CAB_BLOCKSIZE);
+
+    /* No worker looks at the slot until it is counted */
+    Job = Jobs[(Oldest + Count) % Jobs.size()];
+    memcpy(Job->Input, Buffer, Size);
+    Job->InputSize = Size;
+    Job->OutputSize = 0;
+    Job->Status = CS_SUCCESS;
+    Job->Done = false;
+    Job->FolderNode = FolderNode;
+    Job->DataNode = DataNode;
+
+    {
+        std::lock_guard<std::mutex> Guard(Lock);
+        Count++;
+    }
+    WorkAvailable.notify_one();
+
+    return CAB_STATUS_SUCCESS;
+}
+
+/**
+* @name CBlockCompressor class
+* @implemented
+*
+* Waits until the oldest queued block is compressed
+*
+* @return
+* Pointer to the job of the block, or NULL if no block is queued
+*/
+PCAB_BLOCK_JOB CBlockCompressor::WaitOldestBlock()
+{
+    PCAB_BLOCK_JOB Job;
+    std::unique_lock<std::mutex> Guard(Lock);
+
+    if (Count == 0)
+        return NULL;
+
+    Job = Jobs[Oldest];
+    WorkDone.wait(Guard, [Job] { return Job->Done; });
+
+    return Job;
+}
+
+/**
+* @name CBlockCompressor class
+* @implemented
+*
+* Frees the slot of the oldest block after WaitOldestBlock returned it
+*/
+void CBlockCompressor::ReleaseOldestBlock()
+{
+    std::lock_guard<std::mutex> Guard(Lock);
+
+    ASSERT(Count > 0 && Jobs[Oldest]->Done);
+
+    Oldest = (Oldest + 1) % Jobs.size();
+    Count--;
+    NextToCompress--;
+}
+
+/**
+* @name CBlockCompressor class
+* @implemented
+*
+* Compresses queued blocks until the compressor is stopped
+*
+* @param Codec
+* Codec owned by this thread
+*/
+void CBlockCompressor::WorkerThread(CCABCodec* Codec)
+{
+    std::unique_lock<std::mutex> Guard(Lock);
+
+    for (;;)
+    {
+        PCAB_BLOCK_JOB Job;
+
+        WorkAvailable.wait(Guard, [this] { return Stopping || NextToCompress < Count; });
+        if (Stopping)
+            break;
+
+        Job = Jobs[(Oldest + NextToCompress) % Jobs.size()];
+        NextToCompress++;
+
+        Guard.unlock();
+        Job->Status = Codec->Compress(Job->Output, Job->Input, Job->InputSize, &Job->OutputSize);
+        Guard.lock();
+
+        Job->Done = true;
+        WorkDone.notify_all();
+    }
+}
+
+#endif /* CAB_READ_ONLY */
+
+/* EOF */
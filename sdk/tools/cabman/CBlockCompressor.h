@@ -0,0 +1,70 @@
+/*
+ * PROJECT:     ReactOS cabinet manager
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     CBlockCompressor class definition
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#pragma once
+
+#include "cabinet.h"
+
+#ifndef CAB_READ_ONLY
+
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+/* Number of blocks that can be in flight for each worker thread */
+#define CAB_BLOCKS_PER_THREAD 4
+
+typedef struct _CAB_BLOCK_JOB
+{
+    unsigned char   Input[CAB_BLOCKSIZE];
+    ULONG           InputSize;
+    unsigned char   Output[CAB_BLOCKSIZE + 12];
+    ULONG           OutputSize;
+    ULONG           Status;                 // Codec status (CS_*)
+    bool            Done;
+    PCFFOLDER_NODE  FolderNode;             // Folder the block belongs to
+    PCFDATA_NODE    DataNode;               // Node describing the block
+} CAB_BLOCK_JOB, *PCAB_BLOCK_JOB;
+
+/*
+ * Compresses whole data blocks on a pool of worker threads.
+ * The codecs start every block with an empty dictionary, so the blocks can be
+ * compressed in any order; they are handed back in the order they were queued.
+ */
+class CBlockCompressor
+{
+public:
+    /* Default constructor */
+    CBlockCompressor();
+    /* Default destructor */
+    virtual ~CBlockCompressor();
+    ULONG Start(LONG CodecId, int Level, ULONG Threads);
+    void Stop();
+    bool IsFull();
+    bool IsEmpty();
+    ULONG QueueBlock(void* Buffer, ULONG Size, PCFFOLDER_NODE FolderNode, PCFDATA_NODE DataNode);
+    PCAB_BLOCK_JOB WaitOldestBlock();
+    void ReleaseOldestBlock();
+private:
+    void WorkerThread(CCABCodec* Codec);
+    std::vector<std::thread> Workers;
+    std::vector<CCABCodec*> Codecs;
+    std::vector<PCAB_BLOCK_JOB> Jobs;       // Ring of job slots
+    ULONG Oldest;                           // Slot of the oldest queued block
+    ULONG Count;                            // Number of queued blocks
+    ULONG NextToCompress;                   // Number of queued blocks taken by a worker
+    bool Stopping;
+    std::mutex Lock;
+    std::condition_variable WorkAvailable;
+    std::condition_variable WorkDone;
+};
+
+#endif /* CAB_READ_ONLY */
+
+/* EOF */
@@ -31,6 +31,8 @@
 CCFDATAStorage::CCFDATAStorage()
 {
     FileHandle = NULL;
+    MemoryPosition = 0;
+    MemoryLimit = CAB_SCRATCH_MEMORY_LIMIT;
 }
 
 /**
@@ -48,40 +50,20 @@ CCFDATAStorage::~CCFDATAStorage()
 * @name CCFDATAStorage class
 * @implemented
 *
-* Creates the file
+* Creates the scratch storage. It stays in memory until it grows
+* beyond the memory limit
 *
 * @return
 * Status of operation
 */
 ULONG CCFDATAStorage::Create()
 {
-#if defined(_WIN32)
-    char TmpName[PATH_MAX];
-    char *pName;
-    int length;
-
-    if (tmpnam(TmpName) == NULL)
-        return CAB_STATUS_CANNOT_CREATE;
-
-    /* Append 'tmp' if the file name ends with a dot */
-    length = strlen(TmpName);
-    if (length > 0 && TmpName[length - 1] == '.')
-        strcat(TmpName, "tmp");
+    Memory.clear();
+    MemoryPosition = 0;
 
-    /* Skip a leading slash or backslash */
-    pName = TmpName;
-    if (*pName == '/' || *pName == '\\')
-        pName++;
-
-    strcpy(FullName, pName);
+    if (MemoryLimit == 0)
+        return CreateScratchFile();
 
-    FileHandle = fopen(FullName, "w+b");
-    if (FileHandle == NULL)
-        return CAB_STATUS_CANNOT_CREATE;
-#else
-    if ((FileHandle = tmpfile()) == NULL)
-        return CAB_STATUS_CANNOT_CREATE;
-#endif
     return CAB_STATUS_SUCCESS;
 }
 
@@ -89,22 +71,19 @@ ULONG CCFDATAStorage::Create()
 * @name CCFDATAStorage class
 * @implemented
 *
-* Destroys the file
+* Destroys the scratch storage
 *
 * @return
 * Status of operation
 */
 ULONG CCFDATAStorage::Destroy()
 {
-    ASSERT(FileHandle != NULL);
-
-    fclose(FileHandle);
+    if (FileHandle != NULL)
+        DestroyScratchFile();
 
-    FileHandle = NULL;
-
-#if defined(_WIN32)
-    remove(FullName);
-#endif
+    Memory.clear();
+    Memory.shrink_to_fit();
+    MemoryPosition = 0;
 
     return CAB_STATUS_SUCCESS;
 }
@@ -113,23 +92,27 @@ ULONG CCFDATAStorage::Destroy()
 * @name CCFDATAStorage class
 * @implemented
 *
-* Truncate the scratch file to zero bytes
+* Truncate the scratch storage to zero bytes
 *
 * @return
 * Status of operation
 */
 ULONG CCFDATAStorage::Truncate()
 {
-    fclose(FileHandle);
-#if defined(_WIN32)
-    FileHandle = fopen(FullName, "w+b");
-#else
-    FileHandle = tmpfile();
-#endif
-    if (FileHandle == NULL)
+    if (FileHandle != NULL)
+        DestroyScratchFile();
+
+    /* Start over in memory */
+    Memory.clear();
+    MemoryPosition = 0;
+
+    if (MemoryLimit == 0)
     {
-        DPRINT(MID_TRACE, ("ERROR '%i'.\n", errno));
-        return CAB_STATUS_FAILURE;
+        if (CreateScratchFile() != CAB_STATUS_SUCCESS)
+        {
+            DPRINT(MID_TRACE, ("ERROR '%i'.\n", errno));
+            return CAB_STATUS_FAILURE;
+        }
     }
 
     return CAB_STATUS_SUCCESS;
@@ -139,13 +122,16 @@ ULONG CCFDATAStorage::Truncate()
 * @name CCFDATAStorage class
 * @implemented
 *
-* Returns current position in file
+* Returns current position in the scratch storage
 *
 * @return
 * Current position
 */
 ULONG CCFDATAStorage::Position()
 {
+    if (FileHandle == NULL)
+        return MemoryPosition;
+
     return (ULONG)ftell(FileHandle);
 }
 
@@ -164,6 +150,15 @@ ULONG CCFDATAStorage::Position()
 */
 ULONG CCFDATAStorage::Seek(LONG Position)
 {
+    if (FileHandle == NULL)
+    {
+        if (Position < 0 || (ULONG)Position > Memory.size())
+            return CAB_STATUS_FAILURE;
+
+        MemoryPosition = (ULONG)Position;
+        return CAB_STATUS_SUCCESS;
+    }
+
     if (fseek(FileHandle, (off_t)Position, SEEK_SET) != 0)
         return CAB_STATUS_FAILURE;
     else
@@ -175,7 +170,7 @@ ULONG CCFDATAStorage::Seek(LONG Position)
 * @name CCFDATAStorage class
 * @implemented
 *
-* Reads a CFDATA block from the file
+* Reads a CFDATA block from the scratch storage
 *
 * @param Data
 * Pointer to CFDATA block for the buffer
@@ -191,7 +186,20 @@ ULONG CCFDATAStorage::Seek(LONG Position)
 */
 ULONG CCFDATAStorage::ReadBlock(PCFDATA Data, void* Buffer, PULONG BytesRead)
 {
-    *BytesRead = fread(Buffer, 1, Data->CompSize, FileHandle);
+    if (FileHandle == NULL)
+    {
+        *BytesRead = (ULONG)Memory.size() - MemoryPosition;
+        if (*BytesRead > Data->CompSize)
+            *BytesRead = Data->CompSize;
+
+        memcpy(Buffer, &Memory[0] + MemoryPosition, *BytesRead);
+        MemoryPosition += *BytesRead;
+    }
+    else
+    {
+        *BytesRead = fread(Buffer, 1, Data->CompSize, FileHandle);
+    }
+
     if (*BytesRead != Data->CompSize)
         return CAB_STATUS_CANNOT_READ;
 
@@ -203,7 +211,7 @@ ULONG CCFDATAStorage::ReadBlock(PCFDATA Data, void* Buffer, PULONG BytesRead)
 * @name CCFDATAStorage class
 * @implemented
 *
-* Writes a CFDATA block to the file
+* Writes a CFDATA block to the scratch storage
 *
 * @param Data
 * Pointer to CFDATA block for the buffer
@@ -219,6 +227,29 @@ ULONG CCFDATAStorage::ReadBlock(PCFDATA Data, void* Buffer, PULONG BytesRead)
 */
 ULONG CCFDATAStorage::WriteBlock(PCFDATA Data, void* Buffer, PULONG BytesWritten)
 {
+    ULONG Status;
+
+    if (FileHandle == NULL)
+    {
+        if ((ULONGLONG)MemoryPosition + Data->CompSize <= MemoryLimit)
+        {
+            if (MemoryPosition + Data->CompSize > Memory.size())
+                Memory.resize(MemoryPosition + Data->CompSize);
+
+            memcpy(&Memory[0] + MemoryPosition, Buffer, Data->CompSize);
+            MemoryPosition += Data->CompSize;
+            *BytesWritten = Data->CompSize;
+            return CAB_STATUS_SUCCESS;
+        }
+
+        Status = SpillToFile();
+        if (Status != CAB_STATUS_SUCCESS)
+        {
+            *BytesWritten = 0;
+            return Status;
+        }
+    }
+
     *BytesWritten = fwrite(Buffer, 1, Data->CompSize, FileHandle);
     if (*BytesWritten != Data->CompSize)
         return CAB_STATUS_CANNOT_WRITE;
@@ -227,4 +258,99 @@ ULONG CCFDATAStorage::WriteBlock(PCFDATA Data, void* Buffer, PULONG BytesWritten
 }
 
 
+/**
+* @name CCFDATAStorage class
+* @implemented
+*
+* Creates the scratch file
+*
+* @return
+* Status of operation
+*/
+ULONG CCFDATAStorage::CreateScratchFile()
+{
+#if defined(_WIN32)
+    char TmpName[PATH_MAX];
+    char *pName;
+    int length;
+
+    if (tmpnam(TmpName) == NULL)
+        return CAB_STATUS_CANNOT_CREATE;
+
+    /* Append 'tmp' if the file name ends with a dot */
+    length = strlen(TmpName);
+    if (length > 0 && TmpName[length - 1] == '.')
+        strcat(TmpName, "tmp");
+
+    /* Skip a leading slash or backslash */
+    pName = TmpName;
+    if (*pName == '/' || *pName == '\\')
+        pName++;
+
+    strcpy(FullName, pName);
+
+    FileHandle = fopen(FullName, "w+b");
+    if (FileHandle == NULL)
+        return CAB_STATUS_CANNOT_CREATE;
+#else
+    if ((FileHandle = tmpfile()) == NULL)
+        return CAB_STATUS_CANNOT_CREATE;
+#endif
+    return CAB_STATUS_SUCCESS;
+}
+
+
+/**
+* @name CCFDATAStorage class
+* @implemented
+*
+* Closes and deletes the scratch file
+*/
+void CCFDATAStorage::DestroyScratchFile()
+{
+    ASSERT(FileHandle != NULL);
+
+    fclose(FileHandle);
+
+    FileHandle = NULL;
+
+#if defined(_WIN32)
+    remove(FullName);
+#endif
+}
+
+
+/**
+* @name CCFDATAStorage class
+* @implemented
+*
+* Moves the blocks kept in memory to the scratch file
+*
+* @return
+* Status of operation
+*/
+ULONG CCFDATAStorage::SpillToFile()
+{
+    ULONG Status;
+
+    DPRINT(MID_TRACE, ("Moving %u bytes of scratch storage to a file.\n", (UINT)Memory.size()));
+
+    Status = CreateScratchFile();
+    if (Status != CAB_STATUS_SUCCESS)
+        return Status;
+
+    if (!Memory.empty() && fwrite(&Memory[0], 1, Memory.size(), FileHandle) != Memory.size())
+        return CAB_STATUS_CANNOT_WRITE;
+
+    if (fseek(FileHandle, (off_t)MemoryPosition, SEEK_SET) != 0)
+        return CAB_STATUS_FAILURE;
+
+    Memory.clear();
+    Memory.shrink_to_fit();
+    MemoryPosition = 0;
+
+    return CAB_STATUS_SUCCESS;
+}
+
+
 #endif /* CAB_READ_ONLY */
@@ -11,6 +11,14 @@
 
 #ifndef CAB_READ_ONLY
 
+#include <vector>
+
+/* Blocks are kept in memory until the scratch storage grows beyond this,
+ * 0 always uses a file */
+#ifndef CAB_SCRATCH_MEMORY_LIMIT
+#define CAB_SCRATCH_MEMORY_LIMIT (256 * 1024 * 1024)
+#endif
+
 class CCFDATAStorage
 {
 public:
@@ -26,8 +34,14 @@ public:
     ULONG ReadBlock(PCFDATA Data, void* Buffer, PULONG BytesRead);
     ULONG WriteBlock(PCFDATA Data, void* Buffer, PULONG BytesWritten);
 private:
+    ULONG CreateScratchFile();
+    void DestroyScratchFile();
+    ULONG SpillToFile();
     char FullName[PATH_MAX];
     FILE* FileHandle;
+    std::vector<unsigned char> Memory;  // Contents while not in the file
+    ULONG MemoryPosition;
+    ULONG MemoryLimit;
 };
 
 #endif /* CAB_READ_ONLY */
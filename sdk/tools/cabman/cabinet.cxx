@@ -25,6 +25,7 @@
 #endif
 #include "cabinet.h"
 #include "CCFDATAStorage.h"
+#include "CBlockCompressor.h"
 #include "raw.h"
 #include "mszip.h"
 
@@ -86,12 +87,15 @@ CCabinet::CCabinet()
     Codec          = NULL;
     CodecId        = -1;
     CodecSelected  = false;
+    CompressionLevel = 0;
 
     OutputBuffer = NULL;
     InputBuffer  = NULL;
     MaxDiskSize  = 0;
     BlockIsSplit = false;
     ScratchFile  = NULL;
+    Compressor   = NULL;
+    CompressionThreads = 1;
 
     FolderUncompSize = 0;
     BytesLeftInBlock = 0;
@@ -1039,6 +1043,7 @@ void CCabinet::SelectCodec(LONG Id)
 
         case CAB_CODEC_MSZIP:
             Codec = new CMSZipCodec();
+            ((CMSZipCodec*)Codec)->SetLevel(CompressionLevel);
             break;
 
         default:
@@ -1074,6 +1079,7 @@ ULONG CCabinet::NewCabinet()
     }
     CurrentIBuffer     = InputBuffer;
     CurrentIBufferSize = 0;
+    CurrentOBufferSize = 0;
 
     CABHeader.Signature     = CAB_SIGNATURE;
     CABHeader.Reserved1     = 0;            // Not used
@@ -1114,6 +1120,22 @@ ULONG CCabinet::NewCabinet()
     }
 
     Status = ScratchFile->Create();
+    if (Status != CAB_STATUS_SUCCESS)
+        return Status;
+
+    if (CompressionThreads > 1)
+    {
+        Compressor = new CBlockCompressor;
+        if (!Compressor)
+        {
+            DPRINT(MIN_TRACE, ("Insufficient memory.\n"));
+            return CAB_STATUS_NOMEMORY;
+        }
+
+        Status = Compressor->Start(CodecId, CompressionLevel, CompressionThreads);
+        if (Status != CAB_STATUS_SUCCESS)
+            return Status;
+    }
 
     CreateNewFolder = false;
 
@@ -1401,6 +1423,11 @@ ULONG CCabinet::CommitDisk(ULONG MoreDisks)
 {
     ULONG Status;
 
+    /* Every block must be in the scratch file before the header is written */
+    Status = FlushDataBlocks();
+    if (Status != CAB_STATUS_SUCCESS)
+        return Status;
+
     OnCabinetName(CurrentDiskNumber, CabinetName);
 
     /* Create file, fail if it already exists */
@@ -1487,6 +1514,12 @@ ULONG CCabinet::CloseCabinet()
 
     DestroyFolderNodes();
 
+    if (Compressor)
+    {
+        delete Compressor;
+        Compressor = NULL;
+    }
+
     if (InputBuffer)
     {
         free(InputBuffer);
@@ -1717,6 +1750,33 @@ cleanup2:
     return bRet;
 }
 
+void CCabinet::SetCompressionThreads(ULONG Threads)
+/*
+ * FUNCTION: Sets the number of threads compressing data blocks
+ * ARGUMENTS:
+ *     Threads = Number of threads. With 1, blocks are compressed one
+ *               by one. Takes effect at the next NewCabinet()
+ */
+{
+    CompressionThreads = (Threads > 0) ? Threads : 1;
+}
+
+
+void CCabinet::SetCompressionLevel(int Level)
+/*
+ * FUNCTION: Sets the compression level of the codec
+ * ARGUMENTS:
+ *     Level = 1 (fastest) to 9 (smallest), 0 for the codec default.
+ *             Only MSZIP has levels
+ */
+{
+    CompressionLevel = Level;
+
+    if (CodecSelected && CodecId == CAB_CODEC_MSZIP)
+        ((CMSZipCodec*)Codec)->SetLevel(Level);
+}
+
+
 void CCabinet::SetMaxDiskSize(ULONG Size)
 /*
  * FUNCTION: Sets the maximum size of the current disk
@@ -2759,6 +2819,17 @@ ULONG CCabinet::WriteDataBlock()
     ULONG BytesWritten;
     PCFDATA_NODE DataNode;
 
+    if (Compressor)
+    {
+        if (MaxDiskSize == 0)
+            return QueueDataBlock();
+
+        /* Splitting a disk needs the compressed size of every block before it */
+        Status = FlushDataBlocks();
+        if (Status != CAB_STATUS_SUCCESS)
+            return Status;
+    }
+
     if (!BlockIsSplit)
     {
         Status = Codec->Compress(OutputBuffer,
@@ -2835,6 +2906,117 @@ ULONG CCabinet::WriteDataBlock()
     return CAB_STATUS_SUCCESS;
 }
 
+
+ULONG CCabinet::QueueDataBlock()
+/*
+ * FUNCTION: Queues the current data block for compression by the worker threads
+ * RETURNS:
+ *     Status of operation
+ * NOTES:
+ *     Only used when the disk size is not limited, so a block is never split
+ *     and its compressed size is not needed until the disk is committed
+ */
+{
+    ULONG Status;
+    PCFDATA_NODE DataNode;
+
+    while (Compressor->IsFull())
+    {
+        Status = RetireDataBlock();
+        if (Status != CAB_STATUS_SUCCESS)
+            return Status;
+    }
+
+    DataNode = NewDataNode(CurrentFolderNode);
+    if (!DataNode)
+    {
+        DPRINT(MIN_TRACE, ("Insufficient memory.\n"));
+        return CAB_STATUS_NOMEMORY;
+    }
+
+    DataNode->Data.Checksum   = 0;
+    DataNode->Data.UncompSize = (USHORT)CurrentIBufferSize;
+
+    Status = Compressor->QueueBlock(InputBuffer, CurrentIBufferSize, CurrentFolderNode, DataNode);
+    if (Status != CAB_STATUS_SUCCESS)
+        return Status;
+
+    CurrentFolderNode->Folder.DataBlockCount++;
+
+    LastBlockStart += CurrentIBufferSize;
+
+    CurrentIBufferSize = 0;
+    CurrentIBuffer     = InputBuffer;
+
+    return CAB_STATUS_SUCCESS;
+}
+
+
+ULONG CCabinet::RetireDataBlock()
+/*
+ * FUNCTION: Waits for the oldest queued data block and writes it to the scratch file
+ * RETURNS:
+ *     Status of operation
+ */
+{
+    ULONG Status;
+    ULONG BytesWritten;
+    PCAB_BLOCK_JOB Job;
+    PCFDATA_NODE DataNode;
+
+    Job = Compressor->WaitOldestBlock();
+    if (!Job)
+        return CAB_STATUS_SUCCESS;
+
+    if (Job->Status != CS_SUCCESS)
+    {
+        DPRINT(MIN_TRACE, ("Cannot compress block (%u).\n", (UINT)Job->Status));
+        return (Job->Status == CS_NOMEMORY) ? CAB_STATUS_NOMEMORY : CAB_STATUS_FAILURE;
+    }
+
+    DPRINT(MAX_TRACE, ("Block compressed. UncompSize (%u)  CompSize(%u).\n",
+        (UINT)Job->InputSize, (UINT)Job->OutputSize));
+
+    DataNode = Job->DataNode;
+    DataNode->Data.CompSize = (USHORT)Job->OutputSize;
+    DataNode->ScratchFilePosition = ScratchFile->Position();
+
+    Status = ScratchFile->WriteBlock(&DataNode->Data, Job->Output, &BytesWritten);
+    if (Status != CAB_STATUS_SUCCESS)
+        return Status;
+
+    DiskSize += sizeof(CFDATA) + BytesWritten;
+
+    Job->FolderNode->TotalFolderSize += (BytesWritten + sizeof(CFDATA));
+
+    Compressor->ReleaseOldestBlock();
+
+    return CAB_STATUS_SUCCESS;
+}
+
+
+ULONG CCabinet::FlushDataBlocks()
+/*
+ * FUNCTION: Writes all queued data blocks to the scratch file
+ * RETURNS:
+ *     Status of operation
+ */
+{
+    ULONG Status;
+
+    if (!Compressor)
+        return CAB_STATUS_SUCCESS;
+
+    while (!Compressor->IsEmpty())
+    {
+        Status = RetireDataBlock();
+        if (Status != CAB_STATUS_SUCCESS)
+            return Status;
+    }
+
+    return CAB_STATUS_SUCCESS;
+}
+
 #if !defined(_WIN32)
 
 void CCabinet::ConvertDateAndTime(time_t* Time,
@@ -377,6 +377,10 @@ public:
     ULONG AddFile(const std::string& FileName, const std::string& TargetFolder);
     /* Sets the maximum size of the current disk */
     void SetMaxDiskSize(ULONG Size);
+    /* Sets the number of threads compressing data blocks */
+    void SetCompressionThreads(ULONG Threads);
+    /* Sets the compression level of the codec */
+    void SetCompressionLevel(int Level);
 #endif /* CAB_READ_ONLY */
 
     /* Default event handlers */
@@ -422,6 +426,9 @@ private:
     ULONG WriteFileEntries();
     ULONG CommitDataBlocks(PCFFOLDER_NODE FolderNode);
     ULONG WriteDataBlock();
+    ULONG QueueDataBlock();
+    ULONG RetireDataBlock();
+    ULONG FlushDataBlocks();
     ULONG GetAttributesOnFile(PCFFILE_NODE File);
     ULONG SetAttributesOnFile(char* FileName, USHORT FileAttributes);
     ULONG GetFileTimes(FILE* FileHandle, PCFFILE_NODE File);
@@ -460,6 +467,7 @@ private:
     CCABCodec *Codec;
     LONG CodecId;
     bool CodecSelected;
+    int CompressionLevel;       // Codec specific, 0 for the default level
     void* InputBuffer;
     void* CurrentIBuffer;               // Current offset in input buffer
     ULONG CurrentIBufferSize;   // Bytes left in input buffer
@@ -479,6 +487,8 @@ private:
     bool CreateNewFolder;
 
     class CCFDATAStorage *ScratchFile;
+    class CBlockCompressor *Compressor; // NULL if blocks are compressed one by one
+    ULONG CompressionThreads;
     FILE* SourceFile;
     bool ContinueFile;
     ULONG TotalBytesLeft;
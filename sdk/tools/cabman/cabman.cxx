@@ -14,6 +14,7 @@
 #include <stdarg.h>
 #include <string.h>
 #include <stdio.h>
+#include <thread>
 #include "cabman.h"
 
 
@@ -174,6 +175,9 @@ CCABManager::CCABManager()
     Mode = CM_MODE_DISPLAY;
     FileName[0] = 0;
     Verbose = false;
+
+    /* Blocks are compressed independently, so this doesn't change the cabinet */
+    SetCompressionThreads(std::thread::hardware_concurrency());
 }
 
 
@@ -192,8 +196,8 @@ void CCABManager::Usage()
 {
     printf("ReactOS Cabinet Manager\n\n");
     printf("CABMAN [-D | -E] [-A] [-L dir] cabinet [filename ...]\n");
-    printf("CABMAN [-M mode] -C dirfile [-I] [-RC file] [-P dir]\n");
-    printf("CABMAN [-M mode] -S cabinet filename [-F folder] [filename] [...]\n");
+    printf("CABMAN [-M mode] [-Z level] [-J num] -C dirfile [-I] [-RC file] [-P dir]\n");
+    printf("CABMAN [-M mode] [-Z level] [-J num] -S cabinet filename [-F folder] [filename] [...]\n");
     printf("  cabinet   Cabinet file.\n");
     printf("  filename  Name of the file to add to or extract from the cabinet.\n");
     printf("            Wild cards and multiple filenames\n");
@@ -208,6 +212,8 @@ void CCABManager::Usage()
     printf("  -E        Extract files from cabinet.\n");
     printf("  -F        Put the files from the next 'filename' filter in the cab in folder\filename.\n");
     printf("  -I        Don't create the cabinet, only the .inf file.\n");
+    printf("  -J num    Number of threads compressing data blocks\n");
+    printf("            (default is one per processor).\n");
     printf("  -L dir    Location to place extracted or generated files\n");
     printf("            (default is current directory).\n");
     printf("  -M mode   Specify the compression method to use:\n");
@@ -219,6 +225,8 @@ void CCABManager::Usage()
     printf("  -S        Create simple cabinet.\n");
     printf("  -P dir    Files in the .dff are relative to this directory.\n");
     printf("  -V        Verbose mode (prints more messages).\n");
+    printf("  -Z level  MsZip compression level, from 1 (fastest)\n");
+    printf("            to 9 (smallest cabinet).\n");
 }
 
 bool CCABManager::ParseCmdline(int argc, char* argv[])
@@ -281,6 +289,18 @@ bool CCABManager::ParseCmdline(int argc, char* argv[])
                     InfFileOnly = true;
                     break;
 
+                case 'j':
+                case 'J':
+                    if (argv[i][2] == 0)
+                    {
+                        i++;
+                        SetCompressionThreads(strtoul(&argv[i][0], NULL, 10));
+                    }
+                    else
+                        SetCompressionThreads(strtoul(&argv[i][2], NULL, 10));
+
+                    break;
+
                 case 'l':
                 case 'L':
                     if (argv[i][2] == 0)
@@ -365,6 +385,18 @@ bool CCABManager::ParseCmdline(int argc, char* argv[])
                     Verbose = true;
                     break;
 
+                case 'z':
+                case 'Z':
+                    if (argv[i][2] == 0)
+                    {
+                        i++;
+                        SetCompressionLevel(atoi(&argv[i][0]));
+                    }
+                    else
+                        SetCompressionLevel(atoi(&argv[i][2]));
+
+                    break;
+
                 default:
                     printf("ERROR: Bad parameter %s.\n", argv[i]);
                     return false;
@@ -41,6 +41,7 @@ CMSZipCodec::CMSZipCodec()
     ZStream.zalloc = MSZipAlloc;
     ZStream.zfree  = MSZipFree;
     ZStream.opaque = (voidpf)0;
+    Level = Z_DEFAULT_COMPRESSION;
 }
 
 
@@ -52,6 +53,22 @@ CMSZipCodec::~CMSZipCodec()
 }
 
 
+void CMSZipCodec::SetLevel(int NewLevel)
+/*
+ * FUNCTION: Sets the compression level
+ * ARGUMENTS:
+ *     NewLevel = zlib compression level. 1 is the fastest, 9 gives
+ *                the smallest blocks. Any level can be read by every
+ *                MSZIP decompressor
+ */
+{
+    if (NewLevel < Z_BEST_SPEED || NewLevel > Z_BEST_COMPRESSION)
+        Level = Z_DEFAULT_COMPRESSION;
+    else
+        Level = NewLevel;
+}
+
+
 ULONG CMSZipCodec::Compress(void* OutputBuffer,
                             void* InputBuffer,
                             ULONG InputLength,
@@ -79,7 +96,7 @@ ULONG CMSZipCodec::Compress(void* OutputBuffer,
 
     /* WindowBits is passed < 0 to tell that there is no zlib header */
     Status = deflateInit2(&ZStream,
-                          Z_DEFAULT_COMPRESSION,
+                          Level,
                           Z_DEFLATED,
                           -MAX_WBITS,
                           8, /* memLevel */
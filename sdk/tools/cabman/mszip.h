@@ -32,8 +32,11 @@ public:
                              void* InputBuffer,
                              ULONG InputLength,
                              PULONG OutputLength) override;
+    /* Sets the zlib compression level (1-9) */
+    void SetLevel(int NewLevel);
 private:
     int Status;
+    int Level;
     z_stream ZStream; /* Zlib stream */
 };
 
@@ -0,0 +1,1067 @@
+/*
+ * COPYRIGHT:       See COPYING in the top level directory
+ * PROJECT:         ReactOS FAT Image Creator
+ * FILE:            tools/fatten/bulk.c
+ * PURPOSE:         Bulk build of freshly formatted images
+ */
+
+/*
+ * Through FatFs, every file added to the image reads and writes back the
+ * FAT and directory sectors it touches, one sector at a time. Here all the
+ * files listed in a manifest are laid out at once on an empty volume: the
+ * directory tables first, then the data of every file in one contiguous
+ * run, in the order of the manifest. The directory tables and the FAT are
+ * built in memory and written once, and the data is copied with large
+ * writes. The result is an ordinary FAT volume that the other commands
+ * can edit afterwards.
+ *
+ * Each line of the manifest is either "<external file> <image path>" to
+ * add a file, or "<image path>" alone to create a directory. Paths holding
+ * spaces are put in double quotes, and lines starting with '#' are
+ * comments. The parent directories of the image paths are created as
+ * needed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "fatfs/ff.h"
+#include "fatfs/diskio.h"
+#include "bulk.h"
+
+#define SECTOR_SIZE     512
+#define DIR_ENTRY_SIZE  32
+#define COPY_SECTORS    2048    /* 1 MB per write */
+
+#define END_OF_CHAIN    0xFFFFFFFF
+
+/* Lower case flags of the short names, as in FatFs */
+#define NS_BODY         0x08
+#define NS_EXT          0x10
+
+typedef struct _BULK_ENTRY
+{
+    struct _BULK_ENTRY* parent;
+    struct _BULK_ENTRY* first_child;    /* Directories only */
+    struct _BULK_ENTRY* last_child;
+    struct _BULK_ENTRY* next_sibling;
+    struct _BULK_ENTRY* next;           /* Next directory or file in the layout */
+    char* name;
+    char* source;                       /* NULL for directories */
+    BYTE sfn[11];                       /* All zero until the short name is chosen */
+    BYTE nt_flags;
+    int lfn_entries;
+    DWORD size;                         /* Size of the file, or of the directory table */
+    DWORD first_cluster;
+} BULK_ENTRY;
+
+typedef struct _BULK_VOLUME
+{
+    BYTE fs_type;
+    DWORD cluster_sectors;
+    DWORD fat_start;
+    DWORD fat_count;
+    DWORD fat_sectors;
+    DWORD root_start;                   /* FAT12/16 root directory */
+    DWORD root_entries;
+    DWORD root_cluster;                 /* FAT32 root directory */
+    DWORD fsinfo_sector;
+    DWORD data_start;
+    DWORD cluster_count;                /* Clusters are numbered from 2 */
+    BYTE* fat;                          /* The first FAT */
+    DWORD* chain;                       /* Next cluster of every cluster, 0 if free */
+    DWORD next_cluster;                 /* Allocation pointer */
+    DWORD last_cluster;
+    BYTE label[DIR_ENTRY_SIZE];         /* Volume label entry of the root */
+    int has_label;
+} BULK_VOLUME;
+
+static WORD ld_word(const BYTE* p)
+{
+    return (WORD)(p[0] | (p[1] << 8));
+}
+
+static DWORD ld_dword(const BYTE* p)
+{
+    return (DWORD)p[0] | ((DWORD)p[1] << 8) | ((DWORD)p[2] << 16) | ((DWORD)p[3] << 24);
+}
+
+static void st_word(BYTE* p, WORD value)
+{
+    p[0] = (BYTE)value;
+    p[1] = (BYTE)(value >> 8);
+}
+
+static void st_dword(BYTE* p, DWORD value)
+{
+    p[0] = (BYTE)value;
+    p[1] = (BYTE)(value >> 8);
+    p[2] = (BYTE)(value >> 16);
+    p[3] = (BYTE)(value >> 24);
+}
+
+static DWORD end_of_chain(BULK_VOLUME* vol)
+{
+    if (vol->fs_type == FS_FAT12)
+        return 0xFFF;
+    if (vol->fs_type == FS_FAT16)
+        return 0xFFFF;
+    return 0x0FFFFFFF;
+}
+
+static DWORD get_fat(BULK_VOLUME* vol, DWORD cluster)
+{
+    DWORD offset;
+
+    switch (vol->fs_type)
+    {
+    case FS_FAT12:
+        offset = cluster + cluster / 2;
+        if (cluster & 1)
+            return ld_word(vol->fat + offset) >> 4;
+        return ld_word(vol->fat + offset) & 0xFFF;
+    case FS_FAT16:
+        return ld_word(vol->fat + cluster * 2);
+    default:
+        return ld_dword(vol->fat + cluster * 4) & 0x0FFFFFFF;
+    }
+}
+
+static void put_fat(BULK_VOLUME* vol, DWORD cluster, DWORD value)
+{
+    BYTE* p;
+
+    switch (vol->fs_type)
+    {
+    case FS_FAT12:
+        p = vol->fat + cluster + cluster / 2;
+        if (cluster & 1)
+        {
+            p[0] = (BYTE)((p[0] & 0x0F) | (value << 4));
+            p[1] = (BYTE)(value >> 4);
+        }
+        else
+        {
+            p[0] = (BYTE)value;
+            p[1] = (BYTE)((p[1] & 0xF0) | ((value >> 8) & 0x0F));
+        }
+        break;
+    case FS_FAT16:
+        st_word(vol->fat + cluster * 2, (WORD)value);
+        break;
+    default:
+        p = vol->fat + cluster * 4;
+        st_dword(p, (ld_dword(p) & 0xF0000000) | value);
+        break;
+    }
+}
+
+static DWORD cluster_to_sector(BULK_VOLUME* vol, DWORD cluster)
+{
+    return vol->data_start + (cluster - 2) * vol->cluster_sectors;
+}
+
+/* Reads the boot sector and the FAT, and checks that the volume holds nothing but a label */
+static int open_volume(BULK_VOLUME* vol)
+{
+    BYTE sector[SECTOR_SIZE];
+    BYTE* root;
+    DWORD total_sectors, system_sectors, root_size, cluster, i;
+    DWORD needed_fat_size;
+    int empty;
+
+    if (disk_read(0, sector, 0, 1))
+    {
+        fprintf(stderr, "Error: Unable to read the boot sector from image.\n");
+        return 1;
+    }
+
+    vol->cluster_sectors = sector[13];
+    vol->fat_start = ld_word(sector + 14);
+    vol->fat_count = sector[16];
+    vol->root_entries = ld_word(sector + 17);
+    total_sectors = ld_word(sector + 19);
+    if (!total_sectors)
+        total_sectors = ld_dword(sector + 32);
+    vol->fat_sectors = ld_word(sector + 22);
+    if (!vol->fat_sectors)
+        vol->fat_sectors = ld_dword(sector + 36);
+
+    if (ld_word(sector + 11) != SECTOR_SIZE ||
+        !vol->cluster_sectors || (vol->cluster_sectors & (vol->cluster_sectors - 1)) ||
+        !vol->fat_start || vol->fat_count < 1 || vol->fat_count > 2 ||
+        vol->root_entries % (SECTOR_SIZE / DIR_ENTRY_SIZE))
+    {
+        fprintf(stderr, "Error: The image does not hold a FAT volume.\n");
+        return 1;
+    }
+
+    vol->root_start = vol->fat_start + vol->fat_count * vol->fat_sectors;
+    system_sectors = vol->root_start + vol->root_entries / (SECTOR_SIZE / DIR_ENTRY_SIZE);
+    if (total_sectors <= system_sectors ||
+        (total_sectors - system_sectors) / vol->cluster_sectors == 0)
+    {
+        fprintf(stderr, "Error: The image does not hold a FAT volume.\n");
+        return 1;
+    }
+    vol->data_start = system_sectors;
+    vol->cluster_count = (total_sectors - system_sectors) / vol->cluster_sectors;
+
+    /* Same rules as FatFs */
+    vol->fs_type = FS_FAT12;
+    if (vol->cluster_count >= 4086)
+        vol->fs_type = FS_FAT16;
+    if (vol->cluster_count >= 65526)
+        vol->fs_type = FS_FAT32;
+
+    if (vol->fs_type == FS_FAT32)
+    {
+        vol->root_cluster = ld_dword(sector + 44);
+        vol->fsinfo_sector = ld_word(sector + 48);
+        needed_fat_size = (vol->cluster_count + 2) * 4;
+    }
+    else
+    {
+        needed_fat_size = (vol->fs_type == FS_FAT16) ? (vol->cluster_count + 2) * 2
+                                                     : ((vol->cluster_count + 2) * 3 + 1) / 2;
+    }
+    if ((vol->fs_type == FS_FAT32) != (vol->root_entries == 0) ||
+        vol->fat_sectors < (needed_fat_size + SECTOR_SIZE - 1) / SECTOR_SIZE ||
+        (vol->fs_type == FS_FAT32 &&
+         (vol->root_cluster < 2 || vol->root_cluster >= vol->cluster_count + 2)))
+    {
+        fprintf(stderr, "Error: The image does not hold a FAT volume.\n");
+        return 1;
+    }
+
+    vol->fat = malloc(vol->fat_sectors * SECTOR_SIZE);
+    vol->chain = calloc(vol->cluster_count + 2, sizeof(DWORD));
+    if (!vol->fat || !vol->chain)
+    {
+        fprintf(stderr, "Error: Unable to allocate memory.\n");
+        return 1;
+    }
+    if (disk_read(0, vol->fat, vol->fat_start, vol->fat_sectors))
+    {
+        fprintf(stderr, "Error: Unable to read the FAT from image.\n");
+        return 1;
+    }
+
+    /* Only the root directory of FAT32 may have a cluster */
+    for (cluster = 2; cluster < vol->cluster_count + 2; cluster++)
+    {
+        DWORD value = get_fat(vol, cluster);
+
+        if (vol->fs_type == FS_FAT32 && cluster == vol->root_cluster)
+        {
+            if (value < 0x0FFFFFF8)
+                break;
+            vol->chain[cluster] = END_OF_CHAIN;
+        }
+        else if (value != 0)
+        {
+            break;
+        }
+    }
+    empty = (cluster == vol->cluster_count + 2);
+
+    if (vol->fs_type == FS_FAT32)
+        root_size = vol->cluster_sectors * SECTOR_SIZE;
+    else
+        root_size = vol->root_entries * DIR_ENTRY_SIZE;
+    root = malloc(root_size);
+    if (!root)
+    {
+        fprintf(stderr, "Error: Unable to allocate memory.\n");
+        return 1;
+    }
+    if (disk_read(0, root,
+                  vol->fs_type == FS_FAT32 ? cluster_to_sector(vol, vol->root_cluster) : vol->root_start,
+                  root_size / SECTOR_SIZE))
+    {
+        fprintf(stderr, "Error: Unable to read the root directory from image.\n");
+        free(root);
+        return 1;
+    }
+    for (i = 0; empty && i < root_size; i += DIR_ENTRY_SIZE)
+    {
+        BYTE* entry = root + i;
+
+        if (entry[0] == 0)
+            break;
+        if (entry[0] == 0xE5)
+            continue;
+        if ((entry[11] & ~AM_ARC) == AM_VOL && !vol->has_label)
+        {
+            memcpy(vol->label, entry, DIR_ENTRY_SIZE);
+            vol->has_label = 1;
+            continue;
+        }
+        empty = 0;
+    }
+    free(root);
+
+    if (!empty)
+    {
+        fprintf(stderr, "Error: The bulk mode needs a freshly formatted image, use -add for incremental edits.\n");
+        return 1;
+    }
+
+    vol->next_cluster = 2;
+    return 0;
+}
+
+static int is_valid_name(const char* name)
+{
+    size_t len = strlen(name);
+    const unsigned char* p;
+
+    if (len == 0 || len > _MAX_LFN || !strcmp(name, ".") || !strcmp(name, ".."))
+        return 0;
+    if (name[len - 1] == '.' || name[len - 1] == ' ')
+        return 0;
+    for (p = (const unsigned char*)name; *p; p++)
+    {
+        if (*p < 0x20 || *p == 0x7F || strchr("\"*/:<>?\\|", *p))
+            return 0;
+    }
+    return 1;
+}
+
+static BYTE upcase(BYTE c)
+{
+    if (c < 0x80)
+        return (BYTE)toupper(c);
+    return (BYTE)ff_convert(ff_wtoupper(ff_convert(c, 1)), 0);
+}
+
+static int same_name(const char* name1, const char* name2)
+{
+    while (*name1 && upcase((BYTE)*name1) == upcase((BYTE)*name2))
+    {
+        name1++;
+        name2++;
+    }
+    return *name1 == *name2;
+}
+
+static BULK_ENTRY* add_entry(BULK_ENTRY* dir, const char* name, const char* source)
+{
+    BULK_ENTRY* entry;
+
+    for (entry = dir->first_child; entry; entry = entry->next_sibling)
+    {
+        if (same_name(entry->name, name))
+        {
+            if (source || entry->source)
+            {
+                fprintf(stderr, "Error: '%s' is listed more than once in the manifest.\n", name);
+                return NULL;
+            }
+            return entry;
+        }
+    }
+
+    if (!is_valid_name(name))
+    {
+        fprintf(stderr, "Error: '%s' is not a valid file name.\n", name);
+        return NULL;
+    }
+
+    entry = calloc(1, sizeof(BULK_ENTRY));
+    if (!entry ||
+        !(entry->name = strdup(name)) ||
+        (source && !(entry->source = strdup(source))))
+    {
+        fprintf(stderr, "Error: Unable to allocate memory.\n");
+        if (entry)
+        {
+            free(entry->name);
+            free(entry);
+        }
+        return NULL;
+    }
+    entry->parent = dir;
+    if (dir->last_child)
+        dir->last_child->next_sibling = entry;
+    else
+        dir->first_child = entry;
+    dir->last_child = entry;
+    return entry;
+}
+
+/* Adds the image path to the tree, creating the missing directories */
+static BULK_ENTRY* add_path(BULK_ENTRY* root, char* path, const char* source)
+{
+    BULK_ENTRY* dir = root;
+    char* name = path;
+    char* end;
+
+    while (*name == '/' || *name == '\\')
+        name++;
+    if (!*name)
+    {
+        fprintf(stderr, "Error: Missing image path in the manifest.\n");
+        return NULL;
+    }
+
+    for (;;)
+    {
+        end = name + strcspn(name, "/\\");
+        if (*end)
+        {
+            *end++ = '\0';
+            while (*end == '/' || *end == '\\')
+                end++;
+        }
+
+        /* Intermediate names, and a trailing one without source, are directories */
+        dir = add_entry(dir, name, *end ? NULL : source);
+        if (!dir)
+            return NULL;
+        if (!*end)
+            return dir;
+        if (dir->source)
+        {
+            fprintf(stderr, "Error: '%s' is a file, not a directory.\n", dir->name);
+            return NULL;
+        }
+        name = end;
+    }
+}
+
+static char* next_field(char** line)
+{
+    char* field;
+    char* p = *line;
+
+    while (*p && isspace((unsigned char)*p))
+        p++;
+    if (!*p)
+        return NULL;
+
+    if (*p == '"')
+    {
+        field = ++p;
+        while (*p && *p != '"')
+            p++;
+    }
+    else
+    {
+        field = p;
+        while (*p && !isspace((unsigned char)*p))
+            p++;
+    }
+    if (*p)
+        *p++ = '\0';
+
+    *line = p;
+    return field;
+}
+
+static int read_manifest(const char* manifest, BULK_ENTRY* root, BULK_ENTRY** files)
+{
+    FILE* fm;
+    char line[4096];
+    int line_number = 0;
+    BULK_ENTRY** last_file = files;
+
+    fm = fopen(manifest, "r");
+    if (!fm)
+    {
+        fprintf(stderr, "Error: Unable to open manifest file '%s' for reading.\n", manifest);
+        return 1;
+    }
+
+    while (fgets(line, sizeof(line), fm))
+    {
+        char* p = line;
+        char* field1;
+        char* field2;
+        BULK_ENTRY* entry;
+
+        line_number++;
+        field1 = next_field(&p);
+        if (!field1 || field1[0] == '#')
+            continue;
+        field2 = next_field(&p);
+        if (next_field(&p))
+        {
+            fprintf(stderr, "Error: %s(%d): Too many fields.\n", manifest, line_number);
+            fclose(fm);
+            return 1;
+        }
+
+        entry = field2 ? add_path(root, field2, field1) : add_path(root, field1, NULL);
+        if (!entry)
+        {
+            fprintf(stderr, "Error: %s(%d): Invalid entry.\n", manifest, line_number);
+            fclose(fm);
+            return 1;
+        }
+
+        if (entry->source)
+        {
+            FILE* fe = fopen(entry->source, "rb");
+            long size;
+
+            if (!fe)
+            {
+                fprintf(stderr, "Error: Unable to open external file '%s' for reading.\n", entry->source);
+                fclose(fm);
+                return 1;
+            }
+            if (fseek(fe, 0, SEEK_END) || (size = ftell(fe)) < 0 || (DWORD)size != (unsigned long)size)
+            {
+                fprintf(stderr, "Error: Unable to get the size of external file '%s'.\n", entry->source);
+                fclose(fe);
+                fclose(fm);
+                return 1;
+            }
+            fclose(fe);
+
+            entry->size = (DWORD)size;
+            *last_file = entry;
+            last_file = &entry->next;
+        }
+    }
+
+    fclose(fm);
+    return 0;
+}
+
+static int is_short_name_char(BYTE c)
+{
+    return c > 0x20 && c < 0x7F && !strchr("\"*+,./:;<=>?[\\]|", c);
+}
+
+static void put_short_name_char(BYTE c, BYTE* sfn, int* cases, int* lossy)
+{
+    if (!is_short_name_char(c))
+    {
+        *sfn = '_';
+        *lossy = 1;
+    }
+    else if (islower(c))
+    {
+        *sfn = (BYTE)toupper(c);
+        *cases |= 1;
+    }
+    else
+    {
+        *sfn = c;
+        if (isupper(c))
+            *cases |= 2;
+    }
+}
+
+/*
+ * Builds the short name the way Windows does. The long name is needed if
+ * characters are lost, or if the body or the extension mixes cases;
+ * otherwise the lower case flags keep the case of the name.
+ */
+static int make_basis_name(BULK_ENTRY* entry, BYTE* sfn)
+{
+    const char* name = entry->name;
+    const char* dot = strrchr(name, '.');
+    int lossy = 0, body_cases = 0, ext_cases = 0, i;
+
+    memset(sfn, ' ', 11);
+
+    while (*name == '.' || *name == ' ')
+    {
+        name++;
+        lossy = 1;
+    }
+    if (dot < name)
+        dot = NULL;
+
+    for (i = 0; *name && name != dot; name++)
+    {
+        if (*name == '.' || *name == ' ')
+        {
+            lossy = 1;
+            continue;
+        }
+        if (i == 8)
+        {
+            lossy = 1;
+            break;
+        }
+        put_short_name_char((BYTE)*name, sfn + i++, &body_cases, &lossy);
+    }
+
+    if (dot)
+    {
+        for (name = dot + 1, i = 8; *name; name++)
+        {
+            if (*name == ' ')
+            {
+                lossy = 1;
+                continue;
+            }
+            if (i == 11)
+            {
+                lossy = 1;
+                break;
+            }
+            put_short_name_char((BYTE)*name, sfn + i++, &ext_cases, &lossy);
+        }
+    }
+
+    entry->nt_flags = 0;
+    if (lossy)
+        return 2;
+    if (body_cases == 3 || ext_cases == 3)
+        return 1;
+    if (body_cases == 1)
+        entry->nt_flags |= NS_BODY;
+    if (ext_cases == 1)
+        entry->nt_flags |= NS_EXT;
+    return 0;
+}
+
+static int short_name_exists(BULK_ENTRY* dir, const BYTE* sfn)
+{
+    BULK_ENTRY* entry;
+
+    for (entry = dir->first_child; entry; entry = entry->next_sibling)
+    {
+        if (!memcmp(entry->sfn, sfn, 11))
+            return 1;
+    }
+    return 0;
+}
+
+/* Gives a unique short name to the entries of the directory */
+static int make_short_names(BULK_ENTRY* dir)
+{
+    BULK_ENTRY* entry;
+    BYTE basis[11];
+    BYTE sfn[11];
+    char tail[12];
+    DWORD number;
+    int pass, kind, length, body_length;
+
+    /* Exact short names first, so that the generated ones keep out of their way */
+    for (pass = 0; pass < 2; pass++)
+    {
+        for (entry = dir->first_child; entry; entry = entry->next_sibling)
+        {
+            if (entry->sfn[0])
+                continue;
+
+            kind = make_basis_name(entry, basis);
+            if (pass == 0)
+            {
+                if (kind == 0)
+                    memcpy(entry->sfn, basis, 11);
+                continue;
+            }
+
+            entry->lfn_entries = (int)((strlen(entry->name) + 12) / 13);
+            if (kind == 1 && !short_name_exists(dir, basis))
+            {
+                memcpy(entry->sfn, basis, 11);
+                continue;
+            }
+
+            body_length = 8;
+            while (body_length > 0 && basis[body_length - 1] == ' ')
+                body_length--;
+            for (number = 1; number < 1000000; number++)
+            {
+                length = sprintf(tail, "~%lu", (unsigned long)number);
+                memcpy(sfn, basis, 11);
+                memcpy(sfn + (body_length < 8 - length ? body_length : 8 - length), tail, length);
+                if (!short_name_exists(dir, sfn))
+                    break;
+            }
+            if (number == 1000000)
+            {
+                fprintf(stderr, "Error: Unable to make a short name for '%s'.\n", entry->name);
+                return 1;
+            }
+            memcpy(entry->sfn, sfn, 11);
+        }
+    }
+    return 0;
+}
+
+/* Links a chain of clusters, skipping the ones already in use */
+static DWORD allocate_clusters(BULK_VOLUME* vol, DWORD count)
+{
+    DWORD first = 0, previous = 0;
+
+    while (count > 0)
+    {
+        if (vol->chain[vol->next_cluster] == 0)
+        {
+            if (previous)
+                vol->chain[previous] = vol->next_cluster;
+            else
+                first = vol->next_cluster;
+            vol->chain[vol->next_cluster] = END_OF_CHAIN;
+            previous = vol->next_cluster;
+            count--;
+        }
+        vol->next_cluster++;
+    }
+    if (previous)
+        vol->last_cluster = previous;
+
+    return first;
+}
+
+/* Returns the first sector of the run of consecutive clusters starting at the cluster, and moves to the next run */
+static DWORD next_run(BULK_VOLUME* vol, DWORD* cluster, DWORD* sectors)
+{
+    DWORD first = *cluster;
+    DWORD last = first;
+
+    while (vol->chain[last] == last + 1)
+        last++;
+
+    *cluster = vol->chain[last];
+    *sectors = (last - first + 1) * vol->cluster_sectors;
+    return cluster_to_sector(vol, first);
+}
+
+static int write_chain(BULK_VOLUME* vol, DWORD cluster, const BYTE* data, DWORD sectors)
+{
+    DWORD sector, run_sectors;
+
+    while (sectors > 0)
+    {
+        sector = next_run(vol, &cluster, &run_sectors);
+        if (run_sectors > sectors)
+            run_sectors = sectors;
+        if (disk_write(0, data, sector, run_sectors))
+            return 1;
+        data += run_sectors * SECTOR_SIZE;
+        sectors -= run_sectors;
+    }
+    return 0;
+}
+
+/* A directory has at least one cluster, even the empty root of FAT32 */
+static DWORD directory_clusters(BULK_VOLUME* vol, BULK_ENTRY* dir)
+{
+    DWORD cluster_size = vol->cluster_sectors * SECTOR_SIZE;
+    DWORD clusters = (dir->size + cluster_size - 1) / cluster_size;
+
+    return clusters ? clusters : 1;
+}
+
+static BYTE* put_lfn_entries(BYTE* dir, BULK_ENTRY* entry)
+{
+    static const BYTE offsets[13] = { 1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30 };
+    size_t length = strlen(entry->name);
+    BYTE sum = 0;
+    int order, i;
+
+    for (i = 0; i < 11; i++)
+        sum = (BYTE)(((sum & 1) << 7) + (sum >> 1) + entry->sfn[i]);
+
+    for (order = entry->lfn_entries; order > 0; order--, dir += DIR_ENTRY_SIZE)
+    {
+        dir[0] = (BYTE)(order == entry->lfn_entries ? order | 0x40 : order);
+        dir[11] = AM_LFN;
+        dir[13] = sum;
+        for (i = 0; i < 13; i++)
+        {
+            size_t index = (order - 1) * 13 + i;
+            WCHAR wc;
+
+            if (index < length)
+                wc = ff_convert((BYTE)entry->name[index], 1);
+            else
+                wc = (index == length) ? 0 : 0xFFFF;
+            st_word(dir + offsets[i], wc);
+        }
+    }
+    return dir;
+}
+
+static BYTE* put_entry(BYTE* dir, const BYTE* sfn, BYTE attr, BYTE nt_flags,
+                       DWORD cluster, DWORD size, DWORD time)
+{
+    memcpy(dir, sfn, 11);
+    dir[11] = attr;
+    dir[12] = nt_flags;
+    st_dword(dir + 14, time);           /* Created time */
+    st_word(dir + 20, (WORD)(cluster >> 16));
+    st_dword(dir + 22, time);           /* Modified time */
+    st_word(dir + 26, (WORD)cluster);
+    st_dword(dir + 28, size);
+    return dir + DIR_ENTRY_SIZE;
+}
+
+static int write_directory(BULK_VOLUME* vol, BULK_ENTRY* dir, BULK_ENTRY* root, DWORD time)
+{
+    BULK_ENTRY* entry;
+    BYTE* table;
+    BYTE* p;
+    DWORD sectors;
+    int ret;
+
+    if (dir == root && vol->fs_type != FS_FAT32)
+        sectors = vol->root_entries / (SECTOR_SIZE / DIR_ENTRY_SIZE);
+    else
+        sectors = directory_clusters(vol, dir) * vol->cluster_sectors;
+
+    table = calloc(sectors, SECTOR_SIZE);
+    if (!table)
+    {
+        fprintf(stderr, "Error: Unable to allocate memory.\n");
+        return 1;
+    }
+
+    p = table;
+    if (dir == root)
+    {
+        if (vol->has_label)
+        {
+            memcpy(p, vol->label, DIR_ENTRY_SIZE);
+            p += DIR_ENTRY_SIZE;
+        }
+    }
+    else
+    {
+        p = put_entry(p, (const BYTE*)".          ", AM_DIR, 0, dir->first_cluster, 0, time);
+        p = put_entry(p, (const BYTE*)"..         ", AM_DIR, 0,
+                      dir->parent == root ? 0 : dir->parent->first_cluster, 0, time);
+    }
+    for (entry = dir->first_child; entry; entry = entry->next_sibling)
+    {
+        p = put_lfn_entries(p, entry);
+        p = put_entry(p, entry->sfn, entry->source ? AM_ARC : AM_DIR, entry->nt_flags,
+                      entry->first_cluster, entry->source ? entry->size : 0, time);
+    }
+
+    if (dir == root && vol->fs_type != FS_FAT32)
+        ret = disk_write(0, table, vol->root_start, sectors);
+    else
+        ret = write_chain(vol, dir->first_cluster, table, sectors);
+    free(table);
+
+    if (ret)
+        fprintf(stderr, "Error: Unable to write directory '%s' to image.\n", dir->name);
+    return ret;
+}
+
+static int copy_file(BULK_VOLUME* vol, BULK_ENTRY* file, BYTE* buffer)
+{
+    FILE* fe;
+    DWORD cluster = file->first_cluster;
+    DWORD remaining = file->size;
+    DWORD sector, run_sectors, sectors, bytes;
+
+    fe = fopen(file->source, "rb");
+    if (!fe)
+    {
+        fprintf(stderr, "Error: Unable to open external file '%s' for reading.\n", file->source);
+        return 1;
+    }
+
+    while (remaining > 0)
+    {
+        sector = next_run(vol, &cluster, &run_sectors);
+        while (remaining > 0 && run_sectors > 0)
+        {
+            sectors = (run_sectors < COPY_SECTORS) ? run_sectors : COPY_SECTORS;
+            bytes = (remaining < sectors * SECTOR_SIZE) ? remaining : sectors * SECTOR_SIZE;
+            sectors = (bytes + SECTOR_SIZE - 1) / SECTOR_SIZE;
+
+            if (fread(buffer, 1, bytes, fe) != bytes)
+            {
+                fprintf(stderr, "Error: External file '%s' changed while building the image.\n", file->source);
+                fclose(fe);
+                return 1;
+            }
+            memset(buffer + bytes, 0, sectors * SECTOR_SIZE - bytes);
+            if (disk_write(0, buffer, sector, sectors))
+            {
+                fprintf(stderr, "Error: Unable to write '%s' to image.\n", file->source);
+                fclose(fe);
+                return 1;
+            }
+
+            sector += sectors;
+            run_sectors -= sectors;
+            remaining -= bytes;
+        }
+    }
+
+    fclose(fe);
+    return 0;
+}
+
+static int write_fat(BULK_VOLUME* vol)
+{
+    BYTE sector[SECTOR_SIZE];
+    DWORD cluster, free_clusters = 0, i;
+
+    for (cluster = 2; cluster < vol->cluster_count + 2; cluster++)
+    {
+        if (vol->chain[cluster] == END_OF_CHAIN)
+            put_fat(vol, cluster, end_of_chain(vol));
+        else if (vol->chain[cluster] != 0)
+            put_fat(vol, cluster, vol->chain[cluster]);
+        else
+            free_clusters++;
+    }
+
+    for (i = 0; i < vol->fat_count; i++)
+    {
+        if (disk_write(0, vol->fat, vol->fat_start + i * vol->fat_sectors, vol->fat_sectors))
+        {
+            fprintf(stderr, "Error: Unable to write the FAT to image.\n");
+            return 1;
+        }
+    }
+
+    /* Keep the free cluster count of FAT32 right */
+    if (vol->fs_type == FS_FAT32 && vol->fsinfo_sector && vol->fsinfo_sector < vol->fat_start)
+    {
+        if (disk_read(0, sector, vol->fsinfo_sector, 1))
+            return 1;
+        if (ld_dword(sector) == 0x41615252 && ld_dword(sector + 484) == 0x61417272)
+        {
+            st_dword(sector + 488, free_clusters);
+            st_dword(sector + 492, vol->last_cluster ? vol->last_cluster : 0xFFFFFFFF);
+            if (disk_write(0, sector, vol->fsinfo_sector, 1))
+                return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void free_tree(BULK_ENTRY* dir)
+{
+    BULK_ENTRY* entry = dir->first_child;
+
+    while (entry)
+    {
+        BULK_ENTRY* next = entry->next_sibling;
+
+        free_tree(entry);
+        free(entry->name);
+        free(entry->source);
+        free(entry);
+        entry = next;
+    }
+}
+
+int bulk_build(const char* manifest)
+{
+    BULK_VOLUME vol;
+    BULK_ENTRY root;
+    BULK_ENTRY* files = NULL;
+    BULK_ENTRY* dir;
+    BULK_ENTRY* last_dir;
+    BULK_ENTRY* entry;
+    BYTE* buffer = NULL;
+    DWORD cluster_size, entries, clusters, needed = 0;
+    DWORD time = get_fattime();
+    int ret = 1;
+
+    memset(&vol, 0, sizeof(vol));
+    memset(&root, 0, sizeof(root));
+    root.name = "/";
+
+    if (open_volume(&vol) || read_manifest(manifest, &root, &files))
+        goto exit;
+    cluster_size = vol.cluster_sectors * SECTOR_SIZE;
+
+    /* Lay out the directories breadth first, in front of the files */
+    for (dir = last_dir = &root; dir; dir = dir->next)
+    {
+        if (make_short_names(dir))
+            goto exit;
+
+        entries = (dir == &root) ? vol.has_label : 2;
+        for (entry = dir->first_child; entry; entry = entry->next_sibling)
+        {
+            entries += 1 + entry->lfn_entries;
+            if (!entry->source)
+            {
+                last_dir->next = entry;
+                last_dir = entry;
+            }
+        }
+        dir->size = entries * DIR_ENTRY_SIZE;
+
+        if (dir == &root && vol.fs_type != FS_FAT32)
+        {
+            if (entries > vol.root_entries)
+            {
+                fprintf(stderr, "Error: Too many entries for the root directory (%lu, at most %lu).\n",
+                        (unsigned long)entries, (unsigned long)vol.root_entries);
+                goto exit;
+            }
+        }
+        else
+        {
+            needed += directory_clusters(&vol, dir) - (dir == &root);
+        }
+    }
+    for (entry = files; entry; entry = entry->next)
+        needed += (entry->size + cluster_size - 1) / cluster_size;
+
+    if (needed > vol.cluster_count - (vol.fs_type == FS_FAT32))
+    {
+        fprintf(stderr, "Error: The files need %lu clusters, the image has %lu.\n",
+                (unsigned long)needed, (unsigned long)(vol.cluster_count - (vol.fs_type == FS_FAT32)));
+        goto exit;
+    }
+
+    for (dir = &root; dir; dir = dir->next)
+    {
+        clusters = directory_clusters(&vol, dir);
+        if (dir != &root)
+            dir->first_cluster = allocate_clusters(&vol, clusters);
+        else if (vol.fs_type == FS_FAT32)
+        {
+            dir->first_cluster = vol.root_cluster;
+            if (clusters > 1)
+                vol.chain[vol.root_cluster] = allocate_clusters(&vol, clusters - 1);
+        }
+    }
+    for (entry = files; entry; entry = entry->next)
+    {
+        if (entry->size)
+            entry->first_cluster = allocate_clusters(&vol, (entry->size + cluster_size - 1) / cluster_size);
+    }
+
+    /* Write everything in the order of the layout */
+    for (dir = &root; dir; dir = dir->next)
+    {
+        if (write_directory(&vol, dir, &root, time))
+            goto exit;
+    }
+
+    buffer = malloc(COPY_SECTORS * SECTOR_SIZE);
+    if (!buffer)
+    {
+        fprintf(stderr, "Error: Unable to allocate memory.\n");
+        goto exit;
+    }
+    for (entry = files; entry; entry = entry->next)
+    {
+        if (copy_file(&vol, entry, buffer))
+            goto exit;
+    }
+
+    ret = write_fat(&vol);
+
+exit:
+    free(buffer);
+    free_tree(&root);
+    free(vol.fat);
+    free(vol.chain);
+
+    return ret;
+}
@@ -0,0 +1,10 @@
+/*
+ * COPYRIGHT:       See COPYING in the top level directory
+ * PROJECT:         ReactOS FAT Image Creator
+ * FILE:            tools/fatten/bulk.h
+ * PURPOSE:         Bulk build of freshly formatted images
+ */
+
+#pragma once
+
+int bulk_build(const char* manifest);
@@ -11,6 +11,7 @@
 #include <ctype.h>
 #include "fatfs/ff.h"
 #include "fatfs/diskio.h"
+#include "bulk.h"
 
 static FATFS g_Filesystem;
 static int isMounted = 0;
@@ -70,6 +71,11 @@ void print_help(const char* name)
            "            Writes a new boot sector.\n");
     printf("    -add <src path> <dst path>\n"
            "            Copies an external file or directory into the image.\n");
+    printf("    -bulk <manifest file>\n"
+           "            Adds all the files and directories listed in the manifest to\n"
+           "            a freshly formatted image at once. Each line is either\n"
+           "            '<src path> <dst path>' for a file, or '<dst path>' for a\n"
+           "            directory.\n");
     printf("    -extract <src path> <dst path>\n"
            "            Copies a file or directory from the image into an external file\n"
            "            or directory.\n");
@@ -393,6 +399,25 @@ int main(int oargc, char* oargv[])
             fclose(fe);
             f_close(&fv);
         }
+        else if (strcmp(parg, "bulk") == 0)
+        {
+            NEED_PARAMS(1, 1);
+
+            // Arg 1: manifest file
+
+            // The image is written directly, FatFs must not keep anything cached
+            if (isMounted)
+            {
+                f_mount(NULL, "0:", 0);
+                isMounted = 0;
+            }
+
+            if (bulk_build(argv[0]))
+            {
+                ret = 1;
+                goto exit;
+            }
+        }
         else if (strcmp(parg, "extract") == 0)
         {
             FIL   fe = { 0 };
@@ -22,6 +22,8 @@ static char CacheName[PATH_MAX];
 static char *cache_name = CacheName;
 static char TmpName[PATH_MAX];
 static char *tmp_name = TmpName;
+static char SymCacheName[PATH_MAX];
+static char *symcache_name = SymCacheName;
 
 static int
 unpack_iso(char *dir, char *iso)
@@ -150,9 +152,20 @@ check_directory(int force)
         strcat(cache_name, PATH_STR CACHEFILE);
     strcpy(tmp_name, cache_name);
     strcat(tmp_name, "~");
+    strcpy(symcache_name, opt_dir);
+    if (cleanable(opt_dir))
+        strcat(symcache_name, ALT_PATH_STR SYMCACHEDIR);
+    else
+        strcat(symcache_name, PATH_STR SYMCACHEDIR);
     return 0;
 }
 
+const char *
+symcache_dir(void)
+{
+    return symcache_name;
+}
+
 int
 read_cache(void)
 {
@@ -199,6 +212,7 @@ create_cache(int force, int skipImageBase)
         l2l_dbg(1, "Apparently %s is not writable (mounted ISO?), using current dir\n", tmp_name);
         cache_name = basename(cache_name);
         tmp_name = basename(tmp_name);
+        symcache_name = basename(symcache_name);
     }
     else
     {
@@ -11,5 +11,6 @@ int check_directory(int force);
 int read_cache(void);
 int create_cache(int force, int skipImageBase);
 int cleanable(char *path);
+const char *symcache_dir(void);
 
 /* EOF */
@@ -7,10 +7,12 @@
 #endif
 
 #include <direct.h>
+#include <process.h>
 
 #define POPEN           _popen
 #define PCLOSE          _pclose
 #define MKDIR(d)        _mkdir(d)
+#define GETPID          _getpid
 #define DEV_NULL        "NUL"
 #define DOS_PATHS
 #define PATH_CHAR       '\\'
@@ -21,10 +23,12 @@
 
 #else /* not defined (_WIN32) */
 #include <sys/stat.h>
+#include <unistd.h>
 
 #define POPEN           popen
 #define PCLOSE          pclose
 #define MKDIR(d)        mkdir(d, S_IRWXU|S_IRWXG|S_IROTH|S_IXOTH)
+#define GETPID          getpid
 #define DEV_NULL        "/dev/null"
 #define UNIX_PATHS
 #define PATH_CHAR       '/'
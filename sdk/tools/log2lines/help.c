@@ -29,7 +29,9 @@ char *verboseUsage =
 "  - The offset of a relocated image MUST be relative.\n\n"
 "  log2lines uses a cache in order to avoid a directory scan at each\n"
 "  image lookup, greatly increasing performance. Only image path and its\n"
-"  base address are cached.\n\n"
+"  base address are cached.\n"
+"  The symbols of each image are also cached, in the '" SYMCACHEDIR "'\n"
+"  directory, so that they are only read once per build of the image.\n\n"
 "Options:\n"
 "  -b   Use this combined with '-l'. Enable buffering on logFile.\n"
 "       This may solve loosing output on real hardware (ymmv).\n\n"
@@ -49,6 +51,12 @@ char *verboseUsage =
 "  -f   Force creating new cache.\n\n"
 "  -F   As -f but exits immediately after creating cache.\n\n"
 "  -h   This text.\n\n"
+"  -j <threads>\n"
+"       <threads>: Number of threads loading the symbols of the images.\n"
+"       Only used when the input is a file, which is then read in chunks:\n"
+"       the images of a chunk are loaded together, and the output keeps\n"
+"       the order of the input.\n"
+"       Default: the number of processors\n\n"
 "  -l <logFile>\n"
 "       <logFile>: Append copy to specified logFile.\n"
 "       Default: no logFile\n\n"
@@ -12,21 +12,10 @@
 #include "compat.h"
 #include "util.h"
 #include "options.h"
+#include "image.h"
 #include "log2lines.h"
 #include <sys/types.h>
 
-static PIMAGE_SECTION_HEADER
-find_rossym_section(PIMAGE_FILE_HEADER PEFileHeader, PIMAGE_SECTION_HEADER PESectionHeaders)
-{
-    size_t i;
-    for (i = 0; i < PEFileHeader->NumberOfSections; i++)
-    {
-        if (0 == strcmp((char *)PESectionHeaders[i].Name, ".rossym"))
-            return &PESectionHeaders[i];
-    }
-    return NULL;
-}
-
 size_t
 fixup_offset(size_t ImageBase, size_t offset)
 {
@@ -35,67 +24,55 @@ fixup_offset(size_t ImageBase, size_t offset)
     return offset;
 }
 
-PROSSYM_ENTRY
-find_offset(void *data, size_t offset)
+/*
+ * Locates the .rossym section of an image, and reads what identifies
+ * the build of the image.
+ */
+int
+get_RosSymSection(FILE *fr, PIMAGE_SECTION_HEADER RosSymSection, IMAGE_ID *Id)
 {
-    PSYMBOLFILE_HEADER RosSymHeader = (PSYMBOLFILE_HEADER)data;
-    PROSSYM_ENTRY Entries = (PROSSYM_ENTRY)((char *)data + RosSymHeader->SymbolsOffset);
-    size_t symbols = RosSymHeader->SymbolsLength / sizeof(ROSSYM_ENTRY);
+    IMAGE_DOS_HEADER PEDosHeader;
+    IMAGE_FILE_HEADER PEFileHeader;
+    IMAGE_OPTIONAL_HEADER PEOptHeader;
     size_t i;
 
-    for (i = 0; i < symbols; i++)
-    {
-        if (Entries[i].Address > offset)
-        {
-            if (!i--)
-                return NULL;
-            else
-                return &Entries[i];
-        }
-    }
-    return NULL;
-}
-
-PIMAGE_SECTION_HEADER
-get_sectionheader(const void *FileData)
-{
-    PIMAGE_DOS_HEADER PEDosHeader;
-    PIMAGE_FILE_HEADER PEFileHeader;
-    PIMAGE_OPTIONAL_HEADER PEOptHeader;
-    PIMAGE_SECTION_HEADER PESectionHeaders;
-    PIMAGE_SECTION_HEADER PERosSymSectionHeader;
-    size_t ImageBase;
-
     /* Check if MZ header exists */
-    PEDosHeader = (PIMAGE_DOS_HEADER)FileData;
-    if (PEDosHeader->e_magic != IMAGE_DOS_MAGIC || PEDosHeader->e_lfanew == 0L)
+    if (fseek(fr, 0, SEEK_SET) ||
+        fread(&PEDosHeader, sizeof(IMAGE_DOS_HEADER), 1, fr) != 1 ||
+        PEDosHeader.e_magic != IMAGE_DOS_MAGIC || PEDosHeader.e_lfanew == 0L)
     {
-        l2l_dbg(0, "Input file is not a PE image.\n");
-        summ.offset_errors++;
-        return NULL;
+        return 2;
     }
 
-    /* Locate PE file header */
+    /* Locate PE file header and optional header */
     /* sizeof(ULONG) = sizeof(MAGIC) */
-    PEFileHeader = (PIMAGE_FILE_HEADER)((char *)FileData + PEDosHeader->e_lfanew + sizeof(ULONG));
-
-    /* Locate optional header */
-    PEOptHeader = (PIMAGE_OPTIONAL_HEADER)(PEFileHeader + 1);
-    ImageBase = PEOptHeader->ImageBase;
+    if (fseek(fr, PEDosHeader.e_lfanew + sizeof(ULONG), SEEK_SET) ||
+        fread(&PEFileHeader, sizeof(IMAGE_FILE_HEADER), 1, fr) != 1 ||
+        PEFileHeader.SizeOfOptionalHeader < sizeof(IMAGE_OPTIONAL_HEADER) ||
+        fread(&PEOptHeader, sizeof(IMAGE_OPTIONAL_HEADER), 1, fr) != 1)
+    {
+        return 2;
+    }
 
-    /* Locate PE section headers */
-    PESectionHeaders = (PIMAGE_SECTION_HEADER)((char *)PEOptHeader + PEFileHeader->SizeOfOptionalHeader);
+    /* SizeOfImage and CheckSum are at the same place for 32 and 64 bit */
+    Id->TimeDateStamp = PEFileHeader.TimeDateStamp;
+    Id->SizeOfImage = PEOptHeader.SizeOfImage;
+    Id->CheckSum = PEOptHeader.CheckSum;
 
     /* find rossym section */
-    PERosSymSectionHeader = find_rossym_section(PEFileHeader, PESectionHeaders);
-    if (!PERosSymSectionHeader)
+    if (fseek(fr, PEDosHeader.e_lfanew + sizeof(ULONG) + sizeof(IMAGE_FILE_HEADER) +
+                  PEFileHeader.SizeOfOptionalHeader, SEEK_SET))
     {
-        l2l_dbg(0, "Couldn't find rossym section in executable\n");
-        summ.offset_errors++;
-        return NULL;
+        return 3;
     }
-
-    return PERosSymSectionHeader;
+    for (i = 0; i < PEFileHeader.NumberOfSections; i++)
+    {
+        if (fread(RosSymSection, sizeof(IMAGE_SECTION_HEADER), 1, fr) != 1)
+            break;
+        if (strncmp((char *)RosSymSection->Name, ".rossym", IMAGE_SIZEOF_SHORT_NAME) == 0)
+            return 0;
+    }
+    return 3;
 }
 
 int
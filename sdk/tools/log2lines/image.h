@@ -7,13 +7,19 @@
 
 #pragma once
 
+#include <stdio.h>
 #include <rsym.h>
 
-size_t fixup_offset(size_t ImageBase, size_t offset);
+typedef struct image_id_struct
+{
+    ULONG TimeDateStamp;
+    ULONG CheckSum;
+    ULONG SizeOfImage;
+} IMAGE_ID;
 
-PROSSYM_ENTRY find_offset(void *data, size_t offset);
+size_t fixup_offset(size_t ImageBase, size_t offset);
 
-PIMAGE_SECTION_HEADER get_sectionheader(const void *FileData);
+int get_RosSymSection(FILE *fr, PIMAGE_SECTION_HEADER RosSymSection, IMAGE_ID *Id);
 
 int get_ImageBase(char *fname, size_t *ImageBase);
 
@@ -16,6 +16,7 @@
 #include "options.h"
 #include "image.h"
 #include "cache.h"
+#include "symtab.h"
 #include "log2lines.h"
 #include "help.h"
 #include "cmd.h"
@@ -104,20 +105,19 @@ report(FILE *outFile)
 
 
 static int
-print_offset(void *data, size_t offset, char *toString)
+print_offset(PSYMTAB tab, size_t offset, char *toString)
 {
-    PSYMBOLFILE_HEADER RosSymHeader = (PSYMBOLFILE_HEADER)data;
     PROSSYM_ENTRY e = NULL;
     PROSSYM_ENTRY e2 = NULL;
     int bFileOffsetChanged = 0;
     char fmt[LINESIZE];
-    char *Strings = (char *)data + RosSymHeader->StringsOffset;
+    char *Strings = tab->strings;
 
     fmt[0] = '\0';
-    e = find_offset(data, offset);
+    e = symtab_find(tab, offset);
     if (opt_twice)
     {
-        e2 = find_offset(data, offset - 1);
+        e2 = symtab_find(tab, offset - 1);
 
         if (e == e2)
             e2 = NULL;
@@ -216,15 +216,35 @@ print_offset(void *data, size_t offset, char *toString)
 }
 
 static int
-process_data(const void *FileData, size_t offset, char *toString)
+process_file(const char *file_name, size_t offset, char *toString)
 {
+    PSYMTAB tab;
     int res;
 
-    PIMAGE_SECTION_HEADER PERosSymSectionHeader = get_sectionheader((char *)FileData);
-    if (!PERosSymSectionHeader)
+    tab = symtab_get(file_name);
+    if (!tab || tab->status == SYMTAB_LOAD_ERROR)
+    {
+        l2l_dbg(0, "An error occured loading '%s'\n", file_name);
+        return 1;
+    }
+
+    switch (tab->status)
+    {
+    case SYMTAB_NOT_PE:
+        l2l_dbg(0, "Input file is not a PE image.\n");
+        summ.offset_errors++;
+        return 2;
+    case SYMTAB_NO_ROSSYM:
+        l2l_dbg(0, "Couldn't find rossym section in executable\n");
+        summ.offset_errors++;
+        return 2;
+    case SYMTAB_BAD_ROSSYM:
+        l2l_dbg(0, "Invalid rossym section in executable\n");
+        summ.offset_errors++;
         return 2;
+    }
 
-    res = print_offset((char *)FileData + PERosSymSectionHeader->PointerToRawData, offset, toString);
+    res = print_offset(tab, offset, toString);
     if (res)
     {
         if (toString)
@@ -238,37 +258,15 @@ process_data(const void *FileData, size_t offset, char *toString)
     return res;
 }
 
+/* Finds the image file of a (converted) image path */
 static int
-process_file(const char *file_name, size_t offset, char *toString)
-{
-    void *FileData;
-    size_t FileSize;
-    int res = 1;
-
-    FileData = load_file(file_name, &FileSize);
-    if (!FileData)
-    {
-        l2l_dbg(0, "An error occured loading '%s'\n", file_name);
-    }
-    else
-    {
-        res = process_data(FileData, offset, toString);
-        free(FileData);
-    }
-    return res;
-}
-
-static int
-translate_file(const char *cpath, size_t offset, char *toString)
+find_module(char *path, char **pfile)
 {
     size_t base = 0;
     LIST_MEMBER *pentry = NULL;
     int res = 0;
-    char *path, *dpath;
 
-    dpath = path = convert_path(cpath);
-    if (!path)
-        return 1;
+    *pfile = path;
 
     // The path could be absolute:
     if (get_ImageBase(path, &base))
@@ -276,11 +274,11 @@ translate_file(const char *cpath, size_t offset, char *toString)
         pentry = entry_lookup(&cache, path);
         if (pentry)
         {
-            path = pentry->path;
+            *pfile = pentry->path;
             base = pentry->ImageBase;
             if (base == INVALID_BASE)
             {
-                l2l_dbg(1, "No, or invalid base address: %s\n", path);
+                l2l_dbg(1, "No, or invalid base address: %s\n", pentry->path);
                 res = 2;
             }
         }
@@ -290,7 +288,20 @@ translate_file(const char *cpath, size_t offset, char *toString)
             res = 3;
         }
     }
+    return res;
+}
+
+static int
+translate_file(const char *cpath, size_t offset, char *toString)
+{
+    int res;
+    char *path, *dpath;
 
+    dpath = convert_path(cpath);
+    if (!dpath)
+        return 1;
+
+    res = find_module(dpath, &path);
     if (!res)
     {
         res = process_file(path, offset, toString);
@@ -317,6 +328,65 @@ remove_mark(char *Line)
     return Line;
 }
 
+/*
+ * Loads the symbols of all the images referenced by a chunk of lines,
+ * with several threads, before the lines are translated one by one.
+ */
+static void
+preload_lines(char *Lines, int count)
+{
+    char Line[LINESIZE + 1];
+    char path[LINESIZE + 1];
+    char **paths, **files, *file;
+    unsigned int offset;
+    int i, j, cnt, npaths = 0, nfiles = 0;
+    unsigned char ch;
+    char *s, *sep;
+
+    paths = malloc(count * sizeof(char *));
+    files = malloc(count * sizeof(char *));
+    if (!paths || !files)
+        goto done;
+
+    for (i = 0; i < count; i++)
+    {
+        /* Same parsing as translate_line(), on a copy */
+        strcpy(Line, remove_mark(Lines + i * (LINESIZE + 1)));
+        s = Line;
+        sep = strchr(s, ':');
+        if (!sep)
+            continue;
+        *sep = ' ';
+        cnt = sscanf(s, "<%s %x%c", path, &offset, &ch);
+        if (cnt != 3 || (ch != '>' && ch != ' '))
+            continue;
+
+        if (!(paths[npaths] = convert_path(path)))
+            continue;
+        for (j = 0; j < npaths && strcmp(paths[npaths], paths[j]) != 0; j++)
+            ;
+        if (j < npaths)
+        {
+            free(paths[npaths]);
+            continue;
+        }
+        if (!find_module(paths[npaths], &file))
+            files[nfiles++] = file;
+        npaths++;
+    }
+
+    symtab_preload(files, nfiles);
+
+done:
+    if (paths)
+    {
+        for (i = 0; i < npaths; i++)
+            free(paths[i]);
+    }
+    free(paths);
+    free(files);
+}
+
 static void
 translate_line(FILE *outFile, char *Line, char *path, char *LineOut)
 {
@@ -411,9 +481,11 @@ translate_files(FILE *inFile, FILE *outFile)
     char Line[LINESIZE + 1];
     char path[LINESIZE + 1];
     char LineOut[LINESIZE + 1];
+    char *Lines;
     int c;
     unsigned char ch;
     int i = 0;
+    int n;
     const char *pc    = kdbg_cont;
     const char *p     = kdbg_prompt;
     const char *p_eos = p + sizeof(KDBG_PROMPT) - 1; //end of string pos
@@ -517,6 +589,26 @@ translate_files(FILE *inFile, FILE *outFile)
                 translate_char(c, outFile);
         }
     }
+    else if (!opt_raw && is_regular_file(inFile) &&
+             (Lines = malloc(CHUNK_LINES * (LINESIZE + 1))) != NULL)
+    {   // Chunks of lines from a file, loading their images together
+        do
+        {
+            for (n = 0; n < CHUNK_LINES; n++)
+            {
+                if (!fgets(Lines + n * (LINESIZE + 1), LINESIZE, inFile))
+                    break;
+            }
+            preload_lines(Lines, n);
+
+            for (i = 0; i < n && !opt_quit; i++)
+            {
+                translate_line(outFile, Lines + i * (LINESIZE + 1), path, LineOut);
+                report(outFile);
+            }
+        } while (n == CHUNK_LINES && !opt_quit);
+        free(Lines);
+    }
     else
     {   // Line by line, slightly faster but less interactive
         while (fgets(Line, LINESIZE, inFile) != NULL)
@@ -666,6 +758,7 @@ cleanup:
 
     list_clear(&sources);
     list_clear(&cache);
+    symtab_clear();
 
     return res;
 }
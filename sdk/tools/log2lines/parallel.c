@@ -0,0 +1,149 @@
+/*
+ * ReactOS log2lines
+ *
+ * - Worker threads
+ *
+ * Kept apart from the rest, which uses the PE definitions of rsym.h
+ * instead of windows.h.
+ */
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "parallel.h"
+
+#define MAX_THREADS     64      /* MAXIMUM_WAIT_OBJECTS */
+
+typedef struct parallel_struct
+{
+    PARALLEL_JOB job;
+    void *context;
+    int count;
+    int next;
+#if defined(_WIN32)
+    CRITICAL_SECTION lock;
+#else
+    pthread_mutex_t lock;
+#endif
+} PARALLEL;
+
+int
+processor_count(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+static int
+next_job(PARALLEL *par)
+{
+    int index;
+
+#if defined(_WIN32)
+    EnterCriticalSection(&par->lock);
+    index = par->next++;
+    LeaveCriticalSection(&par->lock);
+#else
+    pthread_mutex_lock(&par->lock);
+    index = par->next++;
+    pthread_mutex_unlock(&par->lock);
+#endif
+    return index;
+}
+
+static void
+run_jobs(PARALLEL *par)
+{
+    int index;
+
+    while ((index = next_job(par)) < par->count)
+        par->job(par->context, index);
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI
+worker(LPVOID param)
+{
+    run_jobs(param);
+    return 0;
+}
+#else
+static void *
+worker(void *param)
+{
+    run_jobs(param);
+    return NULL;
+}
+#endif
+
+/* Runs job(context, 0) to job(context, count - 1), the calling thread included */
+void
+run_parallel(PARALLEL_JOB job, void *context, int count, int threads)
+{
+    PARALLEL par;
+#if defined(_WIN32)
+    HANDLE workers[MAX_THREADS];
+#else
+    pthread_t workers[MAX_THREADS];
+#endif
+    int i, started = 0;
+
+    if (threads > count)
+        threads = count;
+    if (threads > MAX_THREADS)
+        threads = MAX_THREADS;
+
+    if (threads <= 1)
+    {
+        for (i = 0; i < count; i++)
+            job(context, i);
+        return;
+    }
+
+    par.job = job;
+    par.context = context;
+    par.count = count;
+    par.next = 0;
+
+#if defined(_WIN32)
+    InitializeCriticalSection(&par.lock);
+    for (i = 1; i < threads; i++)
+    {
+        if (!(workers[started] = CreateThread(NULL, 0, worker, &par, 0, NULL)))
+            break;
+        started++;
+    }
+    run_jobs(&par);
+    if (started)
+        WaitForMultipleObjects(started, workers, TRUE, INFINITE);
+    for (i = 0; i < started; i++)
+        CloseHandle(workers[i]);
+    DeleteCriticalSection(&par.lock);
+#else
+    pthread_mutex_init(&par.lock, NULL);
+    for (i = 1; i < threads; i++)
+    {
+        if (pthread_create(&workers[started], NULL, worker, &par))
+            break;
+        started++;
+    }
+    run_jobs(&par);
+    for (i = 0; i < started; i++)
+        pthread_join(workers[i], NULL);
+    pthread_mutex_destroy(&par.lock);
+#endif
+}
+
+/* EOF */
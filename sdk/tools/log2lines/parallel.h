@@ -0,0 +1,14 @@
+/*
+ * ReactOS log2lines
+ *
+ * - Worker threads
+ */
+
+#pragma once
+
+typedef void (*PARALLEL_JOB)(void *context, int index);
+
+int processor_count(void);
+void run_parallel(PARALLEL_JOB job, void *context, int count, int threads);
+
+/* EOF */
@@ -0,0 +1,423 @@
+/*
+ * ReactOS log2lines
+ *
+ * - Symbol tables of the images
+ *
+ * The .rossym section of an image is read once, when its first address
+ * is translated, and all the addresses of the image are then looked up
+ * in the table in memory. The table is also saved in the symbol cache
+ * directory, under a key made of the checksum, timestamp and size of
+ * the image, so that later runs neither read nor decode the section
+ * again.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "util.h"
+#include "compat.h"
+#include "options.h"
+#include "image.h"
+#include "cache.h"
+#include "parallel.h"
+#include "symtab.h"
+
+#include "log2lines.h"
+
+#define SYMCACHE_SIGNATURE  0x53324c4c  // "LL2S"
+
+typedef struct symcache_key_struct
+{
+    IMAGE_ID id;
+    ULONG RosSymSize;
+    ULONG FileSize;
+    ULONG FileTime;
+    ULONG EntrySize;            // sizeof(ROSSYM_ENTRY) of the writer
+} SYMCACHE_KEY;
+
+typedef struct symcache_header_struct
+{
+    ULONG Signature;
+    SYMCACHE_KEY Key;
+    ULONG SymbolsCount;
+    ULONG StringsLength;
+} SYMCACHE_HEADER;
+
+static PSYMTAB symtabs = NULL;
+
+static void
+symcache_name(char *name, const char *path, const SYMCACHE_KEY *key)
+{
+    const unsigned char *p = (const unsigned char *)key;
+    unsigned int hash = 2166136261u;
+    size_t i;
+
+    for (i = 0; i < sizeof(SYMCACHE_KEY); i++)
+        hash = (hash ^ p[i]) * 16777619u;
+
+    sprintf(name, "%s" PATH_STR "%.200s.%08x", symcache_dir(), basename((char *)path), hash);
+}
+
+/* The lookups need the entries sorted, as rsym writes them, and valid strings */
+static int
+check_symtab(PSYMTAB tab)
+{
+    size_t i;
+
+    if (tab->stringsLength == 0 || tab->strings[tab->stringsLength - 1] != '\0')
+        return 1;
+
+    for (i = 0; i < tab->count; i++)
+    {
+        if (tab->entries[i].FileOffset >= tab->stringsLength ||
+            tab->entries[i].FunctionOffset >= tab->stringsLength ||
+            (i > 0 && tab->entries[i].Address < tab->entries[i - 1].Address))
+            return 1;
+    }
+    return 0;
+}
+
+static int
+read_symcache(PSYMTAB tab, const SYMCACHE_KEY *key)
+{
+    char name[PATH_MAX + 256];
+    SYMCACHE_HEADER header;
+    FILE *fr;
+    int res = 1;
+
+    symcache_name(name, tab->path, key);
+    fr = fopen(name, "rb");
+    if (!fr)
+        return 1;
+
+    if (fread(&header, sizeof(header), 1, fr) == 1 &&
+        header.Signature == SYMCACHE_SIGNATURE &&
+        memcmp(&header.Key, key, sizeof(SYMCACHE_KEY)) == 0 &&
+        header.StringsLength > 0)
+    {
+        tab->entries = malloc(header.SymbolsCount * sizeof(ROSSYM_ENTRY) + 1);
+        tab->strings = malloc(header.StringsLength);
+        if (tab->entries && tab->strings &&
+            fread(tab->entries, sizeof(ROSSYM_ENTRY), header.SymbolsCount, fr) == header.SymbolsCount &&
+            fread(tab->strings, 1, header.StringsLength, fr) == header.StringsLength)
+        {
+            tab->count = header.SymbolsCount;
+            tab->stringsLength = header.StringsLength;
+            res = check_symtab(tab);
+        }
+        if (res)
+        {
+            free(tab->entries);
+            free(tab->strings);
+            tab->entries = NULL;
+            tab->strings = NULL;
+            tab->count = tab->stringsLength = 0;
+        }
+    }
+    fclose(fr);
+
+    if (!res)
+        l2l_dbg(2, "Symbols of %s read from %s\n", tab->path, name);
+    return res;
+}
+
+static void
+write_symcache(PSYMTAB tab, const SYMCACHE_KEY *key)
+{
+    char name[PATH_MAX + 256];
+    char tmp_name[PATH_MAX + 256 + 16];
+    SYMCACHE_HEADER header;
+    FILE *fw;
+    int ok;
+
+    /* mkPath() modifies the path it creates, so use a copy of our own */
+    strcpy(name, symcache_dir());
+    if (mkPath(name, 1))
+    {
+        l2l_dbg(1, "Cannot create %s\n", name);
+        return;
+    }
+
+    symcache_name(name, tab->path, key);
+    /* Unique for the other threads and the other log2lines processes */
+    sprintf(tmp_name, "%s~%lu~%p", name, (unsigned long)GETPID(), (void *)tab);
+    fw = fopen(tmp_name, "wb");
+    if (!fw)
+    {
+        l2l_dbg(1, "Cannot write %s\n", tmp_name);
+        return;
+    }
+
+    header.Signature = SYMCACHE_SIGNATURE;
+    header.Key = *key;
+    header.SymbolsCount = (ULONG)tab->count;
+    header.StringsLength = (ULONG)tab->stringsLength;
+    ok = fwrite(&header, sizeof(header), 1, fw) == 1 &&
+         fwrite(tab->entries, sizeof(ROSSYM_ENTRY), tab->count, fw) == tab->count &&
+         fwrite(tab->strings, 1, tab->stringsLength, fw) == tab->stringsLength;
+    ok = !fclose(fw) && ok;
+
+    /* Another log2lines may have written it meanwhile */
+    if (!ok || rename(tmp_name, name))
+        remove(tmp_name);
+}
+
+static int
+decode_v1(PSYMTAB tab, char *data, size_t size)
+{
+    PSYMBOLFILE_HEADER RosSymHeader = (PSYMBOLFILE_HEADER)data;
+
+    if (size < sizeof(SYMBOLFILE_HEADER) ||
+        RosSymHeader->SymbolsOffset > size ||
+        RosSymHeader->SymbolsLength > size - RosSymHeader->SymbolsOffset ||
+        RosSymHeader->StringsOffset > size ||
+        RosSymHeader->StringsLength > size - RosSymHeader->StringsOffset ||
+        RosSymHeader->StringsLength == 0)
+    {
+        return 1;
+    }
+
+    tab->count = RosSymHeader->SymbolsLength / sizeof(ROSSYM_ENTRY);
+    tab->stringsLength = RosSymHeader->StringsLength;
+    tab->entries = malloc(tab->count * sizeof(ROSSYM_ENTRY) + 1);
+    tab->strings = malloc(tab->stringsLength + 1);
+    if (!tab->entries || !tab->strings)
+        return 1;
+
+    memcpy(tab->entries, data + RosSymHeader->SymbolsOffset, tab->count * sizeof(ROSSYM_ENTRY));
+    memcpy(tab->strings, data + RosSymHeader->StringsOffset, tab->stringsLength);
+    tab->strings[tab->stringsLength++] = '\0';
+    return 0;
+}
+
+static int
+decode_v2(PSYMTAB tab, char *data, size_t size)
+{
+    ROSSYM_V2_INFO Info;
+    int res = 1;
+
+    if (LoadRosSymV2(data, (ULONG)size, &Info))
+        return 1;
+
+    tab->count = Info.SymbolsCount;
+    tab->stringsLength = Info.StringsLength;
+    tab->entries = malloc(tab->count * sizeof(ROSSYM_ENTRY) + 1);
+    tab->strings = malloc(tab->stringsLength);
+    if (tab->entries && tab->strings && !GetRosSymV2Entries(&Info, tab->entries))
+    {
+        memcpy(tab->strings, Info.Strings, tab->stringsLength);
+        res = 0;
+    }
+
+    FreeRosSymV2(&Info);
+    return res;
+}
+
+static void
+symtab_load(PSYMTAB tab)
+{
+    IMAGE_SECTION_HEADER RosSymSection;
+    SYMCACHE_KEY key;
+    struct stat st;
+    FILE *fr;
+    char *data;
+
+    fr = fopen(tab->path, "rb");
+    if (!fr)
+    {
+        tab->status = SYMTAB_LOAD_ERROR;
+        return;
+    }
+
+    memset(&key, 0, sizeof(key));
+    tab->status = get_RosSymSection(fr, &RosSymSection, &key.id);
+    if (tab->status)
+    {
+        fclose(fr);
+        return;
+    }
+
+    key.RosSymSize = RosSymSection.SizeOfRawData;
+    key.EntrySize = sizeof(ROSSYM_ENTRY);
+    if (!stat(tab->path, &st))
+    {
+        key.FileSize = (ULONG)st.st_size;
+        key.FileTime = (ULONG)st.st_mtime;
+    }
+
+    if (!opt_force && !read_symcache(tab, &key))
+    {
+        fclose(fr);
+        return;
+    }
+
+    tab->status = SYMTAB_BAD_ROSSYM;
+    data = malloc(RosSymSection.SizeOfRawData + 1);
+    if (!data)
+    {
+        fclose(fr);
+        return;
+    }
+    if (!fseek(fr, RosSymSection.PointerToRawData, SEEK_SET) &&
+        fread(data, 1, RosSymSection.SizeOfRawData, fr) == RosSymSection.SizeOfRawData)
+    {
+        /* Version 2 starts with a zero where version 1 has SymbolsOffset */
+        if (RosSymSection.SizeOfRawData >= sizeof(ULONG) && *(ULONG *)data == 0)
+            tab->status = decode_v2(tab, data, RosSymSection.SizeOfRawData) ? SYMTAB_BAD_ROSSYM : SYMTAB_OK;
+        else
+            tab->status = decode_v1(tab, data, RosSymSection.SizeOfRawData) ? SYMTAB_BAD_ROSSYM : SYMTAB_OK;
+    }
+    free(data);
+    fclose(fr);
+
+    if (!tab->status && check_symtab(tab))
+        tab->status = SYMTAB_BAD_ROSSYM;
+
+    if (tab->status)
+    {
+        free(tab->entries);
+        free(tab->strings);
+        tab->entries = NULL;
+        tab->strings = NULL;
+        tab->count = tab->stringsLength = 0;
+        return;
+    }
+
+    write_symcache(tab, &key);
+}
+
+static PSYMTAB
+symtab_lookup(const char *path)
+{
+    PSYMTAB tab;
+
+    for (tab = symtabs; tab; tab = tab->pnext)
+    {
+        if (PATHCMP(path, tab->path) == 0)
+            return tab;
+    }
+    return NULL;
+}
+
+static PSYMTAB
+symtab_create(const char *path)
+{
+    PSYMTAB tab;
+
+    tab = calloc(1, sizeof(SYMTAB));
+    if (!tab)
+        return NULL;
+    tab->path = malloc(strlen(path) + 1);
+    if (!tab->path)
+    {
+        free(tab);
+        return NULL;
+    }
+    strcpy(tab->path, path);
+    tab->status = SYMTAB_LOAD_ERROR;
+    return tab;
+}
+
+static void
+symtab_insert(PSYMTAB tab)
+{
+    tab->pnext = symtabs;
+    symtabs = tab;
+}
+
+PSYMTAB
+symtab_get(const char *path)
+{
+    PSYMTAB tab;
+
+    tab = symtab_lookup(path);
+    if (tab)
+        return tab;
+
+    tab = symtab_create(path);
+    if (!tab)
+        return NULL;
+    symtab_load(tab);
+    symtab_insert(tab);
+    return tab;
+}
+
+static void
+load_job(void *context, int index)
+{
+    symtab_load(((PSYMTAB *)context)[index]);
+}
+
+/* Loads the tables of the images not seen yet, on worker threads */
+void
+symtab_preload(char **paths, int count)
+{
+    PSYMTAB *tabs;
+    int i, j, n = 0;
+
+    tabs = malloc(count * sizeof(PSYMTAB));
+    if (!tabs)
+        return;
+
+    for (i = 0; i < count; i++)
+    {
+        if (symtab_lookup(paths[i]))
+            continue;
+        for (j = 0; j < n && PATHCMP(paths[i], tabs[j]->path) != 0; j++)
+            ;
+        if (j == n && (tabs[n] = symtab_create(paths[i])))
+            n++;
+    }
+
+    if (n > 0)
+    {
+        l2l_dbg(2, "Loading the symbols of %d images\n", n);
+        run_parallel(load_job, tabs, n, opt_threads);
+    }
+
+    for (i = 0; i < n; i++)
+        symtab_insert(tabs[i]);
+    free(tabs);
+}
+
+/* The last entry at or before the offset, like the linear search of the first versions */
+PROSSYM_ENTRY
+symtab_find(PSYMTAB tab, size_t offset)
+{
+    size_t low = 0, high = tab->count, mid;
+
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (tab->entries[mid].Address > offset)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+
+    /* No entry above the offset: past the end of the image */
+    if (low == 0 || low == tab->count)
+        return NULL;
+    return &tab->entries[low - 1];
+}
+
+void
+symtab_clear(void)
+{
+    PSYMTAB tab, next;
+
+    for (tab = symtabs; tab; tab = next)
+    {
+        next = tab->pnext;
+        free(tab->entries);
+        free(tab->strings);
+        free(tab->path);
+        free(tab);
+    }
+    symtabs = NULL;
+}
+
+/* EOF */
@@ -0,0 +1,34 @@
+/*
+ * ReactOS log2lines
+ *
+ * - Symbol tables of the images
+ */
+
+#pragma once
+
+#include <rsym.h>
+
+/* Load status, as reported by process_file() */
+#define SYMTAB_OK           0
+#define SYMTAB_LOAD_ERROR   1
+#define SYMTAB_NOT_PE       2
+#define SYMTAB_NO_ROSSYM    3
+#define SYMTAB_BAD_ROSSYM   4
+
+typedef struct symtab_struct
+{
+    char *path;
+    int status;
+    PROSSYM_ENTRY entries;      // sorted by address
+    size_t count;
+    char *strings;
+    size_t stringsLength;
+    struct symtab_struct *pnext;
+} SYMTAB, *PSYMTAB;
+
+PSYMTAB symtab_get(const char *path);
+void symtab_preload(char **paths, int count);
+PROSSYM_ENTRY symtab_find(PSYMTAB tab, size_t offset);
+void symtab_clear(void);
+
+/* EOF */
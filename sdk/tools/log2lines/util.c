@@ -9,6 +9,8 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "config.h"
 #include "compat.h"
@@ -60,6 +62,17 @@ file_exists(char *name)
     return 1;
 }
 
+/* Files can be read ahead, unlike pipes and consoles */
+int
+is_regular_file(FILE *f)
+{
+    struct stat st;
+
+    if (fstat(fileno(f), &st))
+        return 0;
+    return (st.st_mode & S_IFMT) == S_IFREG;
+}
+
 /* Do this in reverse (recursively)
    This saves many system calls if the path is likely
    to already exist (creating large trees).
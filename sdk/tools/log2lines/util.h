@@ -39,6 +39,7 @@
     }
 
 int file_exists(char *name);
+int is_regular_file(FILE *f);
 int mkPath(char *path, int isDir);
 char *basename(char *path);
 const char *getFmt(const char *a);
@@ -51,6 +51,28 @@ typedef struct _MEMKEY
 #define HKEY_TO_MEMKEY(hKey) ((PMEMKEY)(hKey))
 #define MEMKEY_TO_HKEY(memKey) ((HKEY)(memKey))
 
+/*
+ * The keys along the path last opened by RegpCreateOrOpenKey(). The INF
+ * files give the full path of the key on every line, and consecutive lines
+ * mostly share all or a large part of it, so the next lookup restarts from
+ * the deepest key both paths have in common.
+ */
+#define LAST_KEY_PATH_MAX_DEPTH     32
+#define LAST_KEY_PATH_MAX_LENGTH    512
+
+typedef struct _LAST_KEY_PATH
+{
+    PCMHIVE StartHive;              /* NULL if there is no path */
+    HCELL_INDEX StartCellOffset;
+    ULONG Depth;
+    SIZE_T Lengths[LAST_KEY_PATH_MAX_DEPTH];
+    PCMHIVE RegistryHives[LAST_KEY_PATH_MAX_DEPTH];
+    HCELL_INDEX KeyCellOffsets[LAST_KEY_PATH_MAX_DEPTH];
+    WCHAR Path[LAST_KEY_PATH_MAX_LENGTH];
+} LAST_KEY_PATH;
+
+static LAST_KEY_PATH LastKeyPath;
+
 static CMHIVE RootHive;
 static PMEMKEY RootKey;
 
@@ -385,6 +407,17 @@ CreateInMemoryStructure(
 LIST_ENTRY CmiHiveListHead;
 LIST_ENTRY CmiReparsePointsHead;
 
+/*
+ * Must be called whenever a key is deleted or a reparse point is added,
+ * since the last path may then lead to other keys.
+ */
+static VOID
+RegpForgetLastKeyPath(VOID)
+{
+    LastKeyPath.StartHive = NULL;
+    LastKeyPath.Depth = 0;
+}
+
 static LONG
 RegpCreateOrOpenKey(
     IN HKEY hParentKey,
@@ -404,6 +437,10 @@ RegpCreateOrOpenKey(
     PCM_KEY_NODE ParentKeyCell;
     PLIST_ENTRY Ptr;
     HCELL_INDEX BlockOffset;
+    PCMHIVE StartHive;
+    HCELL_INDEX StartCellOffset;
+    SIZE_T Length;
+    ULONG Level;
 
     DPRINT("RegpCreateOrOpenKey('%S')\n", KeyName);
 
@@ -425,6 +462,50 @@ RegpCreateOrOpenKey(
     }
 
     LocalKeyName = (PWSTR)KeyName;
+    StartHive = ParentRegistryHive;
+    StartCellOffset = ParentCellOffset;
+    Level = 0;
+
+    /* Restart from the deepest key in common with the last path */
+    if (LastKeyPath.StartHive == StartHive &&
+        LastKeyPath.StartCellOffset == StartCellOffset)
+    {
+        for (Length = 0;
+             KeyName[Length] != UNICODE_NULL && KeyName[Length] == LastKeyPath.Path[Length];
+             Length++);
+
+        while (Level < LastKeyPath.Depth &&
+               (LastKeyPath.Lengths[Level] < Length ||
+                (LastKeyPath.Lengths[Level] == Length &&
+                 (KeyName[Length] == OBJ_NAME_PATH_SEPARATOR || KeyName[Length] == UNICODE_NULL))))
+        {
+            Level++;
+        }
+
+        if (Level > 0)
+        {
+            ParentRegistryHive = LastKeyPath.RegistryHives[Level - 1];
+            ParentCellOffset = LastKeyPath.KeyCellOffsets[Level - 1];
+            LocalKeyName += LastKeyPath.Lengths[Level - 1];
+            if (*LocalKeyName == OBJ_NAME_PATH_SEPARATOR)
+                LocalKeyName++;
+        }
+    }
+
+    /* This is now the last path, the keys up to this level are the same */
+    Length = strlenW(KeyName);
+    if (Length < LAST_KEY_PATH_MAX_LENGTH)
+    {
+        LastKeyPath.StartHive = StartHive;
+        LastKeyPath.StartCellOffset = StartCellOffset;
+        LastKeyPath.Depth = Level;
+        memcpy(LastKeyPath.Path, KeyName, (Length + 1) * sizeof(WCHAR));
+    }
+    else
+    {
+        RegpForgetLastKeyPath();
+    }
+
     for (;;)
     {
         End = (PWSTR)strchrW(LocalKeyName, OBJ_NAME_PATH_SEPARATOR);
@@ -493,6 +574,16 @@ RegpCreateOrOpenKey(
         }
 
         ParentCellOffset = BlockOffset;
+
+        /* Remember this key for the next lookup */
+        if (LastKeyPath.StartHive && Level < LAST_KEY_PATH_MAX_DEPTH)
+        {
+            LastKeyPath.Lengths[Level] = (KeyString.Buffer - KeyName) + KeyString.Length / sizeof(WCHAR);
+            LastKeyPath.RegistryHives[Level] = ParentRegistryHive;
+            LastKeyPath.KeyCellOffsets[Level] = ParentCellOffset;
+            LastKeyPath.Depth = ++Level;
+        }
+
         if (End)
             LocalKeyName = End + 1;
         else
@@ -605,6 +696,9 @@ RegDeleteKeyW(
         Status = CmpFreeKeyByCell(Hive, Key->KeyCellOffset, TRUE);
         if (NT_SUCCESS(Status))
         {
+            /* The key may be on the last path */
+            RegpForgetLastKeyPath();
+
             /* Get the parent node */
             Parent = (PCM_KEY_NODE)HvGetCell(Hive, ParentCell);
             if (Parent)
@@ -1073,6 +1167,7 @@ ConnectRegistry(
     ReparsePoint->DestinationHive = NewKey->RegistryHive;
     ReparsePoint->DestinationKeyCellOffset = NewKey->KeyCellOffset;
     InsertTailList(&CmiReparsePointsHead, &ReparsePoint->ListEntry);
+    RegpForgetLastKeyPath();
 
     return TRUE;
 }
@@ -1126,6 +1221,7 @@ CreateSymLink(
     ReparsePoint->DestinationHive = TargetKey->RegistryHive;
     ReparsePoint->DestinationKeyCellOffset = TargetKey->KeyCellOffset;
     InsertTailList(&CmiReparsePointsHead, &ReparsePoint->ListEntry);
+    RegpForgetLastKeyPath();
 
     return TRUE;
 }
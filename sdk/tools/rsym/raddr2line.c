@@ -67,9 +67,37 @@ find_rossym_section ( PIMAGE_FILE_HEADER PEFileHeader,
 	return NULL;
 }
 
+int
+find_and_print_offset_v2 (
+	void* data,
+	size_t length,
+	size_t offset )
+{
+	ROSSYM_V2_INFO Info;
+	ROSSYM_ENTRY e;
+	int res;
+
+	if ( LoadRosSymV2 ( data, (ULONG)length, &Info ) )
+	{
+		fprintf ( stderr, "Invalid rossym section\n" );
+		return 1;
+	}
+	res = FindRosSymV2Entry ( &Info, (ULONG)offset, &e );
+	if ( !res )
+	{
+		printf ( "%s:%u (%s)\n",
+			&Info.Strings[e.FileOffset],
+			(unsigned int)e.SourceLine,
+			&Info.Strings[e.FunctionOffset] );
+	}
+	FreeRosSymV2 ( &Info );
+	return res;
+}
+
 int
 find_and_print_offset (
 	void* data,
+	size_t length,
 	size_t offset )
 {
 	PSYMBOLFILE_HEADER RosSymHeader = (PSYMBOLFILE_HEADER)data;
@@ -78,7 +106,9 @@ find_and_print_offset (
 	size_t symbols = RosSymHeader->SymbolsLength / sizeof(ROSSYM_ENTRY);
 	size_t i;
 
-	//if ( RosSymHeader->SymbolsOffset )
+	/* Version 2 sections start with a zero */
+	if ( !RosSymHeader->SymbolsOffset )
+		return find_and_print_offset_v2 ( data, length, offset );
 
 	for ( i = 0; i < symbols; i++ )
 	{
@@ -142,7 +172,7 @@ process_data ( const void* FileData, size_t offset )
 		return 1;
 	}
 	res = find_and_print_offset ( (char*)FileData + PERosSymSectionHeader->PointerToRawData,
-		offset );
+		PERosSymSectionHeader->SizeOfRawData, offset );
 	if ( res )
 		printf ( "??:0\n" );
 	return res;
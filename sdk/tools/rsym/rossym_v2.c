@@ -0,0 +1,245 @@
+/* rossym_v2.c
+ *
+ * Creates version 2 .rossym sections, see the description of the
+ * format in sdk/include/reactos/rossym.h. They are read back by
+ * rossym_v2_read.c, which is kept apart because rsym links the
+ * inflate code of dbghelp.
+ * As for the rest of rsym, the functions return 0 on success.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "rsym.h"
+
+#define Z_SOLO
+#include <zlib.h>
+
+static voidpf
+ZAlloc(voidpf Opaque, uInt Items, uInt Size)
+{
+	return malloc((size_t)Items * Size);
+}
+
+static void
+ZFree(voidpf Opaque, voidpf Address)
+{
+	free(Address);
+}
+
+static ULONG
+WriteLeb128(UCHAR *Data, ULONG Value)
+{
+	ULONG Length = 0;
+
+	do
+	{
+		UCHAR Byte = Value & 0x7f;
+
+		Value >>= 7;
+		if (Value != 0)
+			Byte |= 0x80;
+		Data[Length++] = Byte;
+	}
+	while (Value != 0);
+
+	return Length;
+}
+
+static ULONG
+WriteDelta(UCHAR *Data, ULONG Value, ULONG Previous)
+{
+	LONG Delta = (LONG)(Value - Previous);
+
+	return WriteLeb128(Data, ((ULONG)Delta << 1) ^ (ULONG)(Delta >> 31));
+}
+
+/* qsort has no context argument */
+static const char *SortStrings;
+
+static int
+CompareFunctionOffset(const void *a, const void *b)
+{
+	const ROSSYM_V2_FUNCTION *f1 = a, *f2 = b;
+
+	if (f1->NameOffset != f2->NameOffset)
+		return f1->NameOffset < f2->NameOffset ? -1 : 1;
+	if (f1->Address != f2->Address)
+		return f1->Address < f2->Address ? -1 : 1;
+	return 0;
+}
+
+static int
+CompareFunctionName(const void *a, const void *b)
+{
+	const ROSSYM_V2_FUNCTION *f1 = a, *f2 = b;
+	int Compare;
+
+	Compare = strcmp(SortStrings + f1->NameOffset, SortStrings + f2->NameOffset);
+	if (Compare != 0)
+		return Compare;
+	if (f1->Address != f2->Address)
+		return f1->Address < f2->Address ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Builds a version 2 section out of the entries, which must be sorted by
+ * address, and the string table they refer to. The raw data holds the
+ * block index, the function index, the blocks and the strings, in that
+ * order. It is deflated if Compress is set and that makes it smaller.
+ */
+int
+CreateRosSymV2(ULONG SymbolsCount, PROSSYM_ENTRY Symbols,
+               ULONG StringsLength, void *Strings, int Compress,
+               ULONG *RosSymLength, void **RosSymSection)
+{
+	ROSSYM_V2_HEADER Header;
+	PROSSYM_V2_BLOCK Blocks;
+	PROSSYM_V2_FUNCTION Functions;
+	UCHAR *BlockData, *RawData, *Section;
+	ULONG i, j, Block, RawDataLength, SectionLength;
+	ROSSYM_ENTRY Previous;
+
+	if (SymbolsCount == 0 || StringsLength == 0 ||
+	    ((char *)Strings)[StringsLength - 1] != '\0')
+	{
+		fprintf(stderr, "Invalid symbols for .rossym section\n");
+		return 1;
+	}
+	for (i = 0; i < SymbolsCount; i++)
+	{
+		if ((ULONG)Symbols[i].Address != Symbols[i].Address ||
+		    (i > 0 && Symbols[i].Address < Symbols[i - 1].Address) ||
+		    Symbols[i].FunctionOffset >= StringsLength ||
+		    Symbols[i].FileOffset >= StringsLength)
+		{
+			fprintf(stderr, "Invalid symbol %lu for .rossym section\n", (unsigned long)i);
+			return 1;
+		}
+	}
+
+	memset(&Header, 0, sizeof(Header));
+	Header.Signature = ROSSYM_V2_SIGNATURE;
+	Header.SymbolsCount = SymbolsCount;
+	Header.BlocksCount = (SymbolsCount + ROSSYM_V2_BLOCK_ENTRIES - 1) / ROSSYM_V2_BLOCK_ENTRIES;
+
+	/* An entry takes at most 4 numbers of 5 bytes */
+	Blocks = malloc(Header.BlocksCount * sizeof(ROSSYM_V2_BLOCK));
+	BlockData = malloc(SymbolsCount * 4 * 5);
+	Functions = malloc(SymbolsCount * sizeof(ROSSYM_V2_FUNCTION));
+	if (Blocks == NULL || BlockData == NULL || Functions == NULL)
+	{
+		free(Blocks);
+		free(BlockData);
+		free(Functions);
+		fprintf(stderr, "Unable to allocate memory for .rossym section\n");
+		return 1;
+	}
+
+	/* Delta code the entries of each block */
+	memset(&Previous, 0, sizeof(Previous));
+	for (i = 0; i < SymbolsCount; i++)
+	{
+		if (i % ROSSYM_V2_BLOCK_ENTRIES == 0)
+		{
+			Block = i / ROSSYM_V2_BLOCK_ENTRIES;
+			Blocks[Block].Address = (ULONG)Symbols[i].Address;
+			Blocks[Block].DataOffset = Header.BlockDataLength;
+			memset(&Previous, 0, sizeof(Previous));
+			Previous.Address = Symbols[i].Address;
+		}
+		Header.BlockDataLength += WriteLeb128(BlockData + Header.BlockDataLength,
+		                                      (ULONG)(Symbols[i].Address - Previous.Address));
+		Header.BlockDataLength += WriteDelta(BlockData + Header.BlockDataLength,
+		                                     Symbols[i].FunctionOffset, Previous.FunctionOffset);
+		Header.BlockDataLength += WriteDelta(BlockData + Header.BlockDataLength,
+		                                     Symbols[i].FileOffset, Previous.FileOffset);
+		Header.BlockDataLength += WriteDelta(BlockData + Header.BlockDataLength,
+		                                     Symbols[i].SourceLine, Previous.SourceLine);
+		Previous = Symbols[i];
+	}
+
+	/* Keep the lowest address of every function, then sort them by name */
+	for (i = 0; i < SymbolsCount; i++)
+	{
+		Functions[i].NameOffset = Symbols[i].FunctionOffset;
+		Functions[i].Address = (ULONG)Symbols[i].Address;
+	}
+	qsort(Functions, SymbolsCount, sizeof(ROSSYM_V2_FUNCTION), CompareFunctionOffset);
+	for (i = 0, j = 0; i < SymbolsCount; i++)
+	{
+		if (Functions[i].NameOffset == 0 || ((char *)Strings)[Functions[i].NameOffset] == '\0')
+			continue;
+		if (j > 0 && Functions[j - 1].NameOffset == Functions[i].NameOffset)
+			continue;
+		Functions[j++] = Functions[i];
+	}
+	Header.FunctionsCount = j;
+	SortStrings = Strings;
+	qsort(Functions, Header.FunctionsCount, sizeof(ROSSYM_V2_FUNCTION), CompareFunctionName);
+
+	Header.BlocksOffset = 0;
+	Header.FunctionsOffset = Header.BlocksOffset + Header.BlocksCount * sizeof(ROSSYM_V2_BLOCK);
+	Header.BlockDataOffset = Header.FunctionsOffset + Header.FunctionsCount * sizeof(ROSSYM_V2_FUNCTION);
+	Header.StringsOffset = Header.BlockDataOffset + Header.BlockDataLength;
+	Header.StringsLength = StringsLength;
+	RawDataLength = Header.StringsOffset + Header.StringsLength;
+	Header.RawDataLength = RawDataLength;
+	Header.DataOffset = sizeof(ROSSYM_V2_HEADER);
+
+	RawData = malloc(RawDataLength);
+	Section = malloc(sizeof(ROSSYM_V2_HEADER) + RawDataLength);
+	if (RawData == NULL || Section == NULL)
+	{
+		free(RawData);
+		free(Section);
+		free(Blocks);
+		free(BlockData);
+		free(Functions);
+		fprintf(stderr, "Unable to allocate memory for .rossym section\n");
+		return 1;
+	}
+	memcpy(RawData + Header.BlocksOffset, Blocks, Header.BlocksCount * sizeof(ROSSYM_V2_BLOCK));
+	memcpy(RawData + Header.FunctionsOffset, Functions, Header.FunctionsCount * sizeof(ROSSYM_V2_FUNCTION));
+	memcpy(RawData + Header.BlockDataOffset, BlockData, Header.BlockDataLength);
+	memcpy(RawData + Header.StringsOffset, Strings, Header.StringsLength);
+	free(Blocks);
+	free(BlockData);
+	free(Functions);
+
+	Header.DataLength = RawDataLength;
+	if (Compress)
+	{
+		z_stream Stream;
+
+		memset(&Stream, 0, sizeof(Stream));
+		Stream.zalloc = ZAlloc;
+		Stream.zfree = ZFree;
+		if (deflateInit(&Stream, Z_BEST_COMPRESSION) == Z_OK)
+		{
+			/* Only keep the compressed data if it is smaller */
+			Stream.next_in = RawData;
+			Stream.avail_in = RawDataLength;
+			Stream.next_out = Section + Header.DataOffset;
+			Stream.avail_out = RawDataLength - 1;
+			if (deflate(&Stream, Z_FINISH) == Z_STREAM_END)
+			{
+				Header.Flags |= ROSSYM_V2_COMPRESSED;
+				Header.DataLength = Stream.total_out;
+			}
+			deflateEnd(&Stream);
+		}
+	}
+	if (!(Header.Flags & ROSSYM_V2_COMPRESSED))
+		memcpy(Section + Header.DataOffset, RawData, RawDataLength);
+	free(RawData);
+
+	memcpy(Section, &Header, sizeof(Header));
+	SectionLength = Header.DataOffset + Header.DataLength;
+
+	*RosSymLength = SectionLength;
+	*RosSymSection = Section;
+	return 0;
+}
@@ -0,0 +1,308 @@
+/* rossym_v2_read.c
+ *
+ * Reads version 2 .rossym sections, see rossym_v2.c.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "rsym.h"
+
+#define Z_SOLO
+#include <zlib.h>
+
+static voidpf
+ZAlloc(voidpf Opaque, uInt Items, uInt Size)
+{
+	return malloc((size_t)Items * Size);
+}
+
+static void
+ZFree(voidpf Opaque, voidpf Address)
+{
+	free(Address);
+}
+
+static int
+ReadLeb128(UCHAR **Data, UCHAR *End, ULONG *Value)
+{
+	ULONG Shift = 0;
+	UCHAR Byte;
+
+	*Value = 0;
+	do
+	{
+		if (*Data >= End || Shift >= 32)
+			return 1;
+		Byte = *(*Data)++;
+		*Value |= (ULONG)(Byte & 0x7f) << Shift;
+		Shift += 7;
+	}
+	while (Byte & 0x80);
+
+	return 0;
+}
+
+static int
+ReadDelta(UCHAR **Data, UCHAR *End, ULONG *Value)
+{
+	ULONG ZigZag;
+
+	if (ReadLeb128(Data, End, &ZigZag))
+		return 1;
+	*Value += (ZigZag >> 1) ^ (0 - (ZigZag & 1));
+
+	return 0;
+}
+
+static int
+IsValidRange(PROSSYM_V2_HEADER Header, ULONG Offset, ULONG Length)
+{
+	return Offset <= Header->RawDataLength && Length <= Header->RawDataLength - Offset;
+}
+
+/*
+ * Decodes a version 2 section. The caller frees the data with FreeRosSymV2.
+ */
+int
+LoadRosSymV2(void *RosSymSection, ULONG RosSymLength, PROSSYM_V2_INFO Info)
+{
+	ROSSYM_V2_HEADER Header;
+	UCHAR *RawData;
+	ULONG i;
+
+	memset(Info, 0, sizeof(*Info));
+	if (RosSymLength < sizeof(Header))
+		return 1;
+	memcpy(&Header, RosSymSection, sizeof(Header));
+
+	if (Header.Zero != 0 ||
+	    Header.Signature != ROSSYM_V2_SIGNATURE ||
+	    Header.DataOffset < sizeof(Header) ||
+	    Header.DataOffset > RosSymLength ||
+	    Header.DataLength > RosSymLength - Header.DataOffset ||
+	    Header.BlocksCount == 0 ||
+	    Header.BlocksCount != (Header.SymbolsCount + ROSSYM_V2_BLOCK_ENTRIES - 1) / ROSSYM_V2_BLOCK_ENTRIES ||
+	    Header.BlocksCount > Header.RawDataLength / sizeof(ROSSYM_V2_BLOCK) ||
+	    Header.FunctionsCount > Header.RawDataLength / sizeof(ROSSYM_V2_FUNCTION) ||
+	    !IsValidRange(&Header, Header.BlocksOffset, Header.BlocksCount * sizeof(ROSSYM_V2_BLOCK)) ||
+	    !IsValidRange(&Header, Header.BlockDataOffset, Header.BlockDataLength) ||
+	    !IsValidRange(&Header, Header.FunctionsOffset, Header.FunctionsCount * sizeof(ROSSYM_V2_FUNCTION)) ||
+	    !IsValidRange(&Header, Header.StringsOffset, Header.StringsLength) ||
+	    Header.StringsLength == 0 ||
+	    (Header.BlocksOffset % sizeof(ULONG)) != 0 ||
+	    (Header.FunctionsOffset % sizeof(ULONG)) != 0 ||
+	    (!(Header.Flags & ROSSYM_V2_COMPRESSED) && Header.DataLength != Header.RawDataLength))
+	{
+		return 1;
+	}
+
+	RawData = malloc(Header.RawDataLength ? Header.RawDataLength : 1);
+	if (RawData == NULL)
+		return 1;
+
+	if (Header.Flags & ROSSYM_V2_COMPRESSED)
+	{
+		z_stream Stream;
+		int Status;
+
+		memset(&Stream, 0, sizeof(Stream));
+		Stream.zalloc = ZAlloc;
+		Stream.zfree = ZFree;
+		if (inflateInit(&Stream) != Z_OK)
+		{
+			free(RawData);
+			return 1;
+		}
+		Stream.next_in = (UCHAR *)RosSymSection + Header.DataOffset;
+		Stream.avail_in = Header.DataLength;
+		Stream.next_out = RawData;
+		Stream.avail_out = Header.RawDataLength;
+		Status = inflate(&Stream, Z_FINISH);
+		inflateEnd(&Stream);
+		if (Status != Z_STREAM_END || Stream.avail_out != 0)
+		{
+			free(RawData);
+			return 1;
+		}
+	}
+	else
+	{
+		memcpy(RawData, (UCHAR *)RosSymSection + Header.DataOffset, Header.RawDataLength);
+	}
+
+	Info->RawData = RawData;
+	Info->SymbolsCount = Header.SymbolsCount;
+	Info->Blocks = (PROSSYM_V2_BLOCK)(RawData + Header.BlocksOffset);
+	Info->BlocksCount = Header.BlocksCount;
+	Info->BlockData = RawData + Header.BlockDataOffset;
+	Info->BlockDataLength = Header.BlockDataLength;
+	Info->Functions = (PROSSYM_V2_FUNCTION)(RawData + Header.FunctionsOffset);
+	Info->FunctionsCount = Header.FunctionsCount;
+	Info->Strings = (char *)RawData + Header.StringsOffset;
+	Info->StringsLength = Header.StringsLength;
+
+	for (i = 0; i < Info->BlocksCount; i++)
+	{
+		if (Info->Blocks[i].DataOffset > Info->BlockDataLength ||
+		    (i > 0 && (Info->Blocks[i].Address < Info->Blocks[i - 1].Address ||
+		               Info->Blocks[i].DataOffset < Info->Blocks[i - 1].DataOffset)))
+		{
+			FreeRosSymV2(Info);
+			return 1;
+		}
+	}
+	for (i = 0; i < Info->FunctionsCount; i++)
+	{
+		if (Info->Functions[i].NameOffset >= Info->StringsLength)
+		{
+			FreeRosSymV2(Info);
+			return 1;
+		}
+	}
+	if (Info->Strings[Info->StringsLength - 1] != '\0')
+	{
+		FreeRosSymV2(Info);
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Finds the last entry at or before the address: the block index gives
+ * the block, which is then decoded up to the address.
+ */
+int
+FindRosSymV2Entry(PROSSYM_V2_INFO Info, ULONG Address, PROSSYM_ENTRY Entry)
+{
+	PROSSYM_V2_BLOCK Block;
+	ULONG Low, High, Mid, Index, Count, Delta;
+	UCHAR *Data, *End;
+	ROSSYM_ENTRY Current;
+
+	if (Info->BlocksCount == 0 || Address < Info->Blocks[0].Address)
+		return 1;
+
+	Low = 0;
+	High = Info->BlocksCount;
+	while (High - Low > 1)
+	{
+		Mid = Low + (High - Low) / 2;
+		if (Info->Blocks[Mid].Address <= Address)
+			Low = Mid;
+		else
+			High = Mid;
+	}
+	Block = &Info->Blocks[Low];
+
+	Data = Info->BlockData + Block->DataOffset;
+	End = Info->BlockData + (Low + 1 < Info->BlocksCount ? Block[1].DataOffset : Info->BlockDataLength);
+	Count = Info->SymbolsCount - Low * ROSSYM_V2_BLOCK_ENTRIES;
+	if (Count > ROSSYM_V2_BLOCK_ENTRIES)
+		Count = ROSSYM_V2_BLOCK_ENTRIES;
+
+	memset(&Current, 0, sizeof(Current));
+	Current.Address = Block->Address;
+	for (Index = 0; Index < Count; Index++)
+	{
+		if (ReadLeb128(&Data, End, &Delta))
+			return 1;
+		if (Address < Current.Address + Delta)
+			break;
+		Current.Address += Delta;
+		if (ReadDelta(&Data, End, &Current.FunctionOffset) ||
+		    ReadDelta(&Data, End, &Current.FileOffset) ||
+		    ReadDelta(&Data, End, &Current.SourceLine))
+		{
+			return 1;
+		}
+		*Entry = Current;
+	}
+
+	if (Index == 0 ||
+	    Entry->FunctionOffset >= Info->StringsLength ||
+	    Entry->FileOffset >= Info->StringsLength)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Decodes all the entries, in address order. There must be room for
+ * Info->SymbolsCount of them.
+ */
+int
+GetRosSymV2Entries(PROSSYM_V2_INFO Info, PROSSYM_ENTRY Symbols)
+{
+	ULONG Block, Index, Count, Delta;
+	UCHAR *Data, *End;
+	ROSSYM_ENTRY Current;
+
+	for (Block = 0; Block < Info->BlocksCount; Block++)
+	{
+		Data = Info->BlockData + Info->Blocks[Block].DataOffset;
+		End = Info->BlockData + (Block + 1 < Info->BlocksCount ? Info->Blocks[Block + 1].DataOffset : Info->BlockDataLength);
+		Count = Info->SymbolsCount - Block * ROSSYM_V2_BLOCK_ENTRIES;
+		if (Count > ROSSYM_V2_BLOCK_ENTRIES)
+			Count = ROSSYM_V2_BLOCK_ENTRIES;
+
+		memset(&Current, 0, sizeof(Current));
+		Current.Address = Info->Blocks[Block].Address;
+		for (Index = 0; Index < Count; Index++)
+		{
+			if (ReadLeb128(&Data, End, &Delta))
+				return 1;
+			Current.Address += Delta;
+			if (ReadDelta(&Data, End, &Current.FunctionOffset) ||
+			    ReadDelta(&Data, End, &Current.FileOffset) ||
+			    ReadDelta(&Data, End, &Current.SourceLine) ||
+			    Current.FunctionOffset >= Info->StringsLength ||
+			    Current.FileOffset >= Info->StringsLength)
+			{
+				return 1;
+			}
+			*Symbols++ = Current;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Finds the lowest address of the function with this name.
+ */
+int
+FindRosSymV2Function(PROSSYM_V2_INFO Info, const char *Name, ULONG *Address)
+{
+	ULONG Low, High, Mid;
+
+	Low = 0;
+	High = Info->FunctionsCount;
+	while (Low < High)
+	{
+		Mid = Low + (High - Low) / 2;
+		if (strcmp(Info->Strings + Info->Functions[Mid].NameOffset, Name) < 0)
+			Low = Mid + 1;
+		else
+			High = Mid;
+	}
+	if (Low == Info->FunctionsCount ||
+	    strcmp(Info->Strings + Info->Functions[Low].NameOffset, Name) != 0)
+	{
+		return 1;
+	}
+
+	*Address = Info->Functions[Low].Address;
+	return 0;
+}
+
+void
+FreeRosSymV2(PROSSYM_V2_INFO Info)
+{
+	free(Info->RawData);
+	memset(Info, 0, sizeof(*Info));
+}
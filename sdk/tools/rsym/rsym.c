@@ -1,5 +1,5 @@
 /*
- * Usage: rsym input-file output-file
+ * Usage: rsym [-s <sources>] [-2] [-z] [-c <cache>] input-file output-file
  *
  * There are two sources of information: the .stab/.stabstr
  * sections of the executable and the COFF symbol table. Most
@@ -29,6 +29,7 @@
 #include <wchar.h>
 
 #include "rsym.h"
+#include "../toolcache/toolcache.h"
 
 #define MAX_PATH 260
 #define MAX_SYM_NAME 2000
@@ -1227,14 +1228,17 @@ CreateOutputFile(FILE *OutFile, void *InData,
     return 0;
 }
 
-int main(int argc, char* argv[])
+/*
+ * Converts the debug information of the image to a .rossym section.
+ * Returns a NULL section if the image has no symbols.
+ */
+static int
+CreateRosSymSection(void *FileData, size_t FileSize, void *file, char *path1,
+                    char *SourcePath, int Version2, int Compress, ULONG ImageBase,
+                    PIMAGE_FILE_HEADER PEFileHeader, PIMAGE_SECTION_HEADER PESectionHeaders,
+                    ULONG *SectionLength, void **Section)
 {
     PSYMBOLFILE_HEADER SymbolFileHeader;
-    PIMAGE_DOS_HEADER PEDosHeader;
-    PIMAGE_FILE_HEADER PEFileHeader;
-    PIMAGE_OPTIONAL_HEADER PEOptHeader;
-    PIMAGE_SECTION_HEADER PESectionHeaders;
-    ULONG ImageBase;
     void *StabBase;
     ULONG StabsLength;
     void *StabStringBase;
@@ -1243,9 +1247,6 @@ int main(int argc, char* argv[])
     ULONG CoffsLength;
     void *CoffStringBase = NULL;
     ULONG CoffStringsLength;
-    char* path1;
-    char* path2;
-    FILE* out;
     void *StringBase = NULL;
     ULONG StringsLength = 0;
     ULONG StabSymbolsCount = 0;
@@ -1254,89 +1255,10 @@ int main(int argc, char* argv[])
     PROSSYM_ENTRY CoffSymbols = NULL;
     ULONG MergedSymbolsCount = 0;
     PROSSYM_ENTRY MergedSymbols = NULL;
-    size_t FileSize;
-    void *FileData;
     ULONG RosSymLength;
     void *RosSymSection;
     DWORD module_base;
-    void *file;
-    char elfhdr[4] = { '\177', 'E', 'L', 'F' };
     BOOLEAN UseDbgHelp = FALSE;
-    int arg, argstate = 0;
-    char *SourcePath = NULL;
-
-    for (arg = 1; arg < argc; arg++)
-    {
-        switch (argstate)
-        {
-            default:
-                argstate = -1;
-                break;
-
-            case 0:
-                if (!strcmp(argv[arg], "-s"))
-                {
-                    argstate = 1;
-                }
-                else
-                {
-                    argstate = 2;
-                    path1 = convert_path(argv[arg]);
-                }
-            break;
-
-            case 1:
-                free(SourcePath);
-                SourcePath = strdup(argv[arg]);
-                argstate = 0;
-                break;
-
-            case 2:
-                path2 = convert_path(argv[arg]);
-                argstate = 3;
-                break;
-        }
-    }
-
-    if (argstate != 3)
-    {
-        fprintf(stderr, "Usage: rsym [-s <sources>] <input> <output>\n");
-        exit(1);
-    }
-
-    FileData = load_file(path1, &FileSize);
-    if (!FileData)
-    {
-        fprintf(stderr, "An error occured loading '%s'\n", path1);
-        exit(1);
-    }
-
-    file = fopen(path1, "rb");
-
-    /* Check if MZ header exists  */
-    PEDosHeader = (PIMAGE_DOS_HEADER) FileData;
-    if (PEDosHeader->e_magic != IMAGE_DOS_MAGIC ||
-        PEDosHeader->e_lfanew == 0L)
-    {
-        /* Ignore elf */
-        if (!memcmp(PEDosHeader, elfhdr, sizeof(elfhdr)))
-            exit(0);
-        perror("Input file is not a PE image.\n");
-        free(FileData);
-        exit(1);
-    }
-
-    /* Locate PE file header  */
-    /* sizeof(ULONG) = sizeof(MAGIC) */
-    PEFileHeader = (PIMAGE_FILE_HEADER)((char *) FileData + PEDosHeader->e_lfanew + sizeof(ULONG));
-
-    /* Locate optional header */
-    assert(sizeof(ULONG) == 4);
-    PEOptHeader = (PIMAGE_OPTIONAL_HEADER)(PEFileHeader + 1);
-    ImageBase = PEOptHeader->ImageBase;
-
-    /* Locate PE section headers  */
-    PESectionHeaders = (PIMAGE_SECTION_HEADER)((char *) PEOptHeader + PEFileHeader->SizeOfOptionalHeader);
 
     if (GetStabInfo(FileData,
                     PEFileHeader,
@@ -1488,6 +1410,24 @@ int main(int argc, char* argv[])
         RosSymLength = 0;
         RosSymSection = NULL;
     }
+    else if (Version2)
+    {
+        if (CreateRosSymV2(MergedSymbolsCount,
+                           MergedSymbols,
+                           StringsLength,
+                           StringBase,
+                           Compress,
+                           &RosSymLength,
+                           &RosSymSection))
+        {
+            free(MergedSymbols);
+            free(StringBase);
+            free(FileData);
+            exit(1);
+        }
+
+        free(MergedSymbols);
+    }
     else
     {
         RosSymLength = sizeof(SYMBOLFILE_HEADER) +
@@ -1524,6 +1464,171 @@ int main(int argc, char* argv[])
     }
 
     free(StringBase);
+
+    *SectionLength = RosSymLength;
+    *Section = RosSymSection;
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    PIMAGE_DOS_HEADER PEDosHeader;
+    PIMAGE_FILE_HEADER PEFileHeader;
+    PIMAGE_OPTIONAL_HEADER PEOptHeader;
+    PIMAGE_SECTION_HEADER PESectionHeaders;
+    ULONG ImageBase;
+    char* path1;
+    char* path2;
+    FILE* out;
+    size_t FileSize;
+    void *FileData;
+    ULONG RosSymLength;
+    void *RosSymSection;
+    void *file;
+    char elfhdr[4] = { '\177', 'E', 'L', 'F' };
+    int arg, argstate = 0;
+    char *SourcePath = NULL;
+    char *CachePath = NULL;
+    int Version2 = 0, Compress = 0;
+    TOOL_CACHE Cache;
+    size_t CachedLength;
+    ULONG TimeDateStamp, CheckSum;
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        switch (argstate)
+        {
+            default:
+                argstate = -1;
+                break;
+
+            case 0:
+                if (!strcmp(argv[arg], "-s"))
+                {
+                    argstate = 1;
+                }
+                else if (!strcmp(argv[arg], "-2"))
+                {
+                    Version2 = 1;
+                }
+                else if (!strcmp(argv[arg], "-z"))
+                {
+                    Version2 = 1;
+                    Compress = 1;
+                }
+                else if (!strcmp(argv[arg], "-c"))
+                {
+                    argstate = 4;
+                }
+                else
+                {
+                    argstate = 2;
+                    path1 = convert_path(argv[arg]);
+                }
+            break;
+
+            case 1:
+                free(SourcePath);
+                SourcePath = strdup(argv[arg]);
+                argstate = 0;
+                break;
+
+            case 2:
+                path2 = convert_path(argv[arg]);
+                argstate = 3;
+                break;
+
+            case 4:
+                free(CachePath);
+                CachePath = convert_path(argv[arg]);
+                argstate = 0;
+                break;
+        }
+    }
+
+    if (argstate != 3)
+    {
+        fprintf(stderr, "Usage: rsym [-s <sources>] [-2] [-z] [-c <cache>] <input> <output>\n");
+        fprintf(stderr, "  -2  write a version 2 .rossym section (only read by kdbg)\n");
+        fprintf(stderr, "  -z  same as -2, with compressed data\n");
+        fprintf(stderr, "  -c  reuse the .rossym sections stored in this directory\n");
+        exit(1);
+    }
+
+    FileData = load_file(path1, &FileSize);
+    if (!FileData)
+    {
+        fprintf(stderr, "An error occured loading '%s'\n", path1);
+        exit(1);
+    }
+
+    file = fopen(path1, "rb");
+
+    /* Check if MZ header exists  */
+    PEDosHeader = (PIMAGE_DOS_HEADER) FileData;
+    if (PEDosHeader->e_magic != IMAGE_DOS_MAGIC ||
+        PEDosHeader->e_lfanew == 0L)
+    {
+        /* Ignore elf */
+        if (!memcmp(PEDosHeader, elfhdr, sizeof(elfhdr)))
+            exit(0);
+        perror("Input file is not a PE image.\n");
+        free(FileData);
+        exit(1);
+    }
+
+    /* Locate PE file header  */
+    /* sizeof(ULONG) = sizeof(MAGIC) */
+    PEFileHeader = (PIMAGE_FILE_HEADER)((char *) FileData + PEDosHeader->e_lfanew + sizeof(ULONG));
+
+    /* Locate optional header */
+    assert(sizeof(ULONG) == 4);
+    PEOptHeader = (PIMAGE_OPTIONAL_HEADER)(PEFileHeader + 1);
+    ImageBase = PEOptHeader->ImageBase;
+
+    /* Locate PE section headers  */
+    PESectionHeaders = (PIMAGE_SECTION_HEADER)((char *) PEOptHeader + PEFileHeader->SizeOfOptionalHeader);
+
+    /*
+     * The section only depends on the image and the options. The linker
+     * stamps the image with the time of the link, so leave that out, as
+     * well as the checksum covering it.
+     */
+    if (!ToolCacheInit(&Cache, CachePath, argv[0]))
+    {
+        ToolCacheAddString(&Cache, SourcePath);
+        ToolCacheAddData(&Cache, &Version2, sizeof(Version2));
+        ToolCacheAddData(&Cache, &Compress, sizeof(Compress));
+
+        TimeDateStamp = PEFileHeader->TimeDateStamp;
+        CheckSum = PEOptHeader->CheckSum;
+        PEFileHeader->TimeDateStamp = 0;
+        PEOptHeader->CheckSum = 0;
+        ToolCacheAddData(&Cache, FileData, FileSize);
+        PEFileHeader->TimeDateStamp = TimeDateStamp;
+        PEOptHeader->CheckSum = CheckSum;
+    }
+
+    if (!ToolCacheLookup(&Cache, &RosSymSection, &CachedLength))
+    {
+        RosSymLength = (ULONG)CachedLength;
+        if (RosSymLength == 0)
+        {
+            free(RosSymSection);
+            RosSymSection = NULL;
+        }
+    }
+    else
+    {
+        CreateRosSymSection(FileData, FileSize, file, path1,
+                            SourcePath, Version2, Compress, ImageBase,
+                            PEFileHeader, PESectionHeaders,
+                            &RosSymLength, &RosSymSection);
+
+        ToolCacheStore(&Cache, RosSymSection, RosSymLength);
+    }
+    ToolCacheClose(&Cache);
+
     out = fopen(path2, "wb");
     if (out == NULL)
     {
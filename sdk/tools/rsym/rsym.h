@@ -170,8 +170,55 @@ typedef struct _ROSSYM_ENTRY {
   ULONG SourceLine;
 } ROSSYM_ENTRY, *PROSSYM_ENTRY;
 
+/* Version 2 of the .rossym section, see sdk/include/reactos/rossym.h */
+#define ROSSYM_V2_SIGNATURE       0x32535352 /* "RSS2" */
+#define ROSSYM_V2_COMPRESSED      0x00000001
+#define ROSSYM_V2_BLOCK_ENTRIES   64
+
+typedef struct _ROSSYM_V2_HEADER {
+  ULONG Zero;
+  ULONG Signature;
+  ULONG Flags;
+  ULONG SymbolsCount;
+  ULONG DataOffset;
+  ULONG DataLength;
+  ULONG RawDataLength;
+  ULONG BlocksOffset;
+  ULONG BlocksCount;
+  ULONG BlockDataOffset;
+  ULONG BlockDataLength;
+  ULONG FunctionsOffset;
+  ULONG FunctionsCount;
+  ULONG StringsOffset;
+  ULONG StringsLength;
+} ROSSYM_V2_HEADER, *PROSSYM_V2_HEADER;
+
+typedef struct _ROSSYM_V2_BLOCK {
+  ULONG Address;
+  ULONG DataOffset;
+} ROSSYM_V2_BLOCK, *PROSSYM_V2_BLOCK;
+
+typedef struct _ROSSYM_V2_FUNCTION {
+  ULONG NameOffset;
+  ULONG Address;
+} ROSSYM_V2_FUNCTION, *PROSSYM_V2_FUNCTION;
+
 #pragma pack(pop)
 
+/* A version 2 section, decoded by LoadRosSymV2 */
+typedef struct _ROSSYM_V2_INFO {
+  void *RawData;
+  ULONG SymbolsCount;
+  PROSSYM_V2_BLOCK Blocks;
+  ULONG BlocksCount;
+  UCHAR *BlockData;
+  ULONG BlockDataLength;
+  PROSSYM_V2_FUNCTION Functions;
+  ULONG FunctionsCount;
+  char *Strings;
+  ULONG StringsLength;
+} ROSSYM_V2_INFO, *PROSSYM_V2_INFO;
+
 #define ROUND_UP(N, S) (((N) + (S) - 1) & ~((S) - 1))
 
 extern char*
@@ -179,3 +226,25 @@ convert_path(const char* origpath);
 
 extern void*
 load_file ( const char* file_name, size_t* file_size );
+
+/* rossym_v2.c */
+
+extern int
+CreateRosSymV2(ULONG SymbolsCount, PROSSYM_ENTRY Symbols,
+               ULONG StringsLength, void *Strings, int Compress,
+               ULONG *RosSymLength, void **RosSymSection);
+
+extern int
+LoadRosSymV2(void *RosSymSection, ULONG RosSymLength, PROSSYM_V2_INFO Info);
+
+extern int
+FindRosSymV2Entry(PROSSYM_V2_INFO Info, ULONG Address, PROSSYM_ENTRY Entry);
+
+extern int
+GetRosSymV2Entries(PROSSYM_V2_INFO Info, PROSSYM_ENTRY Symbols);
+
+extern int
+FindRosSymV2Function(PROSSYM_V2_INFO Info, const char *Name, ULONG *Address);
+
+extern void
+FreeRosSymV2(PROSSYM_V2_INFO Info);
@@ -0,0 +1,352 @@
+/*
+ * Usage: rsymtest [symbols-count]
+ *
+ * Checks version 2 .rossym sections against the version 1 lookup:
+ * a made up symbol table, with the kind of address gaps, repeated
+ * addresses and line number jumps that rsym produces, is converted with
+ * and without compression, then every address and every function name
+ * is looked up in both, and the whole table is decoded. Truncated
+ * sections must be rejected.
+ * The checks are done with the reader of the host tools, then with the
+ * sdk/lib/rossym decoder that kdbg uses.
+ * The sizes of the three encodings are printed at the end.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "rsym.h"
+
+/*
+ * The decoder of kdbg, sdk/lib/rossym built for the host (rossymhost).
+ * Its header clashes with rsym.h, so only what is used here is declared.
+ */
+typedef struct _ROSSYM_INFO *PROSSYM_INFO;
+
+BOOLEAN RosSymCreateFromRaw(PVOID RawData, ULONG_PTR DataSize, PROSSYM_INFO *RosSymInfo);
+BOOLEAN RosSymGetAddressInformation(PROSSYM_INFO RosSymInfo, ULONG_PTR RelativeAddress,
+                                    ULONG *LineNumber, char *FileName, char *FunctionName);
+BOOLEAN RosSymGetFunctionAddress(PROSSYM_INFO RosSymInfo, PCSTR FunctionName,
+                                 ULONG_PTR *RelativeAddress);
+VOID RosSymDelete(PROSSYM_INFO RosSymInfo);
+
+static ULONG Seed = 1;
+
+static ULONG
+Random(void)
+{
+	Seed = Seed * 1103515245 + 12345;
+	return (Seed >> 16) & 0x7fff;
+}
+
+static int
+AddString(char *Strings, ULONG *StringsLength, const char *String)
+{
+	ULONG Offset = *StringsLength;
+
+	strcpy(Strings + Offset, String);
+	*StringsLength += strlen(String) + 1;
+	return Offset;
+}
+
+/* The version 1 lookup of raddr2line: the last entry at or before the address */
+static PROSSYM_ENTRY
+FindEntryV1(PROSSYM_ENTRY Symbols, ULONG SymbolsCount, ULONG Address)
+{
+	ULONG Low = 0, High = SymbolsCount, Mid;
+
+	/* Count the entries at or before the address */
+	while (Low < High)
+	{
+		Mid = Low + (High - Low) / 2;
+		if (Symbols[Mid].Address <= Address)
+			Low = Mid + 1;
+		else
+			High = Mid;
+	}
+	return Low ? &Symbols[Low - 1] : NULL;
+}
+
+static int
+CheckSection(PROSSYM_ENTRY Symbols, ULONG SymbolsCount, char *Strings,
+             void *Section, ULONG Length)
+{
+	ROSSYM_V2_INFO Info;
+	PROSSYM_ENTRY Expected, Entries;
+	ROSSYM_ENTRY Entry;
+	ULONG Address, Last, i, FunctionAddress;
+	char *Seen;
+	int Errors = 0;
+
+	if (LoadRosSymV2(Section, Length, &Info))
+	{
+		fprintf(stderr, "Cannot load the section\n");
+		return 1;
+	}
+
+	Last = (ULONG)Symbols[SymbolsCount - 1].Address + 16;
+	for (Address = 0; Address <= Last; Address++)
+	{
+		Expected = FindEntryV1(Symbols, SymbolsCount, Address);
+		if (FindRosSymV2Entry(&Info, Address, &Entry))
+		{
+			if (Expected != NULL)
+			{
+				fprintf(stderr, "0x%x: not found\n", (unsigned int)Address);
+				Errors++;
+			}
+			continue;
+		}
+		if (Expected == NULL ||
+		    strcmp(Info.Strings + Entry.FunctionOffset, Strings + Expected->FunctionOffset) ||
+		    strcmp(Info.Strings + Entry.FileOffset, Strings + Expected->FileOffset) ||
+		    Entry.SourceLine != Expected->SourceLine)
+		{
+			fprintf(stderr, "0x%x: wrong entry\n", (unsigned int)Address);
+			Errors++;
+		}
+	}
+
+	/* The entries are sorted, so the first one of a function has its address */
+	Seen = calloc(SymbolsCount + 1, 1);
+	for (i = 0; i < SymbolsCount; i++)
+	{
+		const char *Name = Strings + Symbols[i].FunctionOffset;
+		ULONG Number;
+
+		if (Symbols[i].FunctionOffset == 0)
+			continue;
+		Number = strtoul(Name + strlen("Function"), NULL, 10);
+		if (Seen[Number])
+			continue;
+		Seen[Number] = 1;
+		if (FindRosSymV2Function(&Info, Name, &FunctionAddress))
+		{
+			fprintf(stderr, "%s: not found\n", Name);
+			Errors++;
+		}
+		else if (FunctionAddress != Symbols[i].Address)
+		{
+			fprintf(stderr, "%s: wrong address 0x%x\n", Name, (unsigned int)FunctionAddress);
+			Errors++;
+		}
+	}
+	free(Seen);
+	if (!FindRosSymV2Function(&Info, "NoSuchFunction", &FunctionAddress))
+	{
+		fprintf(stderr, "NoSuchFunction: found\n");
+		Errors++;
+	}
+
+	/* Decoding the whole table gives the entries back */
+	Entries = malloc(SymbolsCount * sizeof(ROSSYM_ENTRY));
+	if (GetRosSymV2Entries(&Info, Entries))
+	{
+		fprintf(stderr, "Cannot decode the entries\n");
+		Errors++;
+	}
+	else
+	{
+		for (i = 0; i < SymbolsCount; i++)
+		{
+			if (Entries[i].Address != Symbols[i].Address ||
+			    Entries[i].FunctionOffset != Symbols[i].FunctionOffset ||
+			    Entries[i].FileOffset != Symbols[i].FileOffset ||
+			    Entries[i].SourceLine != Symbols[i].SourceLine)
+			{
+				fprintf(stderr, "Entry %u: decoded wrong\n", (unsigned int)i);
+				Errors++;
+			}
+		}
+	}
+	free(Entries);
+
+	FreeRosSymV2(&Info);
+
+	/* Any truncation must be caught */
+	for (i = 0; i < Length; i += 1 + i / 64)
+	{
+		if (!LoadRosSymV2(Section, i, &Info))
+		{
+			fprintf(stderr, "Section truncated to %u bytes accepted\n", (unsigned int)i);
+			FreeRosSymV2(&Info);
+			Errors++;
+		}
+	}
+
+	return Errors;
+}
+
+/* The same checks, with the decoder of kdbg */
+static int
+CheckLibrary(PROSSYM_ENTRY Symbols, ULONG SymbolsCount, char *Strings,
+             void *Section, ULONG Length)
+{
+	PROSSYM_INFO Info;
+	PROSSYM_ENTRY Expected;
+	ULONG Address, Last, Line, i;
+	ULONG_PTR FunctionAddress;
+	char FileName[256], FunctionName[256];
+	char *Seen;
+	int Errors = 0;
+
+	if (!RosSymCreateFromRaw(Section, Length, &Info))
+	{
+		fprintf(stderr, "rossym: cannot load the section\n");
+		return 1;
+	}
+
+	Last = (ULONG)Symbols[SymbolsCount - 1].Address + 16;
+	for (Address = 0; Address <= Last; Address++)
+	{
+		Expected = FindEntryV1(Symbols, SymbolsCount, Address);
+		if (!RosSymGetAddressInformation(Info, Address, &Line, FileName, FunctionName))
+		{
+			if (Expected != NULL)
+			{
+				fprintf(stderr, "rossym: 0x%x: not found\n", (unsigned int)Address);
+				Errors++;
+			}
+			continue;
+		}
+		if (Expected == NULL ||
+		    strcmp(FunctionName, Strings + Expected->FunctionOffset) ||
+		    strcmp(FileName, Strings + Expected->FileOffset) ||
+		    Line != Expected->SourceLine)
+		{
+			fprintf(stderr, "rossym: 0x%x: wrong entry\n", (unsigned int)Address);
+			Errors++;
+		}
+	}
+
+	Seen = calloc(SymbolsCount + 1, 1);
+	for (i = 0; i < SymbolsCount; i++)
+	{
+		const char *Name = Strings + Symbols[i].FunctionOffset;
+		ULONG Number;
+
+		if (Symbols[i].FunctionOffset == 0)
+			continue;
+		Number = strtoul(Name + strlen("Function"), NULL, 10);
+		if (Seen[Number])
+			continue;
+		Seen[Number] = 1;
+		if (!RosSymGetFunctionAddress(Info, Name, &FunctionAddress))
+		{
+			fprintf(stderr, "rossym: %s: not found\n", Name);
+			Errors++;
+		}
+		else if (FunctionAddress != Symbols[i].Address)
+		{
+			fprintf(stderr, "rossym: %s: wrong address 0x%x\n", Name, (unsigned int)FunctionAddress);
+			Errors++;
+		}
+	}
+	free(Seen);
+	if (RosSymGetFunctionAddress(Info, "NoSuchFunction", &FunctionAddress))
+	{
+		fprintf(stderr, "rossym: NoSuchFunction: found\n");
+		Errors++;
+	}
+
+	RosSymDelete(Info);
+
+	for (i = 0; i < Length; i += 1 + i / 64)
+	{
+		if (RosSymCreateFromRaw(Section, i, &Info))
+		{
+			fprintf(stderr, "rossym: section truncated to %u bytes accepted\n", (unsigned int)i);
+			RosSymDelete(Info);
+			Errors++;
+		}
+	}
+
+	return Errors;
+}
+
+int main(int argc, char* argv[])
+{
+	ULONG SymbolsCount = 10000;
+	PROSSYM_ENTRY Symbols;
+	char *Strings;
+	ULONG StringsLength = 0;
+	ULONG Files[8], FunctionOffset = 0, FileOffset = 0, Line = 0, Address = 0x1000;
+	ULONG Length, CompressedLength, i;
+	void *Section, *CompressedSection;
+	char Name[32];
+	int Errors;
+
+	if (argc > 2 || (argc == 2 && (SymbolsCount = strtoul(argv[1], NULL, 0)) == 0))
+	{
+		fprintf(stderr, "Usage: rsymtest [symbols-count]\n");
+		exit(1);
+	}
+
+	Symbols = malloc(SymbolsCount * sizeof(ROSSYM_ENTRY));
+	Strings = malloc(SymbolsCount * 32 + 8 * 32 + 1);
+	if (Symbols == NULL || Strings == NULL)
+	{
+		fprintf(stderr, "Unable to allocate memory\n");
+		exit(1);
+	}
+
+	AddString(Strings, &StringsLength, "");
+	for (i = 0; i < 8; i++)
+	{
+		sprintf(Name, "dir/file%u.c", (unsigned int)i);
+		Files[i] = AddString(Strings, &StringsLength, Name);
+	}
+
+	for (i = 0; i < SymbolsCount; i++)
+	{
+		/* A new function every few lines, some of them without a name */
+		if (i == 0 || Random() % 8 == 0)
+		{
+			sprintf(Name, "Function%u", (unsigned int)(Random() % (SymbolsCount / 4 + 1)));
+			FunctionOffset = (Random() % 16) ? AddString(Strings, &StringsLength, Name) : 0;
+			FileOffset = Files[Random() % 8];
+			Line = Random() % 3000;
+			Address += Random() % 64;
+		}
+		else if (Random() % 4)
+		{
+			Address += Random() % 24;
+			Line += Random() % 5;
+		}
+		else
+		{
+			/* Same address, or a line coming back from an inline function */
+			Line -= Random() % 8;
+		}
+		Symbols[i].Address = Address;
+		Symbols[i].FunctionOffset = FunctionOffset;
+		Symbols[i].FileOffset = FileOffset;
+		Symbols[i].SourceLine = Line;
+	}
+
+	if (CreateRosSymV2(SymbolsCount, Symbols, StringsLength, Strings, 0, &Length, &Section) ||
+	    CreateRosSymV2(SymbolsCount, Symbols, StringsLength, Strings, 1, &CompressedLength, &CompressedSection))
+	{
+		exit(1);
+	}
+
+	Errors = CheckSection(Symbols, SymbolsCount, Strings, Section, Length);
+	Errors += CheckSection(Symbols, SymbolsCount, Strings, CompressedSection, CompressedLength);
+	Errors += CheckLibrary(Symbols, SymbolsCount, Strings, Section, Length);
+	Errors += CheckLibrary(Symbols, SymbolsCount, Strings, CompressedSection, CompressedLength);
+
+	printf("%u symbols, %u bytes of strings\n", (unsigned int)SymbolsCount, (unsigned int)StringsLength);
+	printf("version 1:                    %u bytes\n",
+	       (unsigned int)(sizeof(SYMBOLFILE_HEADER) + SymbolsCount * sizeof(ROSSYM_ENTRY) + StringsLength));
+	printf("version 2:                    %u bytes\n", (unsigned int)Length);
+	printf("version 2, compressed:        %u bytes\n", (unsigned int)CompressedLength);
+	printf("%d errors\n", Errors);
+
+	free(Section);
+	free(CompressedSection);
+	free(Strings);
+	free(Symbols);
+
+	return Errors ? 1 : 0;
+}
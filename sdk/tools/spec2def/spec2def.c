@@ -4,6 +4,8 @@
 #include <string.h>
 #include <stdarg.h>
 
+#include "../toolcache/toolcache.h"
+
 #ifdef _MSC_VER
 #define strcasecmp(_String1, _String2) _stricmp(_String1, _String2)
 #define strncasecmp(_String1, _String2, _MaxCount) _strnicmp(_String1, _String2, _MaxCount)
@@ -1477,19 +1479,23 @@ void usage(void)
            "  --implib                generate a def file for an import library\n"
            "  --no-private-warnings   suppress warnings about symbols that should be -private\n"
            "  -a=<arch>               set architecture to <arch> (i386, x86_64, arm, arm64)\n"
-           "  --with-tracing          generate wine-like \"+relay\" trace trampolines (needs -s)\n");
+           "  --with-tracing          generate wine-like \"+relay\" trace trampolines (needs -s)\n"
+           "  --cache=<dir>           reuse the output of previous runs stored in <dir>\n");
 }
 
 int main(int argc, char *argv[])
 {
     size_t nFileSize;
     char *pszSource, *pszDefFileName = NULL, *pszStubFileName = NULL, *pszLibStubName = NULL;
-    char *pszImpLibAliasFileName = NULL;
+    char *pszImpLibAliasFileName = NULL, *pszCacheDir = NULL;
     const char* pszVersionOption = "--version=0x";
+    const char* pszCacheOption = "--cache=";
+    const char* apszOutputs[4];
     char achDllName[40];
     FILE *file;
-    unsigned cExports = 0, i;
+    unsigned cExports = 0, cOutputs = 0, i, j;
     EXPORT *pexports;
+    TOOL_CACHE Cache;
 
     if (argc < 2)
     {
@@ -1555,6 +1561,10 @@ int main(int argc, char *argv[])
         {
             pszArchString = argv[i] + 3;
         }
+        else if (strncasecmp(argv[i], pszCacheOption, strlen(pszCacheOption)) == 0)
+        {
+            pszCacheDir = argv[i] + strlen(pszCacheOption);
+        }
         else
         {
             fprintf(stderr, "Unrecognized option: %s\n", argv[i]);
@@ -1604,6 +1614,41 @@ int main(int argc, char *argv[])
         pszDllName = achDllName;
     }
 
+    if (pszDefFileName) apszOutputs[cOutputs++] = pszDefFileName;
+    if (pszStubFileName) apszOutputs[cOutputs++] = pszStubFileName;
+    if (pszLibStubName) apszOutputs[cOutputs++] = pszLibStubName;
+    if (pszImpLibAliasFileName) apszOutputs[cOutputs++] = pszImpLibAliasFileName;
+
+    /*
+     * The output only depends on the options and on the contents of the
+     * spec file. Leave out all the paths, so that other build trees can
+     * reuse it: the outputs only count by kind, and the spec file by the
+     * dll name derived from it.
+     */
+    if (!ToolCacheInit(&Cache, pszCacheDir, argv[0]))
+    {
+        for (j = 1; j < i; j++)
+        {
+            if (strncasecmp(argv[j], pszCacheOption, strlen(pszCacheOption)) == 0)
+                continue;
+            if (argv[j][1] && strchr("dlsi", argv[j][1]) && argv[j][2] == '=')
+                ToolCacheAddData(&Cache, argv[j], 3);
+            else
+                ToolCacheAddString(&Cache, argv[j]);
+        }
+        ToolCacheAddString(&Cache, pszDllName);
+
+        if (ToolCacheAddFile(&Cache, argv[i]))
+        {
+            ToolCacheClose(&Cache);
+        }
+        else if (!ToolCacheRestoreFiles(&Cache, cOutputs, apszOutputs))
+        {
+            ToolCacheClose(&Cache);
+            return 0;
+        }
+    }
+
     /* Open input file */
     pszSourceFileName = argv[i];
     file = fopen(pszSourceFileName, "r");
@@ -1737,5 +1782,8 @@ int main(int argc, char *argv[])
 
     free(pexports);
 
+    ToolCacheStoreFiles(&Cache, cOutputs, apszOutputs);
+    ToolCacheClose(&Cache);
+
     return 0;
 }
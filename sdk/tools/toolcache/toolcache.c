@@ -0,0 +1,458 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Content-addressed cache of the output of build tools
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#include <process.h>
+#define mkdir(_Path, _Mode) _mkdir(_Path)
+#define getpid _getpid
+#define access _access
+#else
+#include <unistd.h>
+#endif
+
+#include "toolcache.h"
+
+#define TOOL_CACHE_MAGIC "RTC1"
+
+/* SHA-256 (FIPS 180-4) ******************************************************/
+
+static const unsigned int Sha256K[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROR32(_x, _n) (((_x) >> (_n)) | ((_x) << (32 - (_n))))
+
+static void
+Sha256Init(TOOL_CACHE_SHA256 *Hash)
+{
+    static const unsigned int InitialState[8] =
+    {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    memcpy(Hash->State, InitialState, sizeof(InitialState));
+    Hash->Length = 0;
+}
+
+static void
+Sha256Block(TOOL_CACHE_SHA256 *Hash, const unsigned char *Block)
+{
+    unsigned int W[64], a, b, c, d, e, f, g, h, t1, t2;
+    int i;
+
+    for (i = 0; i < 16; i++)
+    {
+        W[i] = ((unsigned int)Block[i * 4] << 24) | ((unsigned int)Block[i * 4 + 1] << 16) |
+               ((unsigned int)Block[i * 4 + 2] << 8) | Block[i * 4 + 3];
+    }
+    for (i = 16; i < 64; i++)
+    {
+        W[i] = W[i - 16] + (ROR32(W[i - 15], 7) ^ ROR32(W[i - 15], 18) ^ (W[i - 15] >> 3)) +
+               W[i - 7] + (ROR32(W[i - 2], 17) ^ ROR32(W[i - 2], 19) ^ (W[i - 2] >> 10));
+    }
+
+    a = Hash->State[0]; b = Hash->State[1]; c = Hash->State[2]; d = Hash->State[3];
+    e = Hash->State[4]; f = Hash->State[5]; g = Hash->State[6]; h = Hash->State[7];
+    for (i = 0; i < 64; i++)
+    {
+        t1 = h + (ROR32(e, 6) ^ ROR32(e, 11) ^ ROR32(e, 25)) + ((e & f) ^ (~e & g)) + Sha256K[i] + W[i];
+        t2 = (ROR32(a, 2) ^ ROR32(a, 13) ^ ROR32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    Hash->State[0] += a; Hash->State[1] += b; Hash->State[2] += c; Hash->State[3] += d;
+    Hash->State[4] += e; Hash->State[5] += f; Hash->State[6] += g; Hash->State[7] += h;
+}
+
+static void
+Sha256Update(TOOL_CACHE_SHA256 *Hash, const void *Data, size_t Size)
+{
+    const unsigned char *p = Data;
+    size_t Used = (size_t)(Hash->Length % 64), Chunk;
+
+    Hash->Length += Size;
+    while (Size > 0)
+    {
+        Chunk = 64 - Used;
+        if (Chunk > Size)
+            Chunk = Size;
+        memcpy(Hash->Buffer + Used, p, Chunk);
+        Used += Chunk;
+        p += Chunk;
+        Size -= Chunk;
+        if (Used == 64)
+        {
+            Sha256Block(Hash, Hash->Buffer);
+            Used = 0;
+        }
+    }
+}
+
+static void
+Sha256Final(TOOL_CACHE_SHA256 *Hash, unsigned char *Digest)
+{
+    unsigned long long Bits = Hash->Length * 8;
+    unsigned char Pad[72];
+    size_t PadLength;
+    int i;
+
+    /* A one bit, zeros up to 56 mod 64, then the length in bits */
+    PadLength = 64 - (size_t)((Hash->Length + 8) % 64);
+    memset(Pad, 0, sizeof(Pad));
+    Pad[0] = 0x80;
+    for (i = 0; i < 8; i++)
+        Pad[PadLength + i] = (unsigned char)(Bits >> (56 - i * 8));
+    Sha256Update(Hash, Pad, PadLength + 8);
+
+    for (i = 0; i < 32; i++)
+        Digest[i] = (unsigned char)(Hash->State[i / 4] >> (24 - (i % 4) * 8));
+}
+
+/* Cache *********************************************************************/
+
+static char *
+GetEntryPath(PTOOL_CACHE Cache, const char *Suffix)
+{
+    unsigned char Digest[32];
+    char *Path;
+    int i;
+
+    if (!Cache->Key[0])
+    {
+        Sha256Final(&Cache->Hash, Digest);
+        for (i = 0; i < 32; i++)
+            sprintf(Cache->Key + i * 2, "%02x", Digest[i]);
+    }
+
+    Path = malloc(strlen(Cache->Directory) + 1 + sizeof(Cache->Key) + strlen(Suffix));
+    if (Path)
+        sprintf(Path, "%s/%s%s", Cache->Directory, Cache->Key, Suffix);
+    return Path;
+}
+
+static void
+PutUlong(unsigned char *Data, unsigned int Value)
+{
+    Data[0] = (unsigned char)Value;
+    Data[1] = (unsigned char)(Value >> 8);
+    Data[2] = (unsigned char)(Value >> 16);
+    Data[3] = (unsigned char)(Value >> 24);
+}
+
+static unsigned int
+GetUlong(const unsigned char *Data)
+{
+    return Data[0] | (Data[1] << 8) | (Data[2] << 16) | ((unsigned int)Data[3] << 24);
+}
+
+static void *
+LoadWholeFile(const char *FileName, size_t *Size)
+{
+    FILE *File;
+    long Length;
+    void *Data;
+
+    File = fopen(FileName, "rb");
+    if (!File)
+        return NULL;
+
+    fseek(File, 0, SEEK_END);
+    Length = ftell(File);
+    fseek(File, 0, SEEK_SET);
+    Data = malloc(Length > 0 ? Length : 1);
+    if (Length < 0 || !Data || fread(Data, 1, Length, File) != (size_t)Length)
+    {
+        free(Data);
+        fclose(File);
+        return NULL;
+    }
+
+    fclose(File);
+    *Size = Length;
+    return Data;
+}
+
+/*
+ * Starts a key. An empty or NULL directory disables the cache, as does
+ * a tool that cannot be read: its own bytes are part of the key, so a
+ * rebuilt tool never reuses the output of the previous one.
+ */
+int
+ToolCacheInit(PTOOL_CACHE Cache, const char *Directory, const char *ToolPath)
+{
+    char *ExePath;
+    int Result;
+
+    memset(Cache, 0, sizeof(*Cache));
+    if (!Directory || !Directory[0])
+        return 1;
+
+    Sha256Init(&Cache->Hash);
+    ToolCacheAddString(Cache, TOOL_CACHE_MAGIC);
+
+    Result = ToolCacheAddFile(Cache, ToolPath);
+    if (Result)
+    {
+        ExePath = malloc(strlen(ToolPath) + 5);
+        if (ExePath)
+        {
+            sprintf(ExePath, "%s.exe", ToolPath);
+            Result = ToolCacheAddFile(Cache, ExePath);
+            free(ExePath);
+        }
+    }
+    if (Result)
+    {
+        fprintf(stderr, "Warning: cannot read %s, not using the cache\n", ToolPath);
+        return 1;
+    }
+
+    if (mkdir(Directory, 0777) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "Warning: cannot create %s, not using the cache\n", Directory);
+        return 1;
+    }
+
+    Cache->Directory = strdup(Directory);
+    return Cache->Directory ? 0 : 1;
+}
+
+void
+ToolCacheAddData(PTOOL_CACHE Cache, const void *Data, size_t Size)
+{
+    unsigned char Length[4];
+
+    /* Prefix the length, so that consecutive pieces cannot be confused */
+    PutUlong(Length, (unsigned int)Size);
+    Sha256Update(&Cache->Hash, Length, sizeof(Length));
+    Sha256Update(&Cache->Hash, Data, Size);
+}
+
+void
+ToolCacheAddString(PTOOL_CACHE Cache, const char *String)
+{
+    ToolCacheAddData(Cache, String ? String : "", String ? strlen(String) : 0);
+}
+
+int
+ToolCacheAddFile(PTOOL_CACHE Cache, const char *FileName)
+{
+    void *Data;
+    size_t Size;
+
+    Data = LoadWholeFile(FileName, &Size);
+    if (!Data)
+        return 1;
+
+    ToolCacheAddData(Cache, Data, Size);
+    free(Data);
+    return 0;
+}
+
+/*
+ * Returns the data stored under the key, to be freed by the caller.
+ */
+int
+ToolCacheLookup(PTOOL_CACHE Cache, void **Data, size_t *Size)
+{
+    unsigned char *Entry;
+    size_t EntrySize;
+    char *Path;
+
+    if (!Cache->Directory)
+        return 1;
+
+    Path = GetEntryPath(Cache, "");
+    if (!Path)
+        return 1;
+    Entry = LoadWholeFile(Path, &EntrySize);
+    free(Path);
+    if (!Entry)
+        return 1;
+
+    if (EntrySize < 8 ||
+        memcmp(Entry, TOOL_CACHE_MAGIC, 4) != 0 ||
+        GetUlong(Entry + 4) != EntrySize - 8)
+    {
+        free(Entry);
+        return 1;
+    }
+
+    memmove(Entry, Entry + 8, EntrySize - 8);
+    *Data = Entry;
+    *Size = EntrySize - 8;
+    return 0;
+}
+
+/*
+ * Stores the data under the key. Parallel builds may store the same
+ * entry at the same time, so it is written to a file of its own first,
+ * and then renamed.
+ */
+int
+ToolCacheStore(PTOOL_CACHE Cache, const void *Data, size_t Size)
+{
+    unsigned char Header[8];
+    char Suffix[32];
+    char *TempPath, *Path;
+    FILE *File;
+    int Result = 1;
+
+    if (!Cache->Directory)
+        return 0;
+
+    sprintf(Suffix, ".%d.tmp", (int)getpid());
+    TempPath = GetEntryPath(Cache, Suffix);
+    Path = GetEntryPath(Cache, "");
+    if (!TempPath || !Path)
+    {
+        free(TempPath);
+        free(Path);
+        return 1;
+    }
+
+    memcpy(Header, TOOL_CACHE_MAGIC, 4);
+    PutUlong(Header + 4, (unsigned int)Size);
+
+    File = fopen(TempPath, "wb");
+    if (File)
+    {
+        if (fwrite(Header, 1, sizeof(Header), File) == sizeof(Header) &&
+            fwrite(Data, 1, Size, File) == Size)
+        {
+            Result = 0;
+        }
+        if (fclose(File) != 0)
+            Result = 1;
+    }
+
+    /* Somebody else may have stored it in the meantime, that is fine too */
+    if (Result == 0 && rename(TempPath, Path) != 0)
+        Result = (access(Path, 0) == 0) ? 0 : 1;
+    remove(TempPath);
+
+    free(TempPath);
+    free(Path);
+    return Result;
+}
+
+/*
+ * Writes the files stored by ToolCacheStoreFiles, in the same order.
+ */
+int
+ToolCacheRestoreFiles(PTOOL_CACHE Cache, int Count, const char *const *FileNames)
+{
+    unsigned char *Data, *p;
+    size_t Size, Length;
+    FILE *File;
+    int i;
+
+    if (ToolCacheLookup(Cache, (void **)&Data, &Size))
+        return 1;
+
+    if (Size < 4 || GetUlong(Data) != (unsigned int)Count)
+    {
+        free(Data);
+        return 1;
+    }
+
+    p = Data + 4;
+    for (i = 0; i < Count; i++)
+    {
+        if ((size_t)(Data + Size - p) < 4)
+            break;
+        Length = GetUlong(p);
+        p += 4;
+        if ((size_t)(Data + Size - p) < Length)
+            break;
+
+        File = fopen(FileNames[i], "wb");
+        if (!File)
+            break;
+        if (fwrite(p, 1, Length, File) != Length)
+        {
+            fclose(File);
+            break;
+        }
+        if (fclose(File) != 0)
+            break;
+        p += Length;
+    }
+
+    free(Data);
+    return (i == Count) ? 0 : 1;
+}
+
+int
+ToolCacheStoreFiles(PTOOL_CACHE Cache, int Count, const char *const *FileNames)
+{
+    unsigned char *Data = NULL, *NewData;
+    void *FileData;
+    size_t Size = 4, FileSize;
+    int i, Result;
+
+    if (!Cache->Directory)
+        return 0;
+
+    Data = malloc(Size);
+    if (!Data)
+        return 1;
+    PutUlong(Data, (unsigned int)Count);
+
+    for (i = 0; i < Count; i++)
+    {
+        FileData = LoadWholeFile(FileNames[i], &FileSize);
+        if (!FileData)
+        {
+            free(Data);
+            return 1;
+        }
+
+        NewData = realloc(Data, Size + 4 + FileSize);
+        if (!NewData)
+        {
+            free(FileData);
+            free(Data);
+            return 1;
+        }
+        Data = NewData;
+        PutUlong(Data + Size, (unsigned int)FileSize);
+        memcpy(Data + Size + 4, FileData, FileSize);
+        Size += 4 + FileSize;
+        free(FileData);
+    }
+
+    Result = ToolCacheStore(Cache, Data, Size);
+    free(Data);
+    return Result;
+}
+
+void
+ToolCacheClose(PTOOL_CACHE Cache)
+{
+    free(Cache->Directory);
+    memset(Cache, 0, sizeof(*Cache));
+}
+
+/* EOF */
@@ -0,0 +1,61 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Content-addressed cache of the output of build tools
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+/*
+ * A tool hashes everything its output depends on: the tool itself, the
+ * options and the input data. The output stored under that hash by an
+ * earlier run can then be reused instead of being computed again.
+ *
+ * The functions return 0 on success, like the rest of the host tools.
+ */
+
+typedef struct _TOOL_CACHE_SHA256
+{
+    unsigned int State[8];
+    unsigned long long Length;
+    unsigned char Buffer[64];
+} TOOL_CACHE_SHA256;
+
+typedef struct _TOOL_CACHE
+{
+    char *Directory;                /* NULL if the cache is disabled */
+    TOOL_CACHE_SHA256 Hash;
+    char Key[65];                   /* Hex digest, once finalized */
+} TOOL_CACHE, *PTOOL_CACHE;
+
+int
+ToolCacheInit(PTOOL_CACHE Cache, const char *Directory, const char *ToolPath);
+
+void
+ToolCacheAddData(PTOOL_CACHE Cache, const void *Data, size_t Size);
+
+void
+ToolCacheAddString(PTOOL_CACHE Cache, const char *String);
+
+int
+ToolCacheAddFile(PTOOL_CACHE Cache, const char *FileName);
+
+int
+ToolCacheLookup(PTOOL_CACHE Cache, void **Data, size_t *Size);
+
+int
+ToolCacheStore(PTOOL_CACHE Cache, const void *Data, size_t Size);
+
+int
+ToolCacheRestoreFiles(PTOOL_CACHE Cache, int Count, const char *const *FileNames);
+
+int
+ToolCacheStoreFiles(PTOOL_CACHE Cache, int Count, const char *const *FileNames);
+
+void
+ToolCacheClose(PTOOL_CACHE Cache);
+
+/* EOF */
@@ -91,6 +91,17 @@ typedef struct tagMSFT_ImpFile {
     char filename[0]; /* preceded by two bytes of encoded (length << 2) + flags in the low two bits. */
 } MSFT_ImpFile;
 
+/* The hash tables of the typelib file only have a few buckets, and some of
+ * the segments have none, so the entries are also indexed in memory. */
+#define MSFT_INDEX_SIZE 0x400
+
+typedef struct _msft_index_entry_t
+{
+    struct _msft_index_entry_t *next;
+    unsigned int hash;
+    int offset;
+} msft_index_entry_t;
+
 typedef struct _msft_typelib_t
 {
     typelib_t *typelib;
@@ -104,6 +115,8 @@ typedef struct _msft_typelib_t
     INT *typelib_namehash_segment;
     INT *typelib_guidhash_segment;
 
+    msft_index_entry_t *typelib_index[MSFT_SEG_MAX][MSFT_INDEX_SIZE];
+
     INT help_string_dll_offset;
 
     struct _msft_typeinfo_t *typeinfos;
@@ -194,6 +207,46 @@ static void ctl2_init_segdir(
     }
 }
 
+/****************************************************************************
+ *	ctl2_hash_data
+ *
+ *  Generates the key of an entry in the in-memory index of a segment.
+ *
+ * RETURNS
+ *
+ *  The FNV-1a hash of the data.
+ */
+static unsigned int ctl2_hash_data(
+	const void *data,          /* [I] The data to hash. */
+	int size)                  /* [I] The size of the data. */
+{
+    const unsigned char *bytes = data;
+    unsigned int hash = 2166136261u;
+
+    while (size--) hash = (hash ^ *bytes++) * 16777619u;
+
+    return hash;
+}
+
+/****************************************************************************
+ *	ctl2_index_add
+ *
+ *  Adds an entry of a segment to its in-memory index.
+ */
+static void ctl2_index_add(
+	msft_typelib_t *typelib,         /* [I] The type library to operate against. */
+	enum MSFT_segment_index segment, /* [I] The segment of the entry. */
+	unsigned int hash,               /* [I] The key of the entry. */
+	int offset)                      /* [I] The offset of the entry in the segment. */
+{
+    msft_index_entry_t *entry = xmalloc(sizeof(*entry));
+
+    entry->hash = hash;
+    entry->offset = offset;
+    entry->next = typelib->typelib_index[segment][hash % MSFT_INDEX_SIZE];
+    typelib->typelib_index[segment][hash % MSFT_INDEX_SIZE] = entry;
+}
+
 /****************************************************************************
  *	ctl2_hash_guid
  *
@@ -228,22 +281,18 @@ static int ctl2_hash_guid(
  */
 static int ctl2_find_guid(
 	msft_typelib_t *typelib,   /* [I] The typelib to operate against. */
-	int hash_key,              /* [I] The hash key for the guid. */
 	REFGUID guid)              /* [I] The guid to find. */
 {
-    int offset;
-    MSFT_GuidEntry *guidentry;
-
-    offset = typelib->typelib_guidhash_segment[hash_key];
-    while (offset != -1) {
-	guidentry = (MSFT_GuidEntry *)&typelib->typelib_segment_data[MSFT_SEG_GUID][offset];
+    unsigned int hash = ctl2_hash_data(guid, sizeof(GUID));
+    msft_index_entry_t *entry;
 
-	if (!memcmp(guidentry, guid, sizeof(GUID))) return offset;
-
-	offset = guidentry->next_hash;
+    for (entry = typelib->typelib_index[MSFT_SEG_GUID][hash % MSFT_INDEX_SIZE]; entry; entry = entry->next) {
+	if (entry->hash == hash &&
+	    !memcmp(&typelib->typelib_segment_data[MSFT_SEG_GUID][entry->offset], guid, sizeof(GUID)))
+	    return entry->offset;
     }
 
-    return offset;
+    return -1;
 }
 
 /****************************************************************************
@@ -263,23 +312,23 @@ static int ctl2_find_name(
 	msft_typelib_t *typelib,   /* [I] The typelib to operate against. */
 	char *name)                /* [I] The encoded name to find. */
 {
-    int offset;
+    int key = *((int *)name) & 0xffff00ff;
+    unsigned int hash = ctl2_hash_data(&key, sizeof(key));
+    msft_index_entry_t *entry;
     int *namestruct;
 
-    offset = typelib->typelib_namehash_segment[name[2] & 0x7f];
-    while (offset != -1) {
-	namestruct = (int *)&typelib->typelib_segment_data[MSFT_SEG_NAME][offset];
+    for (entry = typelib->typelib_index[MSFT_SEG_NAME][hash % MSFT_INDEX_SIZE]; entry; entry = entry->next) {
+	if (entry->hash != hash) continue;
+
+	namestruct = (int *)&typelib->typelib_segment_data[MSFT_SEG_NAME][entry->offset];
 
 	if (!((namestruct[2] ^ *((int *)name)) & 0xffff00ff)) {
 	    /* hash codes and lengths match, final test */
-	    if (!strncasecmp(name+4, (void *)(namestruct+3), name[0])) break;
+	    if (!strncasecmp(name+4, (void *)(namestruct+3), name[0])) return entry->offset;
 	}
-
-	/* move to next item in hash bucket */
-	offset = namestruct[1];
     }
 
-    return offset;
+    return -1;
 }
 
 /****************************************************************************
@@ -514,7 +563,7 @@ static int ctl2_alloc_guid(
 
     hash_key = ctl2_hash_guid(&guid->guid);
 
-    offset = ctl2_find_guid(typelib, hash_key, &guid->guid);
+    offset = ctl2_find_guid(typelib, &guid->guid);
     if (offset != -1)
     {
         if (is_warning_enabled(2368))
@@ -533,6 +582,8 @@ static int ctl2_alloc_guid(
     guid_space->next_hash = typelib->typelib_guidhash_segment[hash_key];
     typelib->typelib_guidhash_segment[hash_key] = offset;
 
+    ctl2_index_add(typelib, MSFT_SEG_GUID, ctl2_hash_data(&guid->guid, sizeof(GUID)), offset);
+
     return offset;
 }
 
@@ -553,6 +604,7 @@ static int ctl2_alloc_name(
 {
     int length;
     int offset;
+    int key;
     MSFT_NameIntro *name_space;
     char *encoded_name;
 
@@ -573,6 +625,9 @@ static int ctl2_alloc_name(
 
     typelib->typelib_namehash_segment[encoded_name[2] & 0x7f] = offset;
 
+    key = *((int *)encoded_name) & 0xffff00ff;
+    ctl2_index_add(typelib, MSFT_SEG_NAME, ctl2_hash_data(&key, sizeof(key)), offset);
+
     typelib->typelib_header.nametablecount += 1;
     typelib->typelib_header.nametablechars += *encoded_name;
 
@@ -597,13 +652,15 @@ static int ctl2_alloc_string(
     int offset;
     unsigned char *string_space;
     char *encoded_string;
+    unsigned int hash;
+    msft_index_entry_t *entry;
 
     length = ctl2_encode_string(string, &encoded_string);
+    hash = ctl2_hash_data(encoded_string, length);
 
-    for (offset = 0; offset < typelib->typelib_segdir[MSFT_SEG_STRING].length;
-	 offset += (((typelib->typelib_segment_data[MSFT_SEG_STRING][offset + 1] << 8) |
-	      typelib->typelib_segment_data[MSFT_SEG_STRING][offset + 0]) + 5) & ~3) {
-	if (!memcmp(encoded_string, typelib->typelib_segment_data[MSFT_SEG_STRING] + offset, length)) return offset;
+    for (entry = typelib->typelib_index[MSFT_SEG_STRING][hash % MSFT_INDEX_SIZE]; entry; entry = entry->next) {
+	if (entry->hash == hash &&
+	    !memcmp(encoded_string, typelib->typelib_segment_data[MSFT_SEG_STRING] + entry->offset, length)) return entry->offset;
     }
 
     offset = ctl2_alloc_segment(typelib, MSFT_SEG_STRING, length, 0);
@@ -611,6 +668,8 @@ static int ctl2_alloc_string(
     string_space = typelib->typelib_segment_data[MSFT_SEG_STRING] + offset;
     memcpy(string_space, encoded_string, length);
 
+    ctl2_index_add(typelib, MSFT_SEG_STRING, hash, offset);
+
     return offset;
 }
 
@@ -630,13 +689,16 @@ static int alloc_msft_importinfo(
 {
     int offset;
     MSFT_ImpInfo *impinfo_space;
+    unsigned int hash;
+    msft_index_entry_t *entry;
+
+    hash = ctl2_hash_data(impinfo, sizeof(MSFT_ImpInfo));
 
-    for (offset = 0;
-	 offset < typelib->typelib_segdir[MSFT_SEG_IMPORTINFO].length;
-	 offset += sizeof(MSFT_ImpInfo)) {
-	if (!memcmp(&(typelib->typelib_segment_data[MSFT_SEG_IMPORTINFO][offset]),
+    for (entry = typelib->typelib_index[MSFT_SEG_IMPORTINFO][hash % MSFT_INDEX_SIZE]; entry; entry = entry->next) {
+	if (entry->hash == hash &&
+	    !memcmp(&(typelib->typelib_segment_data[MSFT_SEG_IMPORTINFO][entry->offset]),
 		    impinfo, sizeof(MSFT_ImpInfo))) {
-	    return offset;
+	    return entry->offset;
 	}
     }
 
@@ -647,6 +709,8 @@ static int alloc_msft_importinfo(
     impinfo_space = (void *)(typelib->typelib_segment_data[MSFT_SEG_IMPORTINFO] + offset);
     *impinfo_space = *impinfo;
 
+    ctl2_index_add(typelib, MSFT_SEG_IMPORTINFO, ctl2_hash_data(impinfo, sizeof(MSFT_ImpInfo)), offset);
+
     return offset;
 }
 
@@ -671,16 +735,19 @@ static int alloc_importfile(
     int offset;
     MSFT_ImpFile *importfile;
     char *encoded_string;
+    unsigned int hash;
+    msft_index_entry_t *entry;
 
     length = ctl2_encode_string(filename, &encoded_string);
 
     encoded_string[0] <<= 2;
     encoded_string[0] |= 1;
 
-    for (offset = 0; offset < typelib->typelib_segdir[MSFT_SEG_IMPORTFILES].length;
-	 offset += (((typelib->typelib_segment_data[MSFT_SEG_IMPORTFILES][offset + 0xd] << 8) |
-	              typelib->typelib_segment_data[MSFT_SEG_IMPORTFILES][offset + 0xc]) >> 2) + 0xc) {
-	if (!memcmp(encoded_string, typelib->typelib_segment_data[MSFT_SEG_IMPORTFILES] + offset + 0xc, length)) return offset;
+    hash = ctl2_hash_data(encoded_string, length);
+
+    for (entry = typelib->typelib_index[MSFT_SEG_IMPORTFILES][hash % MSFT_INDEX_SIZE]; entry; entry = entry->next) {
+	if (entry->hash == hash &&
+	    !memcmp(encoded_string, typelib->typelib_segment_data[MSFT_SEG_IMPORTFILES] + entry->offset + 0xc, length)) return entry->offset;
     }
 
     offset = ctl2_alloc_segment(typelib, MSFT_SEG_IMPORTFILES, length + 0xc, 0);
@@ -691,6 +758,8 @@ static int alloc_importfile(
     importfile->version = major_version | (minor_version << 16);
     memcpy(&importfile->filename, encoded_string, length);
 
+    ctl2_index_add(typelib, MSFT_SEG_IMPORTFILES, hash, offset);
+
     return offset;
 }
 
@@ -776,6 +845,64 @@ static void add_coclass_typeinfo(msft_typelib_t *typelib, type_t *cls);
 static void add_dispinterface_typeinfo(msft_typelib_t *typelib, type_t *dispinterface);
 
 
+/****************************************************************************
+ *	ctl2_find_typedesc
+ *
+ *  Locates a TYPEDESC of a given vt referring to a given type.
+ *
+ * RETURNS
+ *
+ *  The offset into the TYPEDESC segment, or -1 if not found.
+ */
+static int ctl2_find_typedesc(
+	msft_typelib_t *typelib,   /* [I] The type library to operate against. */
+	int vt,                    /* [I] The vt of the TYPEDESC. */
+	int target_type)           /* [I] The type it refers to. */
+{
+    int key[2] = { vt, target_type };
+    unsigned int hash = ctl2_hash_data(key, sizeof(key));
+    msft_index_entry_t *entry;
+    int *typedata;
+
+    for (entry = typelib->typelib_index[MSFT_SEG_TYPEDESC][hash % MSFT_INDEX_SIZE]; entry; entry = entry->next) {
+	if (entry->hash != hash) continue;
+
+	typedata = (void *)&typelib->typelib_segment_data[MSFT_SEG_TYPEDESC][entry->offset];
+	if (((typedata[0] & 0xffff) == vt) && (typedata[1] == target_type)) return entry->offset;
+    }
+
+    return -1;
+}
+
+/****************************************************************************
+ *	ctl2_alloc_typedesc
+ *
+ *  Allocates and initializes a TYPEDESC in a type library.
+ *
+ * RETURNS
+ *
+ *  The offset of the new TYPEDESC.
+ */
+static int ctl2_alloc_typedesc(
+	msft_typelib_t *typelib,   /* [I] The type library to allocate in. */
+	int mix_field,             /* [I] The vt with its flags, in the high word. */
+	int target_type)           /* [I] The type it refers to. */
+{
+    int key[2] = { mix_field & 0xffff, target_type };
+    int offset;
+    int *typedata;
+
+    offset = ctl2_alloc_segment(typelib, MSFT_SEG_TYPEDESC, 8, 0);
+    typedata = (void *)&typelib->typelib_segment_data[MSFT_SEG_TYPEDESC][offset];
+
+    typedata[0] = mix_field;
+    typedata[1] = target_type;
+
+    ctl2_index_add(typelib, MSFT_SEG_TYPEDESC, ctl2_hash_data(key, sizeof(key)), offset);
+
+    return offset;
+}
+
 /****************************************************************************
  *	encode_type
  *
@@ -893,12 +1020,9 @@ static int encode_type(
             break;
         }
 
-	for (typeoffset = 0; typeoffset < typelib->typelib_segdir[MSFT_SEG_TYPEDESC].length; typeoffset += 8) {
-	    typedata = (void *)&typelib->typelib_segment_data[MSFT_SEG_TYPEDESC][typeoffset];
-	    if (((typedata[0] & 0xffff) == VT_PTR) && (typedata[1] == target_type)) break;
-	}
+	typeoffset = ctl2_find_typedesc(typelib, VT_PTR, target_type);
 
-	if (typeoffset == typelib->typelib_segdir[MSFT_SEG_TYPEDESC].length) {
+	if (typeoffset == -1) {
 	    int mix_field;
 
 	    if (target_type & 0x80000000) {
@@ -908,11 +1032,7 @@ static int encode_type(
 		mix_field = ((typedata[0] >> 16) == 0x7fff)? 0x7fff: 0x7ffe;
 	    }
 
-	    typeoffset = ctl2_alloc_segment(typelib, MSFT_SEG_TYPEDESC, 8, 0);
-	    typedata = (void *)&typelib->typelib_segment_data[MSFT_SEG_TYPEDESC][typeoffset];
-
-	    typedata[0] = (mix_field << 16) | VT_PTR;
-	    typedata[1] = target_type;
+	    typeoffset = ctl2_alloc_typedesc(typelib, (mix_field << 16) | VT_PTR, target_type);
 	}
 
 	*encoded_type = typeoffset;
@@ -929,12 +1049,9 @@ static int encode_type(
 	encode_type(typelib, next_vt, type_alias_get_aliasee(type_array_get_element(type)),
         &target_type, &child_size);
 
-	for (typeoffset = 0; typeoffset < typelib->typelib_segdir[MSFT_SEG_TYPEDESC].length; typeoffset += 8) {
-	    typedata = (void *)&typelib->typelib_segment_data[MSFT_SEG_TYPEDESC][typeoffset];
-	    if (((typedata[0] & 0xffff) == VT_SAFEARRAY) && (typedata[1] == target_type)) break;
-	}
+	typeoffset = ctl2_find_typedesc(typelib, VT_SAFEARRAY, target_type);
 
-	if (typeoffset == typelib->typelib_segdir[MSFT_SEG_TYPEDESC].length) {
+	if (typeoffset == -1) {
 	    int mix_field;
 
 	    if (target_type & 0x80000000) {
@@ -944,11 +1061,7 @@ static int encode_type(
 		mix_field = ((typedata[0] >> 16) == 0x7fff)? 0x7fff: 0x7ffe;
 	    }
 
-	    typeoffset = ctl2_alloc_segment(typelib, MSFT_SEG_TYPEDESC, 8, 0);
-	    typedata = (void *)&typelib->typelib_segment_data[MSFT_SEG_TYPEDESC][typeoffset];
-
-	    typedata[0] = (mix_field << 16) | VT_SAFEARRAY;
-	    typedata[1] = target_type;
+	    typeoffset = ctl2_alloc_typedesc(typelib, (mix_field << 16) | VT_SAFEARRAY, target_type);
 	}
 
 	*encoded_type = typeoffset;
@@ -1008,18 +1121,10 @@ static int encode_type(
 
             typeinfo_offset = typelib->typelib_typeinfo_offsets[type->typelib_idx];
         }
-	for (typeoffset = 0; typeoffset < typelib->typelib_segdir[MSFT_SEG_TYPEDESC].length; typeoffset += 8) {
-	    typedata = (void *)&typelib->typelib_segment_data[MSFT_SEG_TYPEDESC][typeoffset];
-	    if ((typedata[0] == ((0x7fff << 16) | VT_USERDEFINED)) && (typedata[1] == typeinfo_offset)) break;
-	}
+	typeoffset = ctl2_find_typedesc(typelib, VT_USERDEFINED, typeinfo_offset);
 
-	if (typeoffset == typelib->typelib_segdir[MSFT_SEG_TYPEDESC].length) {
-	    typeoffset = ctl2_alloc_segment(typelib, MSFT_SEG_TYPEDESC, 8, 0);
-	    typedata = (void *)&typelib->typelib_segment_data[MSFT_SEG_TYPEDESC][typeoffset];
-
-	    typedata[0] = (0x7fff << 16) | VT_USERDEFINED;
-	    typedata[1] = typeinfo_offset;
-	}
+	if (typeoffset == -1)
+	    typeoffset = ctl2_alloc_typedesc(typelib, (0x7fff << 16) | VT_USERDEFINED, typeinfo_offset);
 
 	*encoded_type = typeoffset;
         break;
@@ -1090,11 +1195,7 @@ static int encode_var(
             elements *= type_array_get_dim(atype);
         }
 
-        typeoffset = ctl2_alloc_segment(typelib, MSFT_SEG_TYPEDESC, 8, 0);
-        typedata = (void *)&typelib->typelib_segment_data[MSFT_SEG_TYPEDESC][typeoffset];
-
-        typedata[0] = (0x7ffe << 16) | VT_CARRAY;
-        typedata[1] = arrayoffset;
+        typeoffset = ctl2_alloc_typedesc(typelib, (0x7ffe << 16) | VT_CARRAY, arrayoffset);
 
         *encoded_type = typeoffset;
         *decoded_size = 20 /*sizeof(ARRAYDESC)*/ + (num_dims - 1) * 8 /*sizeof(SAFEARRAYBOUND)*/;
@@ -1114,12 +1215,9 @@ static int encode_var(
             return 0;
         }
 
-	for (typeoffset = 0; typeoffset < typelib->typelib_segdir[MSFT_SEG_TYPEDESC].length; typeoffset += 8) {
-	    typedata = (void *)&typelib->typelib_segment_data[MSFT_SEG_TYPEDESC][typeoffset];
-	    if (((typedata[0] & 0xffff) == VT_PTR) && (typedata[1] == target_type)) break;
-	}
+	typeoffset = ctl2_find_typedesc(typelib, VT_PTR, target_type);
 
-	if (typeoffset == typelib->typelib_segdir[MSFT_SEG_TYPEDESC].length) {
+	if (typeoffset == -1) {
 	    int mix_field;
 
 	    if (target_type & 0x80000000) {
@@ -1132,11 +1230,7 @@ static int encode_var(
 		mix_field = ((typedata[0] >> 16) == 0x7fff)? 0x7fff: 0x7ffe;
 	    }
 
-	    typeoffset = ctl2_alloc_segment(typelib, MSFT_SEG_TYPEDESC, 8, 0);
-	    typedata = (void *)&typelib->typelib_segment_data[MSFT_SEG_TYPEDESC][typeoffset];
-
-	    typedata[0] = (mix_field << 16) | VT_PTR;
-	    typedata[1] = target_type;
+	    typeoffset = ctl2_alloc_typedesc(typelib, (mix_field << 16) | VT_PTR, target_type);
 	}
 
 	*encoded_type = typeoffset;
@@ -1947,7 +2041,7 @@ static msft_typeinfo_t *create_msft_typeinfo(msft_typelib_t *typelib, enum type_
 
 static void add_dispatch(msft_typelib_t *typelib)
 {
-    int guid_offset, impfile_offset, hash_key;
+    int guid_offset, impfile_offset;
     MSFT_GuidEntry guidentry;
     MSFT_ImpInfo impinfo;
     GUID stdole =        {0x00020430,0x0000,0x0000,{0xc0,0x00,0x00,0x00,0x00,0x00,0x00,0x46}};
@@ -1958,8 +2052,7 @@ static void add_dispatch(msft_typelib_t *typelib)
     guidentry.guid = stdole;
     guidentry.hreftype = 2;
     guidentry.next_hash = -1;
-    hash_key = ctl2_hash_guid(&guidentry.guid);
-    guid_offset = ctl2_find_guid(typelib, hash_key, &guidentry.guid);
+    guid_offset = ctl2_find_guid(typelib, &guidentry.guid);
     if (guid_offset == -1)
         guid_offset = ctl2_alloc_guid(typelib, &guidentry);
     impfile_offset = alloc_importfile(typelib, guid_offset, 2, 0, "stdole2.tlb");
@@ -1969,8 +2062,7 @@ static void add_dispatch(msft_typelib_t *typelib)
     guidentry.next_hash = -1;
     impinfo.flags = TKIND_INTERFACE << 24 | MSFT_IMPINFO_OFFSET_IS_GUID;
     impinfo.oImpFile = impfile_offset;
-    hash_key = ctl2_hash_guid(&guidentry.guid);
-    guid_offset = ctl2_find_guid(typelib, hash_key, &guidentry.guid);
+    guid_offset = ctl2_find_guid(typelib, &guidentry.guid);
     if (guid_offset == -1)
         guid_offset = ctl2_alloc_guid(typelib, &guidentry);
     impinfo.oGuid = guid_offset;
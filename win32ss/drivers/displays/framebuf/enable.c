@@ -34,6 +34,17 @@ static DRVFN DrvFunctionTable[] =
    {INDEX_DrvMovePointer, (PFN)DrvMovePointer},
    {INDEX_DrvEnableDirectDraw, (PFN)DrvEnableDirectDraw},
    {INDEX_DrvDisableDirectDraw, (PFN)DrvDisableDirectDraw},
+#ifdef SHADOW_FRAMEBUFFER_SUPPORT
+   {INDEX_DrvBitBlt, (PFN)DrvBitBlt},
+   {INDEX_DrvCopyBits, (PFN)DrvCopyBits},
+   {INDEX_DrvStretchBltROP, (PFN)DrvStretchBltROP},
+   {INDEX_DrvTextOut, (PFN)DrvTextOut},
+   {INDEX_DrvStrokePath, (PFN)DrvStrokePath},
+   {INDEX_DrvLineTo, (PFN)DrvLineTo},
+   {INDEX_DrvAlphaBlend, (PFN)DrvAlphaBlend},
+   {INDEX_DrvTransparentBlt, (PFN)DrvTransparentBlt},
+   {INDEX_DrvGradientFill, (PFN)DrvGradientFill},
+#endif
 
 };
 
@@ -30,6 +30,9 @@
 
 //#define EXPERIMENTAL_MOUSE_CURSOR_SUPPORT
 
+/* Draw into a system memory copy of the frame buffer, see shadow.c */
+#define SHADOW_FRAMEBUFFER_SUPPORT
+
 typedef struct _PDEV
 {
    HANDLE hDriver;
@@ -45,6 +48,9 @@ typedef struct _PDEV
    ULONG BlueMask;
    BYTE PaletteShift;
    PVOID ScreenPtr;
+   HSURF hSurfShadow;
+   SURFOBJ *psoShadow;
+   RECTL rclShadowDirty;
    HPALETTE DefaultPalette;
    PALETTEENTRY *PaletteEntries;
 
@@ -171,4 +177,133 @@ IntSetPalette(
    IN ULONG iStart,
    IN ULONG cColors);
 
+#ifdef SHADOW_FRAMEBUFFER_SUPPORT
+HSURF
+IntCreateShadowSurface(
+   IN PPDEV ppdev,
+   IN SIZEL ScreenSize,
+   IN ULONG BitmapType);
+
+VOID
+IntDeleteShadowSurface(
+   IN PPDEV ppdev);
+
+VOID
+IntShadowFlush(
+   IN PPDEV ppdev);
+
+VOID
+IntShadowFlushAll(
+   IN PPDEV ppdev);
+
+BOOL APIENTRY
+DrvBitBlt(
+   IN SURFOBJ *psoTrg,
+   IN SURFOBJ *psoSrc,
+   IN SURFOBJ *psoMask,
+   IN CLIPOBJ *pco,
+   IN XLATEOBJ *pxlo,
+   IN RECTL *prclTrg,
+   IN POINTL *pptlSrc,
+   IN POINTL *pptlMask,
+   IN BRUSHOBJ *pbo,
+   IN POINTL *pptlBrush,
+   IN ROP4 rop4);
+
+BOOL APIENTRY
+DrvCopyBits(
+   OUT SURFOBJ *psoDest,
+   IN SURFOBJ *psoSrc,
+   IN CLIPOBJ *pco,
+   IN XLATEOBJ *pxlo,
+   IN RECTL *prclDest,
+   IN POINTL *pptlSrc);
+
+BOOL APIENTRY
+DrvStretchBltROP(
+   IN SURFOBJ *psoDest,
+   IN SURFOBJ *psoSrc,
+   IN SURFOBJ *psoMask,
+   IN CLIPOBJ *pco,
+   IN XLATEOBJ *pxlo,
+   IN COLORADJUSTMENT *pca,
+   IN POINTL *pptlHTOrg,
+   IN RECTL *prclDest,
+   IN RECTL *prclSrc,
+   IN POINTL *pptlMask,
+   IN ULONG iMode,
+   IN BRUSHOBJ *pbo,
+   IN ROP4 rop4);
+
+BOOL APIENTRY
+DrvTextOut(
+   IN SURFOBJ *pso,
+   IN STROBJ *pstro,
+   IN FONTOBJ *pfo,
+   IN CLIPOBJ *pco,
+   IN RECTL *prclExtra,
+   IN RECTL *prclOpaque,
+   IN BRUSHOBJ *pboFore,
+   IN BRUSHOBJ *pboOpaque,
+   IN POINTL *pptlOrg,
+   IN MIX mix);
+
+BOOL APIENTRY
+DrvStrokePath(
+   IN SURFOBJ *pso,
+   IN PATHOBJ *ppo,
+   IN CLIPOBJ *pco,
+   IN XFORMOBJ *pxo,
+   IN BRUSHOBJ *pbo,
+   IN POINTL *pptlBrushOrg,
+   IN LINEATTRS *plineattrs,
+   IN MIX mix);
+
+BOOL APIENTRY
+DrvLineTo(
+   IN SURFOBJ *pso,
+   IN CLIPOBJ *pco,
+   IN BRUSHOBJ *pbo,
+   IN LONG x1,
+   IN LONG y1,
+   IN LONG x2,
+   IN LONG y2,
+   IN RECTL *prclBounds,
+   IN MIX mix);
+
+BOOL APIENTRY
+DrvAlphaBlend(
+   IN SURFOBJ *psoDest,
+   IN SURFOBJ *psoSrc,
+   IN CLIPOBJ *pco,
+   IN XLATEOBJ *pxlo,
+   IN RECTL *prclDest,
+   IN RECTL *prclSrc,
+   IN BLENDOBJ *pBlendObj);
+
+BOOL APIENTRY
+DrvTransparentBlt(
+   IN SURFOBJ *psoDest,
+   IN SURFOBJ *psoSrc,
+   IN CLIPOBJ *pco,
+   IN XLATEOBJ *pxlo,
+   IN RECTL *prclDest,
+   IN RECTL *prclSrc,
+   IN ULONG iTransColor,
+   IN ULONG ulReserved);
+
+BOOL APIENTRY
+DrvGradientFill(
+   IN SURFOBJ *pso,
+   IN CLIPOBJ *pco,
+   IN XLATEOBJ *pxlo,
+   IN TRIVERTEX *pVertex,
+   IN ULONG nVertex,
+   IN PVOID pMesh,
+   IN ULONG nMesh,
+   IN RECTL *prclExtents,
+   IN POINTL *pptlDitherOrg,
+   IN ULONG ulMode);
+#endif
+
 #endif /* _FRAMEBUF_PCH_ */
@@ -0,0 +1,490 @@
+/*
+ * PROJECT:     ReactOS Generic Framebuffer display driver
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     System memory shadow of the frame buffer
+ */
+
+#include "framebuf.h"
+
+#ifdef SHADOW_FRAMEBUFFER_SUPPORT
+
+/*
+ * When the shadow is enabled, GDI sees a device managed primary surface
+ * and every drawing call we hook is carried out by the engine on a bitmap
+ * in system memory. Only the area that was touched is then copied to the
+ * frame buffer, so video memory is never read back.
+ */
+
+static BOOL
+IntShadowIntersectRect(
+   OUT RECTL *prclDest,
+   IN const RECTL *prcl1,
+   IN const RECTL *prcl2)
+{
+   prclDest->left = max(prcl1->left, prcl2->left);
+   prclDest->top = max(prcl1->top, prcl2->top);
+   prclDest->right = min(prcl1->right, prcl2->right);
+   prclDest->bottom = min(prcl1->bottom, prcl2->bottom);
+
+   return prclDest->left < prclDest->right && prclDest->top < prclDest->bottom;
+}
+
+/*
+ * IntShadowMarkDirty
+ *
+ * Adds the part of a drawing operation that may have changed pixels to the
+ * dirty rectangle of the shadow surface.
+ */
+
+static VOID
+IntShadowMarkDirty(
+   IN PPDEV ppdev,
+   IN CLIPOBJ *pco,
+   IN const RECTL *prcl)
+{
+   RECTL rclScreen, rclDirty;
+
+   rclScreen.left = 0;
+   rclScreen.top = 0;
+   rclScreen.right = ppdev->ScreenWidth;
+   rclScreen.bottom = ppdev->ScreenHeight;
+
+   if (prcl != NULL)
+   {
+      /* Some callers pass unordered rectangles */
+      rclDirty.left = min(prcl->left, prcl->right);
+      rclDirty.right = max(prcl->left, prcl->right);
+      rclDirty.top = min(prcl->top, prcl->bottom);
+      rclDirty.bottom = max(prcl->top, prcl->bottom);
+
+      if (!IntShadowIntersectRect(&rclScreen, &rclScreen, &rclDirty))
+         return;
+   }
+
+   if (pco != NULL && pco->iDComplexity != DC_TRIVIAL &&
+       !IntShadowIntersectRect(&rclScreen, &rclScreen, &pco->rclBounds))
+   {
+      return;
+   }
+
+   if (ppdev->rclShadowDirty.left >= ppdev->rclShadowDirty.right)
+   {
+      ppdev->rclShadowDirty = rclScreen;
+   }
+   else
+   {
+      ppdev->rclShadowDirty.left = min(ppdev->rclShadowDirty.left, rclScreen.left);
+      ppdev->rclShadowDirty.top = min(ppdev->rclShadowDirty.top, rclScreen.top);
+      ppdev->rclShadowDirty.right = max(ppdev->rclShadowDirty.right, rclScreen.right);
+      ppdev->rclShadowDirty.bottom = max(ppdev->rclShadowDirty.bottom, rclScreen.bottom);
+   }
+}
+
+/*
+ * IntShadowFlush
+ *
+ * Copies the dirty rectangle of the shadow surface to the frame buffer.
+ * The shadow has the layout of the frame buffer, top-down or bottom-up,
+ * so a pixel is at the same offset in both. Full width updates of a
+ * frame buffer without padding are done with a single copy, anything
+ * else row by row.
+ */
+
+VOID
+IntShadowFlush(
+   IN PPDEV ppdev)
+{
+   SURFOBJ *psoShadow = ppdev->psoShadow;
+   PRECTL prcl = &ppdev->rclShadowDirty;
+   ULONG BytesPerPixel = ppdev->BitsPerPixel >> 3;
+   LONG lDelta;
+   ULONG cjRow;
+   PBYTE pjSrc;
+   LONG y;
+
+   if (psoShadow == NULL || prcl->left >= prcl->right)
+      return;
+
+   lDelta = psoShadow->lDelta;
+   cjRow = (prcl->right - prcl->left) * BytesPerPixel;
+   pjSrc = (PBYTE)psoShadow->pvScan0 + prcl->top * lDelta +
+           prcl->left * BytesPerPixel;
+
+   if (cjRow == (ULONG)abs(lDelta))
+   {
+      /* The rows are contiguous, start from the lowest address */
+      if (lDelta < 0)
+         pjSrc += (prcl->bottom - prcl->top - 1) * lDelta;
+
+      RtlCopyMemory((PBYTE)ppdev->ScreenPtr + (pjSrc - (PBYTE)psoShadow->pvBits),
+                    pjSrc, cjRow * (prcl->bottom - prcl->top));
+   }
+   else
+   {
+      for (y = prcl->top; y < prcl->bottom; y++)
+      {
+         RtlCopyMemory((PBYTE)ppdev->ScreenPtr + (pjSrc - (PBYTE)psoShadow->pvBits),
+                       pjSrc, cjRow);
+         pjSrc += lDelta;
+      }
+   }
+
+   prcl->left = prcl->top = prcl->right = prcl->bottom = 0;
+}
+
+/*
+ * IntShadowFlushAll
+ *
+ * Rewrites the whole frame buffer from the shadow, e.g. after a mode set.
+ */
+
+VOID
+IntShadowFlushAll(
+   IN PPDEV ppdev)
+{
+   IntShadowMarkDirty(ppdev, NULL, NULL);
+   IntShadowFlush(ppdev);
+}
+
+/*
+ * IntCreateShadowSurface
+ *
+ * Creates the shadow bitmap and the device managed primary surface that
+ * GDI draws on.
+ */
+
+HSURF
+IntCreateShadowSurface(
+   IN PPDEV ppdev,
+   IN SIZEL ScreenSize,
+   IN ULONG BitmapType)
+{
+   HSURF hSurface;
+   LONG ScreenDelta = (LONG)ppdev->ScreenDelta;
+
+   /* Same orientation and stride as the frame buffer, see IntShadowFlush */
+   ppdev->hSurfShadow = (HSURF)EngCreateBitmap(ScreenSize, abs(ScreenDelta), BitmapType,
+                                               (ScreenDelta > 0) ? BMF_TOPDOWN : 0,
+                                               NULL);
+   if (ppdev->hSurfShadow == NULL)
+      return NULL;
+
+   ppdev->psoShadow = EngLockSurface(ppdev->hSurfShadow);
+   if (ppdev->psoShadow == NULL)
+   {
+      IntDeleteShadowSurface(ppdev);
+      return NULL;
+   }
+
+   hSurface = EngCreateDeviceSurface((DHSURF)ppdev, ScreenSize, BitmapType);
+   if (hSurface == NULL)
+   {
+      IntDeleteShadowSurface(ppdev);
+      return NULL;
+   }
+
+   if (!EngAssociateSurface(hSurface, ppdev->hDevEng,
+                            HOOK_BITBLT | HOOK_COPYBITS | HOOK_STRETCHBLTROP |
+                            HOOK_TEXTOUT | HOOK_STROKEPATH | HOOK_LINETO |
+                            HOOK_ALPHABLEND | HOOK_TRANSPARENTBLT |
+                            HOOK_GRADIENTFILL))
+   {
+      EngDeleteSurface(hSurface);
+      IntDeleteShadowSurface(ppdev);
+      return NULL;
+   }
+
+   /* Start from what is currently on screen */
+   RtlCopyMemory(ppdev->psoShadow->pvBits, ppdev->ScreenPtr,
+                 ppdev->psoShadow->cjBits);
+
+   return hSurface;
+}
+
+VOID
+IntDeleteShadowSurface(
+   IN PPDEV ppdev)
+{
+   if (ppdev->psoShadow != NULL)
+   {
+      EngUnlockSurface(ppdev->psoShadow);
+      ppdev->psoShadow = NULL;
+   }
+
+   if (ppdev->hSurfShadow != NULL)
+   {
+      EngDeleteSurface(ppdev->hSurfShadow);
+      ppdev->hSurfShadow = NULL;
+   }
+}
+
+/* Returns the shadow bitmap for our primary surface, other surfaces as is */
+static SURFOBJ *
+IntShadowSurface(
+   IN SURFOBJ *pso)
+{
+   if (pso != NULL && pso->iType == STYPE_DEVICE)
+      return ((PPDEV)pso->dhpdev)->psoShadow;
+
+   return pso;
+}
+
+BOOL APIENTRY
+DrvBitBlt(
+   IN SURFOBJ *psoTrg,
+   IN SURFOBJ *psoSrc,
+   IN SURFOBJ *psoMask,
+   IN CLIPOBJ *pco,
+   IN XLATEOBJ *pxlo,
+   IN RECTL *prclTrg,
+   IN POINTL *pptlSrc,
+   IN POINTL *pptlMask,
+   IN BRUSHOBJ *pbo,
+   IN POINTL *pptlBrush,
+   IN ROP4 rop4)
+{
+   BOOL bResult;
+
+   bResult = EngBitBlt(IntShadowSurface(psoTrg), IntShadowSurface(psoSrc),
+                       psoMask, pco, pxlo, prclTrg, pptlSrc, pptlMask, pbo,
+                       pptlBrush, rop4);
+
+   if (bResult && psoTrg->iType == STYPE_DEVICE)
+   {
+      IntShadowMarkDirty((PPDEV)psoTrg->dhpdev, pco, prclTrg);
+      IntShadowFlush((PPDEV)psoTrg->dhpdev);
+   }
+
+   return bResult;
+}
+
+BOOL APIENTRY
+DrvCopyBits(
+   OUT SURFOBJ *psoDest,
+   IN SURFOBJ *psoSrc,
+   IN CLIPOBJ *pco,
+   IN XLATEOBJ *pxlo,
+   IN RECTL *prclDest,
+   IN POINTL *pptlSrc)
+{
+   BOOL bResult;
+
+   bResult = EngCopyBits(IntShadowSurface(psoDest), IntShadowSurface(psoSrc),
+                         pco, pxlo, prclDest, pptlSrc);
+
+   if (bResult && psoDest->iType == STYPE_DEVICE)
+   {
+      IntShadowMarkDirty((PPDEV)psoDest->dhpdev, pco, prclDest);
+      IntShadowFlush((PPDEV)psoDest->dhpdev);
+   }
+
+   return bResult;
+}
+
+BOOL APIENTRY
+DrvStretchBltROP(
+   IN SURFOBJ *psoDest,
+   IN SURFOBJ *psoSrc,
+   IN SURFOBJ *psoMask,
+   IN CLIPOBJ *pco,
+   IN XLATEOBJ *pxlo,
+   IN COLORADJUSTMENT *pca,
+   IN POINTL *pptlHTOrg,
+   IN RECTL *prclDest,
+   IN RECTL *prclSrc,
+   IN POINTL *pptlMask,
+   IN ULONG iMode,
+   IN BRUSHOBJ *pbo,
+   IN ROP4 rop4)
+{
+   BOOL bResult;
+
+   bResult = EngStretchBltROP(IntShadowSurface(psoDest), IntShadowSurface(psoSrc),
+                              psoMask, pco, pxlo, pca, pptlHTOrg, prclDest,
+                              prclSrc, pptlMask, iMode, pbo, rop4);
+
+   if (bResult && psoDest->iType == STYPE_DEVICE)
+   {
+      IntShadowMarkDirty((PPDEV)psoDest->dhpdev, pco, prclDest);
+      IntShadowFlush((PPDEV)psoDest->dhpdev);
+   }
+
+   return bResult;
+}
+
+BOOL APIENTRY
+DrvTextOut(
+   IN SURFOBJ *pso,
+   IN STROBJ *pstro,
+   IN FONTOBJ *pfo,
+   IN CLIPOBJ *pco,
+   IN RECTL *prclExtra,
+   IN RECTL *prclOpaque,
+   IN BRUSHOBJ *pboFore,
+   IN BRUSHOBJ *pboOpaque,
+   IN POINTL *pptlOrg,
+   IN MIX mix)
+{
+   PPDEV ppdev = (PPDEV)pso->dhpdev;
+   BOOL bResult;
+
+   bResult = EngTextOut(ppdev->psoShadow, pstro, pfo, pco, prclExtra,
+                        prclOpaque, pboFore, pboOpaque, pptlOrg, mix);
+
+   if (bResult)
+   {
+      IntShadowMarkDirty(ppdev, pco, &pstro->rclBkGround);
+      if (prclOpaque != NULL)
+         IntShadowMarkDirty(ppdev, pco, prclOpaque);
+
+      /* Underlines and strike-outs, terminated by a null rectangle */
+      while (prclExtra != NULL && prclExtra->left != prclExtra->right)
+      {
+         IntShadowMarkDirty(ppdev, pco, prclExtra);
+         prclExtra++;
+      }
+
+      IntShadowFlush(ppdev);
+   }
+
+   return bResult;
+}
+
+BOOL APIENTRY
+DrvStrokePath(
+   IN SURFOBJ *pso,
+   IN PATHOBJ *ppo,
+   IN CLIPOBJ *pco,
+   IN XFORMOBJ *pxo,
+   IN BRUSHOBJ *pbo,
+   IN POINTL *pptlBrushOrg,
+   IN LINEATTRS *plineattrs,
+   IN MIX mix)
+{
+   PPDEV ppdev = (PPDEV)pso->dhpdev;
+   RECTFX rcfxBounds;
+   RECTL rclBounds;
+   BOOL bResult;
+
+   bResult = EngStrokePath(ppdev->psoShadow, ppo, pco, pxo, pbo, pptlBrushOrg,
+                           plineattrs, mix);
+
+   if (bResult)
+   {
+      PATHOBJ_vGetBounds(ppo, &rcfxBounds);
+      rclBounds.left = (rcfxBounds.xLeft >> 4) - 1;
+      rclBounds.top = (rcfxBounds.yTop >> 4) - 1;
+      rclBounds.right = (rcfxBounds.xRight >> 4) + 2;
+      rclBounds.bottom = (rcfxBounds.yBottom >> 4) + 2;
+
+      IntShadowMarkDirty(ppdev, pco, &rclBounds);
+      IntShadowFlush(ppdev);
+   }
+
+   return bResult;
+}
+
+BOOL APIENTRY
+DrvLineTo(
+   IN SURFOBJ *pso,
+   IN CLIPOBJ *pco,
+   IN BRUSHOBJ *pbo,
+   IN LONG x1,
+   IN LONG y1,
+   IN LONG x2,
+   IN LONG y2,
+   IN RECTL *prclBounds,
+   IN MIX mix)
+{
+   PPDEV ppdev = (PPDEV)pso->dhpdev;
+   BOOL bResult;
+
+   bResult = EngLineTo(ppdev->psoShadow, pco, pbo, x1, y1, x2, y2, prclBounds, mix);
+
+   if (bResult)
+   {
+      IntShadowMarkDirty(ppdev, pco, prclBounds);
+      IntShadowFlush(ppdev);
+   }
+
+   return bResult;
+}
+
+BOOL APIENTRY
+DrvAlphaBlend(
+   IN SURFOBJ *psoDest,
+   IN SURFOBJ *psoSrc,
+   IN CLIPOBJ *pco,
+   IN XLATEOBJ *pxlo,
+   IN RECTL *prclDest,
+   IN RECTL *prclSrc,
+   IN BLENDOBJ *pBlendObj)
+{
+   BOOL bResult;
+
+   bResult = EngAlphaBlend(IntShadowSurface(psoDest), IntShadowSurface(psoSrc),
+                           pco, pxlo, prclDest, prclSrc, pBlendObj);
+
+   if (bResult && psoDest->iType == STYPE_DEVICE)
+   {
+      IntShadowMarkDirty((PPDEV)psoDest->dhpdev, pco, prclDest);
+      IntShadowFlush((PPDEV)psoDest->dhpdev);
+   }
+
+   return bResult;
+}
+
+BOOL APIENTRY
+DrvTransparentBlt(
+   IN SURFOBJ *psoDest,
+   IN SURFOBJ *psoSrc,
+   IN CLIPOBJ *pco,
+   IN XLATEOBJ *pxlo,
+   IN RECTL *prclDest,
+   IN RECTL *prclSrc,
+   IN ULONG iTransColor,
+   IN ULONG ulReserved)
+{
+   BOOL bResult;
+
+   bResult = EngTransparentBlt(IntShadowSurface(psoDest), IntShadowSurface(psoSrc),
+                               pco, pxlo, prclDest, prclSrc, iTransColor, ulReserved);
+
+   if (bResult && psoDest->iType == STYPE_DEVICE)
+   {
+      IntShadowMarkDirty((PPDEV)psoDest->dhpdev, pco, prclDest);
+      IntShadowFlush((PPDEV)psoDest->dhpdev);
+   }
+
+   return bResult;
+}
+
+BOOL APIENTRY
+DrvGradientFill(
+   IN SURFOBJ *pso,
+   IN CLIPOBJ *pco,
+   IN XLATEOBJ *pxlo,
+   IN TRIVERTEX *pVertex,
+   IN ULONG nVertex,
+   IN PVOID pMesh,
+   IN ULONG nMesh,
+   IN RECTL *prclExtents,
+   IN POINTL *pptlDitherOrg,
+   IN ULONG ulMode)
+{
+   PPDEV ppdev = (PPDEV)pso->dhpdev;
+   BOOL bResult;
+
+   bResult = EngGradientFill(ppdev->psoShadow, pco, pxlo, pVertex, nVertex,
+                             pMesh, nMesh, prclExtents, pptlDitherOrg, ulMode);
+
+   if (bResult)
+   {
+      IntShadowMarkDirty(ppdev, pco, prclExtents);
+      IntShadowFlush(ppdev);
+   }
+
+   return bResult;
+}
+
+#endif /* SHADOW_FRAMEBUFFER_SUPPORT */
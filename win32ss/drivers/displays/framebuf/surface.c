@@ -96,6 +96,21 @@ DrvEnableSurface(
    ScreenSize.cx = ppdev->ScreenWidth;
    ScreenSize.cy = ppdev->ScreenHeight;
 
+#ifdef SHADOW_FRAMEBUFFER_SUPPORT
+   /*
+    * Let GDI draw into system memory and copy the changes to the frame
+    * buffer. Fall back to drawing directly into video memory if the
+    * shadow can't be allocated.
+    */
+
+   hSurface = IntCreateShadowSurface(ppdev, ScreenSize, BitmapType);
+   if (hSurface != NULL)
+   {
+      ppdev->hSurfEng = hSurface;
+      return hSurface;
+   }
+#endif
+
    hSurface = (HSURF)EngCreateBitmap(ScreenSize, ppdev->ScreenDelta, BitmapType,
                                      (ppdev->ScreenDelta > 0) ? BMF_TOPDOWN : 0,
                                      ppdev->ScreenPtr);
@@ -140,6 +155,10 @@ DrvDisableSurface(
    EngDeleteSurface(ppdev->hSurfEng);
    ppdev->hSurfEng = NULL;
 
+#ifdef SHADOW_FRAMEBUFFER_SUPPORT
+   IntDeleteShadowSurface(ppdev);
+#endif
+
 #ifdef EXPERIMENTAL_MOUSE_CURSOR_SUPPORT
    /* Clear all mouse pointer surfaces. */
    DrvSetPointerShape(NULL, NULL, NULL, NULL, 0, 0, 0, 0, NULL, 0);
@@ -189,6 +208,11 @@ DrvAssertMode(
 	     IntSetPalette(dhpdev, ppdev->PaletteEntries, 0, 256);
       }
 
+#ifdef SHADOW_FRAMEBUFFER_SUPPORT
+      /* The mode set cleared the frame buffer, restore it */
+      IntShadowFlushAll(ppdev);
+#endif
+
       return TRUE;
    }
    else
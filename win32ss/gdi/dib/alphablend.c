@@ -11,6 +11,10 @@
 #define NDEBUG
 #include <debug.h>
 
+#if defined(_M_AMD64)
+#include <emmintrin.h>
+#endif
+
 typedef union
 {
   ULONG ul;
@@ -121,3 +125,240 @@ DIB_XXBPP_AlphaBlend(SURFOBJ* Dest, SURFOBJ* Source, RECTL* DestRect,
   return TRUE;
 }
 
+/*
+ * Fast paths for the common case of an unstretched 32bpp source whose
+ * pixels can be read without going through the XLATEOBJ. They compute
+ * exactly what the generic per-pixel loops of the DIB_xxBPP_AlphaBlend
+ * functions compute, just without the per-pixel DIB_GetSource calls.
+ */
+
+static __inline UCHAR
+Clamp6(ULONG val)
+{
+  return (val > 63) ? 63 : (UCHAR)val;
+}
+
+static __inline UCHAR
+Clamp5(ULONG val)
+{
+  return (val > 31) ? 31 : (UCHAR)val;
+}
+
+static __inline UCHAR
+ScaleSource32(NICEPIXEL32* SrcPixel, BLENDFUNCTION BlendFunc)
+{
+  SrcPixel->col.red = (SrcPixel->col.red * BlendFunc.SourceConstantAlpha) / 255;
+  SrcPixel->col.green = (SrcPixel->col.green * BlendFunc.SourceConstantAlpha) / 255;
+  SrcPixel->col.blue = (SrcPixel->col.blue * BlendFunc.SourceConstantAlpha) / 255;
+  SrcPixel->col.alpha = (SrcPixel->col.alpha * BlendFunc.SourceConstantAlpha) / 255;
+
+  return ((BlendFunc.AlphaFormat & AC_SRC_ALPHA) != 0) ?
+         SrcPixel->col.alpha : BlendFunc.SourceConstantAlpha;
+}
+
+#if defined(_M_AMD64)
+/* floor(x / 255) for 0 <= x <= 255 * 255, computed as (x + 1 + (x >> 8)) >> 8 */
+static __inline __m128i
+Div255Epu16(__m128i x)
+{
+  return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, _mm_set1_epi16(1)),
+                                      _mm_srli_epi16(x, 8)), 8);
+}
+
+/* Blends two pixels held as 16-bit channels */
+static __inline __m128i
+AlphaBlendEpu16(__m128i Src, __m128i* Dst, __m128i ConstAlpha, BOOLEAN SrcAlpha)
+{
+  __m128i Alpha;
+
+  Src = Div255Epu16(_mm_mullo_epi16(Src, ConstAlpha));
+  if (SrcAlpha)
+  {
+    Alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(Src, _MM_SHUFFLE(3, 3, 3, 3)),
+                                _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  else
+  {
+    Alpha = ConstAlpha;
+  }
+
+  *Dst = Div255Epu16(_mm_mullo_epi16(*Dst, _mm_sub_epi16(_mm_set1_epi16(255), Alpha)));
+  return Src;
+}
+#endif
+
+static VOID
+AlphaBlendRow32(PULONG Dst, const ULONG* Src, LONG Count, BLENDFUNCTION BlendFunc)
+{
+  NICEPIXEL32 SrcPixel, DstPixel;
+  UCHAR Alpha;
+
+#if defined(_M_AMD64)
+  __m128i Zero = _mm_setzero_si128();
+  __m128i ConstAlpha = _mm_set1_epi16(BlendFunc.SourceConstantAlpha);
+  __m128i SrcLo, SrcHi, DstLo, DstHi, Pixels;
+  BOOLEAN SrcAlpha = (BlendFunc.AlphaFormat & AC_SRC_ALPHA) != 0;
+
+  for (; Count >= 4; Count -= 4, Src += 4, Dst += 4)
+  {
+    Pixels = _mm_loadu_si128((const __m128i*)Src);
+    SrcLo = _mm_unpacklo_epi8(Pixels, Zero);
+    SrcHi = _mm_unpackhi_epi8(Pixels, Zero);
+    Pixels = _mm_loadu_si128((const __m128i*)Dst);
+    DstLo = _mm_unpacklo_epi8(Pixels, Zero);
+    DstHi = _mm_unpackhi_epi8(Pixels, Zero);
+
+    SrcLo = AlphaBlendEpu16(SrcLo, &DstLo, ConstAlpha, SrcAlpha);
+    SrcHi = AlphaBlendEpu16(SrcHi, &DstHi, ConstAlpha, SrcAlpha);
+
+    /* Saturating add, same as Clamp8 */
+    Pixels = _mm_adds_epu8(_mm_packus_epi16(DstLo, DstHi),
+                           _mm_packus_epi16(SrcLo, SrcHi));
+    _mm_storeu_si128((__m128i*)Dst, Pixels);
+  }
+#endif
+
+  while (Count-- > 0)
+  {
+    SrcPixel.ul = *Src++;
+    Alpha = ScaleSource32(&SrcPixel, BlendFunc);
+
+    DstPixel.ul = *Dst;
+    DstPixel.col.red = Clamp8((DstPixel.col.red * (255 - Alpha)) / 255 + SrcPixel.col.red);
+    DstPixel.col.green = Clamp8((DstPixel.col.green * (255 - Alpha)) / 255 + SrcPixel.col.green);
+    DstPixel.col.blue = Clamp8((DstPixel.col.blue * (255 - Alpha)) / 255 + SrcPixel.col.blue);
+    DstPixel.col.alpha = Clamp8((DstPixel.col.alpha * (255 - Alpha)) / 255 + SrcPixel.col.alpha);
+    *Dst++ = DstPixel.ul;
+  }
+}
+
+static VOID
+AlphaBlendRow24(PUCHAR Dst, const ULONG* Src, LONG Count, BLENDFUNCTION BlendFunc)
+{
+  NICEPIXEL32 SrcPixel;
+  UCHAR Alpha;
+
+  while (Count-- > 0)
+  {
+    SrcPixel.ul = *Src++;
+    Alpha = ScaleSource32(&SrcPixel, BlendFunc);
+
+    Dst[0] = Clamp8((Dst[0] * (255 - Alpha)) / 255 + SrcPixel.col.red);
+    Dst[1] = Clamp8((Dst[1] * (255 - Alpha)) / 255 + SrcPixel.col.green);
+    Dst[2] = Clamp8((Dst[2] * (255 - Alpha)) / 255 + SrcPixel.col.blue);
+    Dst += 3;
+  }
+}
+
+static VOID
+AlphaBlendRow16(PUSHORT Dst, const ULONG* Src, LONG Count, BLENDFUNCTION BlendFunc,
+                BOOLEAN Is555, BOOLEAN SwapRB)
+{
+  NICEPIXEL32 SrcPixel;
+  UCHAR Alpha, Alpha5, Alpha6, Red, Blue;
+  ULONG DstRed, DstGreen, DstBlue;
+  USHORT DstPixel;
+
+  while (Count-- > 0)
+  {
+    SrcPixel.ul = *Src++;
+    Alpha = ScaleSource32(&SrcPixel, BlendFunc);
+
+    /* The generic code blends in RGB order, ie. red is the low byte */
+    Red = SwapRB ? SrcPixel.col.blue : SrcPixel.col.red;
+    Blue = SwapRB ? SrcPixel.col.red : SrcPixel.col.blue;
+
+    DstPixel = *Dst;
+    if (Is555)
+    {
+      Alpha5 = Alpha >> 3;
+      DstRed = Clamp5((((DstPixel >> 10) & 0x1F) * (31 - Alpha5)) / 31 + (Red >> 3));
+      DstGreen = Clamp5((((DstPixel >> 5) & 0x1F) * (31 - Alpha5)) / 31 + (SrcPixel.col.green >> 3));
+      DstBlue = Clamp5(((DstPixel & 0x1F) * (31 - Alpha5)) / 31 + (Blue >> 3));
+      *Dst++ = (USHORT)((DstPixel & 0x8000) | (DstRed << 10) | (DstGreen << 5) | DstBlue);
+    }
+    else
+    {
+      Alpha6 = Alpha >> 2;
+      Alpha5 = Alpha >> 3;
+      DstRed = Clamp5((((DstPixel >> 11) & 0x1F) * (31 - Alpha5)) / 31 + (Red >> 3));
+      DstGreen = Clamp6((((DstPixel >> 5) & 0x3F) * (63 - Alpha6)) / 63 + (SrcPixel.col.green >> 2));
+      DstBlue = Clamp5(((DstPixel & 0x1F) * (31 - Alpha5)) / 31 + (Blue >> 3));
+      *Dst++ = (USHORT)((DstRed << 11) | (DstGreen << 5) | DstBlue);
+    }
+  }
+}
+
+BOOLEAN
+DIB_AlphaBlendFast(SURFOBJ* Dest, SURFOBJ* Source, RECTL* DestRect,
+                   RECTL* SourceRect, XLATEOBJ* ColorTranslation,
+                   BLENDFUNCTION BlendFunc)
+{
+  LONG Width = DestRect->right - DestRect->left;
+  LONG Height = DestRect->bottom - DestRect->top;
+  PBYTE SrcLine, DstLine;
+  EXLATEOBJ* pexlo;
+  BOOLEAN Is555 = FALSE, SwapRB = FALSE;
+
+  if (Source->iBitmapFormat != BMF_32BPP ||
+      SourceRect->right - SourceRect->left != Width ||
+      SourceRect->bottom - SourceRect->top != Height)
+  {
+    return FALSE;
+  }
+
+  switch (Dest->iBitmapFormat)
+  {
+    case BMF_32BPP:
+    case BMF_24BPP:
+      if (ColorTranslation && !(ColorTranslation->flXlate & XO_TRIVIAL))
+        return FALSE;
+      break;
+
+    case BMF_16BPP:
+      if (!ColorTranslation)
+        return FALSE;
+
+      pexlo = CONTAINING_RECORD(ColorTranslation, EXLATEOBJ, xlo);
+      if (pexlo->ppalSrc->flFlags & PAL_BGR)
+        SwapRB = TRUE;
+      else if (!(pexlo->ppalSrc->flFlags & PAL_RGB))
+        return FALSE;
+
+      if (pexlo->ppalDst->flFlags & PAL_RGB16_555)
+        Is555 = TRUE;
+      else if (!(pexlo->ppalDst->flFlags & PAL_RGB16_565))
+        return FALSE;
+      break;
+
+    default:
+      return FALSE;
+  }
+
+  SrcLine = (PBYTE)Source->pvScan0 + SourceRect->top * Source->lDelta +
+            (SourceRect->left << 2);
+  DstLine = (PBYTE)Dest->pvScan0 + DestRect->top * Dest->lDelta +
+            DestRect->left * (BitsPerFormat(Dest->iBitmapFormat) >> 3);
+
+  while (Height-- > 0)
+  {
+    switch (Dest->iBitmapFormat)
+    {
+      case BMF_32BPP:
+        AlphaBlendRow32((PULONG)DstLine, (PULONG)SrcLine, Width, BlendFunc);
+        break;
+      case BMF_24BPP:
+        AlphaBlendRow24(DstLine, (PULONG)SrcLine, Width, BlendFunc);
+        break;
+      default:
+        AlphaBlendRow16((PUSHORT)DstLine, (PULONG)SrcLine, Width, BlendFunc,
+                        Is555, SwapRB);
+        break;
+    }
+
+    SrcLine += Source->lDelta;
+    DstLine += Dest->lDelta;
+  }
+
+  return TRUE;
+}
@@ -124,8 +124,10 @@ BOOLEAN DIB_32BPP_ColorFill(SURFOBJ*, RECTL*, ULONG);
 BOOLEAN DIB_32BPP_AlphaBlend(SURFOBJ*, SURFOBJ*, RECTL*, RECTL*, CLIPOBJ*, XLATEOBJ*, BLENDOBJ*);
 
 BOOLEAN DIB_XXBPP_StretchBlt(SURFOBJ*,SURFOBJ*,SURFOBJ*,SURFOBJ*,RECTL*,RECTL*,POINTL*,BRUSHOBJ*,POINTL*,XLATEOBJ*,ROP4);
+BOOLEAN DIB_XXBPP_StretchBltHalftone(SURFOBJ*,SURFOBJ*,RECTL*,RECTL*,XLATEOBJ*);
 BOOLEAN DIB_XXBPP_FloodFillSolid(SURFOBJ*, BRUSHOBJ*, RECTL*, POINTL*, ULONG, UINT);
 BOOLEAN DIB_XXBPP_AlphaBlend(SURFOBJ*, SURFOBJ*, RECTL*, RECTL*, CLIPOBJ*, XLATEOBJ*, BLENDOBJ*);
+BOOLEAN DIB_AlphaBlendFast(SURFOBJ*, SURFOBJ*, RECTL*, RECTL*, XLATEOBJ*, BLENDFUNCTION);
 
 extern unsigned char notmask[2];
 extern unsigned char altnotmask[2];
@@ -892,6 +892,9 @@ DIB_16BPP_AlphaBlend(SURFOBJ* Dest, SURFOBJ* Source, RECTL* DestRect,
     return FALSE;
   }
 
+  if (DIB_AlphaBlendFast(Dest, Source, DestRect, SourceRect, ColorTranslation, BlendFunc))
+    return TRUE;
+
   pexlo = CONTAINING_RECORD(ColorTranslation, EXLATEOBJ, xlo);
   EXLATEOBJ_vInitialize(&exloSrcRGB, pexlo->ppalSrc, &gpalRGB, 0, 0, 0);
 
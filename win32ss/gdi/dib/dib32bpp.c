@@ -797,6 +797,9 @@ DIB_32BPP_AlphaBlend(SURFOBJ* Dest, SURFOBJ* Source, RECTL* DestRect,
     return FALSE;
   }
 
+  if (DIB_AlphaBlendFast(Dest, Source, DestRect, SourceRect, ColorTranslation, BlendFunc))
+    return TRUE;
+
   Dst = (PULONG)((ULONG_PTR)Dest->pvScan0 + (DestRect->top * Dest->lDelta) +
     (DestRect->left << 2));
   SrcBpp = BitsPerFormat(Source->iBitmapFormat);
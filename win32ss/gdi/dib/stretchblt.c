@@ -14,6 +14,278 @@
 #define NDEBUG
 #include <debug.h>
 
+/*
+ * Pixel accessors for the byte-aligned formats, used to instantiate the
+ * unflipped SRCCOPY row scalers below for each source/destination pair.
+ */
+#define READ_PIXEL_8(pj, x)      ((ULONG)((PBYTE)(pj))[x])
+#define READ_PIXEL_16(pj, x)     ((ULONG)((PUSHORT)(pj))[x])
+#define READ_PIXEL_24(pj, x)     ((ULONG)(pj)[3 * (x)] | \
+                                  ((ULONG)(pj)[3 * (x) + 1] << 8) | \
+                                  ((ULONG)(pj)[3 * (x) + 2] << 16))
+#define READ_PIXEL_32(pj, x)     (((PULONG)(pj))[x])
+
+#define WRITE_PIXEL_8(pj, x, c)  (((PBYTE)(pj))[x] = (BYTE)(c))
+#define WRITE_PIXEL_16(pj, x, c) (((PUSHORT)(pj))[x] = (USHORT)(c))
+#define WRITE_PIXEL_24(pj, x, c) ((pj)[3 * (x)] = (BYTE)(c), \
+                                  (pj)[3 * (x) + 1] = (BYTE)((c) >> 8), \
+                                  (pj)[3 * (x) + 2] = (BYTE)((c) >> 16))
+#define WRITE_PIXEL_32(pj, x, c) (((PULONG)(pj))[x] = (c))
+
+typedef VOID (*PFN_STRETCH_ROW)(PBYTE, PBYTE, LONG, LONG, XLATEOBJ*);
+
+/*
+ * Source column i is SrcWidth * i / DstWidth, the same rounding as the
+ * generic loop. It is stepped with an integer DDA instead of a division
+ * per pixel.
+ */
+#define DEFINE_STRETCH_ROW(SrcBpp, DstBpp)                                  \
+static VOID                                                                 \
+StretchRow_##SrcBpp##_##DstBpp(PBYTE pjDest, PBYTE pjSource,                \
+                               LONG DstWidth, LONG SrcWidth,                \
+                               XLATEOBJ *pxlo)                              \
+{                                                                           \
+  LONG DesX, sx = 0, Error = 0;                                             \
+  LONG Step = SrcWidth / DstWidth, Remainder = SrcWidth % DstWidth;         \
+  ULONG Color;                                                              \
+                                                                            \
+  for (DesX = 0; DesX < DstWidth; DesX++)                                   \
+  {                                                                         \
+    Color = READ_PIXEL_##SrcBpp(pjSource, sx);                              \
+    if (pxlo)                                                               \
+      Color = XLATEOBJ_iXlate(pxlo, Color);                                 \
+    WRITE_PIXEL_##DstBpp(pjDest, DesX, Color);                              \
+                                                                            \
+    sx += Step;                                                             \
+    Error += Remainder;                                                     \
+    if (Error >= DstWidth)                                                  \
+    {                                                                       \
+      sx++;                                                                 \
+      Error -= DstWidth;                                                    \
+    }                                                                       \
+  }                                                                         \
+}
+
+#define DEFINE_STRETCH_ROWS(SrcBpp) \
+  DEFINE_STRETCH_ROW(SrcBpp, 8)     \
+  DEFINE_STRETCH_ROW(SrcBpp, 16)    \
+  DEFINE_STRETCH_ROW(SrcBpp, 24)    \
+  DEFINE_STRETCH_ROW(SrcBpp, 32)
+
+DEFINE_STRETCH_ROWS(8)
+DEFINE_STRETCH_ROWS(16)
+DEFINE_STRETCH_ROWS(24)
+DEFINE_STRETCH_ROWS(32)
+
+/* Indexed by [source][destination], in the order 8, 16, 24, 32bpp */
+static const PFN_STRETCH_ROW StretchRowFunctions[4][4] =
+{
+  { StretchRow_8_8,  StretchRow_8_16,  StretchRow_8_24,  StretchRow_8_32  },
+  { StretchRow_16_8, StretchRow_16_16, StretchRow_16_24, StretchRow_16_32 },
+  { StretchRow_24_8, StretchRow_24_16, StretchRow_24_24, StretchRow_24_32 },
+  { StretchRow_32_8, StretchRow_32_16, StretchRow_32_24, StretchRow_32_32 },
+};
+
+static INT
+StretchFormatIndex(ULONG iBitmapFormat)
+{
+  switch (iBitmapFormat)
+  {
+    case BMF_8BPP: return 0;
+    case BMF_16BPP: return 1;
+    case BMF_24BPP: return 2;
+    case BMF_32BPP: return 3;
+    default: return -1;
+  }
+}
+
+/* Unflipped, unmasked SRCCOPY from a source rectangle that lies within the surface */
+static BOOLEAN
+DIB_XXBPP_StretchBltSrcCopy(SURFOBJ *DestSurf, SURFOBJ *SourceSurf,
+                            RECTL *DestRect, RECTL *SourceRect,
+                            XLATEOBJ *ColorTranslation)
+{
+  INT SrcIndex, DstIndex;
+  PFN_STRETCH_ROW pfnStretchRow;
+  LONG DstWidth, DstHeight, SrcWidth, SrcHeight;
+  LONG DesY, sy, Step, Remainder, Error;
+  PBYTE pjSource, pjDest;
+
+  SrcIndex = StretchFormatIndex(SourceSurf->iBitmapFormat);
+  DstIndex = StretchFormatIndex(DestSurf->iBitmapFormat);
+  if (SrcIndex < 0 || DstIndex < 0)
+    return FALSE;
+
+  DstWidth = DestRect->right - DestRect->left;
+  DstHeight = DestRect->bottom - DestRect->top;
+  SrcWidth = SourceRect->right - SourceRect->left;
+  SrcHeight = SourceRect->bottom - SourceRect->top;
+
+  if (DstWidth <= 0 || DstHeight <= 0 || SrcWidth <= 0 || SrcHeight <= 0 ||
+      SourceRect->left < 0 || SourceRect->top < 0 ||
+      SourceRect->right > SourceSurf->sizlBitmap.cx ||
+      SourceRect->bottom > SourceSurf->sizlBitmap.cy)
+  {
+    return FALSE;
+  }
+
+  if (ColorTranslation && (ColorTranslation->flXlate & XO_TRIVIAL))
+    ColorTranslation = NULL;
+
+  pfnStretchRow = StretchRowFunctions[SrcIndex][DstIndex];
+
+  pjDest = (PBYTE)DestSurf->pvScan0 + DestRect->top * DestSurf->lDelta +
+           DestRect->left * BitsPerFormat(DestSurf->iBitmapFormat) / 8;
+
+  sy = SourceRect->top;
+  Step = SrcHeight / DstHeight;
+  Remainder = SrcHeight % DstHeight;
+  Error = 0;
+  for (DesY = 0; DesY < DstHeight; DesY++)
+  {
+    pjSource = (PBYTE)SourceSurf->pvScan0 + sy * SourceSurf->lDelta +
+               SourceRect->left * BitsPerFormat(SourceSurf->iBitmapFormat) / 8;
+
+    pfnStretchRow(pjDest, pjSource, DstWidth, SrcWidth, ColorTranslation);
+
+    pjDest += DestSurf->lDelta;
+    sy += Step;
+    Error += Remainder;
+    if (Error >= DstHeight)
+    {
+      sy++;
+      Error -= DstHeight;
+    }
+  }
+
+  return TRUE;
+}
+
+/* Source pixels contributing to one destination pixel along one axis */
+typedef struct _HALFTONE_TAP
+{
+  LONG First;
+  LONG Count;  /* Box filter: average of Count pixels from First */
+  ULONG Frac;  /* Bilinear filter: weight of First + 1, out of 256 */
+} HALFTONE_TAP, *PHALFTONE_TAP;
+
+static VOID
+HalftoneTap(LONG i, LONG SrcSize, LONG DstSize, PHALFTONE_TAP Tap)
+{
+  LONGLONG Pos;
+
+  if (SrcSize > DstSize)
+  {
+    /* Shrinking: average all the source pixels this one covers */
+    Tap->First = (LONG)((LONGLONG)i * SrcSize / DstSize);
+    Tap->Count = (LONG)((LONGLONG)(i + 1) * SrcSize / DstSize) - Tap->First;
+    Tap->Frac = 0;
+  }
+  else
+  {
+    /* Enlarging: interpolate between the two source pixels around the center */
+    Pos = (LONGLONG)(2 * i + 1) * SrcSize * 128 / DstSize - 128;
+    if (Pos < 0)
+      Pos = 0;
+
+    Tap->First = (LONG)(Pos >> 8);
+    Tap->Count = 1;
+    Tap->Frac = (ULONG)(Pos & 0xFF);
+    if (Tap->First >= SrcSize - 1)
+    {
+      Tap->First = SrcSize - 1;
+      Tap->Frac = 0;
+    }
+  }
+}
+
+#define HALFTONE_TAP_COUNT(Tap)     ((Tap)->Frac ? 2 : (Tap)->Count)
+#define HALFTONE_TAP_WEIGHT(Tap, k) ((Tap)->Frac ? ((k) ? (Tap)->Frac : 256 - (Tap)->Frac) : 1)
+#define HALFTONE_TAP_TOTAL(Tap)     ((Tap)->Frac ? 256 : (ULONG)(Tap)->Count)
+
+/*
+ * HALFTONE stretching for 24/32bpp surfaces sharing the same layout:
+ * each destination pixel is the box filtered average of the source pixels
+ * it covers when shrinking, and is bilinearly interpolated when enlarging.
+ */
+BOOLEAN
+DIB_XXBPP_StretchBltHalftone(SURFOBJ *DestSurf, SURFOBJ *SourceSurf,
+                             RECTL *DestRect, RECTL *SourceRect,
+                             XLATEOBJ *ColorTranslation)
+{
+  LONG DstWidth, DstHeight, SrcWidth, SrcHeight;
+  LONG DesX, DesY, ix, iy, c;
+  ULONG SrcBytes, DstBytes, Weight, Total, Sum[4];
+  PHALFTONE_TAP XTaps;
+  HALFTONE_TAP YTap;
+  PBYTE pjSource, pjDest;
+
+  if ((SourceSurf->iBitmapFormat != BMF_24BPP && SourceSurf->iBitmapFormat != BMF_32BPP) ||
+      (DestSurf->iBitmapFormat != BMF_24BPP && DestSurf->iBitmapFormat != BMF_32BPP) ||
+      (ColorTranslation && !(ColorTranslation->flXlate & XO_TRIVIAL)))
+  {
+    return FALSE;
+  }
+
+  DstWidth = DestRect->right - DestRect->left;
+  DstHeight = DestRect->bottom - DestRect->top;
+  SrcWidth = SourceRect->right - SourceRect->left;
+  SrcHeight = SourceRect->bottom - SourceRect->top;
+
+  /* Flipping is left to the generic code. Keep the sums within 32 bits. */
+  if (DstWidth <= 0 || DstHeight <= 0 || SrcWidth <= 0 || SrcHeight <= 0 ||
+      SrcWidth / DstWidth >= 256 || SrcHeight / DstHeight >= 256 ||
+      SourceRect->left < 0 || SourceRect->top < 0 ||
+      SourceRect->right > SourceSurf->sizlBitmap.cx ||
+      SourceRect->bottom > SourceSurf->sizlBitmap.cy)
+  {
+    return FALSE;
+  }
+
+  XTaps = ExAllocatePoolWithTag(PagedPool, DstWidth * sizeof(HALFTONE_TAP), TAG_DIB);
+  if (!XTaps)
+    return FALSE;
+
+  for (DesX = 0; DesX < DstWidth; DesX++)
+    HalftoneTap(DesX, SrcWidth, DstWidth, &XTaps[DesX]);
+
+  SrcBytes = BitsPerFormat(SourceSurf->iBitmapFormat) / 8;
+  DstBytes = BitsPerFormat(DestSurf->iBitmapFormat) / 8;
+
+  for (DesY = 0; DesY < DstHeight; DesY++)
+  {
+    HalftoneTap(DesY, SrcHeight, DstHeight, &YTap);
+    pjDest = (PBYTE)DestSurf->pvScan0 + (DestRect->top + DesY) * DestSurf->lDelta +
+             DestRect->left * DstBytes;
+
+    for (DesX = 0; DesX < DstWidth; DesX++, pjDest += DstBytes)
+    {
+      Sum[0] = Sum[1] = Sum[2] = Sum[3] = 0;
+
+      for (iy = 0; iy < HALFTONE_TAP_COUNT(&YTap); iy++)
+      {
+        pjSource = (PBYTE)SourceSurf->pvScan0 +
+                   (SourceRect->top + YTap.First + iy) * SourceSurf->lDelta +
+                   (SourceRect->left + XTaps[DesX].First) * SrcBytes;
+
+        for (ix = 0; ix < HALFTONE_TAP_COUNT(&XTaps[DesX]); ix++, pjSource += SrcBytes)
+        {
+          Weight = HALFTONE_TAP_WEIGHT(&YTap, iy) * HALFTONE_TAP_WEIGHT(&XTaps[DesX], ix);
+          for (c = 0; c < (LONG)SrcBytes; c++)
+            Sum[c] += Weight * pjSource[c];
+        }
+      }
+
+      Total = HALFTONE_TAP_TOTAL(&YTap) * HALFTONE_TAP_TOTAL(&XTaps[DesX]);
+      for (c = 0; c < (LONG)DstBytes; c++)
+        pjDest[c] = (BYTE)((Sum[c] + Total / 2) / Total);
+    }
+  }
+
+  ExFreePoolWithTag(XTaps, TAG_DIB);
+  return TRUE;
+}
+
 BOOLEAN DIB_XXBPP_StretchBlt(SURFOBJ *DestSurf, SURFOBJ *SourceSurf, SURFOBJ *MaskSurf,
                             SURFOBJ *PatternSurface,
                             RECTL *DestRect, RECTL *SourceRect,
@@ -137,6 +409,14 @@ BOOLEAN DIB_XXBPP_StretchBlt(SURFOBJ *DestSurf, SURFOBJ *SourceSurf, SURFOBJ *Ma
 
   DPRINT("bLeftToRight is '%d' and bTopToBottom is '%d'.\n", bLeftToRight, bTopToBottom);
 
+  /* Plain copies don't need the per-pixel ROP machinery */
+  if (ROP == ROP4_SRCCOPY && !MaskSurf && !bLeftToRight && !bTopToBottom &&
+      DIB_XXBPP_StretchBltSrcCopy(DestSurf, SourceSurf, DestRect, SourceRect,
+                                  ColorTranslation))
+  {
+    return TRUE;
+  }
+
   for (DesY = DestRect->top; DesY < DestRect->bottom; DesY++)
   {
     if (PatternSurface)
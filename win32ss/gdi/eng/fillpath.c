@@ -0,0 +1,570 @@
+/*
+ * PROJECT:     ReactOS Win32k subsystem
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Scanline rasterizer for EngFillPath and EngStrokePath
+ * FILE:        win32ss/gdi/eng/fillpath.c
+ */
+
+#include <win32k.h>
+
+#define NDEBUG
+#include <debug.h>
+
+/* Number of spans collected before they are handed to IntEngFillSpans */
+#define FILLPATH_SPAN_BATCH 64
+
+/* First pixel row/column whose center lies at or after a FIX coordinate */
+#define FIX_TO_FIRST_PIXEL(fx) (((fx) - 8 + 15) >> 4)
+
+/* Same, for the FIX << 16 x coordinates of the edges */
+#define EDGE_X_TO_FIRST_PIXEL(x) ((LONG)(((x) - (8 << 16) + (16 << 16) - 1) >> 20))
+
+/* Edge of a flattened path, stepped from one scanline center to the next */
+typedef struct _FILLPATH_EDGE
+{
+    LONG yTop;          /* First scanline crossed */
+    LONG yBottom;       /* Scanline after the last one crossed */
+    LONGLONG x;         /* X at the current scanline center, FIX << 16 */
+    LONGLONG dx;        /* X increment per scanline, FIX << 16 */
+    LONG lWinding;      /* +1 for edges going down, -1 for edges going up */
+} FILLPATH_EDGE, *PFILLPATH_EDGE;
+
+typedef struct _FILLPATH_CONTEXT
+{
+    PFILLPATH_EDGE pEdges;
+    ULONG cEdges;
+    ULONG cMaxEdges;
+    LONG yMin;
+    LONG yMax;
+    RECTL rclBounds;    /* Rows and columns that can be touched */
+} FILLPATH_CONTEXT, *PFILLPATH_CONTEXT;
+
+typedef BOOL (*PFN_PATH_LINE)(PVOID Context, POINTFIX ptfxFrom, POINTFIX ptfxTo);
+
+/*
+ * Fills spans of height 1, sorted by row, with a brush. Solid fills of
+ * engine managed bitmaps are written with the DIB line functions after
+ * clipping all the spans at once; anything else goes through
+ * IntEngBitBlt span by span.
+ */
+BOOL
+APIENTRY
+IntEngFillSpans(
+    _Inout_ SURFOBJ *psoDest,
+    _In_ CLIPOBJ *pco,
+    _In_ BRUSHOBJ *pbo,
+    _In_ POINTL *pptlBrushOrg,
+    _In_ ROP4 rop4,
+    _In_reads_(cSpans) RECTL *prclSpans,
+    _In_ ULONG cSpans)
+{
+    SURFACE *psurfDest = CONTAINING_RECORD(psoDest, SURFACE, SurfObj);
+    PFN_DIB_HLine pfnHLine;
+    RECT_ENUM RectEnum;
+    RECTL rclClip;
+    BOOL bEnumMore;
+    ULONG i, j, iFirst;
+    LONG left, right;
+
+    if (cSpans == 0)
+        return TRUE;
+
+    if (psoDest->iType != STYPE_BITMAP ||
+        (psurfDest->flags & HOOK_BITBLT) ||
+        pbo->iSolidColor == 0xFFFFFFFF ||
+        rop4 != ROP4_FROM_INDEX(R3_OPINDEX_PATCOPY))
+    {
+        for (i = 0; i < cSpans; i++)
+        {
+            IntEngBitBlt(psoDest, NULL, NULL, pco, NULL, &prclSpans[i], NULL,
+                         NULL, pbo, pptlBrushOrg, rop4);
+        }
+        return TRUE;
+    }
+
+    pfnHLine = DibFunctionsForBitmapFormat[psoDest->iBitmapFormat].DIB_HLine;
+
+    if (!pco || pco->iDComplexity == DC_TRIVIAL)
+    {
+        rclClip.left = 0;
+        rclClip.top = 0;
+        rclClip.right = psoDest->sizlBitmap.cx;
+        rclClip.bottom = psoDest->sizlBitmap.cy;
+
+        for (i = 0; i < cSpans; i++)
+        {
+            left = max(prclSpans[i].left, rclClip.left);
+            right = min(prclSpans[i].right, rclClip.right);
+            if (left < right &&
+                prclSpans[i].top >= rclClip.top && prclSpans[i].top < rclClip.bottom)
+            {
+                pfnHLine(psoDest, left, right, prclSpans[i].top, pbo->iSolidColor);
+            }
+        }
+        return TRUE;
+    }
+
+    /* Walk the clip rectangles once, visiting only the spans in their rows */
+    CLIPOBJ_cEnumStart(pco, FALSE, CT_RECTANGLES, CD_RIGHTDOWN, 0);
+    do
+    {
+        bEnumMore = CLIPOBJ_bEnum(pco, (ULONG)sizeof(RectEnum), (PVOID)&RectEnum);
+        for (j = 0; j < RectEnum.c; j++)
+        {
+            rclClip = RectEnum.arcl[j];
+
+            /* Binary search for the first span at or below the rectangle's top */
+            i = 0;
+            iFirst = cSpans;
+            while (i < iFirst)
+            {
+                ULONG iMid = (i + iFirst) / 2;
+                if (prclSpans[iMid].top < rclClip.top)
+                    i = iMid + 1;
+                else
+                    iFirst = iMid;
+            }
+
+            for (i = iFirst; i < cSpans && prclSpans[i].top < rclClip.bottom; i++)
+            {
+                left = max(prclSpans[i].left, rclClip.left);
+                right = min(prclSpans[i].right, rclClip.right);
+                if (left < right)
+                    pfnHLine(psoDest, left, right, prclSpans[i].top, pbo->iSolidColor);
+            }
+        }
+    }
+    while (bEnumMore);
+
+    return TRUE;
+}
+
+static BOOL
+FillPathAddEdge(
+    _Inout_ PVOID Context,
+    _In_ POINTFIX ptfxFrom,
+    _In_ POINTFIX ptfxTo)
+{
+    PFILLPATH_CONTEXT pfpc = Context;
+    PFILLPATH_EDGE pEdge, pNewEdges;
+    POINTFIX ptfxTmp;
+    LONG lWinding = 1;
+    LONG yTop, yBottom;
+
+    if (ptfxFrom.y == ptfxTo.y)
+        return TRUE;
+
+    if (ptfxFrom.y > ptfxTo.y)
+    {
+        ptfxTmp = ptfxFrom;
+        ptfxFrom = ptfxTo;
+        ptfxTo = ptfxTmp;
+        lWinding = -1;
+    }
+
+    yTop = FIX_TO_FIRST_PIXEL(ptfxFrom.y);
+    yBottom = FIX_TO_FIRST_PIXEL(ptfxTo.y);
+
+    /* Skip edges that don't cross any visible scanline center */
+    yTop = max(yTop, pfpc->rclBounds.top);
+    yBottom = min(yBottom, pfpc->rclBounds.bottom);
+    if (yTop >= yBottom)
+        return TRUE;
+
+    if (pfpc->cEdges == pfpc->cMaxEdges)
+    {
+        pfpc->cMaxEdges = pfpc->cMaxEdges ? 2 * pfpc->cMaxEdges : 64;
+        pNewEdges = ExAllocatePoolWithTag(PagedPool,
+                                          pfpc->cMaxEdges * sizeof(FILLPATH_EDGE),
+                                          GDITAG_TEMP);
+        if (!pNewEdges)
+            return FALSE;
+
+        if (pfpc->pEdges)
+        {
+            RtlCopyMemory(pNewEdges, pfpc->pEdges, pfpc->cEdges * sizeof(FILLPATH_EDGE));
+            ExFreePoolWithTag(pfpc->pEdges, GDITAG_TEMP);
+        }
+        pfpc->pEdges = pNewEdges;
+    }
+
+    pEdge = &pfpc->pEdges[pfpc->cEdges++];
+    pEdge->yTop = yTop;
+    pEdge->yBottom = yBottom;
+    pEdge->lWinding = lWinding;
+    pEdge->dx = ((LONGLONG)(ptfxTo.x - ptfxFrom.x) << 20) / (ptfxTo.y - ptfxFrom.y);
+    pEdge->x = ((LONGLONG)ptfxFrom.x << 16) +
+               pEdge->dx * (yTop * 16 + 8 - ptfxFrom.y) / 16;
+
+    pfpc->yMin = min(pfpc->yMin, yTop);
+    pfpc->yMax = max(pfpc->yMax, yBottom);
+    return TRUE;
+}
+
+static BOOL
+PathLineBezier(
+    _In_ PFN_PATH_LINE pfnLine,
+    _Inout_ PVOID Context,
+    _In_reads_(4) const POINTFIX *pptfx)
+{
+    LONGLONG n, n3, a, b;
+    LONG i, cSteps;
+    ULONG ulLength;
+    POINTFIX ptfxPrev, ptfx;
+
+    /* Roughly one segment per 4 pixels of control polygon */
+    ulLength = abs(pptfx[1].x - pptfx[0].x) + abs(pptfx[1].y - pptfx[0].y) +
+               abs(pptfx[2].x - pptfx[1].x) + abs(pptfx[2].y - pptfx[1].y) +
+               abs(pptfx[3].x - pptfx[2].x) + abs(pptfx[3].y - pptfx[2].y);
+    cSteps = (LONG)min(ulLength / 64 + 1, 64);
+
+    n = cSteps;
+    n3 = n * n * n;
+    ptfxPrev = pptfx[0];
+    for (i = 1; i <= cSteps; i++)
+    {
+        a = n - i;
+        b = i;
+        ptfx.x = (FIX)((a * a * a * pptfx[0].x + 3 * a * a * b * pptfx[1].x +
+                        3 * a * b * b * pptfx[2].x + b * b * b * pptfx[3].x) / n3);
+        ptfx.y = (FIX)((a * a * a * pptfx[0].y + 3 * a * a * b * pptfx[1].y +
+                        3 * a * b * b * pptfx[2].y + b * b * b * pptfx[3].y) / n3);
+        if (!pfnLine(Context, ptfxPrev, ptfx))
+            return FALSE;
+        ptfxPrev = ptfx;
+    }
+
+    return TRUE;
+}
+
+/*
+ * Enumerates the path as straight lines, flattening the Bezier curves.
+ * When bCloseAll is set every figure is closed, as needed for filling;
+ * otherwise only figures marked with PD_CLOSEFIGURE are.
+ */
+static BOOL
+PathEnumLines(
+    _In_ PATHOBJ *ppo,
+    _In_ BOOL bCloseAll,
+    _In_ PFN_PATH_LINE pfnLine,
+    _Inout_ PVOID Context)
+{
+    PATHDATA pd;
+    POINTFIX ptfxStart = {0, 0}, ptfxCurrent = {0, 0}, aptfx[4];
+    BOOL bMore, bFigure = FALSE;
+    ULONG i;
+
+    PATHOBJ_vEnumStart(ppo);
+    do
+    {
+        pd.count = 0;
+        pd.flags = 0;
+        bMore = PATHOBJ_bEnum(ppo, &pd);
+        if (pd.count == 0)
+            continue;
+
+        i = 0;
+        if (pd.flags & PD_BEGINSUBPATH)
+        {
+            if (bFigure && bCloseAll && !pfnLine(Context, ptfxCurrent, ptfxStart))
+                return FALSE;
+
+            ptfxStart = ptfxCurrent = pd.pptfx[0];
+            bFigure = TRUE;
+            i = 1;
+        }
+
+        if (pd.flags & PD_BEZIERS)
+        {
+            for (; i + 2 < pd.count; i += 3)
+            {
+                aptfx[0] = ptfxCurrent;
+                aptfx[1] = pd.pptfx[i];
+                aptfx[2] = pd.pptfx[i + 1];
+                aptfx[3] = pd.pptfx[i + 2];
+                if (!PathLineBezier(pfnLine, Context, aptfx))
+                    return FALSE;
+                ptfxCurrent = aptfx[3];
+            }
+        }
+        else
+        {
+            for (; i < pd.count; i++)
+            {
+                if (!pfnLine(Context, ptfxCurrent, pd.pptfx[i]))
+                    return FALSE;
+                ptfxCurrent = pd.pptfx[i];
+            }
+        }
+
+        if (pd.flags & PD_ENDSUBPATH)
+        {
+            if ((bCloseAll || (pd.flags & PD_CLOSEFIGURE)) &&
+                !pfnLine(Context, ptfxCurrent, ptfxStart))
+            {
+                return FALSE;
+            }
+            bFigure = FALSE;
+        }
+    }
+    while (bMore);
+
+    if (bFigure && bCloseAll)
+        return pfnLine(Context, ptfxCurrent, ptfxStart);
+
+    return TRUE;
+}
+
+static int __cdecl
+CompareEdgeTop(const void *p1, const void *p2)
+{
+    const FILLPATH_EDGE *pEdge1 = p1, *pEdge2 = p2;
+
+    return (pEdge1->yTop > pEdge2->yTop) - (pEdge1->yTop < pEdge2->yTop);
+}
+
+/*
+ * Fills the edges with an active edge table. Pixels are filled when their
+ * center is inside the path, using the alternate or the winding rule.
+ */
+static BOOL
+FillPathRasterize(
+    _Inout_ PFILLPATH_CONTEXT pfpc,
+    _Inout_ SURFOBJ *pso,
+    _In_ CLIPOBJ *pco,
+    _In_ BRUSHOBJ *pbo,
+    _In_ POINTL *pptlBrushOrg,
+    _In_ ROP4 rop4,
+    _In_ BOOL bWinding)
+{
+    PFILLPATH_EDGE *ppActive, pEdge;
+    RECTL arclSpans[FILLPATH_SPAN_BATCH];
+    ULONG cActive, cSpans, iNext, i, j;
+    LONG y, lWinding, left, right;
+    LONGLONG xStart = 0;
+    BOOL bInside, bWasInside;
+
+    if (pfpc->cEdges == 0)
+        return TRUE;
+
+    ppActive = ExAllocatePoolWithTag(PagedPool, pfpc->cEdges * sizeof(PFILLPATH_EDGE), GDITAG_TEMP);
+    if (!ppActive)
+        return FALSE;
+
+    EngSort((PBYTE)pfpc->pEdges, sizeof(FILLPATH_EDGE), pfpc->cEdges, CompareEdgeTop);
+
+    cActive = 0;
+    cSpans = 0;
+    iNext = 0;
+    for (y = pfpc->yMin; y < pfpc->yMax; y++)
+    {
+        /* Drop the edges that ended, then add the ones starting here */
+        for (i = j = 0; i < cActive; i++)
+        {
+            if (ppActive[i]->yBottom > y)
+                ppActive[j++] = ppActive[i];
+        }
+        cActive = j;
+
+        while (iNext < pfpc->cEdges && pfpc->pEdges[iNext].yTop <= y)
+            ppActive[cActive++] = &pfpc->pEdges[iNext++];
+
+        if (cActive == 0)
+        {
+            if (iNext == pfpc->cEdges)
+                break;
+
+            /* Jump over the empty rows */
+            y = pfpc->pEdges[iNext].yTop - 1;
+            continue;
+        }
+
+        /* The order changes little from one row to the next */
+        for (i = 1; i < cActive; i++)
+        {
+            pEdge = ppActive[i];
+            for (j = i; j > 0 && ppActive[j - 1]->x > pEdge->x; j--)
+                ppActive[j] = ppActive[j - 1];
+            ppActive[j] = pEdge;
+        }
+
+        lWinding = 0;
+        bWasInside = FALSE;
+        for (i = 0; i < cActive; i++)
+        {
+            pEdge = ppActive[i];
+            lWinding += bWinding ? pEdge->lWinding : 1;
+            bInside = bWinding ? (lWinding != 0) : (lWinding & 1);
+
+            if (bInside && !bWasInside)
+            {
+                xStart = pEdge->x;
+            }
+            else if (!bInside && bWasInside)
+            {
+                left = EDGE_X_TO_FIRST_PIXEL(xStart);
+                right = EDGE_X_TO_FIRST_PIXEL(pEdge->x);
+                left = max(left, pfpc->rclBounds.left);
+                right = min(right, pfpc->rclBounds.right);
+                if (left < right)
+                {
+                    arclSpans[cSpans].left = left;
+                    arclSpans[cSpans].top = y;
+                    arclSpans[cSpans].right = right;
+                    arclSpans[cSpans].bottom = y + 1;
+                    if (++cSpans == FILLPATH_SPAN_BATCH)
+                    {
+                        IntEngFillSpans(pso, pco, pbo, pptlBrushOrg, rop4, arclSpans, cSpans);
+                        cSpans = 0;
+                    }
+                }
+            }
+            bWasInside = bInside;
+
+            pEdge->x += pEdge->dx;
+        }
+    }
+
+    IntEngFillSpans(pso, pco, pbo, pptlBrushOrg, rop4, arclSpans, cSpans);
+
+    ExFreePoolWithTag(ppActive, GDITAG_TEMP);
+    return TRUE;
+}
+
+/*
+ * @implemented
+ */
+BOOL
+APIENTRY
+EngFillPath(
+    IN SURFOBJ   *pso,
+    IN PATHOBJ   *ppo,
+    IN CLIPOBJ   *pco,
+    IN BRUSHOBJ  *pbo,
+    IN POINTL    *pptlBrushOrg,
+    IN MIX        mix,
+    IN FLONG      flOptions)
+{
+    FILLPATH_CONTEXT fpc;
+    BOOL bResult;
+
+    RtlZeroMemory(&fpc, sizeof(fpc));
+    fpc.yMin = MAXLONG;
+    fpc.yMax = MINLONG;
+
+    if (!pco || pco->iDComplexity == DC_TRIVIAL)
+    {
+        fpc.rclBounds.right = pso->sizlBitmap.cx;
+        fpc.rclBounds.bottom = pso->sizlBitmap.cy;
+    }
+    else
+    {
+        fpc.rclBounds = pco->rclBounds;
+    }
+
+    bResult = PathEnumLines(ppo, TRUE, FillPathAddEdge, &fpc);
+    if (bResult)
+    {
+        bResult = FillPathRasterize(&fpc, pso, pco, pbo, pptlBrushOrg,
+                                    MIX_TO_ROP4(mix),
+                                    (flOptions & FP_WINDINGMODE) != 0);
+    }
+
+    if (fpc.pEdges)
+        ExFreePoolWithTag(fpc.pEdges, GDITAG_TEMP);
+
+    return bResult;
+}
+
+typedef struct _STROKEPATH_CONTEXT
+{
+    SURFOBJ *pso;
+    CLIPOBJ *pco;
+    BRUSHOBJ *pbo;
+    MIX mix;
+} STROKEPATH_CONTEXT, *PSTROKEPATH_CONTEXT;
+
+static BOOL
+StrokePathLine(
+    _Inout_ PVOID Context,
+    _In_ POINTFIX ptfxFrom,
+    _In_ POINTFIX ptfxTo)
+{
+    PSTROKEPATH_CONTEXT pspc = Context;
+    RECTL rclBounds;
+    LONG x1 = (ptfxFrom.x + 8) >> 4, y1 = (ptfxFrom.y + 8) >> 4;
+    LONG x2 = (ptfxTo.x + 8) >> 4, y2 = (ptfxTo.y + 8) >> 4;
+
+    rclBounds.left = min(x1, x2);
+    rclBounds.top = min(y1, y2);
+    rclBounds.right = max(x1, x2) + 1;
+    rclBounds.bottom = max(y1, y2) + 1;
+
+    return IntEngLineTo(pspc->pso, pspc->pco, pspc->pbo, x1, y1, x2, y2,
+                        &rclBounds, pspc->mix);
+}
+
+/*
+ * @implemented
+ */
+BOOL
+APIENTRY
+EngStrokePath(
+    IN SURFOBJ  *pso,
+    IN PATHOBJ  *ppo,
+    IN CLIPOBJ  *pco,
+    IN XFORMOBJ  *pxo,
+    IN BRUSHOBJ  *pbo,
+    IN POINTL  *pptlBrushOrg,
+    IN LINEATTRS  *plineattrs,
+    IN MIX  mix)
+{
+    STROKEPATH_CONTEXT spc;
+
+    /* Wide lines are widened into a path and filled by GDI */
+    if (plineattrs && (plineattrs->fl & LA_GEOMETRIC))
+    {
+        DPRINT1("Geometric lines are not supported\n");
+        return FALSE;
+    }
+
+    /* Only solid lines are drawn here, let the caller style the others */
+    if (plineattrs &&
+        ((plineattrs->fl & (LA_STYLED | LA_ALTERNATE)) || plineattrs->pstyle))
+    {
+        DPRINT1("Styled lines are not supported\n");
+        return FALSE;
+    }
+
+    spc.pso = pso;
+    spc.pco = pco;
+    spc.pbo = pbo;
+    spc.mix = mix;
+    return PathEnumLines(ppo, FALSE, StrokePathLine, &spc);
+}
+
+/*
+ * @implemented
+ */
+BOOL
+APIENTRY
+EngStrokeAndFillPath(
+    IN SURFOBJ  *pso,
+    IN PATHOBJ  *ppo,
+    IN CLIPOBJ  *pco,
+    IN XFORMOBJ  *pxo,
+    IN BRUSHOBJ  *pboStroke,
+    IN LINEATTRS  *plineattrs,
+    IN BRUSHOBJ  *pboFill,
+    IN POINTL  *pptlBrushOrg,
+    IN MIX  mixFill,
+    IN FLONG  flOptions)
+{
+    if (!EngFillPath(pso, ppo, pco, pboFill, pptlBrushOrg, mixFill, flOptions))
+        return FALSE;
+
+    return EngStrokePath(pso, ppo, pco, pxo, pboStroke, pptlBrushOrg,
+                         plineattrs, ROP2_TO_MIX(R2_COPYPEN));
+}
+
+/* EOF */
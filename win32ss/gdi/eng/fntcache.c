@@ -0,0 +1,219 @@
+/*
+ * PROJECT:     ReactOS Win32k subsystem
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Engine font cache for font, display and printer drivers
+ * FILE:        win32ss/gdi/eng/fntcache.c
+ */
+
+#include <win32k.h>
+
+#define NDEBUG
+#include <debug.h>
+
+/*
+ * Drivers store blocks of data (typically rasterized glyphs) under a fast
+ * checksum they compute themselves, and look them up again on later calls.
+ * The API gives drivers no way to release a pointer, so, as with the
+ * font cache file of Windows, a block stays pinned for the rest of the
+ * session once it has been handed out. The cache has a memory budget:
+ * when it is used up, new blocks are refused and drivers render the
+ * data themselves, as they have to for any block the cache doesn't have.
+ */
+
+#define FNTCACHE_BUCKETS        256
+#define FNTCACHE_MAX_BYTES      (4 * 1024 * 1024)
+#define FNTCACHE_MAX_FAULTS     16      /* faults before the cache is turned off */
+#define FNTCACHE_FAULT_PERIOD   60000   /* ms the faults are counted over */
+
+typedef struct _FNTCACHE_ENTRY
+{
+    LIST_ENTRY HashEntry;
+    ULONG ulFastCheckSum;
+    ULONG cjSize;
+    LONGLONG ajData[1];                 /* Keeps the data 8 byte aligned */
+} FNTCACHE_ENTRY, *PFNTCACHE_ENTRY;
+
+static HSEMAPHORE ghsemFntCache;
+static LIST_ENTRY gFntCacheBuckets[FNTCACHE_BUCKETS];
+static LIST_ENTRY gFntCacheFaulted;     /* Out of the lookups, still pinned */
+static SIZE_T gcjFntCache;
+static ULONG gcFntCacheFaults;
+static ULONGLONG gullFntCacheFaultPeriod;
+static BOOL gbFntCacheDisabled;
+
+#define FNTCACHE_BUCKET(ulFastCheckSum) \
+    (&gFntCacheBuckets[((ulFastCheckSum) * 2654435761u) >> 24])
+
+CODE_SEG("INIT")
+NTSTATUS
+NTAPI
+InitFontCacheImpl(VOID)
+{
+    ULONG i;
+
+    ghsemFntCache = EngCreateSemaphore();
+    if (!ghsemFntCache) return STATUS_INSUFFICIENT_RESOURCES;
+
+    for (i = 0; i < FNTCACHE_BUCKETS; i++)
+        InitializeListHead(&gFntCacheBuckets[i]);
+    InitializeListHead(&gFntCacheFaulted);
+
+    return STATUS_SUCCESS;
+}
+
+static
+PFNTCACHE_ENTRY
+FntCacheFind(
+    _In_ ULONG ulFastCheckSum)
+{
+    PLIST_ENTRY pBucket, pEntry;
+    PFNTCACHE_ENTRY pfce;
+
+    pBucket = FNTCACHE_BUCKET(ulFastCheckSum);
+    for (pEntry = pBucket->Flink; pEntry != pBucket; pEntry = pEntry->Flink)
+    {
+        pfce = CONTAINING_RECORD(pEntry, FNTCACHE_ENTRY, HashEntry);
+        if (pfce->ulFastCheckSum == ulFastCheckSum)
+            return pfce;
+    }
+
+    return NULL;
+}
+
+/* Starts counting the faults again once the period is over */
+static
+VOID
+FntCacheCheckFaultPeriod(VOID)
+{
+    ULONGLONG ullNow = EngGetTickCount();
+
+    if (ullNow - gullFntCacheFaultPeriod < FNTCACHE_FAULT_PERIOD)
+        return;
+
+    gullFntCacheFaultPeriod = ullNow;
+    gcFntCacheFaults = 0;
+    if (gbFntCacheDisabled)
+    {
+        DPRINT1("Enabling the font cache again\n");
+        gbFntCacheDisabled = FALSE;
+    }
+}
+
+/*
+ * @implemented
+ */
+_Must_inspect_result_
+_Ret_opt_bytecap_(cjSize)
+ENGAPI
+PVOID
+APIENTRY
+EngFntCacheAlloc(
+    _In_ ULONG ulFastCheckSum,
+    _In_ ULONG cjSize)
+{
+    PFNTCACHE_ENTRY pfce;
+    PVOID pvData = NULL;
+
+    if (cjSize == 0 || cjSize > FNTCACHE_MAX_BYTES / 4)
+        return NULL;
+
+    EngAcquireSemaphore(ghsemFntCache);
+
+    FntCacheCheckFaultPeriod();
+    if (gbFntCacheDisabled)
+        goto Exit;
+
+    pfce = FntCacheFind(ulFastCheckSum);
+    if (pfce)
+    {
+        /* The caller is going to write the same block again */
+        if (pfce->cjSize == cjSize)
+            pvData = pfce->ajData;
+        goto Exit;
+    }
+
+    if (gcjFntCache + cjSize > FNTCACHE_MAX_BYTES)
+    {
+        DPRINT("Font cache is full, not caching 0x%lx\n", ulFastCheckSum);
+        goto Exit;
+    }
+
+    pfce = ExAllocatePoolWithTag(PagedPool,
+                                 FIELD_OFFSET(FNTCACHE_ENTRY, ajData) + cjSize,
+                                 GDITAG_FONTCACHE);
+    if (!pfce)
+        goto Exit;
+
+    pfce->ulFastCheckSum = ulFastCheckSum;
+    pfce->cjSize = cjSize;
+    InsertHeadList(FNTCACHE_BUCKET(ulFastCheckSum), &pfce->HashEntry);
+    gcjFntCache += cjSize;
+    pvData = pfce->ajData;
+
+Exit:
+    EngReleaseSemaphore(ghsemFntCache);
+    return pvData;
+}
+
+/*
+ * @implemented
+ */
+VOID
+APIENTRY
+EngFntCacheFault(
+    _In_ ULONG ulFastCheckSum,
+    _In_ ULONG iFaultMode)
+{
+    PFNTCACHE_ENTRY pfce;
+
+    EngAcquireSemaphore(ghsemFntCache);
+
+    /*
+     * The block could not be read back or written, it's useless now.
+     * Drivers may still hold it, so it is only taken out of the lookups.
+     */
+    pfce = FntCacheFind(ulFastCheckSum);
+    if (pfce)
+    {
+        RemoveEntryList(&pfce->HashEntry);
+        InsertTailList(&gFntCacheFaulted, &pfce->HashEntry);
+    }
+
+    FntCacheCheckFaultPeriod();
+    if (++gcFntCacheFaults >= FNTCACHE_MAX_FAULTS && !gbFntCacheDisabled)
+    {
+        DPRINT1("Too many font cache faults (last mode %lu), disabling the cache\n",
+                iFaultMode);
+        gbFntCacheDisabled = TRUE;
+    }
+
+    EngReleaseSemaphore(ghsemFntCache);
+}
+
+/*
+ * @implemented
+ */
+PVOID
+APIENTRY
+EngFntCacheLookUp(
+    _In_ ULONG FastCheckSum,
+    _Out_ PULONG pulSize)
+{
+    PFNTCACHE_ENTRY pfce;
+    PVOID pvData = NULL;
+
+    *pulSize = 0;
+
+    EngAcquireSemaphore(ghsemFntCache);
+
+    pfce = FntCacheFind(FastCheckSum);
+    if (pfce)
+    {
+        *pulSize = pfce->cjSize;
+        pvData = pfce->ajData;
+    }
+
+    EngReleaseSemaphore(ghsemFntCache);
+
+    return pvData;
+}
@@ -68,6 +68,15 @@ IntEngLineTo(SURFOBJ *Surface,
              RECTL *RectBounds,
              MIX mix);
 
+BOOL APIENTRY
+IntEngFillSpans(SURFOBJ *psoDest,
+                CLIPOBJ *pco,
+                BRUSHOBJ *pbo,
+                POINTL *pptlBrushOrg,
+                ROP4 rop4,
+                RECTL *prclSpans,
+                ULONG cSpans);
+
 BOOL APIENTRY
 IntEngBitBlt(SURFOBJ *DestObj,
                SURFOBJ *SourceObj,
@@ -91,9 +100,10 @@ IntEngStretchBlt(SURFOBJ *DestObj,
                  RECTL *DestRect,
                  RECTL *SourceRect,
                  POINTL *pMaskOrigin,
+                 ULONG Mode,
                  BRUSHOBJ *Brush,
                  POINTL *BrushOrigin,
-                 ULONG Mode);
+                 DWORD Rop4);
 
 BOOL APIENTRY
 IntEngGradientFill(SURFOBJ *psoDest,
@@ -165,3 +175,8 @@ IntEngCopyBits(SURFOBJ *psoDest,
 	    XLATEOBJ *pxlo,
 	    RECTL *prclDest,
 	    POINTL *ptlSource);
+
+CODE_SEG("INIT")
+NTSTATUS
+NTAPI
+InitFontCacheImpl(VOID);
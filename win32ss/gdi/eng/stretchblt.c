@@ -36,6 +36,7 @@ typedef BOOLEAN (APIENTRY *PSTRETCHRECTFUNC)(SURFOBJ* OutputObj,
                                             POINTL* MaskOrigin,
                                             BRUSHOBJ* pbo,
                                             POINTL* BrushOrigin,
+                                            ULONG Mode,
                                             ROP4 Rop4);
 
 static BOOLEAN APIENTRY
@@ -48,6 +49,7 @@ CallDibStretchBlt(SURFOBJ* psoDest,
                   POINTL* MaskOrigin,
                   BRUSHOBJ* pbo,
                   POINTL* BrushOrigin,
+                  ULONG Mode,
                   ROP4 Rop4)
 {
     POINTL RealBrushOrigin;
@@ -80,6 +82,14 @@ CallDibStretchBlt(SURFOBJ* psoDest,
         psoPattern = NULL;
     }
 
+    /* Filter plain copies when asked to, if the formats allow it */
+    if (Mode == HALFTONE && Rop4 == ROP4_SRCCOPY && !Mask &&
+        DIB_XXBPP_StretchBltHalftone(psoDest, psoSource, OutputRect, InputRect,
+                                     ColorTranslation))
+    {
+        return TRUE;
+    }
+
     bResult = DibFunctionsForBitmapFormat[psoDest->iBitmapFormat].DIB_StretchBlt(
                psoDest, psoSource, Mask, psoPattern,
                OutputRect, InputRect, MaskOrigin, pbo, &RealBrushOrigin,
@@ -312,7 +322,7 @@ EngStretchBltROP(
 
             Ret = (*BltRectFunc)(psoOutput, psoInput, Mask,
                          ColorTranslation, &OutputRect, &InputRect, MaskOrigin,
-                         pbo, &AdjustedBrushOrigin, Rop4);
+                         pbo, &AdjustedBrushOrigin, Mode, Rop4);
             break;
         case DC_RECT:
             // Clip the blt to the clip rectangle
@@ -351,6 +361,7 @@ EngStretchBltROP(
                            MaskOrigin,
                            pbo,
                            &AdjustedBrushOrigin,
+                           Mode,
                            Rop4);
             }
             break;
@@ -414,6 +425,7 @@ EngStretchBltROP(
                            MaskOrigin,
                            pbo,
                            &AdjustedBrushOrigin,
+                           Mode,
                            Rop4);
                     }
                 }
@@ -475,6 +487,7 @@ IntEngStretchBlt(SURFOBJ *psoDest,
                  RECTL *DestRect,
                  RECTL *SourceRect,
                  POINTL *pMaskOrigin,
+                 ULONG Mode,
                  BRUSHOBJ *pbo,
                  POINTL *BrushOrigin,
                  DWORD Rop4)
@@ -808,7 +821,7 @@ IntEngStretchBlt(SURFOBJ *psoDest,
                                                  &OutputRect,
                                                  &InputRect,
                                                  &MaskOrigin,
-                                                 COLORONCOLOR,
+                                                 Mode,
                                                  pbo,
                                                  Rop4);
     }
@@ -844,7 +857,7 @@ IntEngStretchBlt(SURFOBJ *psoDest,
                                &OutputRect,
                                &InputRect,
                                &MaskOrigin,
-                               COLORONCOLOR,
+                               Mode,
                                pbo,
                                Rop4);
     }
@@ -87,25 +87,6 @@ EngEnumForms(
     return FALSE;
 }
 
-/*
- * @unimplemented
- */
-BOOL
-APIENTRY
-EngFillPath(
-    IN SURFOBJ   *pso,
-    IN PATHOBJ   *ppo,
-    IN CLIPOBJ   *pco,
-    IN BRUSHOBJ  *pbo,
-    IN POINTL    *pptlBrushOrg,
-    IN MIX        mix,
-    IN FLONG      flOptions)
-{
-    // www.osr.com/ddk/graphics/gdifncs_9pyf.htm
-    UNIMPLEMENTED;
-    return FALSE;
-}
-
 /*
  * @unimplemented
  */
@@ -305,42 +286,6 @@ EngSetPrinterData(
     return 0;
 }
 
-BOOL
-APIENTRY
-EngStrokeAndFillPath(
-    IN SURFOBJ  *pso,
-    IN PATHOBJ  *ppo,
-    IN CLIPOBJ  *pco,
-    IN XFORMOBJ  *pxo,
-    IN BRUSHOBJ  *pboStroke,
-    IN LINEATTRS  *plineattrs,
-    IN BRUSHOBJ  *pboFill,
-    IN POINTL  *pptlBrushOrg,
-    IN MIX  mixFill,
-    IN FLONG  flOptions)
-{
-    // www.osr.com/ddk/graphics/gdifncs_2xwn.htm
-    UNIMPLEMENTED;
-    return FALSE;
-}
-
-BOOL
-APIENTRY
-EngStrokePath(
-    IN SURFOBJ  *pso,
-    IN PATHOBJ  *ppo,
-    IN CLIPOBJ  *pco,
-    IN XFORMOBJ  *pxo,
-    IN BRUSHOBJ  *pbo,
-    IN POINTL  *pptlBrushOrg,
-    IN LINEATTRS  *plineattrs,
-    IN MIX  mix)
-{
-    // www.osr.com/ddk/graphics/gdifncs_4yaw.htm
-    UNIMPLEMENTED;
-    return FALSE;
-}
-
 INT
 APIENTRY
 EngWideCharToMultiByte(
@@ -1490,38 +1435,6 @@ EngControlSprites(
     return FALSE;
 }
 
-_Must_inspect_result_
-_Ret_opt_bytecap_(cjSize)
-ENGAPI
-PVOID
-APIENTRY
-EngFntCacheAlloc(
-    _In_ ULONG ulFastCheckSum,
-    _In_ ULONG cjSize)
-{
-    UNIMPLEMENTED;
-    return NULL;
-}
-
-VOID
-APIENTRY
-EngFntCacheFault(
-    IN ULONG ulFastCheckSum,
-    IN ULONG iFaultMode)
-{
-    UNIMPLEMENTED;
-}
-
-PVOID
-APIENTRY
-EngFntCacheLookUp(
-    IN ULONG FastCheckSum,
-    OUT PULONG pulSize)
-{
-    UNIMPLEMENTED;
-    return NULL;
-}
-
 BOOLEAN
 APIENTRY
 EngNineGrid(
@@ -773,6 +773,7 @@ GreStretchBltMask(
                               &DestRect,
                               &SourceRect,
                               BitmapMask ? &MaskPoint : NULL,
+                              DCDest->pdcattr->jStretchBltMode,
                               &DCDest->eboFill.BrushObject,
                               &BrushOrigin,
                               rop4);
@@ -1501,6 +1501,7 @@ NtGdiStretchDIBitsInternal(
                          &rcDst,
                          &rcSrc,
                          NULL,
+                         pdc->pdcattr->jStretchBltMode,
                          &pdc->eboFill.BrushObject,
                          NULL,
                          WIN32_ROP3_TO_ENG_ROP4(dwRop));
@@ -54,8 +54,11 @@ typedef struct _FONT_CACHE_HASHED
 
 typedef struct _FONT_CACHE_ENTRY
 {
-    LIST_ENTRY ListEntry;
+    LIST_ENTRY ListEntry;   /* LRU order, most recently used first */
+    LIST_ENTRY HashEntry;   /* g_FontCacheHashTable bucket link */
     FT_BitmapGlyph BitmapGlyph;
+    SIZE_T cbSize;          /* Bytes accounted against MAX_FONT_CACHE_BYTES */
+    LONG RefCount;          /* Pinned while drawn outside of the FreeType lock */
     DWORD dwHash;
     FONT_CACHE_HASHED Hashed;
 } FONT_CACHE_ENTRY, *PFONT_CACHE_ENTRY;
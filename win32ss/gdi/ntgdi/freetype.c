@@ -103,10 +103,19 @@ static BOOL             g_RenderingEnabled = TRUE;
 #define ASSERT_FREETYPE_LOCK_NOT_HELD() \
     ASSERT(g_FreeTypeLock->Owner != KeGetCurrentThread())
 
-#define MAX_FONT_CACHE 256
+/* Glyph bitmaps are evicted in LRU order once they use more than this */
+#define MAX_FONT_CACHE_BYTES (1024 * 1024)
+#define FONT_CACHE_HASH_SIZE 1024 /* Must be a power of 2 */
 
 static RTL_STATIC_LIST_HEAD(g_FontCacheListHead);
+static LIST_ENTRY g_FontCacheHashTable[FONT_CACHE_HASH_SIZE];
 static UINT g_FontCacheNumEntries;
+static SIZE_T g_FontCacheBytes;
+static ULONG g_FontCacheHits;
+static ULONG g_FontCacheMisses;
+
+#define FONT_CACHE_BUCKET(dwHash) \
+    (&g_FontCacheHashTable[(dwHash) & (FONT_CACHE_HASH_SIZE - 1)])
 
 static PWCHAR g_ElfScripts[32] =   /* These are in the order of the fsCsb[0] bits */
 {
@@ -268,16 +277,80 @@ SharedFace_AddRef(PSHARED_FACE Ptr)
     ++Ptr->RefCount;
 }
 
+static void
+FreeCachedEntry(PFONT_CACHE_ENTRY Entry)
+{
+    ASSERT(Entry->RefCount == 0);
+
+    FT_Done_Glyph((FT_Glyph)Entry->BitmapGlyph);
+    ExFreePoolWithTag(Entry, TAG_FONT);
+}
+
+/*
+ * Takes the entry out of the cache. An entry that is still being drawn
+ * is only freed by its last DereferenceCachedEntry().
+ */
 static void
 RemoveCachedEntry(PFONT_CACHE_ENTRY Entry)
 {
     ASSERT_FREETYPE_LOCK_HELD();
 
-    FT_Done_Glyph((FT_Glyph)Entry->BitmapGlyph);
     RemoveEntryList(&Entry->ListEntry);
-    ExFreePoolWithTag(Entry, TAG_FONT);
+    RemoveEntryList(&Entry->HashEntry);
+    InitializeListHead(&Entry->ListEntry);
+    ASSERT(g_FontCacheNumEntries > 0);
+    ASSERT(g_FontCacheBytes >= Entry->cbSize);
     g_FontCacheNumEntries--;
-    ASSERT(g_FontCacheNumEntries <= MAX_FONT_CACHE);
+    g_FontCacheBytes -= Entry->cbSize;
+
+    if (Entry->RefCount == 0)
+        FreeCachedEntry(Entry);
+}
+
+static void
+ReferenceCachedEntry(PFONT_CACHE_ENTRY Entry)
+{
+    ASSERT_FREETYPE_LOCK_HELD();
+
+    ++Entry->RefCount;
+}
+
+static void
+DereferenceCachedEntry(PFONT_CACHE_ENTRY Entry)
+{
+    ASSERT_FREETYPE_LOCK_HELD();
+
+    ASSERT(Entry->RefCount > 0);
+    --Entry->RefCount;
+
+    /* Removed from the cache while it was drawn */
+    if (Entry->RefCount == 0 && IsListEmpty(&Entry->ListEntry))
+        FreeCachedEntry(Entry);
+}
+
+/* Evicts the least recently used glyphs until the cache fits its budget */
+static void
+TrimCacheEntries(PFONT_CACHE_ENTRY KeepEntry)
+{
+    PLIST_ENTRY CurrentEntry, PrevEntry;
+    PFONT_CACHE_ENTRY FontEntry;
+
+    ASSERT_FREETYPE_LOCK_HELD();
+
+    for (CurrentEntry = g_FontCacheListHead.Blink;
+         CurrentEntry != &g_FontCacheListHead &&
+         g_FontCacheBytes > MAX_FONT_CACHE_BYTES;
+         CurrentEntry = PrevEntry)
+    {
+        FontEntry = CONTAINING_RECORD(CurrentEntry, FONT_CACHE_ENTRY, ListEntry);
+        PrevEntry = CurrentEntry->Blink;
+
+        /* Glyphs that are being drawn stay until they are released */
+        if (FontEntry == KeepEntry || FontEntry->RefCount != 0)
+            continue;
+
+        RemoveCachedEntry(FontEntry);
+    }
 }
 
 static void
@@ -508,11 +581,19 @@ VOID DumpGlobalFontList(BOOL bDoLock)
         IntUnLockGlobalFonts();
 }
 
+VOID DumpFontCacheStats(VOID)
+{
+    DPRINT("Glyph cache: %u entries, %Iu bytes, %lu hits, %lu misses\n",
+           g_FontCacheNumEntries, g_FontCacheBytes,
+           g_FontCacheHits, g_FontCacheMisses);
+}
+
 VOID DumpFontInfo(BOOL bDoLock)
 {
     DumpGlobalFontList(bDoLock);
     DumpPrivateFontList(bDoLock);
     DumpFontSubstList();
+    DumpFontCacheStats();
 }
 #endif
 
@@ -670,8 +751,14 @@ BOOL FASTCALL
 InitFontSupport(VOID)
 {
     ULONG ulError;
+    ULONG i;
 
     g_FontCacheNumEntries = 0;
+    g_FontCacheBytes = 0;
+    for (i = 0; i < FONT_CACHE_HASH_SIZE; ++i)
+    {
+        InitializeListHead(&g_FontCacheHashTable[i]);
+    }
     /* Fast Mutexes must be allocated from non paged pool */
     g_FontListLock = ExAllocatePoolWithTag(NonPagedPool, sizeof(FAST_MUTEX), TAG_INTERNAL_SYNC);
     if (g_FontListLock == NULL)
@@ -725,7 +812,7 @@ FreeFontSupport(VOID)
     pHead = &g_FontCacheListHead;
     while (!IsListEmpty(pHead))
     {
-        pEntry = RemoveHeadList(pHead);
+        pEntry = pHead->Flink;
         pFontCache = CONTAINING_RECORD(pEntry, FONT_CACHE_ENTRY, ListEntry);
         RemoveCachedEntry(pFontCache);
     }
@@ -3160,20 +3247,21 @@ IntGetHash(IN LPCVOID pv, IN DWORD cdw)
     return dwHash;
 }
 
-static FT_BitmapGlyph
+static PFONT_CACHE_ENTRY
 IntFindGlyphCache(IN const FONT_CACHE_ENTRY *pCache)
 {
-    PLIST_ENTRY CurrentEntry;
+    PLIST_ENTRY CurrentEntry, Bucket;
     PFONT_CACHE_ENTRY FontEntry;
     DWORD dwHash = pCache->dwHash;
 
     ASSERT_FREETYPE_LOCK_HELD();
 
-    for (CurrentEntry = g_FontCacheListHead.Flink;
-         CurrentEntry != &g_FontCacheListHead;
+    Bucket = FONT_CACHE_BUCKET(dwHash);
+    for (CurrentEntry = Bucket->Flink;
+         CurrentEntry != Bucket;
          CurrentEntry = CurrentEntry->Flink)
     {
-        FontEntry = CONTAINING_RECORD(CurrentEntry, FONT_CACHE_ENTRY, ListEntry);
+        FontEntry = CONTAINING_RECORD(CurrentEntry, FONT_CACHE_ENTRY, HashEntry);
         if (FontEntry->dwHash == dwHash &&
             FontEntry->Hashed.GlyphIndex == pCache->Hashed.GlyphIndex &&
             FontEntry->Hashed.Face == pCache->Hashed.Face &&
@@ -3187,17 +3275,19 @@ IntFindGlyphCache(IN const FONT_CACHE_ENTRY *pCache)
         }
     }
 
-    if (CurrentEntry == &g_FontCacheListHead)
+    if (CurrentEntry == Bucket)
     {
+        g_FontCacheMisses++;
         return NULL;
     }
 
-    RemoveEntryList(CurrentEntry);
-    InsertHeadList(&g_FontCacheListHead, CurrentEntry);
-    return FontEntry->BitmapGlyph;
+    g_FontCacheHits++;
+    RemoveEntryList(&FontEntry->ListEntry);
+    InsertHeadList(&g_FontCacheListHead, &FontEntry->ListEntry);
+    return FontEntry;
 }
 
-static FT_BitmapGlyph
+static PFONT_CACHE_ENTRY
 IntGetBitmapGlyphWithCache(
     IN OUT PFONT_CACHE_ENTRY Cache,
     IN FT_GlyphSlot GlyphSlot)
@@ -3248,17 +3338,19 @@ IntGetBitmapGlyphWithCache(
     BitmapGlyph->bitmap = AlignedBitmap;
 
     NewEntry->BitmapGlyph = BitmapGlyph;
+    NewEntry->cbSize = sizeof(FONT_CACHE_ENTRY) + sizeof(*BitmapGlyph) +
+                       (SIZE_T)abs(AlignedBitmap.pitch) * AlignedBitmap.rows;
+    NewEntry->RefCount = 0;
     NewEntry->dwHash = Cache->dwHash;
     NewEntry->Hashed = Cache->Hashed;
 
     InsertHeadList(&g_FontCacheListHead, &NewEntry->ListEntry);
-    if (++g_FontCacheNumEntries > MAX_FONT_CACHE)
-    {
-        NewEntry = CONTAINING_RECORD(g_FontCacheListHead.Blink, FONT_CACHE_ENTRY, ListEntry);
-        RemoveCachedEntry(NewEntry);
-    }
+    InsertHeadList(FONT_CACHE_BUCKET(NewEntry->dwHash), &NewEntry->HashEntry);
+    g_FontCacheNumEntries++;
+    g_FontCacheBytes += NewEntry->cbSize;
+    TrimCacheEntries(NewEntry);
 
-    return BitmapGlyph;
+    return NewEntry;
 }
 
 
@@ -4208,13 +4300,13 @@ ftGdiGetGlyphOutline(
     return needed;
 }
 
-static FT_BitmapGlyph
-IntGetRealGlyph(
+static PFONT_CACHE_ENTRY
+IntGetRealGlyphEntry(
     IN OUT PFONT_CACHE_ENTRY Cache)
 {
     INT error;
     FT_GlyphSlot glyph;
-    FT_BitmapGlyph realglyph;
+    PFONT_CACHE_ENTRY realglyph;
 
     ASSERT_FREETYPE_LOCK_HELD();
 
@@ -4247,6 +4339,15 @@ IntGetRealGlyph(
     return realglyph;
 }
 
+static FT_BitmapGlyph
+IntGetRealGlyph(
+    IN OUT PFONT_CACHE_ENTRY Cache)
+{
+    PFONT_CACHE_ENTRY Entry = IntGetRealGlyphEntry(Cache);
+
+    return (Entry ? Entry->BitmapGlyph : NULL);
+}
+
 BOOL
 FASTCALL
 TextIntGetTextExtentPoint(PDC dc,
@@ -6035,6 +6136,101 @@ IntEngFillBox(
 }
 
 
+/* Number of glyphs drawn per release of the FreeType lock */
+#define MAX_GLYPH_BATCH 32
+
+typedef struct _GLYPH_BATCH_ENTRY
+{
+    PFONT_CACHE_ENTRY CacheEntry;
+    RECTL DestRect;
+} GLYPH_BATCH_ENTRY, *PGLYPH_BATCH_ENTRY;
+
+/*
+ * Draws referenced glyphs without holding the FreeType lock, so that other
+ * threads can rasterize text while the masks are being blitted. The lock is
+ * held again on return; the caller must restore the face size and transform
+ * before using the face, as another thread may have changed them.
+ */
+static BOOL
+IntDrawGlyphBatch(
+    IN PDC dc,
+    IN SURFOBJ *SurfObj,
+    IN EXLATEOBJ *pexloRGB2Dst,
+    IN EXLATEOBJ *pexloDst2RGB,
+    IN OUT PGLYPH_BATCH_ENTRY Batch,
+    IN ULONG Count)
+{
+    ULONG i;
+    BOOL bResult = TRUE;
+    FT_BitmapGlyph realglyph;
+    HBITMAP HSourceGlyph;
+    SURFOBJ *SourceGlyphSurf;
+    SIZEL bitSize;
+
+    ASSERT_FREETYPE_LOCK_HELD();
+    IntUnLockFreeType();
+
+    for (i = 0; i < Count; ++i)
+    {
+        realglyph = Batch[i].CacheEntry->BitmapGlyph;
+        bitSize.cx = realglyph->bitmap.width;
+        bitSize.cy = realglyph->bitmap.rows;
+
+        /*
+         * We should create the bitmap out of the loop at the biggest possible
+         * glyph size. Then use memset with 0 to clear it and sourcerect to
+         * limit the work of the transbitblt.
+         */
+        HSourceGlyph = EngCreateBitmap(bitSize, realglyph->bitmap.pitch,
+                                       BMF_8BPP, BMF_TOPDOWN,
+                                       realglyph->bitmap.buffer);
+        if (!HSourceGlyph)
+        {
+            DPRINT1("WARNING: EngCreateBitmap() failed!\n");
+            bResult = FALSE;
+            break;
+        }
+
+        SourceGlyphSurf = EngLockSurface((HSURF)HSourceGlyph);
+        if (!SourceGlyphSurf)
+        {
+            EngDeleteSurface((HSURF)HSourceGlyph);
+            DPRINT1("WARNING: EngLockSurface() failed!\n");
+            bResult = FALSE;
+            break;
+        }
+
+        /*
+         * Use the font data as a mask to paint onto the DCs surface using a
+         * brush.
+         */
+        if (!IntEngMaskBlt(SurfObj,
+                           SourceGlyphSurf,
+                           (CLIPOBJ *)&dc->co,
+                           &pexloRGB2Dst->xlo,
+                           &pexloDst2RGB->xlo,
+                           &Batch[i].DestRect,
+                           &PointZero,
+                           &dc->eboText.BrushObject,
+                           &PointZero))
+        {
+            DPRINT1("Failed to MaskBlt a glyph!\n");
+        }
+
+        EngUnlockSurface(SourceGlyphSurf);
+        EngDeleteSurface((HSURF)HSourceGlyph);
+    }
+
+    IntLockFreeType();
+
+    for (i = 0; i < Count; ++i)
+    {
+        DereferenceCachedEntry(Batch[i].CacheEntry);
+    }
+
+    return bResult;
+}
+
 BOOL
 APIENTRY
 IntExtTextOutW(
@@ -6055,23 +6251,25 @@ IntExtTextOutW(
      */
 
     PDC_ATTR pdcattr;
-    SURFOBJ *SurfObj, *SourceGlyphSurf;
+    SURFOBJ *SurfObj;
     SURFACE *psurf;
     INT glyph_index, i;
     FT_Face face;
     FT_BitmapGlyph realglyph;
+    PFONT_CACHE_ENTRY CacheEntry;
     LONGLONG X64, Y64, RealXStart64, RealYStart64, DeltaX64, DeltaY64;
     ULONG previous;
-    RECTL DestRect, MaskRect;
-    HBITMAP HSourceGlyph;
+    RECTL DestRect;
     SIZEL bitSize;
+    GLYPH_BATCH_ENTRY Batch[MAX_GLYPH_BATCH];
+    ULONG BatchCount;
     FONTOBJ *FontObj;
     PFONTGDI FontGDI;
     PTEXTOBJ TextObj = NULL;
     EXLATEOBJ exloRGB2Dst, exloDst2RGB;
     POINT Start;
     PMATRIX pmxWorldToDevice;
-    FT_Vector delta, vecAscent64, vecDescent64, vec;
+    FT_Vector delta, vecAscent64, vecDescent64, vec, vecAdvance;
     LOGFONTW *plf;
     BOOL use_kerning, bResult, DoBreak;
     FONT_CACHE_ENTRY Cache;
@@ -6300,6 +6498,7 @@ IntExtTextOutW(
     Y64 = RealYStart64;
     previous = 0;
     DoBreak = FALSE;
+    BatchCount = 0;
     bResult = TRUE; /* Assume success */
     for (i = 0; i < Count; ++i)
     {
@@ -6318,12 +6517,16 @@ IntExtTextOutW(
         glyph_index = get_glyph_index_flagged(face, ch0, (fuOptions & ETO_GLYPH_INDEX));
         Cache.Hashed.GlyphIndex = glyph_index;
 
-        realglyph = IntGetRealGlyph(&Cache);
-        if (!realglyph)
+        CacheEntry = IntGetRealGlyphEntry(&Cache);
+        if (!CacheEntry)
         {
             bResult = FALSE;
             break;
         }
+        realglyph = CacheEntry->BitmapGlyph;
+
+        /* Drawing the batch below drops its references, which may free this glyph */
+        vecAdvance = realglyph->root.advance;
 
         /* retrieve kerning distance and move pen position */
         if (use_kerning && previous && glyph_index && NULL == Dx)
@@ -6339,9 +6542,6 @@ IntExtTextOutW(
         bitSize.cx = realglyph->bitmap.width;
         bitSize.cy = realglyph->bitmap.rows;
 
-        MaskRect.right = realglyph->bitmap.width;
-        MaskRect.bottom = realglyph->bitmap.rows;
-
         DestRect.left   = ((X64 + 32) >> 6) + realglyph->left;
         DestRect.right  = DestRect.left + bitSize.cx;
         DestRect.top    = ((Y64 + 32) >> 6) - realglyph->top;
@@ -6350,34 +6550,6 @@ IntExtTextOutW(
         /* Check if the bitmap has any pixels */
         if ((bitSize.cx != 0) && (bitSize.cy != 0))
         {
-            /*
-             * We should create the bitmap out of the loop at the biggest possible
-             * glyph size. Then use memset with 0 to clear it and sourcerect to
-             * limit the work of the transbitblt.
-             */
-            HSourceGlyph = EngCreateBitmap(bitSize, realglyph->bitmap.pitch,
-                                           BMF_8BPP, BMF_TOPDOWN,
-                                           realglyph->bitmap.buffer);
-            if (!HSourceGlyph)
-            {
-                DPRINT1("WARNING: EngCreateBitmap() failed!\n");
-                bResult = FALSE;
-                break;
-            }
-
-            SourceGlyphSurf = EngLockSurface((HSURF)HSourceGlyph);
-            if (!SourceGlyphSurf)
-            {
-                EngDeleteSurface((HSURF)HSourceGlyph);
-                DPRINT1("WARNING: EngLockSurface() failed!\n");
-                bResult = FALSE;
-                break;
-            }
-
-            /*
-             * Use the font data as a mask to paint onto the DCs surface using a
-             * brush.
-             */
             if (lprc && (fuOptions & ETO_CLIPPED))
             {
                 // We do the check '>=' instead of '>' to possibly save an iteration
@@ -6395,21 +6567,24 @@ IntExtTextOutW(
                 }
             }
 
-            if (!IntEngMaskBlt(SurfObj,
-                               SourceGlyphSurf,
-                               (CLIPOBJ *)&dc->co,
-                               &exloRGB2Dst.xlo,
-                               &exloDst2RGB.xlo,
-                               &DestRect,
-                               (PPOINTL)&MaskRect,
-                               &dc->eboText.BrushObject,
-                               &PointZero))
+            /* Keep the glyph in the cache until it has been drawn */
+            ReferenceCachedEntry(CacheEntry);
+            Batch[BatchCount].CacheEntry = CacheEntry;
+            Batch[BatchCount].DestRect = DestRect;
+            if (++BatchCount == MAX_GLYPH_BATCH)
             {
-                DPRINT1("Failed to MaskBlt a glyph!\n");
-            }
+                bResult = IntDrawGlyphBatch(dc, SurfObj, &exloRGB2Dst, &exloDst2RGB,
+                                            Batch, BatchCount);
+                BatchCount = 0;
 
-            EngUnlockSurface(SourceGlyphSurf);
-            EngDeleteSurface((HSURF)HSourceGlyph);
+                /* Restore the face state other threads may have changed */
+                if (!bResult || !TextIntUpdateSize(dc, TextObj, FontGDI, FALSE))
+                {
+                    bResult = FALSE;
+                    break;
+                }
+                FT_Set_Transform(face, &Cache.Hashed.matTransform, NULL);
+            }
         }
 
         if (DoBreak)
@@ -6417,8 +6592,8 @@ IntExtTextOutW(
 
         if (NULL == Dx)
         {
-            X64 += realglyph->root.advance.x >> 10;
-            Y64 -= realglyph->root.advance.y >> 10;
+            X64 += vecAdvance.x >> 10;
+            Y64 -= vecAdvance.y >> 10;
         }
         else if (fuOptions & ETO_PDY)
         {
@@ -6444,6 +6619,19 @@ IntExtTextOutW(
         previous = glyph_index;
     }
 
+    if (BatchCount != 0)
+    {
+        if (!IntDrawGlyphBatch(dc, SurfObj, &exloRGB2Dst, &exloDst2RGB,
+                               Batch, BatchCount))
+        {
+            bResult = FALSE;
+        }
+
+        /* The underline and strike-out code below uses the face size */
+        TextIntUpdateSize(dc, TextObj, FontGDI, FALSE);
+        FT_Set_Transform(face, &Cache.Hashed.matTransform, NULL);
+    }
+
     if (pdcattr->flTextAlign & TA_UPDATECP)
         pdcattr->ptlCurrent.x = DestRect.right - dc->ptlDCOrig.x;
 
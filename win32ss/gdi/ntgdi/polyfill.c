@@ -600,6 +600,8 @@ IntFillPolygon(
     FILL_EDGE *ActiveHead = 0;
     FILL_EDGE *pLeft, *pRight;
     int ScanLine;
+    RECTL SpanRects[64];
+    ULONG cSpans = 0;
 
     //DPRINT("IntFillPolygon\n");
 
@@ -617,6 +619,13 @@ IntFillPolygon(
 
         if (!ActiveHead)
         {
+            IntEngFillSpans(&psurf->SurfObj,
+                            (CLIPOBJ *)&dc->co,
+                            BrushObj,
+                            BrushOrigin,
+                            ROP4_FROM_INDEX(R3_OPINDEX_PATCOPY),
+                            SpanRects,
+                            cSpans);
             POLYGONFILL_DestroyEdgeList(list);
             return FALSE;
         }
@@ -632,23 +641,23 @@ IntFillPolygon(
 
             if (x2 > x1)
             {
-                RECTL LineRect;
-                LineRect.top = ScanLine;
-                LineRect.bottom = ScanLine + 1;
-                LineRect.left = x1;
-                LineRect.right = x2;
-
-                IntEngBitBlt(&psurf->SurfObj,
-                             NULL,
-                             NULL,
-                             (CLIPOBJ *)&dc->co,
-                             NULL,
-                             &LineRect,
-                             NULL,
-                             NULL,
-                             BrushObj,
-                             BrushOrigin,
-                             ROP4_FROM_INDEX(R3_OPINDEX_PATCOPY));
+                SpanRects[cSpans].top = ScanLine;
+                SpanRects[cSpans].bottom = ScanLine + 1;
+                SpanRects[cSpans].left = x1;
+                SpanRects[cSpans].right = x2;
+
+                /* Hand the spans over in batches rather than one blit each */
+                if (++cSpans == RTL_NUMBER_OF(SpanRects))
+                {
+                    IntEngFillSpans(&psurf->SurfObj,
+                                    (CLIPOBJ *)&dc->co,
+                                    BrushObj,
+                                    BrushOrigin,
+                                    ROP4_FROM_INDEX(R3_OPINDEX_PATCOPY),
+                                    SpanRects,
+                                    cSpans);
+                    cSpans = 0;
+                }
             }
 
             pLeft = pRight->pNext;
@@ -656,6 +665,14 @@ IntFillPolygon(
         }
     }
 
+    IntEngFillSpans(&psurf->SurfObj,
+                    (CLIPOBJ *)&dc->co,
+                    BrushObj,
+                    BrushOrigin,
+                    ROP4_FROM_INDEX(R3_OPINDEX_PATCOPY),
+                    SpanRects,
+                    cSpans);
+
     /* Free Edge List. If any are left. */
     POLYGONFILL_DestroyEdgeList(list);
 
@@ -758,6 +758,10 @@ typedef struct _WND
     UINT HideFocus:1; /* WS_EX_UISTATEFOCUSRECTHIDDEN ? */
     UINT HideAccel:1; /* WS_EX_UISTATEKBACCELHIDDEN ? */
 
+    /* Ids of the creating thread, read by user32. Zero if only win32k knows them. */
+    HANDLE UniqueProcess;
+    HANDLE UniqueThread;
+
     /* Scrollbar info */
     PSBINFOEX pSBInfoex; // convert to PSBINFO
     /* Entry in the list of thread windows. */
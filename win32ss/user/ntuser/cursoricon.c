@@ -1945,6 +1945,7 @@ NoAlpha:
                                &rcDest,
                                &rcSrc,
                                NULL,
+                               COLORONCOLOR,
                                NULL,
                                NULL,
                                rop4);
@@ -1975,6 +1976,7 @@ NoAlpha:
                                    &rcDest,
                                    &rcSrc,
                                    NULL,
+                                   COLORONCOLOR,
                                    NULL,
                                    NULL,
                                    rop4);
@@ -2004,6 +2006,7 @@ NoAlpha:
                                    &rcDest,
                                    &rcSrc,
                                    NULL,
+                                   COLORONCOLOR,
                                    NULL,
                                    NULL,
                                    rop4);
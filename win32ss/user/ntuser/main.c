@@ -1039,6 +1039,7 @@ DriverEntry(
 
     NT_ROF(InitBrushImpl());
     NT_ROF(InitPDEVImpl());
+    NT_ROF(InitFontCacheImpl());
     NT_ROF(InitLDEVImpl());
     NT_ROF(InitDeviceImpl());
     NT_ROF(InitDcImpl());
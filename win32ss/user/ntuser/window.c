@@ -1906,6 +1906,14 @@ PWND FASTCALL IntCreateWindow(CREATESTRUCTW* Cs,
    pWnd->cbwndExtra = pWnd->pcls->cbwndExtra;
    pWnd->pActCtx = acbiBuffer;
 
+   /* Console windows report their leader process, see NtUserQueryWindow */
+   if (!(pWnd->head.pti->TIF_flags & TIF_CSRSSTHREAD) ||
+       Class->atomClassName != gaGuiConsoleWndClass)
+   {
+      pWnd->UniqueProcess = IntGetWndProcessId(pWnd);
+      pWnd->UniqueThread = IntGetWndThreadId(pWnd);
+   }
+
    if (pti->spDefaultImc && Class->atomClassName != gpsi->atomSysClass[ICLS_BUTTON])
       pWnd->hImc = UserHMGetHandle(pti->spDefaultImc);
 
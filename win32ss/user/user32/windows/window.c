@@ -960,7 +960,7 @@ HWND WINAPI
 GetAncestor(HWND hwnd, UINT gaFlags)
 {
     HWND Ret = NULL;
-    PWND Ancestor, Wnd;
+    PWND Ancestor, Parent, Wnd;
 
     Wnd = ValidateHwnd(hwnd);
     if (!Wnd)
@@ -976,8 +976,58 @@ GetAncestor(HWND hwnd, UINT gaFlags)
                     Ancestor = DesktopPtrToUser(Wnd->spwndParent);
                 break;
 
+            case GA_ROOT:
+                /* The desktop window has no ancestor */
+                if (Wnd->spwndParent == NULL)
+                    break;
+
+                /* Climb up to the child of the desktop window */
+                Ancestor = Wnd;
+                for (;;)
+                {
+                    Parent = DesktopPtrToUser(Ancestor->spwndParent);
+                    if (Parent == NULL)
+                    {
+                        Wnd = NULL;
+                        break;
+                    }
+
+                    if (Parent->spwndParent == NULL)
+                        break;
+
+                    Ancestor = Parent;
+                }
+                break;
+
+            case GA_ROOTOWNER:
+                if (Wnd->spwndParent == NULL)
+                    break;
+
+                /* Follow owners of popups and parents of children, like GetParent */
+                Ancestor = Wnd;
+                for (;;)
+                {
+                    if (Ancestor->style & WS_POPUP)
+                        Parent = Ancestor->spwndOwner;
+                    else if (Ancestor->style & WS_CHILD)
+                        Parent = Ancestor->spwndParent;
+                    else
+                        Parent = NULL;
+
+                    if (Parent == NULL)
+                        break;
+
+                    Ancestor = DesktopPtrToUser(Parent);
+                    if (Ancestor == NULL)
+                    {
+                        Wnd = NULL;
+                        break;
+                    }
+                }
+                break;
+
             default:
-                /* FIXME: Call win32k for now */
+                /* Let win32k deal with invalid flags */
                 Wnd = NULL;
                 break;
         }
@@ -1457,7 +1507,13 @@ GetWindowThreadProcessId(HWND hWnd,
 
     if (ti)
     {
-        if (ti == GetW32ThreadInfo())
+        if (pWnd->UniqueThread)
+        {
+            if (lpdwProcessId)
+                *lpdwProcessId = HandleToUlong(pWnd->UniqueProcess);
+            Ret = HandleToUlong(pWnd->UniqueThread);
+        }
+        else if (ti == GetW32ThreadInfo())
         { // We are current.
           //FIXME("Current!\n");
             if (lpdwProcessId)
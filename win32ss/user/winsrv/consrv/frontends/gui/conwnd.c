@@ -1052,6 +1052,9 @@ OnPaint(PGUI_CONSOLE_DATA GuiData)
     /* Do nothing if the window is hidden */
     if (!GuiData->IsWindowVisible) return;
 
+    /* Scroll the window before painting, so that what we paint stays in place */
+    GuiFlushPendingOutput(GuiData);
+
     BeginPaint(GuiData->hWindow, &ps);
     if (ps.hdc != NULL &&
         ps.rcPaint.left < ps.rcPaint.right &&
@@ -1322,6 +1325,9 @@ OnTimer(PGUI_CONSOLE_DATA GuiData)
 
     if (!ConDrvValidateConsoleUnsafe((PCONSOLE)Console, CONSOLE_RUNNING, TRUE)) return;
 
+    /* Repaint the output written since the last tick */
+    GuiFlushPendingOutput(GuiData);
+
     Buff = GuiData->ActiveBuffer;
 
     if (GetType(Buff) == TEXTMODE_BUFFER)
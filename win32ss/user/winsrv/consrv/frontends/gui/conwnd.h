@@ -95,4 +95,9 @@ typedef struct _GUI_CONSOLE_DATA
     BOOL  LineSelection;                    /* TRUE if line-oriented selection (a la *nix terminals), FALSE if block-oriented selection (default on Windows) */
 
     GUI_CONSOLE_INFO GuiInfo;   /* GUI terminal settings */
+
+    /* Streamed output waiting to be repainted, protected by the console lock */
+    BOOL OutputPending;
+    SMALL_RECT PendingRegion;   /* Changed cells, in current screen-buffer coordinates */
+    UINT PendingScrolledLines;  /* Number of lines scrolled since the last repaint */
 } GUI_CONSOLE_DATA, *PGUI_CONSOLE_DATA;
@@ -22,6 +22,8 @@
 
 // HACK!! Remove it when the hack in GuiWriteStream is fixed
 #define CONGUI_UPDATE_TIME    0
+/* Streamed output is repainted at most once per this many milliseconds */
+#define CONGUI_OUTPUT_FLUSH_TIME  16
 #define CONGUI_UPDATE_TIMER   1
 
 #define PM_CREATE_CONSOLE     (WM_APP + 1)
@@ -92,6 +94,70 @@ InvalidateCell(PGUI_CONSOLE_DATA GuiData,
     DrawRegion(GuiData, &CellRect);
 }
 
+/*
+ * Repaints the output accumulated by GuiWriteStream since the last flush:
+ * the window is scrolled once by the total number of scrolled lines, and
+ * the union of the changed cells is invalidated.
+ * The pending output is protected by the console lock, like the screen
+ * buffer it describes; GuiData->Lock must not be held by the caller, as
+ * the console lock is always taken first.
+ */
+VOID
+GuiFlushPendingOutput(PGUI_CONSOLE_DATA GuiData)
+{
+    PCONSRV_CONSOLE Console = GuiData->Console;
+    PCONSOLE_SCREEN_BUFFER Buff;
+    RECT ScrollRect;
+
+    if (!ConDrvValidateConsoleUnsafe((PCONSOLE)Console, CONSOLE_RUNNING, TRUE)) return;
+
+    if (!GuiData->OutputPending)
+        goto Quit;
+    GuiData->OutputPending = FALSE;
+
+    Buff = GuiData->ActiveBuffer;
+    if (GetType(Buff) != TEXTMODE_BUFFER)
+        goto Quit;
+
+    if (GuiData->PendingScrolledLines >= (UINT)Buff->ViewSize.Y)
+    {
+        /* Everything moved, there is nothing left worth scrolling */
+        InvalidateRect(GuiData->hWindow, NULL, FALSE);
+        goto Quit;
+    }
+
+    if (GuiData->PendingScrolledLines != 0 && GuiData->PendingRegion.Top > 0)
+    {
+        ScrollRect.left = 0;
+        ScrollRect.top = 0;
+        ScrollRect.right = Buff->ViewSize.X * GuiData->CharWidth;
+        ScrollRect.bottom = GuiData->PendingRegion.Top * GuiData->CharHeight;
+
+        ScrollWindowEx(GuiData->hWindow,
+                       0,
+                       -(int)(GuiData->PendingScrolledLines * GuiData->CharHeight),
+                       &ScrollRect,
+                       NULL,
+                       NULL,
+                       NULL,
+                       SW_INVALIDATE);
+    }
+
+    if (!ConioIsRectEmpty(&GuiData->PendingRegion))
+        DrawRegion(GuiData, &GuiData->PendingRegion);
+
+Quit:
+    LeaveCriticalSection(&Console->Lock);
+}
+
+/* Adds a region to the output waiting for the next flush; the console lock must be held */
+static VOID
+AddPendingRegion(PGUI_CONSOLE_DATA GuiData,
+                 SMALL_RECT* Region)
+{
+    ConioGetUnion(&GuiData->PendingRegion, &GuiData->PendingRegion, Region);
+}
+
 
 /******************************************************************************
  *                        GUI Terminal Initialization                         *
@@ -634,7 +700,11 @@ GuiDrawRegion(IN OUT PFRONTEND This,
     /* Do nothing if the window is hidden */
     if (!GuiData->IsWindowVisible) return;
 
-    DrawRegion(GuiData, Region);
+    /* Keep the order of the updates if streamed output is waiting to be repainted */
+    if (GuiData->OutputPending)
+        AddPendingRegion(GuiData, Region);
+    else
+        DrawRegion(GuiData, Region);
 }
 
 static VOID NTAPI
@@ -648,8 +718,7 @@ GuiWriteStream(IN OUT PFRONTEND This,
 {
     PGUI_CONSOLE_DATA GuiData = This->Context;
     PCONSOLE_SCREEN_BUFFER Buff;
-    SHORT CursorEndX, CursorEndY;
-    RECT ScrollRect;
+    SMALL_RECT CursorRect;
 
     if (NULL == GuiData || NULL == GuiData->hWindow) return;
 
@@ -659,45 +728,49 @@ GuiWriteStream(IN OUT PFRONTEND This,
     Buff = GuiData->ActiveBuffer;
     if (GetType(Buff) != TEXTMODE_BUFFER) return;
 
-    if (0 != ScrolledLines)
+    /*
+     * Don't repaint now, but accumulate the changes and let OnTimer repaint
+     * them all at once, so that a stream of small writes (e.g. build logs)
+     * only scrolls and repaints the window about once per frame.
+     */
+    if (GuiData->OutputPending)
     {
-        ScrollRect.left = 0;
-        ScrollRect.top = 0;
-        ScrollRect.right = Buff->ViewSize.X * GuiData->CharWidth;
-        ScrollRect.bottom = Region->Top * GuiData->CharHeight;
-
-        ScrollWindowEx(GuiData->hWindow,
-                       0,
-                       -(int)(ScrolledLines * GuiData->CharHeight),
-                       &ScrollRect,
-                       NULL,
-                       NULL,
-                       NULL,
-                       SW_INVALIDATE);
+        /* What was changed before has moved up with the text */
+        if (ScrolledLines != 0 && !ConioIsRectEmpty(&GuiData->PendingRegion))
+        {
+            if (GuiData->PendingRegion.Bottom < (SHORT)ScrolledLines)
+            {
+                ConioInitRect(&GuiData->PendingRegion, 0, 0, -1, -1);
+            }
+            else
+            {
+                GuiData->PendingRegion.Top = max(GuiData->PendingRegion.Top - (SHORT)ScrolledLines, 0);
+                GuiData->PendingRegion.Bottom -= (SHORT)ScrolledLines;
+            }
+        }
+        GuiData->PendingScrolledLines += ScrolledLines;
     }
-
-    DrawRegion(GuiData, Region);
-
-    if (CursorStartX < Region->Left || Region->Right < CursorStartX
-            || CursorStartY < Region->Top || Region->Bottom < CursorStartY)
+    else
     {
-        InvalidateCell(GuiData, CursorStartX, CursorStartY);
+        ConioInitRect(&GuiData->PendingRegion, 0, 0, -1, -1);
+        GuiData->PendingScrolledLines = ScrolledLines;
+        GuiData->OutputPending = TRUE;
+
+        // HACK!!
+        // Set up the update timer (very short interval) - this is a "hack" for getting the OS to
+        // repaint the window without having it just freeze up and stay on the screen permanently.
+        Buff->CursorBlinkOn = TRUE;
+        SetTimer(GuiData->hWindow, CONGUI_UPDATE_TIMER, CONGUI_OUTPUT_FLUSH_TIME, NULL);
     }
 
-    CursorEndX = Buff->CursorPosition.X;
-    CursorEndY = Buff->CursorPosition.Y;
-    if ((CursorEndX < Region->Left || Region->Right < CursorEndX
-            || CursorEndY < Region->Top || Region->Bottom < CursorEndY)
-            && (CursorEndX != CursorStartX || CursorEndY != CursorStartY))
-    {
-        InvalidateCell(GuiData, CursorEndX, CursorEndY);
-    }
+    AddPendingRegion(GuiData, Region);
 
-    // HACK!!
-    // Set up the update timer (very short interval) - this is a "hack" for getting the OS to
-    // repaint the window without having it just freeze up and stay on the screen permanently.
-    Buff->CursorBlinkOn = TRUE;
-    SetTimer(GuiData->hWindow, CONGUI_UPDATE_TIMER, CONGUI_UPDATE_TIME, NULL);
+    /* Also repaint the cells of the old and new cursor positions */
+    ConioInitRect(&CursorRect, CursorStartY, CursorStartX, CursorStartY, CursorStartX);
+    AddPendingRegion(GuiData, &CursorRect);
+    ConioInitRect(&CursorRect, Buff->CursorPosition.Y, Buff->CursorPosition.X,
+                  Buff->CursorPosition.Y, Buff->CursorPosition.X);
+    AddPendingRegion(GuiData, &CursorRect);
 }
 
 /* static */ VOID NTAPI